@@ -9,7 +9,7 @@ import numpy as np
 import rospy
 from std_msgs.msg import Float32MultiArray, Int32, String
 from geometry_msgs.msg import Pose, PoseStamped
-from vanttec_uuv.msg import GuidanceWaypoints
+from vanttec_uuv.msg import GuidanceWaypoints, VehicleState, ObstacleList
 from usv_perception.msg import obj_detected, obj_detected_list
 from nav_msgs.msg import Path
 
@@ -32,12 +32,17 @@ class AutoNav:
         self.distance_away = 5
         self.waypoints = GuidanceWaypoints()
         self.uuv_path = Path()
+        self.detection_stamp = rospy.Time.now()
+        self.decisions = 0
+        self.latency_sum = 0
+        self.latency_max = 0
        
         #Waypoint test instead of perception node
 
 
         # ROS Subscribers
-        rospy.Subscriber("/uuv_simulation/dynamic_model/pose", Pose, self.ins_pose_callback)
+        rospy.Subscriber("/uuv_simulation/dynamic_model/state", VehicleState, self.ins_pose_callback)
+        rospy.Subscriber("/uuv_perception/simulated_perception/obstacles", ObstacleList, self.objs_callback)
         '''
         rospy.Subscriber("/usv_perception/yolo_zed/objects_detected", obj_detected_list, self.objs_callback)
         '''
@@ -48,41 +53,22 @@ class AutoNav:
         self.status_pub = rospy.Publisher("/mission/status", Int32, queue_size=10)
         self.test = rospy.Publisher("/mission/state", Int32, queue_size=10)
 
-        #Waypoint test instead of perception node
+    def ins_pose_callback(self,state):
+        self.ned_x = state.x
+        self.ned_y = state.y
+        self.ned_z = state.z
+        self.yaw = state.yaw
 
-        self.objects_list = [
-            {
-                'X': 7,
-                'Y': -4,
-                'Z': 0
-            },
-            {
-                'X': 7,
-                'Y': 0,
-                'Z': 0
-            },
-            {
-                'X': 7,
-                'Y': 4,
-                'Z': 0                
-            }            
-        ]
-    
-    def ins_pose_callback(self,pose):
-        self.ned_x = pose.position.x
-        self.ned_y = pose.position.y
-        self.ned_z = pose.position.z
-        self.yaw = pose.orientation.z
-    '''
     def objs_callback(self,data):
+        # Detections are in the body frame, Y is flipped to the camera
+        # convention used by the gate calculations
         self.objects_list = []
-        for i in range(data.len):
-            if str(data.objects[i].clase) == 'bouy':
-                self.objects_list.append({'X' : data.objects[i].X + self.offset, 
-                                      'Y' : data.objects[i].Y, 
-                                      'color' : data.objects[i].color, 
-                                      'class' : data.objects[i].clase})
-    '''                                      
+        self.detection_stamp = data.header.stamp
+        for obstacle in data.obstacles:
+            self.objects_list.append({'X' : obstacle.pose.position.x, 
+                                      'Y' : -obstacle.pose.position.y, 
+                                      'Z' : obstacle.pose.position.z, 
+                                      'class' : obstacle.obstacle_class})
 
     def center_point(self):
         '''
@@ -234,11 +220,12 @@ class AutoNav:
         #path_array.layout.data_offset = 3
         #path_array.data = [self.target_x, self.target_y, 0]
         #self.desired(data)
+        # The guidance follows segments, start from the current position
         self.waypoints.guidance_law = 1
-        self.waypoints.waypoint_list_length = 1
-        self.waypoints.waypoint_list_x = {self.target_x}
-        self.waypoints.waypoint_list_y = { self.target_y}
-        self.waypoints.waypoint_list_z = {0}   
+        self.waypoints.waypoint_list_length = 2
+        self.waypoints.waypoint_list_x = [self.ned_x, self.target_x]
+        self.waypoints.waypoint_list_y = [self.ned_y, self.target_y]
+        self.waypoints.waypoint_list_z = [0,0]   
         self.desired(self.waypoints)
 
     def gate_to_body(self, gate_x2, gate_y2, alpha, body_x1, body_y1):
@@ -320,6 +307,15 @@ class AutoNav:
             pose.pose.position.z    = path.waypoint_list_z[index]
             self.uuv_path.poses.append(pose)
         self.uuv_path_pub.publish(self.uuv_path)
+
+        # Same measure as uuv_choose_side_node, detections stamp to publication
+        latency = (rospy.Time.now() - self.detection_stamp).to_sec()*1000
+        self.decisions += 1
+        self.latency_sum += latency
+        self.latency_max = max(self.latency_max, latency)
+        if self.decisions % 10 == 0:
+            rospy.loginfo("Decision latency mean %.2f ms, max %.2f ms over %d decisions",
+                          self.latency_sum/self.decisions, self.latency_max, self.decisions)
 def main():
     rospy.init_node("auto_nav_position", anonymous=False)
     rate = rospy.Rate(20)
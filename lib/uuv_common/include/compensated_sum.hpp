@@ -0,0 +1,41 @@
+/** ----------------------------------------------------------------------------
+ * @file: compensated_sum.hpp
+ *
+ * @brief: Kahan compensated accumulator, used by the integrators that add
+ *         small increments to large running values over long missions.
+ *         Works with scalars and with Eigen vectors (element-wise). Must not
+ *         be compiled with -ffast-math, which would optimize it away.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __COMPENSATED_SUM_H__
+#define __COMPENSATED_SUM_H__
+
+template <typename T>
+class CompensatedSum
+{
+    public:
+
+        T sum;
+        T compensation;
+
+        CompensatedSum(const T& _zero)
+        {
+            this->sum           = _zero;
+            this->compensation  = _zero;
+        }
+
+        ~CompensatedSum(){}
+
+        const T& Add(const T& _increment)
+        {
+            T corrected         = _increment - this->compensation;
+            T new_sum           = this->sum + corrected;
+            this->compensation  = (new_sum - this->sum) - corrected;
+            this->sum           = new_sum;
+
+            return this->sum;
+        }
+};
+
+#endif
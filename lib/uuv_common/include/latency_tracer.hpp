@@ -0,0 +1,69 @@
+/** ----------------------------------------------------------------------------
+ * @file: latency_tracer.hpp
+ *
+ * @brief: In-process latency tracer. Each node records, per stage, the age
+ *         of the traced sample behind what it outputs, into a log2 histogram
+ *         and a fixed ring of recent events that can be written as a Chrome
+ *         trace (chrome://tracing or Perfetto). Recording never allocates.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __LATENCY_TRACER_H__
+#define __LATENCY_TRACER_H__
+
+#include "ring_buffer.hpp"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <vanttec_uuv/TraceInfo.h>
+
+/* Bin 0 holds latencies under 1 us, bin i those in [2^(i-1), 2^i) us, the last one everything above */
+const uint8_t   LATENCY_HISTOGRAM_BINS  = 24;
+const uint8_t   MAX_LATENCY_STAGES      = 8;
+
+typedef struct LatencyStage_S
+{
+    const char*     name;
+    uint32_t        bins[LATENCY_HISTOGRAM_BINS];
+    uint64_t        count;
+    double          sum_us;
+    double          max_us;
+} LatencyStage_S;
+
+typedef struct TraceEvent_S
+{
+    uint8_t         stage;
+    uint64_t        trace_id;
+    double          origin_s;
+    double          end_s;
+} TraceEvent_S;
+
+class LatencyTracer
+{
+    public:
+
+        const char*                 process_name;
+        std::vector<LatencyStage_S> stages;
+        RingBuffer<TraceEvent_S>    events;
+
+        LatencyTracer(const char* _process_name, size_t _event_capacity);
+        ~LatencyTracer();
+
+        /* Returns the stage index, or the last stage when all are taken */
+        uint8_t AddStage(const char* _name);
+
+        /* Samples without an origin stamp are not recorded */
+        void Record(uint8_t _stage, const vanttec_uuv::TraceInfo& _trace, const ros::Time& _now);
+        void Record(uint8_t _stage, uint64_t _trace_id, double _origin_s, double _end_s);
+
+        /* Upper edge of the histogram bin holding the given fraction of the samples, in us */
+        double Percentile(uint8_t _stage, double _fraction) const;
+
+        void LogSummary() const;
+        bool DumpChromeTrace(const std::string& _path) const;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/** ----------------------------------------------------------------------------
+ * @file: ring_buffer.hpp
+ *
+ * @brief: Fixed capacity ring buffer. Storage is allocated once on
+ *         construction; when full, the oldest element is overwritten.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class RingBuffer
+{
+    public:
+
+        RingBuffer(size_t _capacity)
+        {
+            this->storage.resize(_capacity > 0 ? _capacity : 1);
+            this->head  = 0;
+            this->count = 0;
+        }
+
+        ~RingBuffer(){}
+
+        size_t Capacity() const { return this->storage.size(); }
+        size_t Size() const     { return this->count; }
+        bool   Empty() const    { return this->count == 0; }
+        bool   Full() const     { return this->count == this->storage.size(); }
+
+        void Clear()
+        {
+            this->head  = 0;
+            this->count = 0;
+        }
+
+        /* Index 0 is the oldest element, Size() - 1 the newest. */
+        T& operator[](size_t _i)                { return this->storage[(this->head + _i) % this->storage.size()]; }
+        const T& operator[](size_t _i) const    { return this->storage[(this->head + _i) % this->storage.size()]; }
+
+        T& Front()              { return (*this)[0]; }
+        const T& Front() const  { return (*this)[0]; }
+        T& Back()               { return (*this)[this->count - 1]; }
+        const T& Back() const   { return (*this)[this->count - 1]; }
+
+        /* Returns true if an element had to be overwritten to make room. */
+        bool PushBack(const T& _element)
+        {
+            bool overwritten = false;
+
+            if (this->Full())
+            {
+                this->PopFront();
+                overwritten = true;
+            }
+
+            this->storage[(this->head + this->count) % this->storage.size()] = _element;
+            this->count++;
+
+            return overwritten;
+        }
+
+        void PopFront()
+        {
+            if (this->count > 0)
+            {
+                this->head = (this->head + 1) % this->storage.size();
+                this->count--;
+            }
+        }
+
+    private:
+
+        std::vector<T>  storage;
+        size_t          head;
+        size_t          count;
+};
+
+#endif
@@ -0,0 +1,351 @@
+/** ----------------------------------------------------------------------------
+ * @file: telemetry_recorder.hpp
+ *
+ * @brief: In-process telemetry recorder. Records are 128 bytes with a fixed
+ *         layout per type, written into a ring of segment files that are
+ *         created, allocated and memory mapped when the recorder is opened.
+ *         Recording is a copy into the mapping and moving to the next
+ *         segment only switches pointers, so the loops never allocate or
+ *         make system calls; the kernel writes the pages back on its own.
+ *
+ *         Segments are named <source>_<index>.tlm. Each one has a header with
+ *         its generation, which grows every time the ring moves on, and the
+ *         number of valid records, updated after every record. When the ring
+ *         is full the oldest segment is overwritten. Use one directory per
+ *         run, the reader orders the segments of a source by generation.
+ *
+ *         Inputs are recorded when their callback runs. A tick record marks
+ *         the point of each cycle where the loop computes its outputs, which
+ *         follow it, so the order in which a node saw its inputs and what it
+ *         produced from them can be reproduced.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __TELEMETRY_RECORDER_H__
+#define __TELEMETRY_RECORDER_H__
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/Twist.h>
+#include <vanttec_uuv/GuidanceWaypoints.h>
+#include <vanttec_uuv/MasterStatus.h>
+#include <vanttec_uuv/ObstacleList.h>
+#include <vanttec_uuv/ThrustControl.h>
+#include <vanttec_uuv/TraceInfo.h>
+#include <vanttec_uuv/VehicleState.h>
+
+const char      TELEMETRY_FILE_MAGIC[8] = {'U', 'U', 'V', 'T', 'E', 'L', 'E', 'M'};
+const uint32_t  TELEMETRY_FILE_VERSION  = 3;
+const uint32_t  TELEMETRY_MAX_PARAMETERS = 64;
+
+typedef enum TelemetryRecordType_E
+{
+    TELEMETRY_TICK = 0,
+    TELEMETRY_STATE = 1,
+    TELEMETRY_SETPOINT = 2,
+    TELEMETRY_THRUST = 3,
+    TELEMETRY_PID = 4,
+    TELEMETRY_WAYPOINT_LIST = 5,
+    TELEMETRY_WAYPOINT = 6,
+    TELEMETRY_MASTER_STATUS = 7,
+    TELEMETRY_EMERGENCY_STOP = 8,
+    TELEMETRY_OBSTACLE_LIST = 9,
+    TELEMETRY_OBSTACLE = 10,
+    TELEMETRY_PARAMETER = 11,
+    TELEMETRY_RECORD_TYPES = 12,
+} TelemetryRecordType_E;
+
+/* Axes of the PID records */
+typedef enum TelemetryPidAxis_E
+{
+    TELEMETRY_PID_SURGE = 0,
+    TELEMETRY_PID_SWAY = 1,
+    TELEMETRY_PID_DEPTH = 2,
+    TELEMETRY_PID_HEADING = 3,
+} TelemetryPidAxis_E;
+
+/********** Segment Layout ***********/
+
+typedef struct TelemetrySegmentHeader_S
+{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    header_size;
+    uint32_t    record_size;
+    uint32_t    reserved;
+    uint64_t    generation;
+    uint64_t    record_capacity;
+    uint64_t    record_count;
+    char        source[32];
+    uint8_t     padding[48];
+} TelemetrySegmentHeader_S;
+
+/* Fields keep the width they have in the messages, so replays see the same values */
+
+typedef struct TelemetryTick_S
+{
+    uint64_t    cycle;
+} TelemetryTick_S;
+
+typedef struct TelemetryState_S
+{
+    double      x;
+    double      y;
+    double      z;
+    float       roll;
+    float       pitch;
+    float       yaw;
+    float       u;
+    float       v;
+    float       w;
+    float       p;
+    float       q;
+    float       r;
+    float       u_dot;
+    float       v_dot;
+    float       w_dot;
+    float       p_dot;
+    float       q_dot;
+    float       r_dot;
+    uint32_t    sequence;
+    uint64_t    trace_id;
+    double      origin_s;
+} TelemetryState_S;
+
+typedef struct TelemetrySetpoint_S
+{
+    double      linear_x;
+    double      linear_y;
+    double      linear_z;
+    double      angular_x;
+    double      angular_y;
+    double      angular_z;
+    uint64_t    trace_id;
+    double      origin_s;
+} TelemetrySetpoint_S;
+
+typedef struct TelemetryThrust_S
+{
+    float       tau_x;
+    float       tau_y;
+    float       tau_z;
+    float       tau_yaw;
+    uint64_t    trace_id;
+    double      origin_s;
+} TelemetryThrust_S;
+
+typedef struct TelemetryPid_S
+{
+    uint8_t     axis;
+    uint8_t     reserved[3];
+    float       set_point;
+    float       error;
+    float       prev_error;
+    float       manipulation;
+    float       f_x;
+    float       g_x;
+    float       k_p;
+    float       k_i;
+    float       k_d;
+    float       transfer;
+} TelemetryPid_S;
+
+typedef struct TelemetryWaypointList_S
+{
+    uint8_t     guidance_law;
+    uint8_t     waypoint_list_length;
+    uint8_t     reserved[2];
+    uint32_t    sequence;
+    /* Sizes of the arrays, which the length field does not have to match */
+    uint32_t    x_count;
+    uint32_t    y_count;
+    uint32_t    z_count;
+    uint32_t    speed_count;
+    uint32_t    acceptance_radius_count;
+} TelemetryWaypointList_S;
+
+typedef struct TelemetryWaypoint_S
+{
+    uint32_t    index;
+    float       x;
+    float       y;
+    float       z;
+    float       speed;
+    float       acceptance_radius;
+} TelemetryWaypoint_S;
+
+typedef struct TelemetryMasterStatus_S
+{
+    uint8_t     status;
+    uint8_t     desired_routine;
+} TelemetryMasterStatus_S;
+
+typedef struct TelemetryObstacleList_S
+{
+    uint32_t    count;
+    /* Truncated, only compared against "world" */
+    char        frame_id[32];
+} TelemetryObstacleList_S;
+
+typedef struct TelemetryObstacle_S
+{
+    double      x;
+    double      y;
+    double      z;
+    /* Only the yaw of the orientation is used, the components it comes from are kept */
+    double      orientation_z;
+    double      orientation_w;
+    float       radio;
+    float       height;
+    float       length;
+    char        obstacle_class[32];
+} TelemetryObstacle_S;
+
+/* Node settings that are not inputs. The recorder repeats them at the start of
+   every segment, so a log that lost its oldest segments still has them */
+typedef struct TelemetryParameter_S
+{
+    char        name[56];
+    double      value;
+    /* Empty for numeric parameters */
+    char        text[48];
+} TelemetryParameter_S;
+
+typedef struct TelemetryRecord_S
+{
+    uint16_t    type;
+    uint16_t    reserved;
+    uint32_t    sequence;
+    double      time_s;
+    union
+    {
+        TelemetryTick_S             tick;
+        TelemetryState_S            state;
+        TelemetrySetpoint_S         setpoint;
+        TelemetryThrust_S           thrust;
+        TelemetryPid_S              pid;
+        TelemetryWaypointList_S     waypoint_list;
+        TelemetryWaypoint_S         waypoint;
+        TelemetryMasterStatus_S     master_status;
+        TelemetryObstacleList_S     obstacle_list;
+        TelemetryObstacle_S         obstacle;
+        TelemetryParameter_S        parameter;
+        uint8_t                     payload[112];
+    };
+} TelemetryRecord_S;
+
+static_assert(sizeof(TelemetrySegmentHeader_S) == 128, "Telemetry segment header layout changed");
+static_assert(sizeof(TelemetryRecord_S) == 128, "Telemetry record layout changed");
+
+/********** Recorder ***********/
+
+class TelemetryRecorder
+{
+    public:
+
+        const char*     error;
+
+        /* Statistics */
+        uint64_t        records;
+        uint64_t        rotations;
+
+        TelemetryRecorder();
+        ~TelemetryRecorder();
+
+        /* Creates and maps the whole ring, the only place where files are touched */
+        bool Open(const std::string& _directory, const std::string& _source,
+                  uint64_t _records_per_segment, uint32_t _segment_count);
+        void Close();
+        bool IsOpen() const;
+
+        void RecordTick(double _time_s, uint64_t _cycle);
+        void RecordState(double _time_s, const vanttec_uuv::VehicleState& _state);
+        void RecordSetpoint(double _time_s, const geometry_msgs::Twist& _setpoint, const vanttec_uuv::TraceInfo& _trace);
+        void RecordThrust(double _time_s, const vanttec_uuv::ThrustControl& _thrust);
+        void RecordWaypoints(double _time_s, const vanttec_uuv::GuidanceWaypoints& _waypoints);
+        void RecordMasterStatus(double _time_s, const vanttec_uuv::MasterStatus& _status);
+        void RecordEmergencyStop(double _time_s);
+        void RecordObstacles(double _time_s, const vanttec_uuv::ObstacleList& _obstacles);
+        void RecordParameter(double _time_s, const char* _name, double _value);
+        void RecordParameter(double _time_s, const char* _name, const std::string& _text);
+
+        template <typename PID>
+        void RecordPid(double _time_s, TelemetryPidAxis_E _axis, const PID& _pid)
+        {
+            TelemetryRecord_S* record = this->Next(TELEMETRY_PID, _time_s);
+
+            record->pid.axis            = _axis;
+            record->pid.set_point       = _pid.set_point;
+            record->pid.error           = _pid.error;
+            record->pid.prev_error      = _pid.prev_error;
+            record->pid.manipulation    = _pid.manipulation;
+            record->pid.f_x             = _pid.f_x;
+            record->pid.g_x             = _pid.g_x;
+            record->pid.k_p             = _pid.k_p;
+            record->pid.k_i             = _pid.k_i;
+            record->pid.k_d             = _pid.k_d;
+            record->pid.transfer        = _pid.transfer;
+
+            this->Commit();
+        }
+
+    private:
+
+        std::vector<void*>          segments;
+        size_t                      segment_size;
+        uint32_t                    current_segment;
+        TelemetrySegmentHeader_S*   header;
+        TelemetryRecord_S*          slots;
+        TelemetryRecord_S           discard;
+        TelemetryRecord_S           parameters[TELEMETRY_MAX_PARAMETERS];
+        uint32_t                    parameter_count;
+
+        /* Slot for the next record, filled in by the caller before Commit */
+        TelemetryRecord_S* Next(TelemetryRecordType_E _type, double _time_s);
+        void Commit();
+        void Rotate();
+        void KeepParameter(const TelemetryRecord_S& _record);
+};
+
+/********** Reader ***********/
+
+class TelemetryReader
+{
+    public:
+
+        const char*     error;
+        std::string     source;
+
+        TelemetryReader();
+        ~TelemetryReader();
+
+        /* Maps the given segments of one source, ordered by generation */
+        bool Open(const std::vector<std::string>& _paths);
+        void Close();
+
+        /* Records in recording order, NULL after the last one */
+        const TelemetryRecord_S* Next();
+        void Rewind();
+
+        /* Groups the segments of a run directory, or a single segment file, by
+           everything before their _<index>.tlm suffix; false when it is neither */
+        static bool FindLogs(const std::string& _path, std::map<std::string, std::vector<std::string> >* _logs);
+
+    private:
+
+        typedef struct TelemetrySegment_S
+        {
+            const TelemetrySegmentHeader_S*     header;
+            const TelemetryRecord_S*            records;
+            size_t                              size;
+        } TelemetrySegment_S;
+
+        std::vector<TelemetrySegment_S>     segments;
+        size_t                              current_segment;
+        uint64_t                            current_record;
+};
+
+#endif
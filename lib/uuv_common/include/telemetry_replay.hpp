@@ -0,0 +1,86 @@
+/** ----------------------------------------------------------------------------
+ * @file: telemetry_replay.hpp
+ *
+ * @brief: Offline replay of a node from its telemetry. The recorded inputs
+ *         are handed to the node's controller in the order its callbacks saw
+ *         them, the controller is stepped at every tick record, and the
+ *         outputs recorded after the tick are compared bit for bit with the
+ *         ones the replayed controller produces. Each node has its own
+ *         replay, which decides what is an input and what is compared.
+ *         Vehicle parameters recorded as vehicle/<name> are collected before
+ *         the handlers see them, so a replay can bind the recorded vehicle.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __TELEMETRY_REPLAY_H__
+#define __TELEMETRY_REPLAY_H__
+
+#include "telemetry_recorder.hpp"
+#include "vehicle_parameters.hpp"
+
+typedef struct ReplayMismatch_S
+{
+    uint64_t        cycle;
+    double          time_s;
+    const char*     field;
+    double          recorded;
+    double          replayed;
+} ReplayMismatch_S;
+
+class TelemetryReplay
+{
+    public:
+
+        /* Results */
+        uint64_t            cycles;
+        uint64_t            first_cycle;
+        uint64_t            compared;
+        uint64_t            mismatches;
+        double              recorded_duration_s;
+        ReplayMismatch_S    first_mismatch;
+
+        TelemetryReplay();
+        virtual ~TelemetryReplay();
+
+        /* Replays the whole log, true when every compared output matched */
+        bool Run(TelemetryReader& _reader);
+
+    protected:
+
+        /* Outputs are only compared once the replayed controller is known to be
+           in the recorded state, from the start unless the log lost its head */
+        bool                synchronized;
+        uint64_t            cycle;
+        double              time_s;
+
+        /* The recorded vehicle, the shipped one until its parameters are read */
+        VehicleParameters   vehicle;
+
+        virtual void OnParameter(const TelemetryParameter_S& _parameter);
+        virtual void OnState(const vanttec_uuv::VehicleState& _state);
+        virtual void OnSetpoint(const geometry_msgs::Twist& _setpoint, const vanttec_uuv::TraceInfo& _trace);
+        virtual void OnWaypoints(const vanttec_uuv::GuidanceWaypoints& _waypoints);
+        virtual void OnMasterStatus(const vanttec_uuv::MasterStatus& _status);
+        virtual void OnEmergencyStop();
+        virtual void OnObstacles(const vanttec_uuv::ObstacleList& _obstacles);
+        virtual void OnThrust(const vanttec_uuv::ThrustControl& _thrust);
+        virtual void OnPid(const TelemetryPid_S& _pid);
+        virtual void OnTick() = 0;
+
+        /* Bitwise, NaN only matches the same NaN */
+        void Compare(const char* _field, float _recorded, float _replayed);
+        void Compare(const char* _field, double _recorded, double _replayed);
+
+    private:
+
+        /* Lists spread over several records, handed over once complete */
+        vanttec_uuv::GuidanceWaypoints  pending_waypoints;
+        uint32_t                        pending_waypoint_records;
+        vanttec_uuv::ObstacleList       pending_obstacles;
+        uint32_t                        pending_obstacle_records;
+        double                          first_tick_s;
+
+        void Dispatch(const TelemetryRecord_S& _record);
+};
+
+#endif
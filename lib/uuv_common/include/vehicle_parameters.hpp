@@ -0,0 +1,134 @@
+/** ----------------------------------------------------------------------------
+ * @file: vehicle_parameters.hpp
+ *
+ * @brief: Vehicle parameter set loaded at startup, so hull variants do not
+ *         need a rebuild. Starts from the shipped vehicle and takes the
+ *         values found under a parameter server namespace or in a flat
+ *         YAML file, the same file rosparam can load:
+ *
+ *             mass: 13.37
+ *             X_uu: -45.808          # comments are allowed
+ *             Kpid_u: [7.5, 0.025, 0.4]
+ *
+ *         Names are the members below. Missing keys keep their value and
+ *         unknown keys are an error, so a typo does not go unnoticed. The
+ *         model and controller bind a set once when they are constructed.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __VEHICLE_PARAMETERS_H__
+#define __VEHICLE_PARAMETERS_H__
+
+#include "vtec_u3_gamma_parameters.hpp"
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+
+/* Namespace the nodes load the set from, and the prefix of its telemetry parameter names */
+const std::string VEHICLE_PARAMETERS_NAMESPACE = "vehicle";
+
+class VehicleParameters
+{
+    public:
+
+        /* Constants */
+
+        float rho;
+        float g;
+
+        /* Body Parameters */
+
+        float mass;
+        float volume;
+        float Ixx;
+        float Ixy;
+        float Ixz;
+        float Iyx;
+        float Iyy;
+        float Iyz;
+        float Izx;
+        float Izy;
+        float Izz;
+        float thruster_theta;
+        float b;
+        float l;
+        float weight;
+        float buoyancy;
+
+        /* Added Mass Parameters */
+
+        float X_u_dot;
+        float Y_v_dot;
+        float Z_w_dot;
+        float K_p_dot;
+        float M_q_dot;
+        float N_r_dot;
+
+        /* Damping Parameters */
+
+        float X_u;
+        float Y_v;
+        float Z_w;
+        float K_p;
+        float M_q;
+        float N_r;
+
+        float X_uu;
+        float Y_vv;
+        float Z_ww;
+        float K_pp;
+        float M_qq;
+        float N_rr;
+
+        /* Hardcoded Angles for Roll and Pitch */
+
+        float theta_b;
+        float phi_b;
+
+        /* Max Thrust Values for different DoFs */
+
+        float MAX_THRUST_SURGE;
+        float MAX_THRUST_SWAY;
+        float MAX_THRUST_HEAVE;
+        float MAX_THRUST_YAW;
+
+        /* Controller Tuned Constants */
+
+        float Kpid_u[3];
+        float Kpid_v[3];
+        float Kpid_z[3];
+        float Kpid_psi[3];
+
+        /* Why the last load, save or Set failed */
+        std::string error;
+
+        /* The shipped vehicle */
+        VehicleParameters();
+        ~VehicleParameters();
+
+        /* A scalar by name, an element of the gains as Kpid_u[1] */
+        bool Set(const std::string& _name, float _value);
+
+        bool LoadFile(const std::string& _path);
+
+        /* Every parameter in the format LoadFile reads, after the comment lines of _header */
+        bool SaveFile(const std::string& _path, const std::string& _header);
+
+        /* Keys are looked up relative to the namespace of the handle */
+        bool LoadParameterServer(const ros::NodeHandle& _nh);
+
+        /* Every scalar of the set in declaration order, to record or print it */
+        static size_t Count();
+        static std::string Name(size_t _index);
+        float Value(size_t _index) const;
+
+    private:
+
+        float* Find(const std::string& _name);
+        bool SetList(const std::string& _name, const std::vector<double>& _values);
+};
+
+#endif
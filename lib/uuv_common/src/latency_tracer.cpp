@@ -0,0 +1,157 @@
+/** ----------------------------------------------------------------------------
+ * @file: latency_tracer.cpp
+ *
+ * @brief: In-process latency tracer. Each node records, per stage, the age
+ *         of the traced sample behind what it outputs, into a log2 histogram
+ *         and a fixed ring of recent events that can be written as a Chrome
+ *         trace (chrome://tracing or Perfetto). Recording never allocates.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "latency_tracer.hpp"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+LatencyTracer::LatencyTracer(const char* _process_name, size_t _event_capacity) : events(_event_capacity)
+{
+    this->process_name = _process_name;
+    this->stages.reserve(MAX_LATENCY_STAGES);
+}
+
+LatencyTracer::~LatencyTracer(){}
+
+uint8_t LatencyTracer::AddStage(const char* _name)
+{
+    if (this->stages.size() >= MAX_LATENCY_STAGES)
+    {
+        return MAX_LATENCY_STAGES - 1;
+    }
+
+    LatencyStage_S stage;
+    std::memset(&stage, 0, sizeof(stage));
+    stage.name = _name;
+
+    this->stages.push_back(stage);
+    return this->stages.size() - 1;
+}
+
+void LatencyTracer::Record(uint8_t _stage, const vanttec_uuv::TraceInfo& _trace, const ros::Time& _now)
+{
+    if (_trace.origin_stamp.isZero())
+    {
+        return;
+    }
+
+    this->Record(_stage, _trace.trace_id, _trace.origin_stamp.toSec(), _now.toSec());
+}
+
+void LatencyTracer::Record(uint8_t _stage, uint64_t _trace_id, double _origin_s, double _end_s)
+{
+    if (_stage >= this->stages.size())
+    {
+        return;
+    }
+
+    LatencyStage_S& stage = this->stages[_stage];
+    double latency_us = std::max(0.0, (_end_s - _origin_s) * 1e6);
+
+    int bin = (latency_us < 1) ? 0 : (int) std::floor(std::log2(latency_us)) + 1;
+    stage.bins[std::min(bin, LATENCY_HISTOGRAM_BINS - 1)]++;
+    stage.count++;
+    stage.sum_us += latency_us;
+    stage.max_us = std::max(stage.max_us, latency_us);
+
+    TraceEvent_S event;
+    event.stage     = _stage;
+    event.trace_id  = _trace_id;
+    event.origin_s  = _origin_s;
+    event.end_s     = _end_s;
+
+    this->events.PushBack(event);
+}
+
+double LatencyTracer::Percentile(uint8_t _stage, double _fraction) const
+{
+    if (_stage >= this->stages.size() || this->stages[_stage].count == 0)
+    {
+        return 0;
+    }
+
+    const LatencyStage_S& stage = this->stages[_stage];
+    uint64_t target = (uint64_t) std::ceil(_fraction * stage.count);
+    uint64_t accumulated = 0;
+
+    for (int i = 0; i < LATENCY_HISTOGRAM_BINS; i++)
+    {
+        accumulated += stage.bins[i];
+
+        if (accumulated >= target)
+        {
+            return std::min(std::ldexp(1.0, i), stage.max_us);
+        }
+    }
+
+    return stage.max_us;
+}
+
+void LatencyTracer::LogSummary() const
+{
+    for (uint8_t i = 0; i < this->stages.size(); i++)
+    {
+        const LatencyStage_S& stage = this->stages[i];
+
+        if (stage.count == 0)
+        {
+            continue;
+        }
+
+        ROS_INFO("%s %s: %lu samples, mean %.2f ms, p50 < %.2f ms, p99 < %.2f ms, max %.2f ms",
+                 this->process_name, stage.name, (unsigned long) stage.count,
+                 stage.sum_us / stage.count / 1000, this->Percentile(i, 0.5) / 1000,
+                 this->Percentile(i, 0.99) / 1000, stage.max_us / 1000);
+    }
+}
+
+bool LatencyTracer::DumpChromeTrace(const std::string& _path) const
+{
+    FILE* file = std::fopen(_path.c_str(), "w");
+
+    if (file == NULL)
+    {
+        ROS_ERROR("Latency tracer: could not open %s", _path.c_str());
+        return false;
+    }
+
+    /* One process per node and one thread per stage, timestamps are absolute so traces of several nodes line up */
+    int pid = getpid();
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"%s\"}}",
+                 pid, this->process_name);
+
+    for (uint8_t i = 0; i < this->stages.size(); i++)
+    {
+        std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                     pid, i, this->stages[i].name);
+    }
+
+    for (size_t i = 0; i < this->events.Size(); i++)
+    {
+        const TraceEvent_S& event = this->events[i];
+
+        std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"latency\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+                           "\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"trace_id\":%llu}}",
+                     this->stages[event.stage].name, pid, event.stage, event.origin_s * 1e6,
+                     std::max(0.0, event.end_s - event.origin_s) * 1e6, (unsigned long long) event.trace_id);
+    }
+
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+
+    ROS_INFO("Latency tracer: %lu events written to %s", (unsigned long) this->events.Size(), _path.c_str());
+    return true;
+}
@@ -0,0 +1,603 @@
+/** ----------------------------------------------------------------------------
+ * @file: telemetry_recorder.cpp
+ *
+ * @brief: In-process telemetry recorder. Records are 128 bytes with a fixed
+ *         layout per type, written into a ring of segment files that are
+ *         created, allocated and memory mapped when the recorder is opened.
+ *         Recording is a copy into the mapping and moving to the next
+ *         segment only switches pointers, so the loops never allocate or
+ *         make system calls; the kernel writes the pages back on its own.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "telemetry_recorder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void CopyString(char* _destination, size_t _size, const std::string& _source)
+{
+    size_t length = std::min(_source.size(), _size - 1);
+    std::memcpy(_destination, _source.c_str(), length);
+    _destination[length] = '\0';
+}
+
+/********** Recorder ***********/
+
+TelemetryRecorder::TelemetryRecorder()
+{
+    this->error             = NULL;
+    this->records           = 0;
+    this->rotations         = 0;
+    this->segment_size      = 0;
+    this->current_segment   = 0;
+    this->header            = NULL;
+    this->slots             = NULL;
+    this->parameter_count   = 0;
+}
+
+TelemetryRecorder::~TelemetryRecorder()
+{
+    this->Close();
+}
+
+bool TelemetryRecorder::Open(const std::string& _directory, const std::string& _source,
+                             uint64_t _records_per_segment, uint32_t _segment_count)
+{
+    this->Close();
+
+    if (_records_per_segment == 0 || _segment_count == 0)
+    {
+        this->error = "the ring needs at least one record and one segment";
+        return false;
+    }
+
+    if (mkdir(_directory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        this->error = "could not create the telemetry directory";
+        return false;
+    }
+
+    this->segment_size = sizeof(TelemetrySegmentHeader_S) + _records_per_segment * sizeof(TelemetryRecord_S);
+
+    for (uint32_t i = 0; i < _segment_count; i++)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "_%u.tlm", i);
+        std::string path = _directory + "/" + _source + name;
+
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0)
+        {
+            this->error = "could not create a segment file";
+            this->Close();
+            return false;
+        }
+
+        /* Reserve the blocks now, a full disk shows up here and not as a fault in the loop */
+        if (posix_fallocate(fd, 0, this->segment_size) != 0)
+        {
+            close(fd);
+            this->error = "could not allocate a segment file";
+            this->Close();
+            return false;
+        }
+
+        void* mapping = mmap(NULL, this->segment_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+
+        /* The mapping keeps its own reference to the file */
+        close(fd);
+
+        if (mapping == MAP_FAILED)
+        {
+            this->error = "could not map a segment file";
+            this->Close();
+            return false;
+        }
+
+        this->segments.push_back(mapping);
+
+        TelemetrySegmentHeader_S* segment_header = (TelemetrySegmentHeader_S*) mapping;
+
+        std::memset(segment_header, 0, sizeof(TelemetrySegmentHeader_S));
+        std::memcpy(segment_header->magic, TELEMETRY_FILE_MAGIC, sizeof(TELEMETRY_FILE_MAGIC));
+        segment_header->version          = TELEMETRY_FILE_VERSION;
+        segment_header->header_size      = sizeof(TelemetrySegmentHeader_S);
+        segment_header->record_size      = sizeof(TelemetryRecord_S);
+        segment_header->record_capacity  = _records_per_segment;
+        CopyString(segment_header->source, sizeof(segment_header->source), _source);
+    }
+
+    /* Generation 0 marks the segments that have not been written yet */
+    this->current_segment       = 0;
+    this->header                = (TelemetrySegmentHeader_S*) this->segments[0];
+    this->header->generation    = 1;
+    this->slots                 = (TelemetryRecord_S*) ((char*) this->segments[0] + sizeof(TelemetrySegmentHeader_S));
+    this->error                 = NULL;
+
+    return true;
+}
+
+void TelemetryRecorder::Close()
+{
+    for (size_t i = 0; i < this->segments.size(); i++)
+    {
+        munmap(this->segments[i], this->segment_size);
+    }
+
+    this->segments.clear();
+    this->segment_size      = 0;
+    this->current_segment   = 0;
+    this->header            = NULL;
+    this->slots             = NULL;
+    this->parameter_count   = 0;
+}
+
+bool TelemetryRecorder::IsOpen() const
+{
+    return this->header != NULL;
+}
+
+TelemetryRecord_S* TelemetryRecorder::Next(TelemetryRecordType_E _type, double _time_s)
+{
+    TelemetryRecord_S* record;
+
+    if (this->header == NULL)
+    {
+        record = &this->discard;
+    }
+    else
+    {
+        if (this->header->record_count == this->header->record_capacity)
+        {
+            this->Rotate();
+        }
+
+        record = &this->slots[this->header->record_count];
+    }
+
+    std::memset(record->payload, 0, sizeof(record->payload));
+    record->type        = _type;
+    record->reserved    = 0;
+    record->sequence    = (uint32_t) this->records;
+    record->time_s      = _time_s;
+
+    return record;
+}
+
+void TelemetryRecorder::Commit()
+{
+    if (this->header == NULL)
+    {
+        return;
+    }
+
+    /* Readers of a live segment only see records that are complete */
+    __atomic_store_n(&this->header->record_count, this->header->record_count + 1, __ATOMIC_RELEASE);
+    this->records++;
+}
+
+void TelemetryRecorder::Rotate()
+{
+    uint64_t generation = this->header->generation;
+
+    this->current_segment   = (this->current_segment + 1) % this->segments.size();
+    this->header            = (TelemetrySegmentHeader_S*) this->segments[this->current_segment];
+    this->slots             = (TelemetryRecord_S*) ((char*) this->header + sizeof(TelemetrySegmentHeader_S));
+
+    /* The oldest segment is emptied before it takes the new generation */
+    __atomic_store_n(&this->header->record_count, (uint64_t) 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&this->header->generation, generation + 1, __ATOMIC_RELEASE);
+
+    this->rotations++;
+
+    /* Always leaves room for the record that caused the rotation */
+    for (uint32_t i = 0; i < this->parameter_count && this->header->record_count + 1 < this->header->record_capacity; i++)
+    {
+        this->slots[this->header->record_count]             = this->parameters[i];
+        this->slots[this->header->record_count].sequence    = (uint32_t) this->records;
+        this->Commit();
+    }
+}
+
+void TelemetryRecorder::KeepParameter(const TelemetryRecord_S& _record)
+{
+    for (uint32_t i = 0; i < this->parameter_count; i++)
+    {
+        if (std::strncmp(this->parameters[i].parameter.name, _record.parameter.name, sizeof(_record.parameter.name)) == 0)
+        {
+            this->parameters[i] = _record;
+            return;
+        }
+    }
+
+    if (this->parameter_count < TELEMETRY_MAX_PARAMETERS)
+    {
+        this->parameters[this->parameter_count++] = _record;
+    }
+}
+
+void TelemetryRecorder::RecordTick(double _time_s, uint64_t _cycle)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_TICK, _time_s);
+
+    record->tick.cycle = _cycle;
+
+    this->Commit();
+}
+
+void TelemetryRecorder::RecordState(double _time_s, const vanttec_uuv::VehicleState& _state)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_STATE, _time_s);
+
+    record->state.x         = _state.x;
+    record->state.y         = _state.y;
+    record->state.z         = _state.z;
+    record->state.roll      = _state.roll;
+    record->state.pitch     = _state.pitch;
+    record->state.yaw       = _state.yaw;
+    record->state.u         = _state.u;
+    record->state.v         = _state.v;
+    record->state.w         = _state.w;
+    record->state.p         = _state.p;
+    record->state.q         = _state.q;
+    record->state.r         = _state.r;
+    record->state.u_dot     = _state.u_dot;
+    record->state.v_dot     = _state.v_dot;
+    record->state.w_dot     = _state.w_dot;
+    record->state.p_dot     = _state.p_dot;
+    record->state.q_dot     = _state.q_dot;
+    record->state.r_dot     = _state.r_dot;
+    record->state.sequence  = _state.sequence;
+    record->state.trace_id  = _state.trace.trace_id;
+    record->state.origin_s  = _state.trace.origin_stamp.toSec();
+
+    this->Commit();
+}
+
+void TelemetryRecorder::RecordSetpoint(double _time_s, const geometry_msgs::Twist& _setpoint, const vanttec_uuv::TraceInfo& _trace)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_SETPOINT, _time_s);
+
+    record->setpoint.linear_x   = _setpoint.linear.x;
+    record->setpoint.linear_y   = _setpoint.linear.y;
+    record->setpoint.linear_z   = _setpoint.linear.z;
+    record->setpoint.angular_x  = _setpoint.angular.x;
+    record->setpoint.angular_y  = _setpoint.angular.y;
+    record->setpoint.angular_z  = _setpoint.angular.z;
+    record->setpoint.trace_id   = _trace.trace_id;
+    record->setpoint.origin_s   = _trace.origin_stamp.toSec();
+
+    this->Commit();
+}
+
+void TelemetryRecorder::RecordThrust(double _time_s, const vanttec_uuv::ThrustControl& _thrust)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_THRUST, _time_s);
+
+    record->thrust.tau_x    = _thrust.tau_x;
+    record->thrust.tau_y    = _thrust.tau_y;
+    record->thrust.tau_z    = _thrust.tau_z;
+    record->thrust.tau_yaw  = _thrust.tau_yaw;
+    record->thrust.trace_id = _thrust.trace.trace_id;
+    record->thrust.origin_s = _thrust.trace.origin_stamp.toSec();
+
+    this->Commit();
+}
+
+void TelemetryRecorder::RecordWaypoints(double _time_s, const vanttec_uuv::GuidanceWaypoints& _waypoints)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_WAYPOINT_LIST, _time_s);
+
+    record->waypoint_list.guidance_law              = _waypoints.guidance_law;
+    record->waypoint_list.waypoint_list_length      = _waypoints.waypoint_list_length;
+    record->waypoint_list.sequence                  = _waypoints.sequence;
+    record->waypoint_list.x_count                   = _waypoints.waypoint_list_x.size();
+    record->waypoint_list.y_count                   = _waypoints.waypoint_list_y.size();
+    record->waypoint_list.z_count                   = _waypoints.waypoint_list_z.size();
+    record->waypoint_list.speed_count               = _waypoints.waypoint_list_speed.size();
+    record->waypoint_list.acceptance_radius_count   = _waypoints.waypoint_list_acceptance_radius.size();
+
+    this->Commit();
+
+    /* One record per index of the longest array, missing entries are left at zero */
+    size_t count = std::max(std::max(_waypoints.waypoint_list_x.size(), _waypoints.waypoint_list_y.size()),
+                            std::max(_waypoints.waypoint_list_z.size(),
+                                     std::max(_waypoints.waypoint_list_speed.size(),
+                                              _waypoints.waypoint_list_acceptance_radius.size())));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        record = this->Next(TELEMETRY_WAYPOINT, _time_s);
+
+        record->waypoint.index = i;
+
+        if (i < _waypoints.waypoint_list_x.size())
+        {
+            record->waypoint.x = _waypoints.waypoint_list_x[i];
+        }
+        if (i < _waypoints.waypoint_list_y.size())
+        {
+            record->waypoint.y = _waypoints.waypoint_list_y[i];
+        }
+        if (i < _waypoints.waypoint_list_z.size())
+        {
+            record->waypoint.z = _waypoints.waypoint_list_z[i];
+        }
+        if (i < _waypoints.waypoint_list_speed.size())
+        {
+            record->waypoint.speed = _waypoints.waypoint_list_speed[i];
+        }
+        if (i < _waypoints.waypoint_list_acceptance_radius.size())
+        {
+            record->waypoint.acceptance_radius = _waypoints.waypoint_list_acceptance_radius[i];
+        }
+
+        this->Commit();
+    }
+}
+
+void TelemetryRecorder::RecordMasterStatus(double _time_s, const vanttec_uuv::MasterStatus& _status)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_MASTER_STATUS, _time_s);
+
+    record->master_status.status            = _status.status;
+    record->master_status.desired_routine   = _status.desired_routine;
+
+    this->Commit();
+}
+
+void TelemetryRecorder::RecordEmergencyStop(double _time_s)
+{
+    this->Next(TELEMETRY_EMERGENCY_STOP, _time_s);
+    this->Commit();
+}
+
+void TelemetryRecorder::RecordObstacles(double _time_s, const vanttec_uuv::ObstacleList& _obstacles)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_OBSTACLE_LIST, _time_s);
+
+    record->obstacle_list.count = _obstacles.obstacles.size();
+    CopyString(record->obstacle_list.frame_id, sizeof(record->obstacle_list.frame_id), _obstacles.header.frame_id);
+
+    this->Commit();
+
+    for (size_t i = 0; i < _obstacles.obstacles.size(); i++)
+    {
+        const vanttec_uuv::Obstacle& obstacle = _obstacles.obstacles[i];
+
+        record = this->Next(TELEMETRY_OBSTACLE, _time_s);
+
+        record->obstacle.x             = obstacle.pose.position.x;
+        record->obstacle.y             = obstacle.pose.position.y;
+        record->obstacle.z             = obstacle.pose.position.z;
+        record->obstacle.orientation_z = obstacle.pose.orientation.z;
+        record->obstacle.orientation_w = obstacle.pose.orientation.w;
+        record->obstacle.radio         = obstacle.radio;
+        record->obstacle.height        = obstacle.height;
+        record->obstacle.length        = obstacle.length;
+        CopyString(record->obstacle.obstacle_class, sizeof(record->obstacle.obstacle_class), obstacle.obstacle_class);
+
+        this->Commit();
+    }
+}
+
+void TelemetryRecorder::RecordParameter(double _time_s, const char* _name, double _value)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_PARAMETER, _time_s);
+
+    CopyString(record->parameter.name, sizeof(record->parameter.name), _name);
+    record->parameter.value = _value;
+
+    this->KeepParameter(*record);
+    this->Commit();
+}
+
+void TelemetryRecorder::RecordParameter(double _time_s, const char* _name, const std::string& _text)
+{
+    TelemetryRecord_S* record = this->Next(TELEMETRY_PARAMETER, _time_s);
+
+    CopyString(record->parameter.name, sizeof(record->parameter.name), _name);
+    CopyString(record->parameter.text, sizeof(record->parameter.text), _text);
+
+    this->KeepParameter(*record);
+    this->Commit();
+}
+
+/********** Reader ***********/
+
+TelemetryReader::TelemetryReader()
+{
+    this->error             = NULL;
+    this->current_segment   = 0;
+    this->current_record    = 0;
+}
+
+TelemetryReader::~TelemetryReader()
+{
+    this->Close();
+}
+
+bool TelemetryReader::Open(const std::vector<std::string>& _paths)
+{
+    this->Close();
+    this->error = NULL;
+
+    for (size_t i = 0; i < _paths.size(); i++)
+    {
+        int fd = open(_paths[i].c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            this->error = "could not open a segment file";
+            this->Close();
+            return false;
+        }
+
+        struct stat file_stat;
+
+        if (fstat(fd, &file_stat) != 0 || (size_t) file_stat.st_size < sizeof(TelemetrySegmentHeader_S))
+        {
+            close(fd);
+            this->error = "file too short for a segment header";
+            this->Close();
+            return false;
+        }
+
+        void* mapping = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        /* The mapping keeps its own reference to the file */
+        close(fd);
+
+        if (mapping == MAP_FAILED)
+        {
+            this->error = "could not map a segment file";
+            this->Close();
+            return false;
+        }
+
+        TelemetrySegment_S segment;
+        segment.header  = (const TelemetrySegmentHeader_S*) mapping;
+        segment.records = (const TelemetryRecord_S*) ((const char*) mapping + sizeof(TelemetrySegmentHeader_S));
+        segment.size    = file_stat.st_size;
+
+        /* Kept before validating so Close unmaps it */
+        this->segments.push_back(segment);
+
+        if (std::memcmp(segment.header->magic, TELEMETRY_FILE_MAGIC, sizeof(TELEMETRY_FILE_MAGIC)) != 0)
+        {
+            this->error = "not a telemetry segment";
+        }
+        else if (segment.header->version != TELEMETRY_FILE_VERSION ||
+                 segment.header->header_size != sizeof(TelemetrySegmentHeader_S) ||
+                 segment.header->record_size != sizeof(TelemetryRecord_S))
+        {
+            this->error = "unsupported telemetry segment version";
+        }
+        else if (segment.header->record_count > segment.header->record_capacity ||
+                 segment.header->record_capacity > (segment.size - sizeof(TelemetrySegmentHeader_S)) / sizeof(TelemetryRecord_S))
+        {
+            this->error = "telemetry segment is truncated";
+        }
+        else if (i > 0 && std::strncmp(segment.header->source, this->segments[0].header->source, sizeof(segment.header->source)) != 0)
+        {
+            this->error = "segments come from different sources";
+        }
+
+        if (this->error != NULL)
+        {
+            this->Close();
+            return false;
+        }
+
+        madvise(mapping, segment.size, MADV_SEQUENTIAL);
+    }
+
+    if (!this->segments.empty())
+    {
+        const char* name = this->segments[0].header->source;
+        this->source.assign(name, strnlen(name, sizeof(this->segments[0].header->source)));
+    }
+
+    std::sort(this->segments.begin(), this->segments.end(),
+              [](const TelemetrySegment_S& _a, const TelemetrySegment_S& _b)
+              {
+                  return _a.header->generation < _b.header->generation;
+              });
+
+    this->Rewind();
+
+    return true;
+}
+
+void TelemetryReader::Close()
+{
+    for (size_t i = 0; i < this->segments.size(); i++)
+    {
+        munmap((void*) this->segments[i].header, this->segments[i].size);
+    }
+
+    this->segments.clear();
+    this->source.clear();
+    this->current_segment   = 0;
+    this->current_record    = 0;
+}
+
+const TelemetryRecord_S* TelemetryReader::Next()
+{
+    while (this->current_segment < this->segments.size())
+    {
+        const TelemetrySegment_S& segment = this->segments[this->current_segment];
+
+        /* Segments never written have generation 0 and no records */
+        if (segment.header->generation != 0 && this->current_record < segment.header->record_count)
+        {
+            return &segment.records[this->current_record++];
+        }
+
+        this->current_segment++;
+        this->current_record = 0;
+    }
+
+    return NULL;
+}
+
+void TelemetryReader::Rewind()
+{
+    this->current_segment   = 0;
+    this->current_record    = 0;
+}
+
+static bool AddSegment(const std::string& _path, std::map<std::string, std::vector<std::string> >* _logs)
+{
+    size_t extension = _path.rfind(".tlm");
+    size_t separator = _path.rfind('_');
+
+    if (extension == std::string::npos || extension + 4 != _path.size() ||
+        separator == std::string::npos || separator > extension)
+    {
+        return false;
+    }
+
+    (*_logs)[_path.substr(0, separator)].push_back(_path);
+    return true;
+}
+
+bool TelemetryReader::FindLogs(const std::string& _path, std::map<std::string, std::vector<std::string> >* _logs)
+{
+    struct stat path_stat;
+
+    if (stat(_path.c_str(), &path_stat) != 0)
+    {
+        return false;
+    }
+
+    if (!S_ISDIR(path_stat.st_mode))
+    {
+        return AddSegment(_path, _logs);
+    }
+
+    DIR* directory = opendir(_path.c_str());
+
+    if (directory == NULL)
+    {
+        return false;
+    }
+
+    for (struct dirent* entry = readdir(directory); entry != NULL; entry = readdir(directory))
+    {
+        AddSegment(_path + "/" + entry->d_name, _logs);
+    }
+
+    closedir(directory);
+    return true;
+}
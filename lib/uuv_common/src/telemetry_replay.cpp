@@ -0,0 +1,340 @@
+/** ----------------------------------------------------------------------------
+ * @file: telemetry_replay.cpp
+ *
+ * @brief: Offline replay of a node from its telemetry. The recorded inputs
+ *         are handed to the node's controller in the order its callbacks saw
+ *         them, the controller is stepped at every tick record, and the
+ *         outputs recorded after the tick are compared bit for bit with the
+ *         ones the replayed controller produces.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "telemetry_replay.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+TelemetryReplay::TelemetryReplay()
+{
+    this->cycles                    = 0;
+    this->first_cycle               = 0;
+    this->compared                  = 0;
+    this->mismatches                = 0;
+    this->recorded_duration_s       = 0;
+    std::memset(&this->first_mismatch, 0, sizeof(this->first_mismatch));
+
+    this->synchronized              = false;
+    this->cycle                     = 0;
+    this->time_s                    = 0;
+    this->first_tick_s              = 0;
+    this->pending_waypoint_records  = 0;
+    this->pending_obstacle_records  = 0;
+}
+
+TelemetryReplay::~TelemetryReplay(){}
+
+bool TelemetryReplay::Run(TelemetryReader& _reader)
+{
+    _reader.Rewind();
+
+    for (const TelemetryRecord_S* record = _reader.Next(); record != NULL; record = _reader.Next())
+    {
+        this->time_s = record->time_s;
+        this->Dispatch(*record);
+    }
+
+    return this->mismatches == 0;
+}
+
+void TelemetryReplay::Dispatch(const TelemetryRecord_S& _record)
+{
+    switch ((TelemetryRecordType_E) _record.type)
+    {
+        case TELEMETRY_TICK:
+        {
+            if (this->cycles == 0)
+            {
+                /* A log that starts at the first cycle has the whole history of the node */
+                this->first_cycle   = _record.tick.cycle;
+                this->first_tick_s  = _record.time_s;
+                this->synchronized  = (_record.tick.cycle == 0);
+            }
+
+            /* Parameters repeated at the start of the segments keep their original time */
+            this->recorded_duration_s = _record.time_s - this->first_tick_s;
+
+            this->cycle = _record.tick.cycle;
+            this->cycles++;
+
+            /* Stamps set by the controllers take the recorded time */
+            if (_record.time_s > 0)
+            {
+                ros::Time::setNow(ros::Time(_record.time_s));
+            }
+
+            this->OnTick();
+            break;
+        }
+        case TELEMETRY_STATE:
+        {
+            const TelemetryState_S& record = _record.state;
+            vanttec_uuv::VehicleState state;
+
+            state.x                     = record.x;
+            state.y                     = record.y;
+            state.z                     = record.z;
+            state.roll                  = record.roll;
+            state.pitch                 = record.pitch;
+            state.yaw                   = record.yaw;
+            state.u                     = record.u;
+            state.v                     = record.v;
+            state.w                     = record.w;
+            state.p                     = record.p;
+            state.q                     = record.q;
+            state.r                     = record.r;
+            state.u_dot                 = record.u_dot;
+            state.v_dot                 = record.v_dot;
+            state.w_dot                 = record.w_dot;
+            state.p_dot                 = record.p_dot;
+            state.q_dot                 = record.q_dot;
+            state.r_dot                 = record.r_dot;
+            state.sequence              = record.sequence;
+            state.trace.trace_id        = record.trace_id;
+            state.trace.origin_stamp    = ros::Time(record.origin_s);
+
+            this->OnState(state);
+            break;
+        }
+        case TELEMETRY_SETPOINT:
+        {
+            const TelemetrySetpoint_S& record = _record.setpoint;
+            geometry_msgs::Twist setpoint;
+            vanttec_uuv::TraceInfo trace;
+
+            setpoint.linear.x       = record.linear_x;
+            setpoint.linear.y       = record.linear_y;
+            setpoint.linear.z       = record.linear_z;
+            setpoint.angular.x      = record.angular_x;
+            setpoint.angular.y      = record.angular_y;
+            setpoint.angular.z      = record.angular_z;
+            trace.trace_id          = record.trace_id;
+            trace.origin_stamp      = ros::Time(record.origin_s);
+
+            this->OnSetpoint(setpoint, trace);
+            break;
+        }
+        case TELEMETRY_THRUST:
+        {
+            const TelemetryThrust_S& record = _record.thrust;
+            vanttec_uuv::ThrustControl thrust;
+
+            thrust.tau_x                = record.tau_x;
+            thrust.tau_y                = record.tau_y;
+            thrust.tau_z                = record.tau_z;
+            thrust.tau_yaw              = record.tau_yaw;
+            thrust.trace.trace_id       = record.trace_id;
+            thrust.trace.origin_stamp   = ros::Time(record.origin_s);
+
+            this->OnThrust(thrust);
+            break;
+        }
+        case TELEMETRY_PID:
+            this->OnPid(_record.pid);
+            break;
+        case TELEMETRY_WAYPOINT_LIST:
+        {
+            const TelemetryWaypointList_S& record = _record.waypoint_list;
+
+            /* A list cut short by the start of the log is dropped with its records */
+            this->pending_waypoints.guidance_law            = record.guidance_law;
+            this->pending_waypoints.waypoint_list_length    = record.waypoint_list_length;
+            this->pending_waypoints.sequence                = record.sequence;
+            this->pending_waypoints.waypoint_list_x.assign(record.x_count, 0);
+            this->pending_waypoints.waypoint_list_y.assign(record.y_count, 0);
+            this->pending_waypoints.waypoint_list_z.assign(record.z_count, 0);
+            this->pending_waypoints.waypoint_list_speed.assign(record.speed_count, 0);
+            this->pending_waypoints.waypoint_list_acceptance_radius.assign(record.acceptance_radius_count, 0);
+
+            this->pending_waypoint_records = std::max(std::max(record.x_count, record.y_count),
+                                                      std::max(record.z_count,
+                                                               std::max(record.speed_count, record.acceptance_radius_count)));
+
+            if (this->pending_waypoint_records == 0)
+            {
+                this->OnWaypoints(this->pending_waypoints);
+            }
+            break;
+        }
+        case TELEMETRY_WAYPOINT:
+        {
+            const TelemetryWaypoint_S& record = _record.waypoint;
+            vanttec_uuv::GuidanceWaypoints& waypoints = this->pending_waypoints;
+
+            if (this->pending_waypoint_records == 0)
+            {
+                break;
+            }
+
+            if (record.index < waypoints.waypoint_list_x.size())
+            {
+                waypoints.waypoint_list_x[record.index] = record.x;
+            }
+            if (record.index < waypoints.waypoint_list_y.size())
+            {
+                waypoints.waypoint_list_y[record.index] = record.y;
+            }
+            if (record.index < waypoints.waypoint_list_z.size())
+            {
+                waypoints.waypoint_list_z[record.index] = record.z;
+            }
+            if (record.index < waypoints.waypoint_list_speed.size())
+            {
+                waypoints.waypoint_list_speed[record.index] = record.speed;
+            }
+            if (record.index < waypoints.waypoint_list_acceptance_radius.size())
+            {
+                waypoints.waypoint_list_acceptance_radius[record.index] = record.acceptance_radius;
+            }
+
+            this->pending_waypoint_records--;
+
+            if (this->pending_waypoint_records == 0)
+            {
+                this->OnWaypoints(waypoints);
+            }
+            break;
+        }
+        case TELEMETRY_MASTER_STATUS:
+        {
+            vanttec_uuv::MasterStatus status;
+
+            status.status           = _record.master_status.status;
+            status.desired_routine  = _record.master_status.desired_routine;
+
+            this->OnMasterStatus(status);
+            break;
+        }
+        case TELEMETRY_EMERGENCY_STOP:
+            this->OnEmergencyStop();
+            break;
+        case TELEMETRY_OBSTACLE_LIST:
+        {
+            const TelemetryObstacleList_S& record = _record.obstacle_list;
+
+            this->pending_obstacles.header.frame_id.assign(record.frame_id, strnlen(record.frame_id, sizeof(record.frame_id)));
+            this->pending_obstacles.obstacles.clear();
+            this->pending_obstacle_records = record.count;
+
+            if (this->pending_obstacle_records == 0)
+            {
+                this->OnObstacles(this->pending_obstacles);
+            }
+            break;
+        }
+        case TELEMETRY_OBSTACLE:
+        {
+            const TelemetryObstacle_S& record = _record.obstacle;
+            vanttec_uuv::Obstacle obstacle;
+
+            if (this->pending_obstacle_records == 0)
+            {
+                break;
+            }
+
+            obstacle.pose.position.x    = record.x;
+            obstacle.pose.position.y    = record.y;
+            obstacle.pose.position.z    = record.z;
+            obstacle.pose.orientation.z = record.orientation_z;
+            obstacle.pose.orientation.w = record.orientation_w;
+            obstacle.radio              = record.radio;
+            obstacle.height             = record.height;
+            obstacle.length             = record.length;
+            obstacle.obstacle_class.assign(record.obstacle_class, strnlen(record.obstacle_class, sizeof(record.obstacle_class)));
+
+            this->pending_obstacles.obstacles.push_back(obstacle);
+            this->pending_obstacle_records--;
+
+            if (this->pending_obstacle_records == 0)
+            {
+                this->OnObstacles(this->pending_obstacles);
+            }
+            break;
+        }
+        case TELEMETRY_PARAMETER:
+        {
+            const TelemetryParameter_S& record = _record.parameter;
+            std::string name(record.name, strnlen(record.name, sizeof(record.name)));
+            std::string prefix = VEHICLE_PARAMETERS_NAMESPACE + "/";
+
+            if (name.compare(0, prefix.size(), prefix) == 0)
+            {
+                this->vehicle.Set(name.substr(prefix.size()), record.value);
+            }
+
+            this->OnParameter(record);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void TelemetryReplay::Compare(const char* _field, float _recorded, float _replayed)
+{
+    if (!this->synchronized)
+    {
+        return;
+    }
+
+    this->compared++;
+
+    if (std::memcmp(&_recorded, &_replayed, sizeof(float)) != 0)
+    {
+        if (this->mismatches == 0)
+        {
+            this->first_mismatch.cycle      = this->cycle;
+            this->first_mismatch.time_s     = this->time_s;
+            this->first_mismatch.field      = _field;
+            this->first_mismatch.recorded   = _recorded;
+            this->first_mismatch.replayed   = _replayed;
+        }
+
+        this->mismatches++;
+    }
+}
+
+void TelemetryReplay::Compare(const char* _field, double _recorded, double _replayed)
+{
+    if (!this->synchronized)
+    {
+        return;
+    }
+
+    this->compared++;
+
+    if (std::memcmp(&_recorded, &_replayed, sizeof(double)) != 0)
+    {
+        if (this->mismatches == 0)
+        {
+            this->first_mismatch.cycle      = this->cycle;
+            this->first_mismatch.time_s     = this->time_s;
+            this->first_mismatch.field      = _field;
+            this->first_mismatch.recorded   = _recorded;
+            this->first_mismatch.replayed   = _replayed;
+        }
+
+        this->mismatches++;
+    }
+}
+
+/* Records a replay has no use for are ignored */
+
+void TelemetryReplay::OnParameter(const TelemetryParameter_S& _parameter){}
+void TelemetryReplay::OnState(const vanttec_uuv::VehicleState& _state){}
+void TelemetryReplay::OnSetpoint(const geometry_msgs::Twist& _setpoint, const vanttec_uuv::TraceInfo& _trace){}
+void TelemetryReplay::OnWaypoints(const vanttec_uuv::GuidanceWaypoints& _waypoints){}
+void TelemetryReplay::OnMasterStatus(const vanttec_uuv::MasterStatus& _status){}
+void TelemetryReplay::OnEmergencyStop(){}
+void TelemetryReplay::OnObstacles(const vanttec_uuv::ObstacleList& _obstacles){}
+void TelemetryReplay::OnThrust(const vanttec_uuv::ThrustControl& _thrust){}
+void TelemetryReplay::OnPid(const TelemetryPid_S& _pid){}
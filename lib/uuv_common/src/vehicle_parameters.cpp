@@ -0,0 +1,607 @@
+/** ----------------------------------------------------------------------------
+ * @file: vehicle_parameters.cpp
+ *
+ * @brief: Vehicle parameter set loaded at startup, from a parameter server
+ *         namespace or a flat YAML file, starting from the shipped vehicle.
+ *         Written back in the same format by the tools that estimate it.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "vehicle_parameters.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+/* Definitions of the shipped vehicle, the templates bind them by reference */
+
+constexpr float VtecU3GammaParameters::rho;
+constexpr float VtecU3GammaParameters::g;
+constexpr float VtecU3GammaParameters::mass;
+constexpr float VtecU3GammaParameters::volume;
+constexpr float VtecU3GammaParameters::Ixx;
+constexpr float VtecU3GammaParameters::Ixy;
+constexpr float VtecU3GammaParameters::Ixz;
+constexpr float VtecU3GammaParameters::Iyx;
+constexpr float VtecU3GammaParameters::Iyy;
+constexpr float VtecU3GammaParameters::Iyz;
+constexpr float VtecU3GammaParameters::Izx;
+constexpr float VtecU3GammaParameters::Izy;
+constexpr float VtecU3GammaParameters::Izz;
+constexpr float VtecU3GammaParameters::thruster_theta;
+constexpr float VtecU3GammaParameters::b;
+constexpr float VtecU3GammaParameters::l;
+constexpr float VtecU3GammaParameters::weight;
+constexpr float VtecU3GammaParameters::buoyancy;
+constexpr float VtecU3GammaParameters::X_u_dot;
+constexpr float VtecU3GammaParameters::Y_v_dot;
+constexpr float VtecU3GammaParameters::Z_w_dot;
+constexpr float VtecU3GammaParameters::K_p_dot;
+constexpr float VtecU3GammaParameters::M_q_dot;
+constexpr float VtecU3GammaParameters::N_r_dot;
+constexpr float VtecU3GammaParameters::X_u;
+constexpr float VtecU3GammaParameters::Y_v;
+constexpr float VtecU3GammaParameters::Z_w;
+constexpr float VtecU3GammaParameters::K_p;
+constexpr float VtecU3GammaParameters::M_q;
+constexpr float VtecU3GammaParameters::N_r;
+constexpr float VtecU3GammaParameters::X_uu;
+constexpr float VtecU3GammaParameters::Y_vv;
+constexpr float VtecU3GammaParameters::Z_ww;
+constexpr float VtecU3GammaParameters::K_pp;
+constexpr float VtecU3GammaParameters::M_qq;
+constexpr float VtecU3GammaParameters::N_rr;
+constexpr float VtecU3GammaParameters::theta_b;
+constexpr float VtecU3GammaParameters::phi_b;
+constexpr float VtecU3GammaParameters::MAX_THRUST_SURGE;
+constexpr float VtecU3GammaParameters::MAX_THRUST_SWAY;
+constexpr float VtecU3GammaParameters::MAX_THRUST_HEAVE;
+constexpr float VtecU3GammaParameters::MAX_THRUST_YAW;
+constexpr float VtecU3GammaParameters::Kpid_u[3];
+constexpr float VtecU3GammaParameters::Kpid_v[3];
+constexpr float VtecU3GammaParameters::Kpid_z[3];
+constexpr float VtecU3GammaParameters::Kpid_psi[3];
+
+/* Scalars point at their member, the gains at their array */
+
+typedef struct VehicleParameterField_S
+{
+    const char*                     name;
+    float VehicleParameters::*      value;
+    float (VehicleParameters::*     gains)[3];
+} VehicleParameterField_S;
+
+static const VehicleParameterField_S VEHICLE_PARAMETER_FIELDS[] =
+{
+    {"rho",                 &VehicleParameters::rho,                NULL},
+    {"g",                   &VehicleParameters::g,                  NULL},
+    {"mass",                &VehicleParameters::mass,               NULL},
+    {"volume",              &VehicleParameters::volume,             NULL},
+    {"Ixx",                 &VehicleParameters::Ixx,                NULL},
+    {"Ixy",                 &VehicleParameters::Ixy,                NULL},
+    {"Ixz",                 &VehicleParameters::Ixz,                NULL},
+    {"Iyx",                 &VehicleParameters::Iyx,                NULL},
+    {"Iyy",                 &VehicleParameters::Iyy,                NULL},
+    {"Iyz",                 &VehicleParameters::Iyz,                NULL},
+    {"Izx",                 &VehicleParameters::Izx,                NULL},
+    {"Izy",                 &VehicleParameters::Izy,                NULL},
+    {"Izz",                 &VehicleParameters::Izz,                NULL},
+    {"thruster_theta",      &VehicleParameters::thruster_theta,     NULL},
+    {"b",                   &VehicleParameters::b,                  NULL},
+    {"l",                   &VehicleParameters::l,                  NULL},
+    {"weight",              &VehicleParameters::weight,             NULL},
+    {"buoyancy",            &VehicleParameters::buoyancy,           NULL},
+    {"X_u_dot",             &VehicleParameters::X_u_dot,            NULL},
+    {"Y_v_dot",             &VehicleParameters::Y_v_dot,            NULL},
+    {"Z_w_dot",             &VehicleParameters::Z_w_dot,            NULL},
+    {"K_p_dot",             &VehicleParameters::K_p_dot,            NULL},
+    {"M_q_dot",             &VehicleParameters::M_q_dot,            NULL},
+    {"N_r_dot",             &VehicleParameters::N_r_dot,            NULL},
+    {"X_u",                 &VehicleParameters::X_u,                NULL},
+    {"Y_v",                 &VehicleParameters::Y_v,                NULL},
+    {"Z_w",                 &VehicleParameters::Z_w,                NULL},
+    {"K_p",                 &VehicleParameters::K_p,                NULL},
+    {"M_q",                 &VehicleParameters::M_q,                NULL},
+    {"N_r",                 &VehicleParameters::N_r,                NULL},
+    {"X_uu",                &VehicleParameters::X_uu,               NULL},
+    {"Y_vv",                &VehicleParameters::Y_vv,               NULL},
+    {"Z_ww",                &VehicleParameters::Z_ww,               NULL},
+    {"K_pp",                &VehicleParameters::K_pp,               NULL},
+    {"M_qq",                &VehicleParameters::M_qq,               NULL},
+    {"N_rr",                &VehicleParameters::N_rr,               NULL},
+    {"theta_b",             &VehicleParameters::theta_b,            NULL},
+    {"phi_b",               &VehicleParameters::phi_b,              NULL},
+    {"MAX_THRUST_SURGE",    &VehicleParameters::MAX_THRUST_SURGE,   NULL},
+    {"MAX_THRUST_SWAY",     &VehicleParameters::MAX_THRUST_SWAY,    NULL},
+    {"MAX_THRUST_HEAVE",    &VehicleParameters::MAX_THRUST_HEAVE,   NULL},
+    {"MAX_THRUST_YAW",      &VehicleParameters::MAX_THRUST_YAW,     NULL},
+    {"Kpid_u",              NULL,                                   &VehicleParameters::Kpid_u},
+    {"Kpid_v",              NULL,                                   &VehicleParameters::Kpid_v},
+    {"Kpid_z",              NULL,                                   &VehicleParameters::Kpid_z},
+    {"Kpid_psi",            NULL,                                   &VehicleParameters::Kpid_psi},
+};
+
+static const size_t VEHICLE_PARAMETER_FIELD_COUNT = sizeof(VEHICLE_PARAMETER_FIELDS) / sizeof(VEHICLE_PARAMETER_FIELDS[0]);
+static const size_t VEHICLE_PARAMETER_GAINS = 3;
+
+static const VehicleParameterField_S* FindField(const std::string& _name)
+{
+    for (size_t i = 0; i < VEHICLE_PARAMETER_FIELD_COUNT; i++)
+    {
+        if (_name == VEHICLE_PARAMETER_FIELDS[i].name)
+        {
+            return &VEHICLE_PARAMETER_FIELDS[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Field of a scalar index, and the element within the gains */
+static const VehicleParameterField_S* FieldAt(size_t _index, size_t* _element)
+{
+    for (size_t i = 0; i < VEHICLE_PARAMETER_FIELD_COUNT; i++)
+    {
+        size_t length = VEHICLE_PARAMETER_FIELDS[i].value != NULL ? 1 : VEHICLE_PARAMETER_GAINS;
+
+        if (_index < length)
+        {
+            *_element = _index;
+            return &VEHICLE_PARAMETER_FIELDS[i];
+        }
+
+        _index -= length;
+    }
+
+    return NULL;
+}
+
+static std::string Trim(const std::string& _text)
+{
+    size_t first = _text.find_first_not_of(" \t\r");
+
+    if (first == std::string::npos)
+    {
+        return "";
+    }
+
+    return _text.substr(first, _text.find_last_not_of(" \t\r") - first + 1);
+}
+
+static bool ParseNumber(const std::string& _text, double* _value)
+{
+    std::string text = Trim(_text);
+    char* end;
+
+    if (text.empty())
+    {
+        return false;
+    }
+
+    *_value = std::strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+/* Shortest text that loads back to the same float */
+static std::string FormatValue(float _value)
+{
+    char text[32];
+
+    for (int digits = 6; digits < 9; digits++)
+    {
+        std::snprintf(text, sizeof(text), "%.*g", digits, _value);
+
+        if (std::strtof(text, NULL) == _value)
+        {
+            return text;
+        }
+    }
+
+    std::snprintf(text, sizeof(text), "%.9g", _value);
+    return text;
+}
+
+VehicleParameters::VehicleParameters()
+{
+    this->rho               = VtecU3GammaParameters::rho;
+    this->g                 = VtecU3GammaParameters::g;
+
+    this->mass              = VtecU3GammaParameters::mass;
+    this->volume            = VtecU3GammaParameters::volume;
+    this->Ixx               = VtecU3GammaParameters::Ixx;
+    this->Ixy               = VtecU3GammaParameters::Ixy;
+    this->Ixz               = VtecU3GammaParameters::Ixz;
+    this->Iyx               = VtecU3GammaParameters::Iyx;
+    this->Iyy               = VtecU3GammaParameters::Iyy;
+    this->Iyz               = VtecU3GammaParameters::Iyz;
+    this->Izx               = VtecU3GammaParameters::Izx;
+    this->Izy               = VtecU3GammaParameters::Izy;
+    this->Izz               = VtecU3GammaParameters::Izz;
+    this->thruster_theta    = VtecU3GammaParameters::thruster_theta;
+    this->b                 = VtecU3GammaParameters::b;
+    this->l                 = VtecU3GammaParameters::l;
+    this->weight            = VtecU3GammaParameters::weight;
+    this->buoyancy          = VtecU3GammaParameters::buoyancy;
+
+    this->X_u_dot           = VtecU3GammaParameters::X_u_dot;
+    this->Y_v_dot           = VtecU3GammaParameters::Y_v_dot;
+    this->Z_w_dot           = VtecU3GammaParameters::Z_w_dot;
+    this->K_p_dot           = VtecU3GammaParameters::K_p_dot;
+    this->M_q_dot           = VtecU3GammaParameters::M_q_dot;
+    this->N_r_dot           = VtecU3GammaParameters::N_r_dot;
+
+    this->X_u               = VtecU3GammaParameters::X_u;
+    this->Y_v               = VtecU3GammaParameters::Y_v;
+    this->Z_w               = VtecU3GammaParameters::Z_w;
+    this->K_p               = VtecU3GammaParameters::K_p;
+    this->M_q               = VtecU3GammaParameters::M_q;
+    this->N_r               = VtecU3GammaParameters::N_r;
+
+    this->X_uu              = VtecU3GammaParameters::X_uu;
+    this->Y_vv              = VtecU3GammaParameters::Y_vv;
+    this->Z_ww              = VtecU3GammaParameters::Z_ww;
+    this->K_pp              = VtecU3GammaParameters::K_pp;
+    this->M_qq              = VtecU3GammaParameters::M_qq;
+    this->N_rr              = VtecU3GammaParameters::N_rr;
+
+    this->theta_b           = VtecU3GammaParameters::theta_b;
+    this->phi_b             = VtecU3GammaParameters::phi_b;
+
+    this->MAX_THRUST_SURGE  = VtecU3GammaParameters::MAX_THRUST_SURGE;
+    this->MAX_THRUST_SWAY   = VtecU3GammaParameters::MAX_THRUST_SWAY;
+    this->MAX_THRUST_HEAVE  = VtecU3GammaParameters::MAX_THRUST_HEAVE;
+    this->MAX_THRUST_YAW    = VtecU3GammaParameters::MAX_THRUST_YAW;
+
+    for (size_t i = 0; i < VEHICLE_PARAMETER_GAINS; i++)
+    {
+        this->Kpid_u[i]     = VtecU3GammaParameters::Kpid_u[i];
+        this->Kpid_v[i]     = VtecU3GammaParameters::Kpid_v[i];
+        this->Kpid_z[i]     = VtecU3GammaParameters::Kpid_z[i];
+        this->Kpid_psi[i]   = VtecU3GammaParameters::Kpid_psi[i];
+    }
+}
+
+VehicleParameters::~VehicleParameters(){}
+
+float* VehicleParameters::Find(const std::string& _name)
+{
+    size_t bracket = _name.find('[');
+    const VehicleParameterField_S* field = FindField(_name.substr(0, bracket));
+
+    if (field == NULL)
+    {
+        this->error = "unknown parameter " + _name;
+        return NULL;
+    }
+
+    if (bracket == std::string::npos)
+    {
+        if (field->value == NULL)
+        {
+            this->error = _name + " is a list of 3 gains";
+            return NULL;
+        }
+
+        return &(this->*field->value);
+    }
+
+    double element;
+
+    if (field->gains == NULL || _name[_name.size() - 1] != ']' ||
+        !ParseNumber(_name.substr(bracket + 1, _name.size() - bracket - 2), &element) ||
+        element < 0 || element >= VEHICLE_PARAMETER_GAINS || element != (size_t) element)
+    {
+        this->error = "unknown parameter " + _name;
+        return NULL;
+    }
+
+    return &(this->*field->gains)[(size_t) element];
+}
+
+bool VehicleParameters::Set(const std::string& _name, float _value)
+{
+    float* value = this->Find(_name);
+
+    if (value == NULL)
+    {
+        return false;
+    }
+
+    *value = _value;
+    return true;
+}
+
+bool VehicleParameters::SetList(const std::string& _name, const std::vector<double>& _values)
+{
+    const VehicleParameterField_S* field = FindField(_name);
+
+    if (field == NULL)
+    {
+        this->error = "unknown parameter " + _name;
+        return false;
+    }
+
+    if (field->gains == NULL)
+    {
+        this->error = _name + " is not a list";
+        return false;
+    }
+
+    if (_values.size() != VEHICLE_PARAMETER_GAINS)
+    {
+        this->error = _name + " needs 3 gains";
+        return false;
+    }
+
+    for (size_t i = 0; i < VEHICLE_PARAMETER_GAINS; i++)
+    {
+        (this->*field->gains)[i] = _values[i];
+    }
+
+    return true;
+}
+
+bool VehicleParameters::LoadFile(const std::string& _path)
+{
+    std::ifstream file(_path.c_str());
+
+    this->error.clear();
+
+    if (!file.is_open())
+    {
+        this->error = "could not open " + _path;
+        return false;
+    }
+
+    std::string line;
+    uint32_t line_number = 0;
+
+    while (std::getline(file, line))
+    {
+        line_number++;
+
+        std::ostringstream location;
+        location << _path << ":" << line_number << ": ";
+
+        std::string text = Trim(line.substr(0, line.find('#')));
+
+        if (text.empty())
+        {
+            continue;
+        }
+
+        size_t colon = text.find(':');
+        std::string key = Trim(text.substr(0, colon));
+        std::string value = colon != std::string::npos ? Trim(text.substr(colon + 1)) : "";
+
+        if (colon == std::string::npos || key.empty() || value.empty())
+        {
+            /* Includes nested maps, the file is flat like the parameter namespace */
+            this->error = location.str() + "expected key: value";
+            return false;
+        }
+
+        bool loaded;
+
+        if (value[0] == '[')
+        {
+            std::vector<double> values;
+            std::istringstream list(value.substr(1, value.find(']') - 1));
+            std::string item;
+            double number;
+
+            loaded = value[value.size() - 1] == ']';
+
+            while (loaded && std::getline(list, item, ','))
+            {
+                loaded = ParseNumber(item, &number);
+                values.push_back(number);
+            }
+
+            if (!loaded)
+            {
+                this->error = key + " is not a list of numbers";
+            }
+            else
+            {
+                loaded = this->SetList(key, values);
+            }
+        }
+        else
+        {
+            double number;
+
+            loaded = ParseNumber(value, &number);
+
+            if (!loaded)
+            {
+                this->error = key + " is not a number";
+            }
+            else
+            {
+                loaded = this->Set(key, number);
+            }
+        }
+
+        if (!loaded)
+        {
+            this->error = location.str() + this->error;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool VehicleParameters::SaveFile(const std::string& _path, const std::string& _header)
+{
+    std::FILE* file = std::fopen(_path.c_str(), "w");
+
+    this->error.clear();
+
+    if (file == NULL)
+    {
+        this->error = "could not open " + _path;
+        return false;
+    }
+
+    std::istringstream header(_header);
+    std::string line;
+
+    while (std::getline(header, line))
+    {
+        std::fprintf(file, "# %s\n", line.c_str());
+    }
+
+    for (size_t i = 0; i < VEHICLE_PARAMETER_FIELD_COUNT; i++)
+    {
+        const VehicleParameterField_S& field = VEHICLE_PARAMETER_FIELDS[i];
+
+        if (field.value != NULL)
+        {
+            std::fprintf(file, "%s: %s\n", field.name, FormatValue(this->*field.value).c_str());
+        }
+        else
+        {
+            std::fprintf(file, "%s: [%s, %s, %s]\n", field.name,
+                         FormatValue((this->*field.gains)[0]).c_str(),
+                         FormatValue((this->*field.gains)[1]).c_str(),
+                         FormatValue((this->*field.gains)[2]).c_str());
+        }
+    }
+
+    if (std::fclose(file) != 0)
+    {
+        this->error = "could not write " + _path;
+        return false;
+    }
+
+    return true;
+}
+
+bool VehicleParameters::LoadParameterServer(const ros::NodeHandle& _nh)
+{
+    std::vector<std::string> names;
+    std::string prefix = _nh.getNamespace() + "/";
+
+    this->error.clear();
+
+    if (!_nh.getParamNames(names))
+    {
+        this->error = "could not list the parameters of " + _nh.getNamespace();
+        return false;
+    }
+
+    /* Names come fully resolved, anything under the namespace must be a field */
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        if (names[i].compare(0, prefix.size(), prefix) == 0 && FindField(names[i].substr(prefix.size())) == NULL)
+        {
+            this->error = "unknown parameter " + names[i];
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < VEHICLE_PARAMETER_FIELD_COUNT; i++)
+    {
+        const VehicleParameterField_S& field = VEHICLE_PARAMETER_FIELDS[i];
+
+        if (!_nh.hasParam(field.name))
+        {
+            continue;
+        }
+
+        bool loaded;
+
+        if (field.value != NULL)
+        {
+            double value;
+
+            loaded = _nh.getParam(field.name, value);
+
+            if (loaded)
+            {
+                this->*field.value = value;
+            }
+            else
+            {
+                this->error = std::string(field.name) + " is not a number";
+            }
+        }
+        else
+        {
+            std::vector<double> values;
+
+            loaded = _nh.getParam(field.name, values);
+
+            if (loaded)
+            {
+                loaded = this->SetList(field.name, values);
+            }
+            else
+            {
+                this->error = std::string(field.name) + " is not a list of numbers";
+            }
+        }
+
+        if (!loaded)
+        {
+            this->error = _nh.getNamespace() + "/" + this->error;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t VehicleParameters::Count()
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < VEHICLE_PARAMETER_FIELD_COUNT; i++)
+    {
+        count += VEHICLE_PARAMETER_FIELDS[i].value != NULL ? 1 : VEHICLE_PARAMETER_GAINS;
+    }
+
+    return count;
+}
+
+std::string VehicleParameters::Name(size_t _index)
+{
+    size_t element;
+    const VehicleParameterField_S* field = FieldAt(_index, &element);
+
+    if (field == NULL)
+    {
+        return "";
+    }
+
+    if (field->value != NULL)
+    {
+        return field->name;
+    }
+
+    std::ostringstream name;
+    name << field->name << "[" << element << "]";
+
+    return name.str();
+}
+
+float VehicleParameters::Value(size_t _index) const
+{
+    size_t element;
+    const VehicleParameterField_S* field = FieldAt(_index, &element);
+
+    if (field == NULL)
+    {
+        return 0;
+    }
+
+    if (field->value != NULL)
+    {
+        return this->*field->value;
+    }
+
+    return (this->*field->gains)[element];
+}
@@ -0,0 +1,46 @@
+/** ----------------------------------------------------------------------------
+ * @file: control_replay.hpp
+ * 
+ * @brief: Replay of the control node. States and setpoints are the inputs,
+ *         the thrust and the internals of the four PIDs are compared. The
+ *         controller is built at the first input, bound to the recorded
+ *         vehicle.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __CONTROL_REPLAY_H__
+#define __CONTROL_REPLAY_H__
+
+#include "telemetry_replay.hpp"
+
+/* Kept out of this header so it can be used next to the guidance one */
+template <typename Parameters> class UUV4DOFControllerT;
+
+class ControlReplay : public TelemetryReplay
+{
+    public:
+
+        ControlReplay();
+        ~ControlReplay();
+
+    protected:
+
+        void OnParameter(const TelemetryParameter_S& _parameter);
+        void OnState(const vanttec_uuv::VehicleState& _state);
+        void OnSetpoint(const geometry_msgs::Twist& _setpoint, const vanttec_uuv::TraceInfo& _trace);
+        void OnThrust(const vanttec_uuv::ThrustControl& _thrust);
+        void OnPid(const TelemetryPid_S& _pid);
+        void OnTick();
+
+    private:
+
+        UUV4DOFControllerT<VehicleParameters>*  controller;
+        float                                   sample_time_s;
+
+        /* Axes whose recorded PID state has been loaded, for logs that lost their head */
+        uint8_t                                 seeded_axes;
+
+        UUV4DOFControllerT<VehicleParameters>*  Controller();
+};
+
+#endif
@@ -39,12 +39,20 @@ class PIDController
         float f_x;
         float g_x;
 
+        /* Bumpless transfer: the step a gain change would cause in the manipulation
+           is added back here and faded out with transfer_time_constant_s */
+        float transfer;
+        float transfer_time_constant_s;
+
         DOFControllerType_E controller_type;
         
         PIDController(float _sample_time_s, const float _k_pid[3], const DOFControllerType_E _type);
         ~PIDController();
         
         void CalculateManipulation(float _current_value);
+
+        /* Takes effect on the next manipulation */
+        void SetGains(const float _k_pid[3]);
 };
 
 #endif
\ No newline at end of file
@@ -5,7 +5,10 @@
  * @email: pedro.sc.97@gmail.com
  * 
  * @brief: 4-DOF controller class, using a different, decoupled controller for
- *         each DOF.
+ *         each DOF. Templated on the parameter set like the dynamic
+ *         model: UUV4DOFController takes one loaded at startup and
+ *         VtecU3GammaController has the shipped vehicle built in. The gains
+ *         can be tuned while running, see RequestGain.
  * -----------------------------------------------------------------------------
  * */
 
@@ -13,22 +16,38 @@
 #define __UUV_4DOF_CONTROLLER_H__
 
 #include "pid_controller.hpp"
-#include "vtec_u3_gamma_parameters.hpp"
+#include "telemetry_recorder.hpp"
+#include "vehicle_parameters.hpp"
+#include "vanttec_uuv/ControlSetpoint.h"
+#include "vanttec_uuv/SetParameters.h"
 #include "vanttec_uuv/ThrustControl.h"
+#include "vanttec_uuv/VehicleState.h"
 
 #include <geometry_msgs/Pose.h>
 #include <geometry_msgs/Twist.h>
 #include <eigen3/Eigen/Dense>
+#include <string>
 
-
-class UUV4DOFController
+template <typename Parameters>
+class UUV4DOFControllerT
 {
     public:
+
+        /* Bound when the controller is constructed, the gains are only its initial ones */
+        const Parameters            parameters;
+
         geometry_msgs::Pose         local_pose;
         geometry_msgs::Twist        local_twist;
         
         vanttec_uuv::ThrustControl  thrust;
 
+        /* Traces of the last state and setpoint received, the thrust carries the state one */
+        vanttec_uuv::TraceInfo      state_trace;
+        vanttec_uuv::TraceInfo      setpoint_trace;
+
+        /* Inputs are recorded as they are received when set, NULL by default */
+        TelemetryRecorder*          recorder;
+
         float yaw_psi_angle;
 
         PIDController surge_speed_controller;
@@ -39,18 +58,32 @@ class UUV4DOFController
         Eigen::Vector4f f_x;
         Eigen::Vector4f g_x;
 
-        UUV4DOFController(float _sample_time_s, const float _kpid_u[3], const float _kpid_v[3], const float _kpid_z[3], const float _kpid_psi[3]);
-        ~UUV4DOFController();
+        UUV4DOFControllerT(float _sample_time_s, const Parameters& _parameters = Parameters());
+        ~UUV4DOFControllerT();
 
-        void UpdatePose(const geometry_msgs::Pose& _pose);
-        void UpdateTwist(const geometry_msgs::Twist& _twist);
+        void UpdateState(const vanttec_uuv::VehicleState& _state);
         void UpdateSetPoints(const geometry_msgs::Twist& _set_points);
+        void OnSetPointReception(const vanttec_uuv::ControlSetpoint& _set_point);
         
         void UpdateControlLaw();
         void UpdateThrustOutput();
+
+        /* A gain by its vehicle parameter name, as Kpid_psi[2]. Requested gains are
+           applied together at the start of the next UpdateControlLaw, with bumpless
+           transfer, so a change never lands in the middle of a cycle */
+        bool RequestGain(const std::string& _name, float _value);
+
+        /* Service callback, every gain of the request is accepted or none is */
+        bool OnSetGains(vanttec_uuv::SetParameters::Request& _request, vanttec_uuv::SetParameters::Response& _response);
     
     private:
 
+        /* Written by the service callback, read at the tick, both from the spinning thread */
+        float requested_gains[4][3];
+        bool  gains_requested;
+
+        PIDController* AxisController(int _axis);
+
         Eigen::Vector4f upsilon;
         Eigen::Matrix4f M_rb;
         Eigen::Matrix4f M_a;
@@ -59,6 +92,11 @@ class UUV4DOFController
         Eigen::Matrix4f D_lin;
         Eigen::Matrix4f D_qua;
         Eigen::Vector4f G_eta;
+        Eigen::Matrix4f M_inv;
 };
 
+/* Instantiated in uuv_4dof_controller.cpp */
+typedef UUV4DOFControllerT<VehicleParameters>        UUV4DOFController;
+typedef UUV4DOFControllerT<VtecU3GammaParameters>    VtecU3GammaController;
+
 #endif
\ No newline at end of file
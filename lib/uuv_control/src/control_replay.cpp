@@ -0,0 +1,157 @@
+/** ----------------------------------------------------------------------------
+ * @file: control_replay.cpp
+ * 
+ * @brief: Replay of the control node. States and setpoints are the inputs,
+ *         the thrust and the internals of the four PIDs are compared. Gains
+ *         changed while the node ran are requested where they were recorded.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "control_replay.hpp"
+#include "uuv_4dof_controller.hpp"
+
+#include <cstring>
+
+/* Sample time of the control node, until the log says otherwise */
+static const float CONTROL_REPLAY_SAMPLE_TIME_S = 0.01;
+
+static const uint8_t CONTROL_REPLAY_ALL_AXES = (1 << TELEMETRY_PID_SURGE) | (1 << TELEMETRY_PID_SWAY) |
+                                               (1 << TELEMETRY_PID_DEPTH) | (1 << TELEMETRY_PID_HEADING);
+
+/* Field names of the compared PID internals, per axis */
+static const char* const PID_FIELDS[4][6] =
+{
+    {"surge.set_point", "surge.error", "surge.prev_error", "surge.manipulation", "surge.f_x", "surge.transfer"},
+    {"sway.set_point", "sway.error", "sway.prev_error", "sway.manipulation", "sway.f_x", "sway.transfer"},
+    {"depth.set_point", "depth.error", "depth.prev_error", "depth.manipulation", "depth.f_x", "depth.transfer"},
+    {"heading.set_point", "heading.error", "heading.prev_error", "heading.manipulation", "heading.f_x", "heading.transfer"},
+};
+
+/* Gains are vehicle parameters, recorded again when tuned */
+static const char CONTROL_REPLAY_GAIN_PREFIX[] = "vehicle/Kpid_";
+
+ControlReplay::ControlReplay()
+{
+    this->controller    = NULL;
+    this->sample_time_s = CONTROL_REPLAY_SAMPLE_TIME_S;
+    this->seeded_axes   = 0;
+}
+
+ControlReplay::~ControlReplay()
+{
+    delete this->controller;
+}
+
+UUV4DOFController* ControlReplay::Controller()
+{
+    /* The parameters are recorded before any input */
+    if (this->controller == NULL)
+    {
+        this->controller = new UUV4DOFController(this->sample_time_s, this->vehicle);
+    }
+
+    return this->controller;
+}
+
+static PIDController* AxisController(UUV4DOFController* _controller, uint8_t _axis)
+{
+    switch (_axis)
+    {
+        case TELEMETRY_PID_SURGE:
+            return &_controller->surge_speed_controller;
+        case TELEMETRY_PID_SWAY:
+            return &_controller->sway_speed_controller;
+        case TELEMETRY_PID_DEPTH:
+            return &_controller->depth_controller;
+        case TELEMETRY_PID_HEADING:
+            return &_controller->heading_controller;
+        default:
+            return NULL;
+    }
+}
+
+void ControlReplay::OnParameter(const TelemetryParameter_S& _parameter)
+{
+    if (std::strncmp(_parameter.name, "sample_time_s", sizeof(_parameter.name)) == 0)
+    {
+        this->sample_time_s = _parameter.value;
+
+        if (this->controller == NULL)
+        {
+            return;
+        }
+
+        for (uint8_t axis = TELEMETRY_PID_SURGE; axis <= TELEMETRY_PID_HEADING; axis++)
+        {
+            AxisController(this->controller, axis)->sample_time_s = _parameter.value;
+        }
+    }
+    else if (this->controller != NULL &&
+             std::strncmp(_parameter.name, CONTROL_REPLAY_GAIN_PREFIX, sizeof(CONTROL_REPLAY_GAIN_PREFIX) - 1) == 0)
+    {
+        /* Before the controller exists the recorded vehicle already holds it */
+        this->controller->RequestGain(_parameter.name + VEHICLE_PARAMETERS_NAMESPACE.size() + 1, _parameter.value);
+    }
+}
+
+void ControlReplay::OnState(const vanttec_uuv::VehicleState& _state)
+{
+    this->Controller()->UpdateState(_state);
+}
+
+void ControlReplay::OnSetpoint(const geometry_msgs::Twist& _setpoint, const vanttec_uuv::TraceInfo& _trace)
+{
+    vanttec_uuv::ControlSetpoint setpoint;
+
+    setpoint.trace      = _trace;
+    setpoint.setpoint   = _setpoint;
+
+    this->Controller()->OnSetPointReception(setpoint);
+}
+
+void ControlReplay::OnTick()
+{
+    /* The PID state of the previous cycle is all the history the controller keeps */
+    if (!this->synchronized && this->seeded_axes == CONTROL_REPLAY_ALL_AXES)
+    {
+        this->synchronized = true;
+    }
+
+    this->Controller()->UpdateControlLaw();
+    this->Controller()->UpdateThrustOutput();
+}
+
+void ControlReplay::OnThrust(const vanttec_uuv::ThrustControl& _thrust)
+{
+    this->Compare("thrust.tau_x", _thrust.tau_x, this->Controller()->thrust.tau_x);
+    this->Compare("thrust.tau_y", _thrust.tau_y, this->Controller()->thrust.tau_y);
+    this->Compare("thrust.tau_z", _thrust.tau_z, this->Controller()->thrust.tau_z);
+    this->Compare("thrust.tau_yaw", _thrust.tau_yaw, this->Controller()->thrust.tau_yaw);
+}
+
+void ControlReplay::OnPid(const TelemetryPid_S& _pid)
+{
+    PIDController* pid = AxisController(this->Controller(), _pid.axis);
+
+    if (pid == NULL)
+    {
+        return;
+    }
+
+    if (!this->synchronized)
+    {
+        /* Later setpoints overwrite this one, the error is the next cycle's previous error */
+        pid->set_point  = _pid.set_point;
+        pid->error      = _pid.error;
+        pid->transfer   = _pid.transfer;
+        this->seeded_axes |= (1 << _pid.axis);
+        return;
+    }
+
+    this->Compare(PID_FIELDS[_pid.axis][0], _pid.set_point, pid->set_point);
+    this->Compare(PID_FIELDS[_pid.axis][1], _pid.error, pid->error);
+    this->Compare(PID_FIELDS[_pid.axis][2], _pid.prev_error, pid->prev_error);
+    this->Compare(PID_FIELDS[_pid.axis][3], _pid.manipulation, pid->manipulation);
+    this->Compare(PID_FIELDS[_pid.axis][4], _pid.f_x, pid->f_x);
+    this->Compare(PID_FIELDS[_pid.axis][5], _pid.transfer, pid->transfer);
+}
@@ -10,6 +10,10 @@
 
 #include "pid_controller.hpp"
 
+/* Default fade out of a gain change, and the transfer left that is dropped */
+static const float PID_TRANSFER_TIME_CONSTANT_S = 1.0;
+static const float PID_TRANSFER_EPSILON         = 1e-4;
+
 PIDController::PIDController(float _sample_time_s, const float _k_pid[3], const DOFControllerType_E _type)
 {
     this->sample_time_s     = _sample_time_s;
@@ -25,6 +29,9 @@ PIDController::PIDController(float _sample_time_s, const float _k_pid[3], const
     this->f_x               = 0;
     this->g_x               = 0;
 
+    this->transfer                  = 0;
+    this->transfer_time_constant_s  = PID_TRANSFER_TIME_CONSTANT_S;
+
     this->controller_type   = _type;
 }
 
@@ -47,4 +54,38 @@ void PIDController::CalculateManipulation(float _current_value)
     float error_i       = ((this->error + this->prev_error) / 2 * this->sample_time_s) + this->error;
 
     this->manipulation  = (1 / this->g_x) * (-this->f_x + this->k_p * this->error + this->k_i * error_i + this->k_d * error_d);
+
+    if (this->transfer != 0)
+    {
+        this->manipulation  += this->transfer;
+        this->transfer      *= std::exp(-this->sample_time_s / this->transfer_time_constant_s);
+
+        if (std::abs(this->transfer) < PID_TRANSFER_EPSILON)
+        {
+            this->transfer = 0;
+        }
+    }
+}
+
+void PIDController::SetGains(const float _k_pid[3])
+{
+    if (_k_pid[0] == this->k_p && _k_pid[1] == this->k_i && _k_pid[2] == this->k_d)
+    {
+        return;
+    }
+
+    /* Terms of the last manipulation, with the old and the new gains */
+    float error_d       = (this->error - this->prev_error) / this->sample_time_s;
+    float error_i       = ((this->error + this->prev_error) / 2 * this->sample_time_s) + this->error;
+    float old_terms     = this->k_p * this->error + this->k_i * error_i + this->k_d * error_d;
+    float new_terms     = _k_pid[0] * this->error + _k_pid[1] * error_i + _k_pid[2] * error_d;
+
+    if (this->transfer_time_constant_s > 0 && this->g_x != 0)
+    {
+        this->transfer  += (1 / this->g_x) * (old_terms - new_terms);
+    }
+
+    this->k_p           = _k_pid[0];
+    this->k_i           = _k_pid[1];
+    this->k_d           = _k_pid[2];
 }
\ No newline at end of file
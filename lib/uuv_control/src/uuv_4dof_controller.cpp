@@ -11,16 +11,52 @@
 
 #include "uuv_4dof_controller.hpp"
 
-UUV4DOFController::UUV4DOFController(float _sample_time_s, const float _kpid_u[3], const float _kpid_v[3], const float _kpid_z[3], const float _kpid_psi[3])
-                                    : surge_speed_controller(_sample_time_s, _kpid_u, LINEAR_DOF_PID)
-                                    , sway_speed_controller(_sample_time_s, _kpid_v, LINEAR_DOF_PID)
-                                    , depth_controller(_sample_time_s, _kpid_z, LINEAR_DOF_PID)
-                                    , heading_controller(_sample_time_s, _kpid_psi, ANGULAR_DOF_PID)
+#include <ros/ros.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+/* Vehicle parameter names of the gains, in the order of the axes */
+static const char* const CONTROLLER_GAIN_NAMES[4] = {"Kpid_u", "Kpid_v", "Kpid_z", "Kpid_psi"};
+
+/* Axis and term of a gain name, false when it names no gain */
+static bool ParseGainName(const std::string& _name, int* _axis, int* _term)
+{
+    for (int axis = 0; axis < 4; axis++)
+    {
+        size_t length = std::strlen(CONTROLLER_GAIN_NAMES[axis]);
+
+        if (_name.size() == length + 3 && _name.compare(0, length, CONTROLLER_GAIN_NAMES[axis]) == 0 &&
+            _name[length] == '[' && _name[length + 1] >= '0' && _name[length + 1] <= '2' && _name[length + 2] == ']')
+        {
+            *_axis = axis;
+            *_term = _name[length + 1] - '0';
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static std::string GainName(int _axis, int _term)
+{
+    char name[16];
+    std::snprintf(name, sizeof(name), "%s[%d]", CONTROLLER_GAIN_NAMES[_axis], _term);
+    return std::string(name);
+}
+
+template <typename Parameters>
+UUV4DOFControllerT<Parameters>::UUV4DOFControllerT(float _sample_time_s, const Parameters& _parameters)
+                                                  : parameters(_parameters)
+                                                  , surge_speed_controller(_sample_time_s, _parameters.Kpid_u, LINEAR_DOF_PID)
+                                                  , sway_speed_controller(_sample_time_s, _parameters.Kpid_v, LINEAR_DOF_PID)
+                                                  , depth_controller(_sample_time_s, _parameters.Kpid_z, LINEAR_DOF_PID)
+                                                  , heading_controller(_sample_time_s, _parameters.Kpid_psi, ANGULAR_DOF_PID)
 {
-    this->g_x << (1 / (mass - X_u_dot)),
-                 (1 / (mass - Y_v_dot)),
-                 (1 / (mass - Z_w_dot)),
-                 (1 / (Izz - N_r_dot));
+    this->g_x << (1 / (this->parameters.mass - this->parameters.X_u_dot)),
+                 (1 / (this->parameters.mass - this->parameters.Y_v_dot)),
+                 (1 / (this->parameters.mass - this->parameters.Z_w_dot)),
+                 (1 / (this->parameters.Izz - this->parameters.N_r_dot));
 
     this->surge_speed_controller.g_x    = g_x(0);
     this->sway_speed_controller.g_x     = g_x(1);
@@ -31,30 +67,84 @@ UUV4DOFController::UUV4DOFController(float _sample_time_s, const float _kpid_u[3
                  0,
                  0,
                  0;
+
+    this->recorder = NULL;
+    this->gains_requested = false;
+
+    /* Rigid Body Mass Matrix */
+
+    this->M_rb << this->parameters.mass, 0, 0, 0,
+                  0, this->parameters.mass, 0, 0,
+                  0, 0, this->parameters.mass, 0,
+                  0, 0, 0, this->parameters.Izz;
+
+    /* Hydrodynamic Added Mass Matrix */
+
+    this->M_a << this->parameters.X_u_dot, 0, 0, 0,
+                 0, this->parameters.Y_v_dot, 0, 0,
+                 0, 0, this->parameters.Z_w_dot, 0,
+                 0, 0, 0, this->parameters.N_r_dot;
+
+    Eigen::Matrix4f M = this->M_rb - this->M_a;
+    this->M_inv = M.inverse();
+
+    /* Linear Hydrodynamic Damping */
+
+    this->D_lin << -(this->parameters.X_u), 0, 0, 0,
+                   0, -(this->parameters.Y_v), 0, 0,
+                   0, 0, -(this->parameters.Z_w), 0,
+                   0, 0, 0, -(this->parameters.N_r);
+
+    /* Restoring Forces */
+
+    float net_weight = this->parameters.weight - this->parameters.buoyancy;
+
+    this->G_eta << net_weight * sin(this->parameters.theta_b),
+                   -net_weight * cos(this->parameters.theta_b) * sin(this->parameters.phi_b),
+                   -net_weight * cos(this->parameters.theta_b) * cos(this->parameters.phi_b),
+                   0;
 }
 
-UUV4DOFController::~UUV4DOFController(){}
+template <typename Parameters>
+UUV4DOFControllerT<Parameters>::~UUV4DOFControllerT(){}
 
-void UUV4DOFController::UpdatePose(const geometry_msgs::Pose& _pose)
+template <typename Parameters>
+void UUV4DOFControllerT<Parameters>::UpdateState(const vanttec_uuv::VehicleState& _state)
 {
-    this->local_pose.position.x     = _pose.position.x;
-    this->local_pose.position.y     = _pose.position.y;
-    this->local_pose.position.z     = _pose.position.z;
-    this->yaw_psi_angle             = _pose.orientation.z;
+    this->local_pose.position.x     = _state.x;
+    this->local_pose.position.y     = _state.y;
+    this->local_pose.position.z     = _state.z;
+    this->yaw_psi_angle             = _state.yaw;
+
+    this->local_twist.linear.x      = _state.u;
+    this->local_twist.linear.y      = _state.v;
+    this->local_twist.linear.z      = _state.w;
+    this->local_twist.angular.x     = _state.p;
+    this->local_twist.angular.y     = _state.q;
+    this->local_twist.angular.z     = _state.r;
+
+    this->state_trace               = _state.trace;
+
+    if (this->recorder != NULL)
+    {
+        this->recorder->RecordState(ros::Time::now().toSec(), _state);
+    }
 }
 
-void UUV4DOFController::UpdateTwist(const geometry_msgs::Twist& _twist)
+template <typename Parameters>
+void UUV4DOFControllerT<Parameters>::OnSetPointReception(const vanttec_uuv::ControlSetpoint& _set_point)
 {
-    this->local_twist.linear.x = _twist.linear.x;
-    this->local_twist.linear.y = _twist.linear.y;
-    this->local_twist.linear.z = _twist.linear.z;
-    this->local_twist.angular.x = _twist.angular.x;
-    this->local_twist.angular.y = _twist.angular.y;
-    this->local_twist.angular.z = _twist.angular.z;
+    this->setpoint_trace = _set_point.trace;
+    this->UpdateSetPoints(_set_point.setpoint);
 
+    if (this->recorder != NULL)
+    {
+        this->recorder->RecordSetpoint(ros::Time::now().toSec(), _set_point.setpoint, _set_point.trace);
+    }
 }
 
-void UUV4DOFController::UpdateSetPoints(const geometry_msgs::Twist& _set_points)
+template <typename Parameters>
+void UUV4DOFControllerT<Parameters>::UpdateSetPoints(const geometry_msgs::Twist& _set_points)
 {
     this->surge_speed_controller.set_point      = (float) _set_points.linear.x;
     this->sway_speed_controller.set_point       = (float) _set_points.linear.y;
@@ -72,32 +162,29 @@ void UUV4DOFController::UpdateSetPoints(const geometry_msgs::Twist& _set_points)
     } 
 }
 
-void UUV4DOFController::UpdateControlLaw()
+template <typename Parameters>
+void UUV4DOFControllerT<Parameters>::UpdateControlLaw()
 {
+    if (this->gains_requested)
+    {
+        for (int axis = 0; axis < 4; axis++)
+        {
+            this->AxisController(axis)->SetGains(this->requested_gains[axis]);
+        }
+
+        this->gains_requested = false;
+    }
+
     this->upsilon << ((float) this->local_twist.linear.x),
                      ((float) this->local_twist.linear.y),
                      ((float) this->local_twist.linear.z),
                      ((float) this->local_twist.angular.z);
     
     
-    /* Rigid Body Mass Matrix */
-
-    this->M_rb << mass, 0, 0, 0,
-                  0, mass, 0, 0,
-                  0, 0, mass, 0,
-                  0, 0, 0, Izz;
-
-    /* Hydrodynamic Added Mass Matrix */
-
-    this->M_a << X_u_dot, 0, 0, 0,
-                 0, Y_v_dot, 0, 0,
-                 0, 0, Z_w_dot, 0,
-                 0, 0, 0, N_r_dot;
-
     /* Rigid Body Coriolis Matrix */
 
-    float rb_a_1 = mass * this->upsilon(0);
-    float rb_a_2 = mass * this->upsilon(1);
+    float rb_a_1 = this->parameters.mass * this->upsilon(0);
+    float rb_a_2 = this->parameters.mass * this->upsilon(1);
     
     this->C_rb << 0, 0, 0, -rb_a_2,
                   0, 0, 0, rb_a_1,
@@ -106,40 +193,27 @@ void UUV4DOFController::UpdateControlLaw()
 
     /* Hydrodynamic Added Mass Coriolis Matrix */
 
-    float a_a_1 = X_u_dot * this->upsilon(0);
-    float a_a_2 = Y_v_dot * this->upsilon(1);
+    float a_a_1 = this->parameters.X_u_dot * this->upsilon(0);
+    float a_a_2 = this->parameters.Y_v_dot * this->upsilon(1);
     
     this->C_a << 0, 0, 0, a_a_2,
                  0, 0, 0, -a_a_1,
                  0, 0, 0, 0,
                  -a_a_2, a_a_1, 0, 0;
     
-    /* Hydrodynamic Damping */
-
-    this->D_lin << -(X_u), 0, 0, 0,
-                   0, -(Y_v), 0, 0,
-                   0, 0, -(Z_w), 0,
-                   0, 0, 0, -(N_r);
-
-    this->D_qua << -(X_uu * fabs(this->upsilon(0))), 0, 0, 0,
-                   0, -(Y_vv * fabs(this->upsilon(1))), 0, 0,
-                   0, 0, -(Z_ww * fabs(this->upsilon(2))), 0,
-                   0, 0, 0, -(N_rr * fabs(this->upsilon(3)));
+    /* Quadratic Hydrodynamic Damping */
 
-    /* Restoring Forces */
-    
-    this->G_eta << (weight - buoyancy) * sin(theta_b),
-                   -(weight - buoyancy) * cos(theta_b) * sin(phi_b),
-                   -(weight - buoyancy) * cos(theta_b) * cos(phi_b),
-                   0;
+    this->D_qua << -(this->parameters.X_uu * fabs(this->upsilon(0))), 0, 0, 0,
+                   0, -(this->parameters.Y_vv * fabs(this->upsilon(1))), 0, 0,
+                   0, 0, -(this->parameters.Z_ww * fabs(this->upsilon(2))), 0,
+                   0, 0, 0, -(this->parameters.N_rr * fabs(this->upsilon(3)));
 
     /* 4 DoF State Calculation */
 
-    Eigen::Matrix4f M = this->M_rb - this->M_a;
     Eigen::Matrix4f C = this->C_rb + this->C_a;
     Eigen::Matrix4f D = this->D_lin + this->D_qua;
 
-    this->f_x = M.inverse() * (- (C * this->upsilon) - (D * this->upsilon) - this->G_eta);
+    this->f_x = this->M_inv * (- (C * this->upsilon) - (D * this->upsilon) - this->G_eta);
 
     this->surge_speed_controller.f_x    = f_x(0);
     this->sway_speed_controller.f_x     = f_x(1);
@@ -147,8 +221,12 @@ void UUV4DOFController::UpdateControlLaw()
     this->heading_controller.f_x        = f_x(3);
 }
 
-void UUV4DOFController::UpdateThrustOutput()
+template <typename Parameters>
+void UUV4DOFControllerT<Parameters>::UpdateThrustOutput()
 {
+    this->thrust.header.stamp   = ros::Time::now();
+    this->thrust.trace          = this->state_trace;
+
     /* Calculate Controller Ouput/Manipulation */
     this->surge_speed_controller.CalculateManipulation(this->local_twist.linear.x);
     this->sway_speed_controller.CalculateManipulation(this->local_twist.linear.y);
@@ -157,36 +235,36 @@ void UUV4DOFController::UpdateThrustOutput()
 
     /* Saturate Controller Ouput/Manipulation */
 
-    if (fabs(this->surge_speed_controller.manipulation) > MAX_THRUST_SURGE)
+    if (fabs(this->surge_speed_controller.manipulation) > this->parameters.MAX_THRUST_SURGE)
     {
-        this->thrust.tau_x = (this->surge_speed_controller.manipulation / fabs(this->surge_speed_controller.manipulation)) * (MAX_THRUST_SURGE);
+        this->thrust.tau_x = (this->surge_speed_controller.manipulation / fabs(this->surge_speed_controller.manipulation)) * (this->parameters.MAX_THRUST_SURGE);
     }
     else
     {
         this->thrust.tau_x = this->surge_speed_controller.manipulation;
     }
 
-    if (fabs(this->sway_speed_controller.manipulation) > MAX_THRUST_SWAY)
+    if (fabs(this->sway_speed_controller.manipulation) > this->parameters.MAX_THRUST_SWAY)
     {
-        this->thrust.tau_y = (this->sway_speed_controller.manipulation / fabs(this->sway_speed_controller.manipulation)) * (MAX_THRUST_SWAY);
+        this->thrust.tau_y = (this->sway_speed_controller.manipulation / fabs(this->sway_speed_controller.manipulation)) * (this->parameters.MAX_THRUST_SWAY);
     }
     else
     {
         this->thrust.tau_y = this->sway_speed_controller.manipulation;
     }
 
-    if (fabs(this->depth_controller.manipulation) > MAX_THRUST_HEAVE)
+    if (fabs(this->depth_controller.manipulation) > this->parameters.MAX_THRUST_HEAVE)
     {
-        this->thrust.tau_z = (this->depth_controller.manipulation / fabs(this->depth_controller.manipulation)) * (MAX_THRUST_HEAVE);
+        this->thrust.tau_z = (this->depth_controller.manipulation / fabs(this->depth_controller.manipulation)) * (this->parameters.MAX_THRUST_HEAVE);
     }
     else
     {
         this->thrust.tau_z = this->depth_controller.manipulation;
     }
 
-    if (fabs(this->heading_controller.manipulation) > MAX_THRUST_YAW)
+    if (fabs(this->heading_controller.manipulation) > this->parameters.MAX_THRUST_YAW)
     {
-        this->thrust.tau_yaw = (this->heading_controller.manipulation / fabs(this->heading_controller.manipulation)) * (MAX_THRUST_YAW);
+        this->thrust.tau_yaw = (this->heading_controller.manipulation / fabs(this->heading_controller.manipulation)) * (this->parameters.MAX_THRUST_YAW);
     }
     else
     {
@@ -194,3 +272,107 @@ void UUV4DOFController::UpdateThrustOutput()
     }
 }
 
+template <typename Parameters>
+PIDController* UUV4DOFControllerT<Parameters>::AxisController(int _axis)
+{
+    switch (_axis)
+    {
+        case 0:
+            return &this->surge_speed_controller;
+        case 1:
+            return &this->sway_speed_controller;
+        case 2:
+            return &this->depth_controller;
+        default:
+            return &this->heading_controller;
+    }
+}
+
+template <typename Parameters>
+bool UUV4DOFControllerT<Parameters>::RequestGain(const std::string& _name, float _value)
+{
+    int axis;
+    int term;
+
+    if (!ParseGainName(_name, &axis, &term))
+    {
+        return false;
+    }
+
+    /* The first request of a cycle starts from the gains in use */
+    if (!this->gains_requested)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            this->requested_gains[i][0] = this->AxisController(i)->k_p;
+            this->requested_gains[i][1] = this->AxisController(i)->k_i;
+            this->requested_gains[i][2] = this->AxisController(i)->k_d;
+        }
+
+        this->gains_requested = true;
+    }
+
+    this->requested_gains[axis][term] = _value;
+    return true;
+}
+
+template <typename Parameters>
+bool UUV4DOFControllerT<Parameters>::OnSetGains(vanttec_uuv::SetParameters::Request& _request, vanttec_uuv::SetParameters::Response& _response)
+{
+    _response.success = false;
+
+    if (_request.names.size() != _request.values.size())
+    {
+        _response.message = "names and values differ in length";
+        return true;
+    }
+
+    for (size_t i = 0; i < _request.names.size(); i++)
+    {
+        int axis;
+        int term;
+
+        if (!ParseGainName(_request.names[i], &axis, &term))
+        {
+            _response.message = "unknown gain " + _request.names[i];
+            return true;
+        }
+        if (!std::isfinite(_request.values[i]) || _request.values[i] < 0)
+        {
+            _response.message = "gain " + _request.names[i] + " must be finite and not negative";
+            return true;
+        }
+    }
+
+    double time_s = ros::Time::now().toSec();
+
+    for (size_t i = 0; i < _request.names.size(); i++)
+    {
+        this->RequestGain(_request.names[i], _request.values[i]);
+
+        if (this->recorder != NULL)
+        {
+            this->recorder->RecordParameter(time_s, (VEHICLE_PARAMETERS_NAMESPACE + "/" + _request.names[i]).c_str(), _request.values[i]);
+        }
+
+        ROS_INFO("Control: %s set to %g", _request.names[i].c_str(), _request.values[i]);
+    }
+
+    for (int axis = 0; axis < 4; axis++)
+    {
+        PIDController* pid = this->AxisController(axis);
+        float gains[3] = {pid->k_p, pid->k_i, pid->k_d};
+
+        for (int term = 0; term < 3; term++)
+        {
+            _response.names.push_back(GainName(axis, term));
+            _response.values.push_back(this->gains_requested ? this->requested_gains[axis][term] : gains[term]);
+        }
+    }
+
+    _response.success = true;
+    return true;
+}
+
+template class UUV4DOFControllerT<VehicleParameters>;
+template class UUV4DOFControllerT<VtecU3GammaParameters>;
@@ -0,0 +1,52 @@
+/** ----------------------------------------------------------------------------
+ * @file: guidance_replay.hpp
+ * 
+ * @brief: Replay of the guidance node. States, waypoint lists, master status,
+ *         emergency stops and obstacles are the inputs, the setpoints are
+ *         compared.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __GUIDANCE_REPLAY_H__
+#define __GUIDANCE_REPLAY_H__
+
+#include <string>
+
+#include "telemetry_replay.hpp"
+
+/* Kept out of this header so it can be used next to the control one */
+class GuidanceController;
+
+class GuidanceReplay : public TelemetryReplay
+{
+    public:
+
+        GuidanceReplay();
+        ~GuidanceReplay();
+
+    protected:
+
+        void OnParameter(const TelemetryParameter_S& _parameter);
+        void OnState(const vanttec_uuv::VehicleState& _state);
+        void OnSetpoint(const geometry_msgs::Twist& _setpoint, const vanttec_uuv::TraceInfo& _trace);
+        void OnWaypoints(const vanttec_uuv::GuidanceWaypoints& _waypoints);
+        void OnMasterStatus(const vanttec_uuv::MasterStatus& _status);
+        void OnEmergencyStop();
+        void OnObstacles(const vanttec_uuv::ObstacleList& _obstacles);
+        void OnTick();
+
+    private:
+
+        GuidanceController*     controller;
+
+        /* Switching settings of the node, as recorded */
+        std::string             switching_mode;
+        float                   acceptance_radius_m;
+        float                   switching_distance_m;
+
+        /* A log that lost its head is followed from the first list received after
+           an obstacle list, which replaces the obstacles the node was avoiding */
+        bool                    obstacles_received;
+};
+
+#endif
@@ -0,0 +1,103 @@
+/** ----------------------------------------------------------------------------
+ * @file: obstacle_avoidance.hpp
+ * 
+ * @brief: Reactive obstacle avoidance for the guidance laws. The latest
+ *         obstacles around the vehicle are kept in a fixed size spatial hash;
+ *         every tick the lookahead segment is checked against them and, if it
+ *         is blocked, the desired heading is bent with a vector field and the
+ *         speed is reduced with the remaining clearance.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __OBSTACLE_AVOIDANCE_H__
+#define __OBSTACLE_AVOIDANCE_H__
+
+#include <stdint.h>
+#include <vector>
+
+/* Obstacles are kept in the horizontal NED plane as the points within
+   radius of a segment: buoys and posts have no length, walls are as long
+   as they are and radius is half their thickness */
+
+typedef struct AvoidanceObstacle_S
+{
+    float   x;
+    float   y;
+    float   radius;
+    /* Half the segment, along (axis_x, axis_y) on each side of the center */
+    float   half_length;
+    float   axis_x;
+    float   axis_y;
+    /* Cell of the center, entries of other cells share the bucket */
+    int32_t cell_x;
+    int32_t cell_y;
+} AvoidanceObstacle_S;
+
+typedef struct AvoidanceCandidate_S
+{
+    /* Distance between the lookahead segment and the obstacle surface */
+    float   clearance;
+    int32_t index;
+} AvoidanceCandidate_S;
+
+class ObstacleAvoidance
+{
+    public:
+
+        /* Distance kept between the vehicle center and the obstacle surface */
+        float safety_radius_m;
+        /* Clearance below which obstacles start pushing the heading */
+        float influence_distance_m;
+        /* Lookahead segment: speed times horizon, within these bounds */
+        float lookahead_time_s;
+        float min_lookahead_m;
+        float max_lookahead_m;
+        /* Obstacles farther than this from the vehicle are not stored */
+        float local_radius_m;
+        /* Weight of going around an obstacle against being pushed away */
+        float tangential_gain;
+        float avoidance_gain;
+        /* Speed is scaled down linearly below this clearance */
+        float slow_down_distance_m;
+        float min_speed_ratio;
+
+        /* Upper bound of the obstacles looked at in a single tick, the ones
+           closest to the lookahead segment are kept */
+        uint32_t max_evaluated_obstacles;
+
+        bool     active;
+        uint32_t evaluated_count;
+
+        ObstacleAvoidance(uint32_t _capacity, uint32_t _bucket_count, float _cell_size_m);
+        ~ObstacleAvoidance();
+
+        void Clear();
+        bool Insert(float _x, float _y, float _radius, float _length, float _yaw,
+                    float _vehicle_x, float _vehicle_y);
+
+        /* Returns true if the setpoints were modified */
+        bool Update(float _x, float _y, float _desired_heading, float _desired_speed,
+                    float* _heading, float* _speed);
+
+        uint32_t Size() const;
+
+    private:
+
+        float                               cell_size_m;
+        /* Largest distance from a center to the surface of its obstacle */
+        float                               max_extent_m;
+        uint32_t                            bucket_mask;
+
+        /* Chained hash: bucket_heads[h] is the first obstacle of bucket h,
+           next[i] the following one; -1 ends the chain. */
+        std::vector<AvoidanceObstacle_S>    obstacles;
+        std::vector<int32_t>                next;
+        std::vector<int32_t>                bucket_heads;
+
+        std::vector<AvoidanceCandidate_S>   candidates;
+
+        uint32_t Bucket(int _cell_x, int _cell_y) const;
+        int Cell(float _coordinate) const;
+};
+
+#endif
@@ -0,0 +1,77 @@
+/** ----------------------------------------------------------------------------
+ * @file: speed_profile.hpp
+ * 
+ * @brief: Time optimal speed profile along a waypoint list. The path is
+ *         sampled by arc length and each sample gets the fastest speed that
+ *         the vehicle model can reach and still brake for what comes next:
+ *         a forward pass limits acceleration and a backward pass limits
+ *         deceleration, both from the surge thrust and the damping model.
+ *         Corners are limited by the yaw rate and the lateral acceleration
+ *         the sway thrust can hold, climbs by the heave thrust.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __SPEED_PROFILE_H__
+#define __SPEED_PROFILE_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include <vanttec_uuv/GuidanceWaypoints.h>
+
+#include "vehicle_parameters.hpp"
+
+typedef struct SpeedProfileLimits_S
+{
+    /* Cruise speed cap, per waypoint speeds can only lower it */
+    float   max_speed;
+    /* Fraction of the MAX_THRUST_* values the profile may plan with,
+       the rest is left to the controllers to reject disturbances */
+    float   thrust_margin;
+    float   max_yaw_rate;
+    /* Distance over which a corner is turned, about twice the lookahead */
+    float   turn_distance;
+    float   sample_distance;
+    uint32_t max_samples;
+    /* Plan a stop at every waypoint instead of the corner speed */
+    bool    stop_at_waypoints;
+} SpeedProfileLimits_S;
+
+class SpeedProfile
+{
+    public:
+
+        SpeedProfileLimits_S    limits;
+
+        /* Vehicle the profile is planned for, the shipped one by default */
+        VehicleParameters       vehicle;
+
+        /* Planned speed every sample_distance meters of arc length */
+        std::vector<float>      speeds;
+        float                   sample_distance;
+
+        /* Arc length at each waypoint and horizontal length of each segment */
+        std::vector<float>      waypoint_arc_length;
+        std::vector<float>      segment_horizontal_length;
+
+        SpeedProfile(const SpeedProfileLimits_S& _limits);
+        ~SpeedProfile();
+
+        /* Plans the list from the first waypoint at the given speed to a stop at the last one */
+        void Compute(const vanttec_uuv::GuidanceWaypoints& _waypoints, float _start_speed);
+
+        /* Planned speed on a segment, given the LOS along track distance */
+        float Lookup(int _segment, float _along_track_distance) const;
+        float Duration() const;
+
+        /* Vehicle model */
+        float SurgeAcceleration(float _speed, float _thrust) const;
+        float SurgeDeceleration(float _speed, float _thrust) const;
+        static float TopSpeed(float _linear_damping, float _quadratic_damping, float _thrust);
+
+    private:
+
+        std::vector<float>      segment_speed_limit;
+};
+
+#endif
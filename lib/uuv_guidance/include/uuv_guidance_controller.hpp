@@ -5,27 +5,43 @@
  * @email: pedro.sc.97@gmail.com
  * 
  * @brief: Guidance controller, which manages the different guidance laws 
- *         available to the UUV.
+ *         available to the UUV. The lookahead distance, the speed profile
+ *         limits and the orbit speed gain can be tuned while running, see
+ *         RequestParameter.
  * -----------------------------------------------------------------------------
  * */
 
 #ifndef __UUV_GUIDANCE_CONTROLLER_H__
 #define __UUV_GUIDANCE_CONTROLLER_H__
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
+#include <ros/ros.h>
 #include <std_msgs/Empty.h>
 #include <geometry_msgs/Pose.h>
 #include <geometry_msgs/Twist.h>
 
+#include <vanttec_uuv/GuidanceStatus.h>
 #include <vanttec_uuv/GuidanceWaypoints.h>
 #include <vanttec_uuv/MasterStatus.h>
+#include <vanttec_uuv/ObstacleList.h>
+#include <vanttec_uuv/SetParameters.h>
+#include <vanttec_uuv/VehicleState.h>
+
+#include "obstacle_avoidance.hpp"
+#include "speed_profile.hpp"
+#include "telemetry_recorder.hpp"
 
 /********** Helper Constants ***********/
 
 const float     PI                      = 3.14159;
 const uint8_t   LOS_WAYPOINT_OFFSET     = 2;
 
+/* los_lookahead_distance, the three speed profile limits and orbit_speed_gain */
+const size_t    GUIDANCE_TUNABLE_PARAMETERS = 5;
+
 /********** Guidance Laws ***********/
 
 typedef enum GuidanceLaws_E
@@ -33,6 +49,7 @@ typedef enum GuidanceLaws_E
     NONE = 0,
     LOS_GUIDANCE_LAW = 1,
     ORBIT_GUIDANCE_LAW = 2,
+    LOS_3D_GUIDANCE_LAW = 3,
 } GuidanceLaws_E;
 
 
@@ -47,6 +64,18 @@ typedef enum LOSLawStates_E
     LOS_LAW_WAYPOINT_NAV = 2,
 } LOSLawStates_E;
 
+/* Waypoint switching: stop at each waypoint and reach its depth before the next
+   leg, or fly through it when inside its acceptance circle or when the remaining
+   along track distance is under the switching distance. Pass-through modes blend
+   the depth along each leg. */
+
+typedef enum LOSSwitchingModes_E
+{
+    LOS_SWITCH_STOP = 0,
+    LOS_SWITCH_ACCEPTANCE_CIRCLE = 1,
+    LOS_SWITCH_LOOKAHEAD = 2,
+} LOSSwitchingModes_E;
+
 /* 2D LOS Guidance Law Struct */
 
 typedef struct LOSLawStateMachine_S
@@ -55,6 +84,27 @@ typedef struct LOSLawStateMachine_S
     int                 current_waypoint;      
 } LOSLawStateMachine_S;
 
+/***************** 3D LOS ******************/
+
+/* Depth and horizontal path are followed together, there is no depth navigation stage */
+
+typedef enum LOS3DLawStates_E
+{
+    LOS_3D_LAW_STANDBY = 0,
+    LOS_3D_LAW_PATH_FOLLOWING = 1,
+} LOS3DLawStates_E;
+
+/* 3D LOS Guidance Law Struct */
+
+typedef struct LOS3DLawStateMachine_S
+{
+    LOS3DLawStates_E    state_machine;
+    int                 current_waypoint;
+    /* Cross track errors in the path frame of the current segment */
+    float               horizontal_cross_track_error;
+    float               vertical_cross_track_error;
+} LOS3DLawStateMachine_S;
+
 /***************** Orbit ******************/
 
 typedef enum OrbitLawStates_E
@@ -80,24 +130,52 @@ class GuidanceController
         
         GuidanceLaws_E          current_guidance_law;
         LOSLawStateMachine_S    los_state_machine;
+        LOS3DLawStateMachine_S  los_3d_state_machine;
         OrbitLawStateMachine_S  orbit_state_machine;
         
         geometry_msgs::Pose                 current_positions_ned;
+        geometry_msgs::Twist                current_velocities_body;
         geometry_msgs::Twist                desired_setpoints;
+        vanttec_uuv::TraceInfo              state_trace;
         vanttec_uuv::GuidanceWaypoints      current_waypoint_list;
         vanttec_uuv::MasterStatus           uuv_status;
+        vanttec_uuv::GuidanceStatus         guidance_status;
+        ObstacleAvoidance                   obstacle_avoidance;
+        SpeedProfile                        speed_profile;
+
+        /* Inputs are recorded as they are received when set, NULL by default */
+        TelemetryRecorder*                  recorder;
 
         GuidanceController();
         ~GuidanceController();
         
-        void OnCurrentPositionReception(const geometry_msgs::Pose& _pose);
+        void OnCurrentPositionReception(const vanttec_uuv::VehicleState& _state);
         void OnWaypointReception(const vanttec_uuv::GuidanceWaypoints& _waypoints);
         void OnEmergencyStop(const std_msgs::Empty& _msg);
         void OnMasterStatus(const vanttec_uuv::MasterStatus& _status);
+        void OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles);
 
         void UpdateStateMachines();
+        void UpdateGuidanceStatus();
+
+        void SetLOSSwitching(LOSSwitchingModes_E _mode, float _acceptance_radius, float _switching_distance);
+
+        /* "stop", "acceptance" or anything else for lookahead */
+        static LOSSwitchingModes_E LOSSwitchingModeFromName(const std::string& _name);
+
+        /* A tunable parameter by name. Requested values are applied together at the
+           start of the next UpdateStateMachines, so a change never lands in the
+           middle of a cycle */
+        bool RequestParameter(const std::string& _name, float _value);
+
+        /* Service callback, every value of the request is accepted or none is */
+        bool OnSetParameters(vanttec_uuv::SetParameters::Request& _request, vanttec_uuv::SetParameters::Response& _response);
 
     private:
+
+        /* Written by the service callback, read at the tick, both from the spinning thread */
+        float       requested_parameters[GUIDANCE_TUNABLE_PARAMETERS];
+        uint8_t     requested_parameter_mask;
         
         /* LOS Parameters */        
         float los_depth_error_threshold;
@@ -105,8 +183,9 @@ class GuidanceController
         float los_lookahead_distance;
         float los_max_speed;
         float los_min_speed;
-        float los_speed_gain;
         float los_euclidean_distance;
+        LOSSwitchingModes_E los_switching_mode;
+        float los_switching_distance;
 
         /* Orbit Parameters */
         float orbit_depth_error_threshold;
@@ -117,6 +196,16 @@ class GuidanceController
         float orbit_speed_gain;
         float orbit_euclidean_distance;
 
+        /* Per waypoint limits of the current list, or the given default when not set */
+        float WaypointSpeed(int _waypoint, float _default) const;
+        float WaypointAcceptanceRadius(int _waypoint, float _default) const;
+
+        /* True for legs too short horizontally to be flown with LOS, which are dived instead */
+        bool IsVerticalLOSLeg(int _waypoint) const;
+
+        float* TunableParameter(size_t _index);
+        void ApplyRequestedParameters();
+
 };
 
 #endif
\ No newline at end of file
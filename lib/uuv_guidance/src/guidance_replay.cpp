@@ -0,0 +1,112 @@
+/** ----------------------------------------------------------------------------
+ * @file: guidance_replay.cpp
+ * 
+ * @brief: Replay of the guidance node. States, waypoint lists, master status,
+ *         emergency stops and obstacles are the inputs, the setpoints are
+ *         compared. Parameters tuned while the node ran are requested where
+ *         they were recorded.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "guidance_replay.hpp"
+#include "uuv_guidance_controller.hpp"
+
+#include <cstring>
+
+GuidanceReplay::GuidanceReplay()
+{
+    this->controller = new GuidanceController();
+
+    /* Defaults of the guidance node */
+    this->switching_mode        = "lookahead";
+    this->acceptance_radius_m   = 0.4;
+    this->switching_distance_m  = 0.9;
+    this->obstacles_received    = false;
+
+    this->controller->SetLOSSwitching(GuidanceController::LOSSwitchingModeFromName(this->switching_mode),
+                                      this->acceptance_radius_m,
+                                      this->switching_distance_m);
+}
+
+GuidanceReplay::~GuidanceReplay()
+{
+    delete this->controller;
+}
+
+void GuidanceReplay::OnParameter(const TelemetryParameter_S& _parameter)
+{
+    /* The speed profile plans with the recorded vehicle */
+    this->controller->speed_profile.vehicle = this->vehicle;
+
+    if (std::strncmp(_parameter.name, "switching_mode", sizeof(_parameter.name)) == 0)
+    {
+        this->switching_mode.assign(_parameter.text, strnlen(_parameter.text, sizeof(_parameter.text)));
+    }
+    else if (std::strncmp(_parameter.name, "acceptance_radius_m", sizeof(_parameter.name)) == 0)
+    {
+        this->acceptance_radius_m = _parameter.value;
+    }
+    else if (std::strncmp(_parameter.name, "switching_distance_m", sizeof(_parameter.name)) == 0)
+    {
+        this->switching_distance_m = _parameter.value;
+    }
+    else
+    {
+        this->controller->RequestParameter(std::string(_parameter.name, strnlen(_parameter.name, sizeof(_parameter.name))), _parameter.value);
+        return;
+    }
+
+    this->controller->SetLOSSwitching(GuidanceController::LOSSwitchingModeFromName(this->switching_mode),
+                                      this->acceptance_radius_m,
+                                      this->switching_distance_m);
+}
+
+void GuidanceReplay::OnState(const vanttec_uuv::VehicleState& _state)
+{
+    this->controller->OnCurrentPositionReception(_state);
+}
+
+void GuidanceReplay::OnWaypoints(const vanttec_uuv::GuidanceWaypoints& _waypoints)
+{
+    /* A new list restarts the state machines */
+    this->controller->OnWaypointReception(_waypoints);
+
+    if (this->obstacles_received)
+    {
+        this->synchronized = true;
+    }
+}
+
+void GuidanceReplay::OnMasterStatus(const vanttec_uuv::MasterStatus& _status)
+{
+    this->controller->OnMasterStatus(_status);
+}
+
+void GuidanceReplay::OnEmergencyStop()
+{
+    /* Depth and heading setpoints survive the stop, so it does not synchronize the replay */
+    this->controller->OnEmergencyStop(std_msgs::Empty());
+}
+
+void GuidanceReplay::OnObstacles(const vanttec_uuv::ObstacleList& _obstacles)
+{
+    this->controller->OnObstacleReception(_obstacles);
+    this->obstacles_received = true;
+}
+
+void GuidanceReplay::OnTick()
+{
+    this->controller->UpdateStateMachines();
+}
+
+void GuidanceReplay::OnSetpoint(const geometry_msgs::Twist& _setpoint, const vanttec_uuv::TraceInfo& _trace)
+{
+    const geometry_msgs::Twist& replayed = this->controller->desired_setpoints;
+
+    this->Compare("setpoint.linear.x", _setpoint.linear.x, replayed.linear.x);
+    this->Compare("setpoint.linear.y", _setpoint.linear.y, replayed.linear.y);
+    this->Compare("setpoint.linear.z", _setpoint.linear.z, replayed.linear.z);
+    this->Compare("setpoint.angular.x", _setpoint.angular.x, replayed.angular.x);
+    this->Compare("setpoint.angular.y", _setpoint.angular.y, replayed.angular.y);
+    this->Compare("setpoint.angular.z", _setpoint.angular.z, replayed.angular.z);
+}
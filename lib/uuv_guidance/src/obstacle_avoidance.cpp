@@ -0,0 +1,329 @@
+/** ----------------------------------------------------------------------------
+ * @file: obstacle_avoidance.cpp
+ * 
+ * @brief: Reactive obstacle avoidance for the guidance laws. The latest
+ *         obstacles around the vehicle are kept in a fixed size spatial hash;
+ *         every tick the lookahead segment is checked against them and, if it
+ *         is blocked, the desired heading is bent with a vector field and the
+ *         speed is reduced with the remaining clearance.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "obstacle_avoidance.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/* Squared distance between two segments, each given by its start, unit direction and length */
+static float SegmentDistanceSquared(float _ax, float _ay, float _adx, float _ady, float _alength,
+                                    float _bx, float _by, float _bdx, float _bdy, float _blength)
+{
+    float rx = _bx - _ax;
+    float ry = _by - _ay;
+
+    /* Buoys and posts are points */
+    if (_blength == 0)
+    {
+        float along = std::min(std::max(rx * _adx + ry * _ady, 0.0f), _alength);
+
+        rx -= along * _adx;
+        ry -= along * _ady;
+
+        return rx * rx + ry * ry;
+    }
+
+    float cross = _adx * _bdy - _ady * _bdx;
+
+    /* Crossing segments touch */
+    if (std::fabs(cross) > 1e-6)
+    {
+        float t_a = (rx * _bdy - ry * _bdx) / cross;
+        float t_b = (rx * _ady - ry * _adx) / cross;
+
+        if (t_a >= 0 && t_a <= _alength && t_b >= 0 && t_b <= _blength)
+        {
+            return 0;
+        }
+    }
+
+    /* Otherwise the closest pair has an end of one of them */
+    float distance = INFINITY;
+    float points[4][2] = {{_bx, _by}, {_bx + _blength * _bdx, _by + _blength * _bdy},
+                          {_ax, _ay}, {_ax + _alength * _adx, _ay + _alength * _ady}};
+
+    for (int i = 0; i < 4; i++)
+    {
+        bool on_a = i < 2;
+        float sx = on_a ? _ax : _bx;
+        float sy = on_a ? _ay : _by;
+        float dx = on_a ? _adx : _bdx;
+        float dy = on_a ? _ady : _bdy;
+        float length = on_a ? _alength : _blength;
+
+        float px = points[i][0] - sx;
+        float py = points[i][1] - sy;
+        float along = std::min(std::max(px * dx + py * dy, 0.0f), length);
+
+        px -= along * dx;
+        py -= along * dy;
+        distance = std::min(distance, px * px + py * py);
+    }
+
+    return distance;
+}
+
+static bool CloserCandidate(const AvoidanceCandidate_S& _a, const AvoidanceCandidate_S& _b)
+{
+    return _a.clearance < _b.clearance;
+}
+
+ObstacleAvoidance::ObstacleAvoidance(uint32_t _capacity, uint32_t _bucket_count, float _cell_size_m)
+{
+    this->safety_radius_m           = 0.6;
+    this->influence_distance_m      = 2.0;
+    this->lookahead_time_s          = 5.0;
+    this->min_lookahead_m           = 1.0;
+    this->max_lookahead_m           = 6.0;
+    this->local_radius_m            = 20.0;
+    this->tangential_gain           = 2.0;
+    this->avoidance_gain            = 1.5;
+    this->slow_down_distance_m      = 2.0;
+    this->min_speed_ratio           = 0.2;
+    this->max_evaluated_obstacles   = 64;
+
+    this->active            = false;
+    this->evaluated_count   = 0;
+    this->cell_size_m       = _cell_size_m;
+    this->max_extent_m      = 0;
+
+    /* Round the bucket count up to a power of two so the hash is a mask */
+    uint32_t buckets = 1;
+
+    while (buckets < _bucket_count)
+    {
+        buckets <<= 1;
+    }
+
+    this->bucket_mask = buckets - 1;
+    this->bucket_heads.assign(buckets, -1);
+    this->obstacles.reserve(_capacity);
+    this->next.reserve(_capacity);
+    this->candidates.reserve(_capacity);
+}
+
+ObstacleAvoidance::~ObstacleAvoidance(){}
+
+int ObstacleAvoidance::Cell(float _coordinate) const
+{
+    return int(std::floor(_coordinate / this->cell_size_m));
+}
+
+uint32_t ObstacleAvoidance::Bucket(int _cell_x, int _cell_y) const
+{
+    return ((uint32_t) _cell_x * 73856093u ^ (uint32_t) _cell_y * 19349663u) & this->bucket_mask;
+}
+
+uint32_t ObstacleAvoidance::Size() const
+{
+    return this->obstacles.size();
+}
+
+void ObstacleAvoidance::Clear()
+{
+    std::fill(this->bucket_heads.begin(), this->bucket_heads.end(), -1);
+    this->obstacles.clear();
+    this->next.clear();
+    this->max_extent_m = 0;
+}
+
+bool ObstacleAvoidance::Insert(float _x, float _y, float _radius, float _length, float _yaw,
+                               float _vehicle_x, float _vehicle_y)
+{
+    float dx = _x - _vehicle_x;
+    float dy = _y - _vehicle_y;
+    float extent = _radius + _length / 2;
+    float reach = this->local_radius_m + extent;
+
+    if (this->obstacles.size() == this->obstacles.capacity() || dx * dx + dy * dy > reach * reach)
+    {
+        return false;
+    }
+
+    AvoidanceObstacle_S obstacle;
+    obstacle.x              = _x;
+    obstacle.y              = _y;
+    obstacle.radius         = _radius;
+    obstacle.half_length    = _length / 2;
+    obstacle.axis_x         = std::cos(_yaw);
+    obstacle.axis_y         = std::sin(_yaw);
+    obstacle.cell_x         = this->Cell(_x);
+    obstacle.cell_y         = this->Cell(_y);
+
+    uint32_t bucket = this->Bucket(obstacle.cell_x, obstacle.cell_y);
+
+    this->next.push_back(this->bucket_heads[bucket]);
+    this->bucket_heads[bucket] = this->obstacles.size();
+    this->obstacles.push_back(obstacle);
+    this->max_extent_m = std::max(this->max_extent_m, extent);
+
+    return true;
+}
+
+bool ObstacleAvoidance::Update(float _x, float _y, float _desired_heading, float _desired_speed,
+                               float* _heading, float* _speed)
+{
+    *_heading               = _desired_heading;
+    *_speed                 = _desired_speed;
+    this->active            = false;
+    this->evaluated_count   = 0;
+
+    if (this->obstacles.empty())
+    {
+        return false;
+    }
+
+    float lookahead = std::min(std::max(std::fabs(_desired_speed) * this->lookahead_time_s, this->min_lookahead_m),
+                               this->max_lookahead_m);
+    float direction_x = std::cos(_desired_heading);
+    float direction_y = std::sin(_desired_heading);
+    float end_x = _x + lookahead * direction_x;
+    float end_y = _y + lookahead * direction_y;
+
+    /* Obstacles are hashed by their center: widen the search by the largest
+       extent plus the distance at which they start to matter */
+    float margin = this->max_extent_m + this->safety_radius_m + this->influence_distance_m;
+
+    int cell_x0 = this->Cell(std::min(_x, end_x) - margin);
+    int cell_x1 = this->Cell(std::max(_x, end_x) + margin);
+    int cell_y0 = this->Cell(std::min(_y, end_y) - margin);
+    int cell_y1 = this->Cell(std::max(_y, end_y) + margin);
+
+    /* The cell range is bounded by the maximum lookahead; only obstacles
+       close enough to the lookahead segment to matter are candidates */
+    this->candidates.clear();
+
+    for (int cell_x = cell_x0; cell_x <= cell_x1; cell_x++)
+    {
+        for (int cell_y = cell_y0; cell_y <= cell_y1; cell_y++)
+        {
+            int32_t index = this->bucket_heads[this->Bucket(cell_x, cell_y)];
+
+            for (; index >= 0; index = this->next[index])
+            {
+                const AvoidanceObstacle_S& obstacle = this->obstacles[index];
+
+                /* Buckets are shared between cells, each obstacle is taken in its own */
+                if (obstacle.cell_x != cell_x || obstacle.cell_y != cell_y)
+                {
+                    continue;
+                }
+
+                float distance_squared = SegmentDistanceSquared(0, 0, direction_x, direction_y, lookahead,
+                                                                obstacle.x - _x - obstacle.half_length * obstacle.axis_x,
+                                                                obstacle.y - _y - obstacle.half_length * obstacle.axis_y,
+                                                                obstacle.axis_x, obstacle.axis_y, 2 * obstacle.half_length);
+
+                AvoidanceCandidate_S candidate;
+                candidate.clearance = std::sqrt(distance_squared) - obstacle.radius - this->safety_radius_m;
+                candidate.index     = index;
+
+                /* Farther than the influence distance from the whole segment it neither blocks nor pushes */
+                if (candidate.clearance <= this->influence_distance_m)
+                {
+                    this->candidates.push_back(candidate);
+                }
+            }
+        }
+    }
+
+    /* The work per tick is bounded by the number of evaluated obstacles; the
+       ones left out are farther from the path than all the evaluated ones */
+    if (this->candidates.size() > this->max_evaluated_obstacles)
+    {
+        std::nth_element(this->candidates.begin(), this->candidates.begin() + this->max_evaluated_obstacles,
+                         this->candidates.end(), CloserCandidate);
+        this->candidates.resize(this->max_evaluated_obstacles);
+    }
+
+    this->evaluated_count = this->candidates.size();
+
+    bool    blocked         = false;
+    float   min_clearance   = INFINITY;
+    float   field_x         = 0;
+    float   field_y         = 0;
+
+    for (size_t i = 0; i < this->candidates.size(); i++)
+    {
+        const AvoidanceObstacle_S& obstacle = this->obstacles[this->candidates[i].index];
+        float inflated = obstacle.radius + this->safety_radius_m;
+
+        if (this->candidates[i].clearance < 0)
+        {
+            blocked = true;
+        }
+
+        /* Field: pushed away from the closest point of the obstacle and
+           around it, on the side of its center the desired direction
+           already leans to, so a wall is rounded by one end only */
+        float sx = obstacle.x - _x - obstacle.half_length * obstacle.axis_x;
+        float sy = obstacle.y - _y - obstacle.half_length * obstacle.axis_y;
+        float along = std::min(std::max(-(sx * obstacle.axis_x + sy * obstacle.axis_y), 0.0f), 2 * obstacle.half_length);
+        float ox = sx + along * obstacle.axis_x;
+        float oy = sy + along * obstacle.axis_y;
+
+        float distance = std::sqrt(ox * ox + oy * oy);
+        float clearance = distance - inflated;
+
+        if (clearance > this->influence_distance_m || distance < 1e-3)
+        {
+            continue;
+        }
+
+        min_clearance = std::min(min_clearance, clearance);
+
+        float weight = (this->influence_distance_m - std::max(clearance, 0.0f)) / this->influence_distance_m;
+        weight = weight * weight;
+
+        float away_x = -ox / distance;
+        float away_y = -oy / distance;
+        float tangent_x = -away_y;
+        float tangent_y = away_x;
+
+        float center_x = obstacle.x - _x;
+        float center_y = obstacle.y - _y;
+        float lean = center_x * direction_y - center_y * direction_x;
+
+        if ((center_x * tangent_y - center_y * tangent_x) * lean < 0)
+        {
+            tangent_x = -tangent_x;
+            tangent_y = -tangent_y;
+        }
+
+        field_x += weight * (away_x + this->tangential_gain * tangent_x);
+        field_y += weight * (away_y + this->tangential_gain * tangent_y);
+    }
+
+    if (!blocked)
+    {
+        return false;
+    }
+
+    this->active = true;
+
+    float avoid_x = direction_x + this->avoidance_gain * field_x;
+    float avoid_y = direction_y + this->avoidance_gain * field_y;
+
+    if (avoid_x * avoid_x + avoid_y * avoid_y > 1e-6)
+    {
+        /* Keep the heading continuous with the one given by the guidance law */
+        *_heading = _desired_heading + std::remainder(std::atan2(avoid_y, avoid_x) - _desired_heading, 2 * M_PI);
+    }
+
+    if (min_clearance < this->slow_down_distance_m)
+    {
+        float ratio = std::max(min_clearance, 0.0f) / this->slow_down_distance_m;
+        *_speed = _desired_speed * std::max(ratio, this->min_speed_ratio);
+    }
+
+    return true;
+}
@@ -0,0 +1,214 @@
+/** ----------------------------------------------------------------------------
+ * @file: speed_profile.cpp
+ * 
+ * @brief: Time optimal speed profile along a waypoint list. The path is
+ *         sampled by arc length and each sample gets the fastest speed that
+ *         the vehicle model can reach and still brake for what comes next:
+ *         a forward pass limits acceleration and a backward pass limits
+ *         deceleration, both from the surge thrust and the damping model.
+ *         Corners are limited by the yaw rate and the lateral acceleration
+ *         the sway thrust can hold, climbs by the heave thrust.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "speed_profile.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const float pi = 3.14159;
+
+SpeedProfile::SpeedProfile(const SpeedProfileLimits_S& _limits)
+{
+    this->limits            = _limits;
+    this->sample_distance   = _limits.sample_distance;
+}
+
+SpeedProfile::~SpeedProfile(){}
+
+float SpeedProfile::SurgeAcceleration(float _speed, float _thrust) const
+{
+    /* Damping works against the thrust while speeding up */
+    float damping = (this->vehicle.X_u + this->vehicle.X_uu * std::fabs(_speed)) * _speed;
+    return std::max(0.0f, (_thrust + damping) / (this->vehicle.mass - this->vehicle.X_u_dot));
+}
+
+float SpeedProfile::SurgeDeceleration(float _speed, float _thrust) const
+{
+    /* and helps the thrust while braking */
+    float damping = -(this->vehicle.X_u + this->vehicle.X_uu * std::fabs(_speed)) * _speed;
+    return std::max(0.0f, (_thrust + damping) / (this->vehicle.mass - this->vehicle.X_u_dot));
+}
+
+float SpeedProfile::TopSpeed(float _linear_damping, float _quadratic_damping, float _thrust)
+{
+    /* Speed where the damping force (-linear - quadratic * v) * v equals the thrust */
+    float a = -_quadratic_damping;
+    float b_term = -_linear_damping;
+
+    return (-b_term + std::sqrt(b_term * b_term + 4 * a * _thrust)) / (2 * a);
+}
+
+void SpeedProfile::Compute(const vanttec_uuv::GuidanceWaypoints& _waypoints, float _start_speed)
+{
+    size_t n = std::min((size_t) _waypoints.waypoint_list_length,
+                        std::min(_waypoints.waypoint_list_x.size(),
+                                 std::min(_waypoints.waypoint_list_y.size(), _waypoints.waypoint_list_z.size())));
+
+    this->speeds.clear();
+    this->waypoint_arc_length.assign(1, 0);
+    this->segment_horizontal_length.clear();
+    this->segment_speed_limit.clear();
+
+    if (n < 2)
+    {
+        this->speeds.push_back(0);
+        return;
+    }
+
+    const VehicleParameters& vehicle = this->vehicle;
+
+    float thrust_surge  = this->limits.thrust_margin * vehicle.MAX_THRUST_SURGE;
+    float thrust_heave  = std::max(0.0f, this->limits.thrust_margin * vehicle.MAX_THRUST_HEAVE - std::fabs(vehicle.weight - vehicle.buoyancy));
+    float lateral_acc   = this->limits.thrust_margin * vehicle.MAX_THRUST_SWAY / (vehicle.mass - vehicle.Y_v_dot);
+    float top_speed     = std::min(this->limits.max_speed, SpeedProfile::TopSpeed(vehicle.X_u, vehicle.X_uu, thrust_surge));
+    float top_heave     = SpeedProfile::TopSpeed(vehicle.Z_w, vehicle.Z_ww, thrust_heave);
+
+    /* Segment lengths and speed caps */
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        float dx = _waypoints.waypoint_list_x[i + 1] - _waypoints.waypoint_list_x[i];
+        float dy = _waypoints.waypoint_list_y[i + 1] - _waypoints.waypoint_list_y[i];
+        float dz = _waypoints.waypoint_list_z[i + 1] - _waypoints.waypoint_list_z[i];
+
+        float horizontal = std::sqrt(dx * dx + dy * dy);
+        float length = std::sqrt(horizontal * horizontal + dz * dz);
+        float limit = top_speed;
+
+        if (i + 1 < _waypoints.waypoint_list_speed.size() && _waypoints.waypoint_list_speed[i + 1] > 0)
+        {
+            limit = std::min(limit, _waypoints.waypoint_list_speed[i + 1]);
+        }
+
+        /* Keep the vertical component within what the heave thrust can do */
+        if (std::fabs(dz) > 1e-3)
+        {
+            limit = std::min(limit, top_heave * length / std::fabs(dz));
+        }
+
+        this->waypoint_arc_length.push_back(this->waypoint_arc_length.back() + length);
+        this->segment_horizontal_length.push_back(horizontal);
+        this->segment_speed_limit.push_back(limit);
+    }
+
+    float total_length = this->waypoint_arc_length.back();
+
+    /* Coarser samples rather than unbounded memory on very long lists */
+    this->sample_distance = std::max(this->limits.sample_distance, total_length / this->limits.max_samples);
+
+    size_t samples = (size_t) std::ceil(total_length / this->sample_distance) + 1;
+    this->speeds.assign(samples, top_speed);
+
+    /* Samples on a waypoint take the lower cap of both segments */
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        size_t first = (size_t) std::ceil(this->waypoint_arc_length[i] / this->sample_distance);
+        size_t last = std::min(samples - 1, (size_t) std::floor(this->waypoint_arc_length[i + 1] / this->sample_distance));
+
+        for (size_t k = first; k <= last; k++)
+        {
+            this->speeds[k] = std::min(this->speeds[k], this->segment_speed_limit[i]);
+        }
+    }
+
+    /* Corners: yaw rate and lateral acceleration over the turn distance */
+    for (size_t i = 1; i + 1 < n; i++)
+    {
+        size_t k = std::min(samples - 1, (size_t) std::floor(this->waypoint_arc_length[i] / this->sample_distance + 0.5f));
+
+        /* Vertical legs are dived from a stop */
+        if (this->segment_horizontal_length[i - 1] < 1e-3 || this->segment_horizontal_length[i] < 1e-3)
+        {
+            this->speeds[k] = 0;
+            continue;
+        }
+
+        float heading_in = std::atan2(_waypoints.waypoint_list_y[i] - _waypoints.waypoint_list_y[i - 1],
+                                      _waypoints.waypoint_list_x[i] - _waypoints.waypoint_list_x[i - 1]);
+        float heading_out = std::atan2(_waypoints.waypoint_list_y[i + 1] - _waypoints.waypoint_list_y[i],
+                                       _waypoints.waypoint_list_x[i + 1] - _waypoints.waypoint_list_x[i]);
+        float turn = std::fabs(std::remainder(heading_out - heading_in, 2 * pi));
+
+        if (turn < 1e-3 && !this->limits.stop_at_waypoints)
+        {
+            continue;
+        }
+
+        float curvature = turn / this->limits.turn_distance;
+        float corner_speed = this->limits.stop_at_waypoints ? 0 :
+                             std::min(this->limits.max_yaw_rate / curvature, std::sqrt(lateral_acc / curvature));
+
+        this->speeds[k] = std::min(this->speeds[k], corner_speed);
+    }
+
+    this->speeds[0] = std::min(this->speeds[0], std::max(0.0f, _start_speed));
+    this->speeds[samples - 1] = 0;
+
+    /* Forward pass: v^2 <= v_prev^2 + 2 a(v_prev) ds */
+    for (size_t k = 1; k < samples; k++)
+    {
+        float v = this->speeds[k - 1];
+        float reachable = std::sqrt(v * v + 2 * this->SurgeAcceleration(v, thrust_surge) * this->sample_distance);
+        this->speeds[k] = std::min(this->speeds[k], reachable);
+    }
+
+    /* Backward pass: v^2 <= v_next^2 + 2 d(v_next) ds */
+    for (size_t k = samples - 1; k > 0; k--)
+    {
+        float v = this->speeds[k];
+        float brakable = std::sqrt(v * v + 2 * this->SurgeDeceleration(v, thrust_surge) * this->sample_distance);
+        this->speeds[k - 1] = std::min(this->speeds[k - 1], brakable);
+    }
+}
+
+float SpeedProfile::Lookup(int _segment, float _along_track_distance) const
+{
+    if (_segment < 0 || _segment >= (int) this->segment_horizontal_length.size())
+    {
+        return 0;
+    }
+
+    float horizontal = this->segment_horizontal_length[_segment];
+    float length = this->waypoint_arc_length[_segment + 1] - this->waypoint_arc_length[_segment];
+    float fraction = (horizontal > 1e-3) ? std::min(1.0f, std::max(0.0f, _along_track_distance / horizontal)) : 0;
+
+    /* The command is the speed one sample ahead, the one to reach; this way a vehicle
+       at rest is not held there by the zero speed at its own position */
+    float position = (this->waypoint_arc_length[_segment] + fraction * length) / this->sample_distance + 1;
+    size_t k = std::min((size_t) position, this->speeds.size() - 1);
+
+    if (k + 1 >= this->speeds.size())
+    {
+        return this->speeds[k];
+    }
+
+    float t = position - k;
+    return this->speeds[k] + t * (this->speeds[k + 1] - this->speeds[k]);
+}
+
+float SpeedProfile::Duration() const
+{
+    float duration = 0;
+
+    for (size_t k = 1; k < this->speeds.size(); k++)
+    {
+        float mean_speed = (this->speeds[k] + this->speeds[k - 1]) / 2;
+
+        if (mean_speed > 1e-4)
+        {
+            duration += this->sample_distance / mean_speed;
+        }
+    }
+
+    return duration;
+}
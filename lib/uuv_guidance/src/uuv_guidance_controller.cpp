@@ -11,7 +11,33 @@
 
 #include <uuv_guidance_controller.hpp>
 
-GuidanceController::GuidanceController()
+/* Plan with 70% of the thrust, corners are turned over twice the lookahead distance */
+static const SpeedProfileLimits_S LOS_SPEED_PROFILE_LIMITS = {0.9, 0.7, 0.5, 1.8, 0.05, 1 << 20, false};
+
+/* Names of the tunable parameters, in the order of TunableParameter */
+static const char* const GUIDANCE_TUNABLE_NAMES[GUIDANCE_TUNABLE_PARAMETERS] =
+{
+    "los_lookahead_distance",
+    "los_max_speed",
+    "los_thrust_margin",
+    "los_max_yaw_rate",
+    "orbit_speed_gain",
+};
+
+static int TunableIndex(const std::string& _name)
+{
+    for (size_t i = 0; i < GUIDANCE_TUNABLE_PARAMETERS; i++)
+    {
+        if (_name == GUIDANCE_TUNABLE_NAMES[i])
+        {
+            return (int) i;
+        }
+    }
+
+    return -1;
+}
+
+GuidanceController::GuidanceController() : obstacle_avoidance(256, 1024, 2.0), speed_profile(LOS_SPEED_PROFILE_LIMITS)
 {
     /* Desired speed output initalization */
     this->desired_setpoints.linear.x = 0;
@@ -23,6 +49,12 @@ GuidanceController::GuidanceController()
     this->current_guidance_law = NONE;
     this->los_state_machine.state_machine = LOS_LAW_STANDBY;
 
+    /* 3D LOS Init, shares the LOS parameters */
+    this->los_3d_state_machine.state_machine = LOS_3D_LAW_STANDBY;
+    this->los_3d_state_machine.current_waypoint = 0;
+    this->los_3d_state_machine.horizontal_cross_track_error = 0;
+    this->los_3d_state_machine.vertical_cross_track_error = 0;
+
     /* LOS Parameter Init */
     this->los_state_machine.current_waypoint = 0;
     this->los_depth_error_threshold = 0.01;
@@ -31,7 +63,9 @@ GuidanceController::GuidanceController()
     this->los_max_speed = 0.9;
     this->los_position_error_threshold = 0.4;
     this->los_euclidean_distance = 0;
-    this->los_speed_gain = 100;
+    this->speed_profile.limits.max_speed = this->los_max_speed;
+    this->speed_profile.limits.turn_distance = 2 * this->los_lookahead_distance;
+    this->SetLOSSwitching(LOS_SWITCH_LOOKAHEAD, this->los_position_error_threshold, this->los_lookahead_distance);
 
     /* Orbit Parameter Init */
     this->orbit_state_machine.current_waypoint = 0;
@@ -42,21 +76,64 @@ GuidanceController::GuidanceController()
     this->orbit_position_error_threshold = 0.4;
     this->orbit_euclidean_distance = 0;
     this->orbit_speed_gain = 100;
+
+    this->requested_parameter_mask = 0;
+    this->recorder = NULL;
 }
 
 GuidanceController::~GuidanceController(){}
         
-void GuidanceController::OnCurrentPositionReception(const geometry_msgs::Pose& _pose)
+void GuidanceController::OnCurrentPositionReception(const vanttec_uuv::VehicleState& _state)
 {
     /* Store the current position in NED coordinates */
-    this->current_positions_ned.position.x      = _pose.position.x;
-    this->current_positions_ned.position.y      = _pose.position.y;
-    this->current_positions_ned.position.z      = _pose.position.z;
-    this->current_positions_ned.orientation.z   = _pose.orientation.z;
+    this->current_positions_ned.position.x      = _state.x;
+    this->current_positions_ned.position.y      = _state.y;
+    this->current_positions_ned.position.z      = _state.z;
+    this->current_positions_ned.orientation.z   = _state.yaw;
+
+    this->current_velocities_body.linear.x      = _state.u;
+    this->current_velocities_body.linear.y      = _state.v;
+    this->current_velocities_body.linear.z      = _state.w;
+    this->current_velocities_body.angular.z     = _state.r;
+
+    this->state_trace                           = _state.trace;
+
+    if (this->recorder != NULL)
+    {
+        this->recorder->RecordState(ros::Time::now().toSec(), _state);
+    }
 }
 
 void GuidanceController::OnWaypointReception(const vanttec_uuv::GuidanceWaypoints& _waypoints)
 {
+    /* Lists from the missions in this process come through here too */
+    if (this->recorder != NULL)
+    {
+        this->recorder->RecordWaypoints(ros::Time::now().toSec(), _waypoints);
+    }
+
+    /* Every law follows segments and reads the waypoint after the current one; a list
+       with no law stops the current one and is taken whatever its waypoints */
+    size_t length = _waypoints.waypoint_list_length;
+
+    if (_waypoints.guidance_law != NONE)
+    {
+        if (length < 2)
+        {
+            ROS_WARN("Guidance: waypoint list %u rejected, %lu waypoints do not make a segment",
+                     _waypoints.sequence, (unsigned long) length);
+            return;
+        }
+
+        if (_waypoints.waypoint_list_x.size() < length || _waypoints.waypoint_list_y.size() < length ||
+            _waypoints.waypoint_list_z.size() < length)
+        {
+            ROS_WARN("Guidance: waypoint list %u rejected, it has fewer coordinates than its %lu waypoints",
+                     _waypoints.sequence, (unsigned long) length);
+            return;
+        }
+    }
+
     /* Waypoints update (and therefore, guidance law triggering) can only be done when the guidance
     node is not executing any other type of action/law; only acceptable input is an emergency stop */
     
@@ -66,10 +143,20 @@ void GuidanceController::OnWaypointReception(const vanttec_uuv::GuidanceWaypoint
         case LOS_GUIDANCE_LAW:
             this->los_state_machine.state_machine = LOS_LAW_DEPTH_NAV;
             this->orbit_state_machine.state_machine = ORBIT_LAW_STANDBY;
+            this->los_3d_state_machine.state_machine = LOS_3D_LAW_STANDBY;
+            /* Plan the speeds of the whole list, starting from the current surge speed */
+            this->speed_profile.Compute(_waypoints, this->current_velocities_body.linear.x);
             break;
         case ORBIT_GUIDANCE_LAW:
             this->orbit_state_machine.state_machine = ORBIT_LAW_DEPTH_NAV;
             this->los_state_machine.state_machine = LOS_LAW_STANDBY;
+            this->los_3d_state_machine.state_machine = LOS_3D_LAW_STANDBY;
+            break;
+        case LOS_3D_GUIDANCE_LAW:
+            this->los_3d_state_machine.state_machine = LOS_3D_LAW_PATH_FOLLOWING;
+            this->los_state_machine.state_machine = LOS_LAW_STANDBY;
+            this->orbit_state_machine.state_machine = ORBIT_LAW_STANDBY;
+            this->speed_profile.Compute(_waypoints, this->current_velocities_body.linear.x);
             break;
         case NONE:
         default:
@@ -77,11 +164,18 @@ void GuidanceController::OnWaypointReception(const vanttec_uuv::GuidanceWaypoint
     }
 
     this->los_state_machine.current_waypoint = 0;
+    this->los_3d_state_machine.current_waypoint = 0;
     this->orbit_state_machine.current_waypoint = 0;
 
     /* Update the current guidance law selection and the internal waypoint list */
     this->current_guidance_law = (GuidanceLaws_E) _waypoints.guidance_law;
     this->current_waypoint_list = _waypoints;
+
+    /* Depth is blended along the legs when flying through waypoints */
+    if (this->current_guidance_law == LOS_GUIDANCE_LAW && this->los_switching_mode != LOS_SWITCH_STOP && !this->IsVerticalLOSLeg(0))
+    {
+        this->los_state_machine.state_machine = LOS_LAW_WAYPOINT_NAV;
+    }
  
 }
 
@@ -94,17 +188,71 @@ void GuidanceController::OnEmergencyStop(const std_msgs::Empty& _msg)
     /* Reset the guidance law and the state machines */
     this->current_guidance_law = NONE;
     this->los_state_machine.state_machine = LOS_LAW_STANDBY;
+    this->los_3d_state_machine.state_machine = LOS_3D_LAW_STANDBY;
+
+    if (this->recorder != NULL)
+    {
+        this->recorder->RecordEmergencyStop(ros::Time::now().toSec());
+    }
 }
 
 void GuidanceController::OnMasterStatus(const vanttec_uuv::MasterStatus& _status)
 {
     /* Store the current status */
     this->uuv_status = _status; 
+
+    if (this->recorder != NULL)
+    {
+        this->recorder->RecordMasterStatus(ros::Time::now().toSec(), _status);
+    }
 }
 
+void GuidanceController::OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles)
+{
+    if (this->recorder != NULL)
+    {
+        this->recorder->RecordObstacles(ros::Time::now().toSec(), _obstacles);
+    }
+
+    /* Keep only the latest obstacles, in NED around the current position */
+    float x_uuv = this->current_positions_ned.position.x;
+    float y_uuv = this->current_positions_ned.position.y;
+    float yaw   = this->current_positions_ned.orientation.z;
+
+    /* Detections from the perception come in the body frame */
+    bool in_body_frame = (_obstacles.header.frame_id != "world");
+
+    this->obstacle_avoidance.Clear();
+
+    for (size_t i = 0; i < _obstacles.obstacles.size(); i++)
+    {
+        const vanttec_uuv::Obstacle& obstacle = _obstacles.obstacles[i];
+
+        float x = obstacle.pose.position.x;
+        float y = obstacle.pose.position.y;
+        float obstacle_yaw = 2 * std::atan2(obstacle.pose.orientation.z, obstacle.pose.orientation.w);
+
+        if (in_body_frame)
+        {
+            float body_x = x;
+            float body_y = y;
+            x = x_uuv + body_x * std::cos(yaw) - body_y * std::sin(yaw);
+            y = y_uuv + body_x * std::sin(yaw) + body_y * std::cos(yaw);
+            obstacle_yaw += yaw;
+        }
+
+        /* Walls are kept as the segment along their length, so gaps between them stay open */
+        this->obstacle_avoidance.Insert(x, y, obstacle.radio, obstacle.length, obstacle_yaw, x_uuv, y_uuv);
+    }
+}
 
 void GuidanceController::UpdateStateMachines()
 {
+    if (this->requested_parameter_mask != 0)
+    {
+        this->ApplyRequestedParameters();
+    }
+
     /* Enter a specific state machine according to the selected guidance law. */
     switch(this->current_guidance_law)
     {
@@ -134,7 +282,10 @@ void GuidanceController::UpdateStateMachines()
                     //this->desired_setpoints.angular.z = 0;
                     this->desired_setpoints.linear.z = this->current_waypoint_list.waypoint_list_z[this->los_state_machine.current_waypoint + 1];
                     float los_depth_error = std::abs((float) this->current_positions_ned.position.z - (float) this->desired_setpoints.linear.z);
-                    if (los_depth_error <= this->los_depth_error_threshold)
+                    float los_depth_threshold = (this->los_switching_mode == LOS_SWITCH_STOP) ? this->los_depth_error_threshold :
+                                                this->WaypointAcceptanceRadius(this->los_state_machine.current_waypoint + 1,
+                                                                               this->los_position_error_threshold);
+                    if (los_depth_error <= los_depth_threshold)
                     {
                         this->los_state_machine.state_machine = LOS_LAW_WAYPOINT_NAV;
                     }
@@ -166,6 +317,20 @@ void GuidanceController::UpdateStateMachines()
                     float cross_track_error = - (x_uuv - x_k) * std::sin(alpha_k) + (y_uuv - y_k) * std::cos(alpha_k);
                     
                     float total_distance = (x_k1 - x_k) * std::cos(alpha_k) + (y_k1 - y_k) * std::sin(alpha_k);
+
+                    /* Planned speed at the current arc length of the path */
+                    float path_along_track_distance = along_track_distance;
+                    float desired_velocity = this->speed_profile.Lookup(this->los_state_machine.current_waypoint, along_track_distance);
+
+                    /* Blend the depth along the leg, leading by the lookahead distance like the heading */
+                    if (this->los_switching_mode != LOS_SWITCH_STOP)
+                    {
+                        float z_k  = this->current_waypoint_list.waypoint_list_z[this->los_state_machine.current_waypoint];
+                        float z_k1 = this->current_waypoint_list.waypoint_list_z[this->los_state_machine.current_waypoint + 1];
+                        float leg_fraction = (total_distance > 0) ? (along_track_distance + this->los_lookahead_distance) / total_distance : 1;
+
+                        this->desired_setpoints.linear.z = z_k + std::min(1.0f, std::max(0.0f, leg_fraction)) * (z_k1 - z_k);
+                    }
                     
                     if (along_track_distance > total_distance)
                     {
@@ -185,13 +350,14 @@ void GuidanceController::UpdateStateMachines()
                         desired_heading = (desired_heading/abs(desired_heading)) * (abs(desired_heading) - 2 * PI);
                     }*/
 
-                    float desired_velocity = (this->los_max_speed - this->los_min_speed) * 
-                                             (1 - (std::abs(along_track_distance) / std::sqrt(std::pow(along_track_distance, 2) + this->los_speed_gain)));
-
                     if (std::abs(this->current_positions_ned.orientation.z - desired_heading) > 0.75)
                     {
                         float desired_velocity = 0.075;
                     }
+
+                    /* Bend the heading and slow down if the lookahead segment is blocked */
+                    this->obstacle_avoidance.Update(x_uuv, y_uuv, desired_heading, desired_velocity,
+                                                    &desired_heading, &desired_velocity);
                     
                     this->desired_setpoints.linear.x = desired_velocity;
                     this->desired_setpoints.linear.y = 0;
@@ -199,20 +365,43 @@ void GuidanceController::UpdateStateMachines()
 
                     this->los_euclidean_distance = std::sqrt(std::pow((x_k1 - x_uuv), 2) + std::pow((y_k1 - y_uuv), 2));
 
-                    if (this->los_euclidean_distance <= this->los_position_error_threshold)
+                    bool last_waypoint = (this->los_state_machine.current_waypoint + LOS_WAYPOINT_OFFSET) >= this->current_waypoint_list.waypoint_list_length;
+                    bool switch_waypoint = (this->los_euclidean_distance <= this->WaypointAcceptanceRadius(this->los_state_machine.current_waypoint + 1,
+                                                                                                            this->los_position_error_threshold));
+
+                    /* Pass-through modes never turn back for a waypoint already passed, as long as the
+                       vehicle is following the leg; the last one is always reached */
+                    bool on_leg = std::abs(cross_track_error) <= 2 * this->los_lookahead_distance;
+
+                    if (!last_waypoint && on_leg && this->los_switching_mode != LOS_SWITCH_STOP)
+                    {
+                        switch_waypoint = switch_waypoint || (path_along_track_distance >= total_distance);
+
+                        if (this->los_switching_mode == LOS_SWITCH_LOOKAHEAD)
+                        {
+                            switch_waypoint = switch_waypoint || (total_distance - path_along_track_distance <= this->los_switching_distance);
+                        }
+                    }
+
+                    if (switch_waypoint)
                     {
-                        this->desired_setpoints.linear.x = 0;
-                        this->desired_setpoints.linear.y = 0;
-                        //this->desired_setpoints.angular.z = 0;
                         this->los_euclidean_distance = 0;
                         
-                        if ((this->los_state_machine.current_waypoint + LOS_WAYPOINT_OFFSET) < this->current_waypoint_list.waypoint_list_length)
+                        if (!last_waypoint)
                         {
                             this->los_state_machine.current_waypoint += 1;
-                            this->los_state_machine.state_machine = LOS_LAW_DEPTH_NAV;
+
+                            if (this->los_switching_mode == LOS_SWITCH_STOP || this->IsVerticalLOSLeg(this->los_state_machine.current_waypoint))
+                            {
+                                this->desired_setpoints.linear.x = 0;
+                                this->desired_setpoints.linear.y = 0;
+                                this->los_state_machine.state_machine = LOS_LAW_DEPTH_NAV;
+                            }
                         }
                         else
                         {
+                            this->desired_setpoints.linear.x = 0;
+                            this->desired_setpoints.linear.y = 0;
                             this->los_state_machine.state_machine = LOS_LAW_STANDBY;
                             this->los_state_machine.current_waypoint = 0;
                             this->current_guidance_law = NONE;
@@ -223,6 +412,115 @@ void GuidanceController::UpdateStateMachines()
             }
             break;
 
+        /* 3D Line-Of-Sight Guidance Law
+           Strategy:
+                - Project the vehicle on the current 3D segment and take the lookahead point along it.
+                - Steer towards the lookahead point horizontally and use its depth as the depth setpoint, so the
+                  horizontal and vertical cross track errors are corrected together while moving.
+                - Surge follows the speed profile, scaled to the horizontal component of the slope.
+                - Switch segments according to the switching mode; stop at the last waypoint.
+        */
+
+        case LOS_3D_GUIDANCE_LAW:
+
+            switch(this->los_3d_state_machine.state_machine)
+            {
+                case LOS_3D_LAW_STANDBY:
+                {
+                    this->desired_setpoints.linear.x = 0;
+                    this->desired_setpoints.linear.y = 0;
+                    this->los_3d_state_machine.current_waypoint = 0;
+                    break;
+                }
+                case LOS_3D_LAW_PATH_FOLLOWING:
+                {
+                    int k = this->los_3d_state_machine.current_waypoint;
+
+                    /* Create references for readability */
+                    float x_k  = this->current_waypoint_list.waypoint_list_x[k];
+                    float x_k1 = this->current_waypoint_list.waypoint_list_x[k + 1];
+
+                    float y_k  = this->current_waypoint_list.waypoint_list_y[k];
+                    float y_k1 = this->current_waypoint_list.waypoint_list_y[k + 1];
+
+                    float z_k  = this->current_waypoint_list.waypoint_list_z[k];
+                    float z_k1 = this->current_waypoint_list.waypoint_list_z[k + 1];
+
+                    float x_uuv = this->current_positions_ned.position.x;
+                    float y_uuv = this->current_positions_ned.position.y;
+                    float z_uuv = this->current_positions_ned.position.z;
+
+                    /* Path frame: tangent along the segment, horizontal normal and vertical normal */
+                    float horizontal_length = std::sqrt(std::pow(x_k1 - x_k, 2) + std::pow(y_k1 - y_k, 2));
+                    float total_distance = std::sqrt(std::pow(horizontal_length, 2) + std::pow(z_k1 - z_k, 2));
+
+                    /* Vertical segments keep the current heading as azimuth */
+                    float azimuth = (horizontal_length > 1e-3) ? std::atan2(y_k1 - y_k, x_k1 - x_k) : (float) this->desired_setpoints.angular.z;
+                    float cos_elevation = (total_distance > 1e-3) ? horizontal_length / total_distance : 1;
+                    float sin_elevation = (total_distance > 1e-3) ? (z_k1 - z_k) / total_distance : 0;
+
+                    float horizontal_along = (x_uuv - x_k) * std::cos(azimuth) + (y_uuv - y_k) * std::sin(azimuth);
+                    float along_track_distance = horizontal_along * cos_elevation + (z_uuv - z_k) * sin_elevation;
+
+                    this->los_3d_state_machine.horizontal_cross_track_error = - (x_uuv - x_k) * std::sin(azimuth) + (y_uuv - y_k) * std::cos(azimuth);
+                    this->los_3d_state_machine.vertical_cross_track_error = - horizontal_along * sin_elevation + (z_uuv - z_k) * cos_elevation;
+
+                    /* Lookahead point on the segment, not past its end */
+                    float lookahead_along = std::min(total_distance, std::max(0.0f, along_track_distance + this->los_lookahead_distance));
+
+                    float desired_heading = azimuth + std::atan(-(this->los_3d_state_machine.horizontal_cross_track_error / this->los_lookahead_distance));
+                    float desired_depth = z_k + lookahead_along * sin_elevation;
+
+                    /* Planned speed along the slope, of which surge takes the horizontal part */
+                    float desired_velocity = cos_elevation * this->speed_profile.Lookup(k, along_track_distance * cos_elevation);
+
+                    /* Bend the heading and slow down if the lookahead segment is blocked */
+                    this->obstacle_avoidance.Update(x_uuv, y_uuv, desired_heading, desired_velocity,
+                                                    &desired_heading, &desired_velocity);
+
+                    this->desired_setpoints.linear.x = desired_velocity;
+                    this->desired_setpoints.linear.y = 0;
+                    this->desired_setpoints.linear.z = desired_depth;
+                    this->desired_setpoints.angular.z = desired_heading;
+
+                    float euclidean_distance = std::sqrt(std::pow(x_k1 - x_uuv, 2) + std::pow(y_k1 - y_uuv, 2) + std::pow(z_k1 - z_uuv, 2));
+                    float cross_track_error = std::sqrt(std::pow(this->los_3d_state_machine.horizontal_cross_track_error, 2) +
+                                                        std::pow(this->los_3d_state_machine.vertical_cross_track_error, 2));
+
+                    bool last_waypoint = (k + LOS_WAYPOINT_OFFSET) >= this->current_waypoint_list.waypoint_list_length;
+                    bool switch_waypoint = (euclidean_distance <= this->WaypointAcceptanceRadius(k + 1, this->los_position_error_threshold));
+
+                    /* Same switching as the 2D law, with the acceptance sphere */
+                    if (!last_waypoint && cross_track_error <= 2 * this->los_lookahead_distance && this->los_switching_mode != LOS_SWITCH_STOP)
+                    {
+                        switch_waypoint = switch_waypoint || (along_track_distance >= total_distance);
+
+                        if (this->los_switching_mode == LOS_SWITCH_LOOKAHEAD)
+                        {
+                            switch_waypoint = switch_waypoint || (total_distance - along_track_distance <= this->los_switching_distance);
+                        }
+                    }
+
+                    if (switch_waypoint)
+                    {
+                        if (!last_waypoint)
+                        {
+                            this->los_3d_state_machine.current_waypoint += 1;
+                        }
+                        else
+                        {
+                            this->desired_setpoints.linear.x = 0;
+                            this->desired_setpoints.linear.y = 0;
+                            this->los_3d_state_machine.state_machine = LOS_3D_LAW_STANDBY;
+                            this->los_3d_state_machine.current_waypoint = 0;
+                            this->current_guidance_law = NONE;
+                        }
+                    }
+                    break;
+                }
+            }
+            break;
+
         /* Orbit Guidance Law 
            Strategy:
                 - Compute the desired speed and heading according to the LOS algorithm, adding 90 degrees to heading 
@@ -290,7 +588,8 @@ void GuidanceController::UpdateStateMachines()
                     
                     float desired_heading = alpha_k + std::atan(-(cross_track_error/this->los_lookahead_distance));
 
-                    float desired_velocity = (this->orbit_max_speed - this->orbit_min_speed) * 
+                    float max_speed = this->WaypointSpeed(this->orbit_state_machine.current_waypoint + 1, this->orbit_max_speed);
+                    float desired_velocity = (max_speed - this->orbit_min_speed) * 
                                              (1 - (std::abs(along_track_distance) / std::sqrt(std::pow(along_track_distance, 2) + this->orbit_speed_gain)));
 
                     if (std::abs(this->current_positions_ned.orientation.z - desired_heading) > 0.75)
@@ -304,7 +603,8 @@ void GuidanceController::UpdateStateMachines()
 
                     this->orbit_euclidean_distance = std::sqrt(std::pow((x_k1 - x_uuv), 2) + std::pow((y_k1 - y_uuv), 2));
 
-                    if (this->orbit_euclidean_distance <= this->orbit_position_error_threshold)
+                    if (this->orbit_euclidean_distance <= this->WaypointAcceptanceRadius(this->orbit_state_machine.current_waypoint + 1,
+                                                                                          this->orbit_position_error_threshold))
                     {
                         this->desired_setpoints.linear.x = 0;
                         this->desired_setpoints.linear.y = 0;
@@ -333,3 +633,192 @@ void GuidanceController::UpdateStateMachines()
             break;
     }
 }
+
+float GuidanceController::WaypointSpeed(int _waypoint, float _default) const
+{
+    const std::vector<float>& speeds = this->current_waypoint_list.waypoint_list_speed;
+
+    if (_waypoint < (int) speeds.size() && speeds[_waypoint] > 0)
+    {
+        return std::min(speeds[_waypoint], _default);
+    }
+
+    return _default;
+}
+
+float GuidanceController::WaypointAcceptanceRadius(int _waypoint, float _default) const
+{
+    const std::vector<float>& radii = this->current_waypoint_list.waypoint_list_acceptance_radius;
+
+    if (_waypoint < (int) radii.size() && radii[_waypoint] > 0)
+    {
+        return radii[_waypoint];
+    }
+
+    return _default;
+}
+
+void GuidanceController::SetLOSSwitching(LOSSwitchingModes_E _mode, float _acceptance_radius, float _switching_distance)
+{
+    this->los_switching_mode = _mode;
+    this->los_position_error_threshold = _acceptance_radius;
+    this->los_switching_distance = _switching_distance;
+
+    /* The speed profile has to plan the stops */
+    this->speed_profile.limits.stop_at_waypoints = (_mode == LOS_SWITCH_STOP);
+}
+
+LOSSwitchingModes_E GuidanceController::LOSSwitchingModeFromName(const std::string& _name)
+{
+    if (_name == "stop")
+    {
+        return LOS_SWITCH_STOP;
+    }
+    else if (_name == "acceptance")
+    {
+        return LOS_SWITCH_ACCEPTANCE_CIRCLE;
+    }
+    else
+    {
+        return LOS_SWITCH_LOOKAHEAD;
+    }
+}
+
+bool GuidanceController::IsVerticalLOSLeg(int _waypoint) const
+{
+    if (_waypoint + 1 >= (int) this->current_waypoint_list.waypoint_list_length)
+    {
+        return false;
+    }
+
+    float dx = this->current_waypoint_list.waypoint_list_x[_waypoint + 1] - this->current_waypoint_list.waypoint_list_x[_waypoint];
+    float dy = this->current_waypoint_list.waypoint_list_y[_waypoint + 1] - this->current_waypoint_list.waypoint_list_y[_waypoint];
+
+    return std::sqrt(dx * dx + dy * dy) <= this->WaypointAcceptanceRadius(_waypoint + 1, this->los_position_error_threshold);
+}
+
+void GuidanceController::UpdateGuidanceStatus()
+{
+    /* Progress along the current waypoint list, for the nodes that stream waypoints */
+    this->guidance_status.header.stamp              = ros::Time::now();
+    this->guidance_status.guidance_law              = this->current_guidance_law;
+    this->guidance_status.waypoint_list_sequence    = this->current_waypoint_list.sequence;
+    this->guidance_status.waypoint_list_length      = this->current_waypoint_list.waypoint_list_length;
+
+    switch(this->current_guidance_law)
+    {
+        case LOS_GUIDANCE_LAW:
+            this->guidance_status.current_waypoint = this->los_state_machine.current_waypoint;
+            break;
+        case ORBIT_GUIDANCE_LAW:
+            this->guidance_status.current_waypoint = this->orbit_state_machine.current_waypoint;
+            break;
+        case LOS_3D_GUIDANCE_LAW:
+            this->guidance_status.current_waypoint = this->los_3d_state_machine.current_waypoint;
+            break;
+        case NONE:
+        default:
+            this->guidance_status.current_waypoint = -1;
+            break;
+    }
+}
+
+float* GuidanceController::TunableParameter(size_t _index)
+{
+    switch (_index)
+    {
+        case 0:
+            return &this->los_lookahead_distance;
+        case 1:
+            return &this->speed_profile.limits.max_speed;
+        case 2:
+            return &this->speed_profile.limits.thrust_margin;
+        case 3:
+            return &this->speed_profile.limits.max_yaw_rate;
+        default:
+            return &this->orbit_speed_gain;
+    }
+}
+
+void GuidanceController::ApplyRequestedParameters()
+{
+    for (size_t i = 0; i < GUIDANCE_TUNABLE_PARAMETERS; i++)
+    {
+        if (this->requested_parameter_mask & (1 << i))
+        {
+            *this->TunableParameter(i) = this->requested_parameters[i];
+        }
+    }
+
+    /* Lists already planned keep their speeds and corners until the next one */
+    this->speed_profile.limits.turn_distance = 2 * this->los_lookahead_distance;
+    this->requested_parameter_mask = 0;
+}
+
+bool GuidanceController::RequestParameter(const std::string& _name, float _value)
+{
+    int index = TunableIndex(_name);
+
+    if (index < 0)
+    {
+        return false;
+    }
+
+    this->requested_parameters[index] = _value;
+    this->requested_parameter_mask |= (1 << index);
+    return true;
+}
+
+bool GuidanceController::OnSetParameters(vanttec_uuv::SetParameters::Request& _request, vanttec_uuv::SetParameters::Response& _response)
+{
+    _response.success = false;
+
+    if (_request.names.size() != _request.values.size())
+    {
+        _response.message = "names and values differ in length";
+        return true;
+    }
+
+    for (size_t i = 0; i < _request.names.size(); i++)
+    {
+        int index = TunableIndex(_request.names[i]);
+
+        if (index < 0)
+        {
+            _response.message = "unknown parameter " + _request.names[i];
+            return true;
+        }
+
+        /* The lookahead distance divides the cross track error, a zero speed or yaw rate
+           limit plans a list that is never flown and the margin is a fraction of the thrust */
+        if (!std::isfinite(_request.values[i]) || _request.values[i] < 0 ||
+            (index <= 3 && _request.values[i] == 0) || (index == 2 && _request.values[i] > 1))
+        {
+            _response.message = "parameter " + _request.names[i] + " out of range";
+            return true;
+        }
+    }
+
+    double time_s = ros::Time::now().toSec();
+
+    for (size_t i = 0; i < _request.names.size(); i++)
+    {
+        this->RequestParameter(_request.names[i], _request.values[i]);
+
+        if (this->recorder != NULL)
+        {
+            this->recorder->RecordParameter(time_s, _request.names[i].c_str(), _request.values[i]);
+        }
+
+        ROS_INFO("Guidance: %s set to %g", _request.names[i].c_str(), _request.values[i]);
+    }
+
+    for (size_t i = 0; i < GUIDANCE_TUNABLE_PARAMETERS; i++)
+    {
+        _response.names.push_back(GUIDANCE_TUNABLE_NAMES[i]);
+        _response.values.push_back((this->requested_parameter_mask & (1 << i)) ? this->requested_parameters[i] : *this->TunableParameter(i));
+    }
+
+    _response.success = true;
+    return true;
+}
@@ -0,0 +1,91 @@
+/** ----------------------------------------------------------------------------
+ * @file: behavior_tree.hpp
+ * 
+ * @brief: Behavior tree with preallocated nodes, used to run missions. Nodes
+ *         live in a fixed capacity pool and are linked by index, leaves are
+ *         plain function pointers, so ticking never allocates.
+ *
+ *         Sequences and fallbacks keep their running child between ticks, so
+ *         a tick resumes where the previous one stopped. Ticks have a time
+ *         budget, checked before every leaf: when it runs out the tick
+ *         returns BT_RUNNING and the next one carries on from that leaf.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __BEHAVIOR_TREE_H__
+#define __BEHAVIOR_TREE_H__
+
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+
+typedef enum BehaviorStatus_E
+{
+    BT_SUCCESS = 0,
+    BT_FAILURE = 1,
+    BT_RUNNING = 2,
+} BehaviorStatus_E;
+
+typedef enum BehaviorNodeType_E
+{
+    BT_SEQUENCE = 0,
+    BT_FALLBACK = 1,
+    BT_ACTION = 2,
+    BT_CONDITION = 3,
+    BT_INVERTER = 4,
+} BehaviorNodeType_E;
+
+typedef BehaviorStatus_E (*BehaviorCallback)(void* _context);
+
+const uint16_t BT_NO_NODE = 0xFFFF;
+
+typedef struct BehaviorNode_S
+{
+    BehaviorNodeType_E  type;
+    const char*         name;
+    BehaviorCallback    callback;
+    void*               context;
+    uint16_t            first_child;
+    uint16_t            last_child;
+    uint16_t            next_sibling;
+    /* Child being run by a composite, BT_NO_NODE when idle */
+    uint16_t            running_child;
+    BehaviorStatus_E    last_status;
+} BehaviorNode_S;
+
+class BehaviorTree
+{
+    public:
+
+        std::vector<BehaviorNode_S> nodes;
+        uint16_t                    root;
+
+        /* Statistics of the last tick */
+        uint32_t                    tick_leaves;
+        uint32_t                    budget_overruns;
+        const char*                 running_leaf;
+
+        BehaviorTree(uint16_t _capacity);
+        ~BehaviorTree();
+
+        /* Building, returns BT_NO_NODE when the pool is full. Nodes without parent become the root */
+        uint16_t AddComposite(BehaviorNodeType_E _type, const char* _name, uint16_t _parent);
+        uint16_t AddLeaf(BehaviorNodeType_E _type, const char* _name, BehaviorCallback _callback, void* _context, uint16_t _parent);
+        void Clear();
+
+        /* Forgets the running children, the next tick starts from the root */
+        void Reset();
+
+        BehaviorStatus_E Tick(std::chrono::microseconds _budget);
+
+    private:
+
+        uint16_t                                capacity;
+        std::chrono::steady_clock::time_point   deadline;
+        bool                                    budget_exhausted;
+
+        uint16_t AddNode(BehaviorNodeType_E _type, const char* _name, uint16_t _parent);
+        BehaviorStatus_E TickNode(uint16_t _index);
+};
+
+#endif
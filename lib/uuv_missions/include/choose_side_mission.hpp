@@ -1,22 +1,53 @@
+/** ----------------------------------------------------------------------------
+ * @file: choose_side_mission.hpp
+ * @date: July 30, 2020
+ * @author: Pedro Sanchez
+ * @email: pedro.sc.97@gmail.com
+ * 
+ * @brief: Choose side mission, native port of the auto_nav_position script.
+ *         Goes through the left or right opening of three post gates, pushing
+ *         forward between them until the configured number of gates is done.
+ * -----------------------------------------------------------------------------
+ * */
+
 #ifndef __CHOOSE_SIDE_MISSION__
 #define __CHOOSE_SIDE_MISSION__
 
+#include <vector>
+
+#include <ros/ros.h>
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Path.h>
 #include <vanttec_uuv/GuidanceWaypoints.h>
+#include <vanttec_uuv/ObstacleList.h>
+#include <vanttec_uuv/VehicleState.h>
 
 typedef enum ChooseSideStates_E
 {
-    STANDBY = 0,
-    SEARCH = 1,
-    CALCULATE = 2,
-    NAVIGATE = 3,
+    CHOOSE_SIDE_STANDBY = 0,
+    CHOOSE_SIDE_SEARCH = 1,
+    CHOOSE_SIDE_CALCULATE = 2,
+    CHOOSE_SIDE_NAVIGATE = 3,
+    CHOOSE_SIDE_DONE = 4,
 } ChooseSideStates_E;
 
 typedef enum Side_E
 {
-    LEFT = 0,
-    RIGHT = 1,
+    SIDE_LEFT = 0,
+    SIDE_RIGHT = 1,
 } Side_E;
 
+/* Gate post in the body frame at reception, x forward and y to starboard */
+typedef struct GatePost_S
+{
+    float   x;
+    float   y;
+    float   distance;
+} GatePost_S;
+
+const size_t    MAX_GATE_POSTS  = 32;
+
 class ChooseSideMission
 {
     public:
@@ -24,18 +55,65 @@ class ChooseSideMission
         Side_E                  selected_side;
         ChooseSideStates_E      state_machine;
 
+        /* Gate offset geometry */
+        float                   distance_away;
+        float                   pass_distance;
+        float                   search_distance;
+        float                   min_gate_distance;
+        float                   replan_distance;
+
+        /* Timeouts of the script, in seconds */
+        float                   lost_timeout;
+        float                   search_delay;
+
+        uint8_t                 gate_count;
+        uint8_t                 gates_passed;
+
         vanttec_uuv::GuidanceWaypoints  desired_waypoints;
+        nav_msgs::Path                  path;
         geometry_msgs::Pose             current_position;
 
+        /* Stamp of the detections used for the last decision, set only when the
+           waypoints of this iteration come from detections and not from the search */
+        ros::Time                       decision_stamp;
+        bool                            detection_decision;
+
         ChooseSideMission();
         ~ChooseSideMission();
 
-        void OnPoseReception();
-        void On
-        void 
+        void OnPoseReception(const vanttec_uuv::VehicleState& _state);
+        void OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles);
 
-        void Iteration();
-};
+        /* Returns true when there are new waypoints to publish */
+        bool Iteration(double _time_s);
+
+    private:
+
+        std::vector<GatePost_S>     posts;
+        ros::Time                   posts_stamp;
+        bool                        new_detections;
+        double                      last_valid_time_s;
+        double                      search_time_s;
+        bool                        search_sent;
 
+        /* Pose at the time of the detections, to move them to NED */
+        float                       posts_x;
+        float                       posts_y;
+        float                       posts_yaw;
+
+        /* NED gate heading and last target, for the search */
+        float                       ned_alpha;
+        float                       target_x;
+        float                       target_y;
+
+        uint32_t                    sequence;
+
+        /* Computes the waypoints through the selected opening, false if no usable gate.
+           _send is set when they changed enough to be sent, or always when forced. */
+        bool CenterPoint(bool _force, bool* _send);
+        void Farther();
+        void BodyToNed(float _x, float _y, float* _ned_x, float* _ned_y) const;
+        void SendWaypoints(const float* _x, const float* _y, uint8_t _count);
+};
 
-#endif
\ No newline at end of file
+#endif // __CHOOSE_SIDE_MISSION__
@@ -0,0 +1,201 @@
+/** ----------------------------------------------------------------------------
+ * @file: mission_coroutine.hpp
+ * 
+ * @brief: Stackless coroutines to write missions as plain sequential code,
+ *         and the single threaded scheduler that resumes them.
+ *
+ *         A mission script derives from MissionCoroutine and writes its
+ *         Resume body between MISSION_BEGIN and MISSION_END, suspending with
+ *         MISSION_AWAIT on one of the scheduler waits:
+ *
+ *             MISSION_BEGIN();
+ *             MISSION_AWAIT(_scheduler.ReachDepth(1.0));
+ *             MISSION_AWAIT(_scheduler.Detect("gate", 30));
+ *             if (this->wait_result != WAIT_DONE) MISSION_FAIL();
+ *             MISSION_END();
+ *
+ *         The body is a switch on the resume point, so locals do not survive
+ *         an await, keep that state in members. Suspended coroutines sit in
+ *         the list of the event they wait for, or in the timer heap, and are
+ *         only looked at when that event arrives or the timer expires.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __MISSION_COROUTINE_H__
+#define __MISSION_COROUTINE_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include <ros/ros.h>
+#include <std_msgs/UInt8.h>
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Path.h>
+#include <vanttec_uuv/GuidanceStatus.h>
+#include <vanttec_uuv/GuidanceWaypoints.h>
+#include <vanttec_uuv/ObstacleList.h>
+#include <vanttec_uuv/VehicleState.h>
+
+/********** Coroutine Body Macros ***********/
+
+#define MISSION_BEGIN()         switch (this->resume_point) { case 0:
+
+#define MISSION_AWAIT(_wait)    do { this->wait = (_wait); this->resume_point = __LINE__; \
+                                     return COROUTINE_SUSPENDED; case __LINE__:; } while (0)
+
+#define MISSION_FAIL()          do { this->resume_point = -1; return COROUTINE_FAILED; } while (0)
+
+#define MISSION_END()           default: break; } this->resume_point = -1; return COROUTINE_DONE
+
+/********** Waits ***********/
+
+typedef enum CoroutineStatus_E
+{
+    COROUTINE_SUSPENDED = 0,
+    COROUTINE_DONE = 1,
+    COROUTINE_FAILED = 2,
+} CoroutineStatus_E;
+
+typedef enum MissionWaitType_E
+{
+    WAIT_TIME = 0,
+    WAIT_DEPTH = 1,
+    WAIT_FOLLOW = 2,
+    WAIT_DETECT = 3,
+} MissionWaitType_E;
+
+typedef enum MissionWaitResult_E
+{
+    WAIT_DONE = 0,
+    WAIT_TIMEOUT = 1,
+    /* The waypoints being followed were replaced by another source */
+    WAIT_PREEMPTED = 2,
+} MissionWaitResult_E;
+
+typedef struct MissionWait_S
+{
+    MissionWaitType_E   type;
+    /* Relative on creation, no timeout when not positive */
+    double              timeout_s;
+    float               depth;
+    float               tolerance;
+    uint32_t            sequence;
+    bool                accepted;
+    const char*         obstacle_class;
+} MissionWait_S;
+
+const uint16_t COROUTINE_NO_SLOT = 0xFFFF;
+
+class MissionScheduler;
+
+/********** Coroutine ***********/
+
+class MissionCoroutine
+{
+    public:
+
+        const char*             name;
+
+        /* Resume state, written by the body macros */
+        int                     resume_point;
+        MissionWait_S           wait;
+
+        /* Outcome of the last wait, and the NED position of what Detect found */
+        MissionWaitResult_E     wait_result;
+        float                   detected_x;
+        float                   detected_y;
+
+        /* Scheduler bookkeeping, the generation drops stale wait entries */
+        uint16_t                slot;
+        uint32_t                generation;
+
+        MissionCoroutine(const char* _name);
+        virtual ~MissionCoroutine();
+
+        virtual CoroutineStatus_E Resume(MissionScheduler& _scheduler) = 0;
+};
+
+/********** Scheduler ***********/
+
+typedef struct CoroutineWaiter_S
+{
+    uint16_t    slot;
+    uint32_t    generation;
+} CoroutineWaiter_S;
+
+typedef struct CoroutineTimer_S
+{
+    double      deadline_s;
+    uint16_t    slot;
+    uint32_t    generation;
+} CoroutineTimer_S;
+
+class MissionScheduler
+{
+    public:
+
+        geometry_msgs::Pose             current_pose;
+        double                          time_s;
+
+        /* Waypoints for guidance, new_waypoints is set when they change */
+        vanttec_uuv::GuidanceWaypoints  waypoints;
+        nav_msgs::Path                  path;
+        bool                            new_waypoints;
+
+        /* Statistics */
+        uint32_t                        resumes;
+        uint16_t                        running;
+
+        MissionScheduler(uint16_t _capacity);
+        ~MissionScheduler();
+
+        /* Starts the coroutine from its beginning on the next tick, false if full or already running */
+        bool Spawn(MissionCoroutine* _coroutine);
+        void Cancel(MissionCoroutine* _coroutine);
+
+        void OnStateReception(const vanttec_uuv::VehicleState& _state);
+        void OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles);
+        void OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status);
+
+        /* Resumes the coroutines whose event arrived or whose timer expired */
+        void Tick(double _time_s);
+
+        /* Waits, ReachDepth and Follow send the waypoints to get there */
+        MissionWait_S Sleep(double _seconds);
+        MissionWait_S ReachDepth(float _depth, float _tolerance = 0.15, double _timeout_s = 0);
+        MissionWait_S Follow(const float* _x, const float* _y, const float* _z, uint8_t _count, double _timeout_s = 0);
+        MissionWait_S Detect(const char* _obstacle_class, double _timeout_s = 0);
+
+    private:
+
+        std::vector<MissionCoroutine*>      coroutines;
+        std::vector<uint16_t>               ready;
+        std::vector<CoroutineWaiter_S>      depth_waiters;
+        std::vector<CoroutineWaiter_S>      follow_waiters;
+        std::vector<CoroutineWaiter_S>      detect_waiters;
+        std::vector<CoroutineTimer_S>       timers;
+
+        /* Scratch lists, swapped with the waiters while they are processed */
+        std::vector<uint16_t>               scratch_ready;
+        std::vector<CoroutineWaiter_S>      scratch_waiters;
+
+        vanttec_uuv::GuidanceStatus         guidance_status;
+        vanttec_uuv::ObstacleList           obstacles;
+        bool                                state_event;
+        bool                                status_event;
+        bool                                obstacle_event;
+        uint32_t                            sequence;
+
+        void Run(uint16_t _slot);
+        void Wake(uint16_t _slot, MissionWaitResult_E _result);
+        void Release(uint16_t _slot);
+        void ProcessWaiters(std::vector<CoroutineWaiter_S>& _waiters);
+
+        /* Whether the wait is over, and with which result */
+        bool CheckWait(MissionCoroutine* _coroutine, MissionWaitResult_E* _result);
+
+        void SendWaypoints(const float* _x, const float* _y, const float* _z, uint8_t _count);
+};
+
+#endif
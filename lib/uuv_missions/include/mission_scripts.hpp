@@ -0,0 +1,80 @@
+/** ----------------------------------------------------------------------------
+ * @file: mission_scripts.hpp
+ * 
+ * @brief: Mission scripts written as coroutines, and the table used to start
+ *         them by number from a topic.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __MISSION_SCRIPTS_H__
+#define __MISSION_SCRIPTS_H__
+
+#include "mission_coroutine.hpp"
+#include "uuv_mission_manager.hpp"
+
+typedef enum MissionScriptId_E
+{
+    SCRIPT_CANCEL_ALL = 0,
+    SCRIPT_SQUARE_SURVEY = 1,
+    SCRIPT_OBJECT_WATCH = 2,
+} MissionScriptId_E;
+
+/* Dives, goes around a square starting at the current position and surfaces */
+class SquareSurveyScript : public MissionCoroutine
+{
+    public:
+
+        float   depth;
+        float   side;
+
+        SquareSurveyScript();
+        ~SquareSurveyScript();
+
+        CoroutineStatus_E Resume(MissionScheduler& _scheduler);
+
+    private:
+
+        float   corners_x[4];
+        float   corners_y[4];
+        float   corners_z[4];
+};
+
+/* Reports every detection of a class, at most once per period, until the count is reached */
+class ObjectWatchScript : public MissionCoroutine
+{
+    public:
+
+        const char*     obstacle_class;
+        double          period_s;
+        double          timeout_s;
+        uint32_t        count;
+
+        ObjectWatchScript();
+        ~ObjectWatchScript();
+
+        CoroutineStatus_E Resume(MissionScheduler& _scheduler);
+
+    private:
+
+        uint32_t        detections;
+};
+
+class MissionScripts
+{
+    public:
+
+        MissionScheduler*       scheduler;
+        SquareSurveyScript      square_survey;
+        ObjectWatchScript       object_watch;
+
+        /* Owner of the guidance while its mission runs, scripts are not started meanwhile */
+        const MissionManager*   mission_manager;
+
+        MissionScripts(MissionScheduler* _scheduler);
+        ~MissionScripts();
+
+        void OnScriptRequest(const std_msgs::UInt8& _script);
+        void CancelAll();
+};
+
+#endif
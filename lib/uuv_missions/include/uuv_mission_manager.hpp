@@ -5,33 +5,157 @@
  * @email: pedro.sc.97@gmail.com
  * 
  * @brief: Mission manager class, used to trigger and track mission progress.
+ *         Each mission is a behavior tree built when the mission is requested
+ *         and ticked within a time budget from the guidance process, which
+ *         receives the waypoints of the mission actions directly.
  * -----------------------------------------------------------------------------
  * */
 
 #ifndef __UUV_MISSION_MANAGER__
 #define __UUV_MISSION_MANAGER__
 
+#include "behavior_tree.hpp"
+
+#include <vector>
+
+#include <ros/ros.h>
+#include <std_msgs/UInt8.h>
 #include <geometry_msgs/Pose.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Path.h>
+#include <vanttec_uuv/GuidanceStatus.h>
+#include <vanttec_uuv/GuidanceWaypoints.h>
+#include <vanttec_uuv/ObstacleList.h>
+#include <vanttec_uuv/VehicleState.h>
 
 typedef enum MissionType_E
 {
-    NONE = 0,
-    GATE = 1,
-    BUOY = 2,
-    TORPEDOES = 3,
+    MISSION_NONE = 0,
+    MISSION_GATE = 1,
+    MISSION_BUOY = 2,
+    MISSION_TORPEDOES = 3,
 } MissionType_E;
 
+typedef enum MissionStatus_E
+{
+    MISSION_IDLE = 0,
+    MISSION_RUNNING = 1,
+    MISSION_SUCCEEDED = 2,
+    MISSION_FAILED = 3,
+} MissionStatus_E;
+
+/* Action currently owning the waypoints sent to guidance */
+typedef enum MissionAction_E
+{
+    ACTION_NONE = 0,
+    ACTION_DIVE = 1,
+    ACTION_SEARCH = 2,
+    ACTION_PASS_GATE = 3,
+    ACTION_TOUCH_BUOY = 4,
+    ACTION_BACK_OFF = 5,
+} MissionAction_E;
+
+typedef enum MissionObjectClass_E
+{
+    OBJECT_BUOY = 0,
+    OBJECT_GATE = 1,
+    OBJECT_OTHER = 2,
+} MissionObjectClass_E;
+
+/* Detections kept in NED */
+typedef struct MissionObject_S
+{
+    MissionObjectClass_E    object_class;
+    float                   x;
+    float                   y;
+    float                   radius;
+} MissionObject_S;
+
+const uint16_t  MISSION_TREE_CAPACITY   = 64;
+const size_t    MAX_MISSION_OBJECTS     = 64;
+
 class MissionManager
 {
     public:
     
         MissionType_E   current_mission;
+        MissionStatus_E mission_status;
 
         geometry_msgs::Pose     current_pose;
-        
+
+        BehaviorTree                    tree;
+
+        /* Mission parameters */
+        float                           mission_depth_m;
+        float                           search_step_m;
+        float                           search_distance_m;
+        /* Every action fails if its list is not finished within this time */
+        double                          action_timeout_s;
+        /* Safety radius of the guidance obstacle avoidance, which keeps the
+           vehicle that far from the buoy surface, and the margin past it
+           at which the buoy counts as touched */
+        float                           avoidance_radius_m;
+        float                           touch_margin_m;
+
+        /* Waypoints for guidance, new_waypoints is set when they change */
+        vanttec_uuv::GuidanceWaypoints  waypoints;
+        nav_msgs::Path                  path;
+        bool                            new_waypoints;
+
+        std::vector<MissionObject_S>    objects;
 
         MissionManager();
         ~MissionManager();
+
+        void OnMissionRequest(const std_msgs::UInt8& _mission);
+        void OnStateReception(const vanttec_uuv::VehicleState& _state);
+        void OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles);
+        void OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status);
+
+        void StartMission(MissionType_E _mission);
+
+        /* Ticks the running mission within the budget */
+        void Iteration(std::chrono::microseconds _budget);
+
+    private:
+
+        vanttec_uuv::GuidanceStatus     guidance_status;
+        uint32_t                        sequence;
+        /* The guidance has reported following the latest list */
+        bool                            waypoints_accepted;
+        MissionAction_E                 active_action;
+        float                           searched_distance_m;
+        /* Back off point of the buoy mission */
+        float                           target_x;
+        float                           target_y;
+
+        void BuildMission(MissionType_E _mission);
+
+        /* Sends a list from the current position through the given points at the mission depth,
+           the last one with the given acceptance radius or the guidance default when 0 */
+        void SendWaypoints(MissionAction_E _action, const float* _x, const float* _y, const float* _z, uint8_t _count,
+                           float _last_acceptance_radius = 0);
+
+        /* Success once the guidance reaches the end of the latest list, failure
+           if another waypoint source replaced it or it timed out */
+        BehaviorStatus_E GuidanceProgress();
+
+        bool FindNearest(MissionObjectClass_E _class, MissionObject_S& _object) const;
+        bool FindGate(float* _center_x, float* _center_y, float* _normal_x, float* _normal_y) const;
+
+        /* Behavior tree leaves, the context is the mission manager */
+        static BehaviorStatus_E Dive(void* _context);
+        static BehaviorStatus_E GateVisible(void* _context);
+        static BehaviorStatus_E BuoyVisible(void* _context);
+        static BehaviorStatus_E SearchForGate(void* _context);
+        static BehaviorStatus_E SearchForBuoy(void* _context);
+        static BehaviorStatus_E PassGate(void* _context);
+        static BehaviorStatus_E TouchBuoy(void* _context);
+        static BehaviorStatus_E BackOff(void* _context);
+        static BehaviorStatus_E Unsupported(void* _context);
+
+        BehaviorStatus_E Search(MissionObjectClass_E _class);
+        BehaviorStatus_E FollowWaypoints(MissionAction_E _action);
 };
 
-#endif // __UUV_MISSION_MANAGER__
\ No newline at end of file
+#endif // __UUV_MISSION_MANAGER__
@@ -0,0 +1,197 @@
+/** ----------------------------------------------------------------------------
+ * @file: behavior_tree.cpp
+ * 
+ * @brief: Behavior tree with preallocated nodes, used to run missions. Nodes
+ *         live in a fixed capacity pool and are linked by index, leaves are
+ *         plain function pointers, so ticking never allocates.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "behavior_tree.hpp"
+
+BehaviorTree::BehaviorTree(uint16_t _capacity)
+{
+    this->capacity          = (_capacity < BT_NO_NODE) ? _capacity : BT_NO_NODE - 1;
+    this->root              = BT_NO_NODE;
+    this->tick_leaves       = 0;
+    this->budget_overruns   = 0;
+    this->running_leaf      = NULL;
+    this->budget_exhausted  = false;
+
+    this->nodes.reserve(this->capacity);
+}
+
+BehaviorTree::~BehaviorTree(){}
+
+uint16_t BehaviorTree::AddNode(BehaviorNodeType_E _type, const char* _name, uint16_t _parent)
+{
+    if (this->nodes.size() >= this->capacity)
+    {
+        return BT_NO_NODE;
+    }
+
+    BehaviorNode_S node;
+    node.type           = _type;
+    node.name           = _name;
+    node.callback       = NULL;
+    node.context        = NULL;
+    node.first_child    = BT_NO_NODE;
+    node.last_child     = BT_NO_NODE;
+    node.next_sibling   = BT_NO_NODE;
+    node.running_child  = BT_NO_NODE;
+    node.last_status    = BT_SUCCESS;
+
+    uint16_t index = this->nodes.size();
+    this->nodes.push_back(node);
+
+    if (_parent == BT_NO_NODE)
+    {
+        this->root = index;
+    }
+    else if (this->nodes[_parent].first_child == BT_NO_NODE)
+    {
+        this->nodes[_parent].first_child = index;
+        this->nodes[_parent].last_child = index;
+    }
+    else
+    {
+        this->nodes[this->nodes[_parent].last_child].next_sibling = index;
+        this->nodes[_parent].last_child = index;
+    }
+
+    return index;
+}
+
+uint16_t BehaviorTree::AddComposite(BehaviorNodeType_E _type, const char* _name, uint16_t _parent)
+{
+    return this->AddNode(_type, _name, _parent);
+}
+
+uint16_t BehaviorTree::AddLeaf(BehaviorNodeType_E _type, const char* _name, BehaviorCallback _callback, void* _context, uint16_t _parent)
+{
+    uint16_t index = this->AddNode(_type, _name, _parent);
+
+    if (index != BT_NO_NODE)
+    {
+        this->nodes[index].callback = _callback;
+        this->nodes[index].context  = _context;
+    }
+
+    return index;
+}
+
+void BehaviorTree::Clear()
+{
+    this->nodes.clear();
+    this->root          = BT_NO_NODE;
+    this->running_leaf  = NULL;
+}
+
+void BehaviorTree::Reset()
+{
+    for (size_t i = 0; i < this->nodes.size(); i++)
+    {
+        this->nodes[i].running_child = BT_NO_NODE;
+    }
+
+    this->running_leaf = NULL;
+}
+
+BehaviorStatus_E BehaviorTree::Tick(std::chrono::microseconds _budget)
+{
+    if (this->root == BT_NO_NODE)
+    {
+        return BT_FAILURE;
+    }
+
+    this->deadline          = std::chrono::steady_clock::now() + _budget;
+    this->budget_exhausted  = false;
+    this->tick_leaves       = 0;
+
+    BehaviorStatus_E status = this->TickNode(this->root);
+
+    if (this->budget_exhausted)
+    {
+        this->budget_overruns++;
+    }
+
+    return status;
+}
+
+BehaviorStatus_E BehaviorTree::TickNode(uint16_t _index)
+{
+    BehaviorNode_S& node = this->nodes[_index];
+    BehaviorStatus_E status = BT_FAILURE;
+
+    switch (node.type)
+    {
+        case BT_ACTION:
+        case BT_CONDITION:
+        {
+            /* At least one leaf runs every tick so the tree always makes progress */
+            if (this->tick_leaves > 0 && std::chrono::steady_clock::now() >= this->deadline)
+            {
+                this->budget_exhausted = true;
+                return BT_RUNNING;
+            }
+
+            this->tick_leaves++;
+            status = node.callback(node.context);
+
+            if (status == BT_RUNNING)
+            {
+                this->running_leaf = node.name;
+            }
+            break;
+        }
+        case BT_INVERTER:
+        {
+            status = this->TickNode(node.first_child);
+
+            if (status != BT_RUNNING)
+            {
+                status = (status == BT_SUCCESS) ? BT_FAILURE : BT_SUCCESS;
+            }
+            break;
+        }
+        case BT_SEQUENCE:
+        case BT_FALLBACK:
+        {
+            /* A sequence stops at the first child that fails, a fallback at the first that succeeds */
+            BehaviorStatus_E stop_status = (node.type == BT_SEQUENCE) ? BT_FAILURE : BT_SUCCESS;
+
+            if (node.running_child == BT_NO_NODE)
+            {
+                node.running_child = node.first_child;
+            }
+
+            status = (node.type == BT_SEQUENCE) ? BT_SUCCESS : BT_FAILURE;
+
+            while (node.running_child != BT_NO_NODE)
+            {
+                BehaviorStatus_E child_status = this->TickNode(node.running_child);
+
+                if (child_status == BT_RUNNING)
+                {
+                    node.last_status = BT_RUNNING;
+                    return BT_RUNNING;
+                }
+
+                if (child_status == stop_status)
+                {
+                    status = stop_status;
+                    break;
+                }
+
+                node.running_child = this->nodes[node.running_child].next_sibling;
+            }
+
+            node.running_child = BT_NO_NODE;
+            break;
+        }
+    }
+
+    node.last_status = status;
+
+    return status;
+}
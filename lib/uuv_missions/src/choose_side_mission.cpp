@@ -0,0 +1,297 @@
+/** ----------------------------------------------------------------------------
+ * @file: choose_side_mission.cpp
+ * 
+ * @brief: Choose side mission, native port of the auto_nav_position script.
+ *         Goes through the left or right opening of three post gates, pushing
+ *         forward between them until the configured number of gates is done.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "choose_side_mission.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static bool ClosestPost(const GatePost_S& _a, const GatePost_S& _b)
+{
+    return _a.distance < _b.distance;
+}
+
+static bool PortPost(const GatePost_S& _a, const GatePost_S& _b)
+{
+    return _a.y < _b.y;
+}
+
+ChooseSideMission::ChooseSideMission()
+{
+    this->selected_side     = SIDE_LEFT;
+    this->state_machine     = CHOOSE_SIDE_STANDBY;
+
+    this->distance_away     = 5;
+    this->pass_distance     = 3;
+    this->search_distance   = 10;
+    this->min_gate_distance = 2;
+    this->replan_distance   = 0.5;
+    this->lost_timeout      = 2;
+    this->search_delay      = 1;
+    this->gate_count        = 2;
+    this->gates_passed      = 0;
+
+    this->new_detections    = false;
+    this->last_valid_time_s = -1;
+    this->search_time_s     = 0;
+    this->search_sent       = false;
+    this->detection_decision = false;
+    this->posts_x           = 0;
+    this->posts_y           = 0;
+    this->posts_yaw         = 0;
+    this->ned_alpha         = 0;
+    this->target_x          = 0;
+    this->target_y          = 0;
+
+    /* Chosen so it does not collide with the sequence of other waypoint sources */
+    this->sequence          = 0x40000;
+
+    this->current_position.orientation.w = 1;
+    this->posts.reserve(MAX_GATE_POSTS);
+}
+
+ChooseSideMission::~ChooseSideMission(){}
+
+void ChooseSideMission::OnPoseReception(const vanttec_uuv::VehicleState& _state)
+{
+    this->current_position.position.x       = _state.x;
+    this->current_position.position.y       = _state.y;
+    this->current_position.position.z       = _state.z;
+    this->current_position.orientation.z    = _state.yaw;
+}
+
+void ChooseSideMission::OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles)
+{
+    /* Detections come in the body frame, keep the pose they were taken from */
+    this->posts.clear();
+    this->posts_x       = this->current_position.position.x;
+    this->posts_y       = this->current_position.position.y;
+    this->posts_yaw     = this->current_position.orientation.z;
+    this->posts_stamp   = _obstacles.header.stamp;
+
+    for (size_t i = 0; i < _obstacles.obstacles.size() && this->posts.size() < MAX_GATE_POSTS; i++)
+    {
+        GatePost_S post;
+
+        post.x          = _obstacles.obstacles[i].pose.position.x;
+        post.y          = _obstacles.obstacles[i].pose.position.y;
+        post.distance   = std::sqrt(post.x * post.x + post.y * post.y);
+
+        this->posts.push_back(post);
+    }
+
+    this->new_detections = true;
+}
+
+bool ChooseSideMission::Iteration(double _time_s)
+{
+    bool send = false;
+    bool detections = this->new_detections;
+
+    this->new_detections = false;
+    this->detection_decision = false;
+
+    switch(this->state_machine)
+    {
+        /* Wait until the three posts of the gate are seen */
+        case CHOOSE_SIDE_STANDBY:
+        {
+            if (this->posts.size() >= 3)
+            {
+                this->last_valid_time_s = _time_s;
+                this->state_machine = CHOOSE_SIDE_CALCULATE;
+            }
+            else
+            {
+                break;
+            }
+        }
+        /* Fall through */
+
+        /* Aim for the selected opening, the gate is passed once it is out of sight or too close */
+        case CHOOSE_SIDE_CALCULATE:
+        case CHOOSE_SIDE_NAVIGATE:
+        {
+            if (detections || this->state_machine == CHOOSE_SIDE_CALCULATE)
+            {
+                bool calculate = (this->state_machine == CHOOSE_SIDE_CALCULATE);
+
+                if (this->CenterPoint(calculate, &send))
+                {
+                    this->last_valid_time_s = _time_s;
+                    this->state_machine = CHOOSE_SIDE_NAVIGATE;
+                    break;
+                }
+            }
+
+            if (_time_s - this->last_valid_time_s > this->lost_timeout)
+            {
+                this->gates_passed++;
+
+                if (this->gates_passed >= this->gate_count)
+                {
+                    ROS_INFO("Choose side mission: done after %u gates", this->gates_passed);
+                    this->state_machine = CHOOSE_SIDE_DONE;
+                }
+                else
+                {
+                    this->search_time_s = _time_s;
+                    this->search_sent = false;
+                    this->state_machine = CHOOSE_SIDE_SEARCH;
+                }
+            }
+            break;
+        }
+
+        /* Push forward along the last gate heading until the next gate shows up */
+        case CHOOSE_SIDE_SEARCH:
+        {
+            if (this->posts.size() >= 3 && detections)
+            {
+                this->state_machine = CHOOSE_SIDE_CALCULATE;
+                this->last_valid_time_s = _time_s;
+                break;
+            }
+
+            float distance_to_target = std::sqrt(std::pow(this->target_x - this->current_position.position.x, 2) +
+                                                 std::pow(this->target_y - this->current_position.position.y, 2));
+
+            if ((!this->search_sent && _time_s - this->search_time_s > this->search_delay) ||
+                (this->search_sent && distance_to_target < this->distance_away))
+            {
+                this->Farther();
+                this->search_sent = true;
+                send = true;
+            }
+            break;
+        }
+
+        case CHOOSE_SIDE_DONE:
+        default:
+            break;
+    }
+
+    return send;
+}
+
+bool ChooseSideMission::CenterPoint(bool _force, bool* _send)
+{
+    if (this->posts.size() < 3)
+    {
+        return false;
+    }
+
+    /* The three closest posts, from port to starboard */
+    std::partial_sort(this->posts.begin(), this->posts.begin() + 3, this->posts.end(), ClosestPost);
+    std::sort(this->posts.begin(), this->posts.begin() + 3, PortPost);
+
+    const GatePost_S& left  = (this->selected_side == SIDE_LEFT) ? this->posts[0] : this->posts[1];
+    const GatePost_S& right = (this->selected_side == SIDE_LEFT) ? this->posts[1] : this->posts[2];
+
+    float xc = (left.x + right.x) / 2;
+    float yc = (left.y + right.y) / 2;
+
+    if (std::sqrt(xc * xc + yc * yc) < this->min_gate_distance)
+    {
+        return false;
+    }
+
+    /* Gate normal, pointing forward through the opening */
+    float alpha = std::atan2(left.y - right.y, left.x - right.x) + M_PI / 2;
+    alpha = std::atan2(std::sin(alpha), std::cos(alpha));
+
+    this->ned_alpha = std::atan2(std::sin(alpha + this->posts_yaw), std::cos(alpha + this->posts_yaw));
+
+    /* Line up in front of the opening and end past it */
+    float x[2];
+    float y[2];
+
+    this->BodyToNed(xc - this->distance_away * std::cos(alpha), yc - this->distance_away * std::sin(alpha), &x[0], &y[0]);
+    this->BodyToNed(xc + this->pass_distance * std::cos(alpha), yc + this->pass_distance * std::sin(alpha), &x[1], &y[1]);
+
+    /* Keep the current list unless the gate estimate moved, resending restarts the leg */
+    float shift = std::sqrt(std::pow(x[1] - this->target_x, 2) + std::pow(y[1] - this->target_y, 2));
+
+    if (!_force && shift < this->replan_distance)
+    {
+        return true;
+    }
+
+    this->target_x = x[1];
+    this->target_y = y[1];
+
+    /* Once past the line up point, which is the case when the vehicle is closer to the gate, go straight through */
+    float gate_distance = xc * std::cos(alpha) + yc * std::sin(alpha);
+
+    if (gate_distance < this->distance_away)
+    {
+        this->SendWaypoints(&x[1], &y[1], 1);
+    }
+    else
+    {
+        this->SendWaypoints(x, y, 2);
+    }
+
+    this->decision_stamp        = this->posts_stamp;
+    this->detection_decision    = true;
+
+    *_send = true;
+    return true;
+}
+
+void ChooseSideMission::Farther()
+{
+    this->target_x += this->search_distance * std::cos(this->ned_alpha);
+    this->target_y += this->search_distance * std::sin(this->ned_alpha);
+
+    this->SendWaypoints(&this->target_x, &this->target_y, 1);
+}
+
+void ChooseSideMission::BodyToNed(float _x, float _y, float* _ned_x, float* _ned_y) const
+{
+    *_ned_x = this->posts_x + _x * std::cos(this->posts_yaw) - _y * std::sin(this->posts_yaw);
+    *_ned_y = this->posts_y + _x * std::sin(this->posts_yaw) + _y * std::cos(this->posts_yaw);
+}
+
+void ChooseSideMission::SendWaypoints(const float* _x, const float* _y, uint8_t _count)
+{
+    float z = this->current_position.position.z;
+
+    /* Start from the current position, keeping the current depth */
+    this->desired_waypoints.waypoint_list_x.assign(1, this->current_position.position.x);
+    this->desired_waypoints.waypoint_list_y.assign(1, this->current_position.position.y);
+    this->desired_waypoints.waypoint_list_z.assign(1, z);
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        this->desired_waypoints.waypoint_list_x.push_back(_x[i]);
+        this->desired_waypoints.waypoint_list_y.push_back(_y[i]);
+        this->desired_waypoints.waypoint_list_z.push_back(z);
+    }
+
+    this->desired_waypoints.guidance_law            = 1;
+    this->desired_waypoints.waypoint_list_length    = this->desired_waypoints.waypoint_list_x.size();
+    this->desired_waypoints.sequence                = ++this->sequence;
+
+    this->path.header.stamp     = ros::Time::now();
+    this->path.header.frame_id  = "world";
+    this->desired_waypoints.header = this->path.header;
+    this->path.poses.resize(this->desired_waypoints.waypoint_list_length);
+
+    for (size_t i = 0; i < this->path.poses.size(); i++)
+    {
+        geometry_msgs::PoseStamped& pose = this->path.poses[i];
+
+        pose.header                 = this->path.header;
+        pose.pose.position.x        = this->desired_waypoints.waypoint_list_x[i];
+        pose.pose.position.y        = -this->desired_waypoints.waypoint_list_y[i];
+        pose.pose.position.z        = -this->desired_waypoints.waypoint_list_z[i];
+        pose.pose.orientation.w     = 1;
+    }
+}
@@ -0,0 +1,396 @@
+/** ----------------------------------------------------------------------------
+ * @file: mission_coroutine.cpp
+ * 
+ * @brief: Stackless coroutines to write missions as plain sequential code,
+ *         and the single threaded scheduler that resumes them.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "mission_coroutine.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/* Orders the timer vector as a min heap on the deadline */
+static bool LaterTimer(const CoroutineTimer_S& _a, const CoroutineTimer_S& _b)
+{
+    return _a.deadline_s > _b.deadline_s;
+}
+
+MissionCoroutine::MissionCoroutine(const char* _name)
+{
+    this->name          = _name;
+    this->resume_point  = 0;
+    this->wait_result   = WAIT_DONE;
+    this->detected_x    = 0;
+    this->detected_y    = 0;
+    this->slot          = COROUTINE_NO_SLOT;
+    this->generation    = 0;
+}
+
+MissionCoroutine::~MissionCoroutine(){}
+
+MissionScheduler::MissionScheduler(uint16_t _capacity)
+{
+    this->time_s            = 0;
+    this->new_waypoints     = false;
+    this->resumes           = 0;
+    this->running           = 0;
+    this->state_event       = false;
+    this->status_event      = false;
+    this->obstacle_event    = false;
+
+    /* Chosen so it does not collide with the sequence of other waypoint sources */
+    this->sequence          = 0x50000;
+
+    this->current_pose.orientation.w = 1;
+
+    this->coroutines.assign(std::min(_capacity, (uint16_t) (COROUTINE_NO_SLOT - 1)), (MissionCoroutine*) NULL);
+    this->ready.reserve(this->coroutines.size());
+    this->scratch_ready.reserve(this->coroutines.size());
+    this->depth_waiters.reserve(this->coroutines.size());
+    this->follow_waiters.reserve(this->coroutines.size());
+    this->detect_waiters.reserve(this->coroutines.size());
+    this->scratch_waiters.reserve(this->coroutines.size());
+    this->timers.reserve(2 * this->coroutines.size());
+}
+
+MissionScheduler::~MissionScheduler(){}
+
+bool MissionScheduler::Spawn(MissionCoroutine* _coroutine)
+{
+    if (_coroutine->slot != COROUTINE_NO_SLOT)
+    {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < this->coroutines.size(); i++)
+    {
+        if (this->coroutines[i] == NULL)
+        {
+            _coroutine->resume_point    = 0;
+            _coroutine->wait_result     = WAIT_DONE;
+            _coroutine->slot            = i;
+            _coroutine->generation++;
+
+            this->coroutines[i] = _coroutine;
+            this->ready.push_back(i);
+            this->running++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MissionScheduler::Cancel(MissionCoroutine* _coroutine)
+{
+    if (_coroutine->slot != COROUTINE_NO_SLOT)
+    {
+        this->Release(_coroutine->slot);
+    }
+}
+
+void MissionScheduler::Release(uint16_t _slot)
+{
+    MissionCoroutine* coroutine = this->coroutines[_slot];
+
+    /* Entries left in the wait lists are dropped when their generation does not match */
+    coroutine->slot = COROUTINE_NO_SLOT;
+    coroutine->generation++;
+
+    this->coroutines[_slot] = NULL;
+    this->running--;
+}
+
+void MissionScheduler::OnStateReception(const vanttec_uuv::VehicleState& _state)
+{
+    this->current_pose.position.x       = _state.x;
+    this->current_pose.position.y       = _state.y;
+    this->current_pose.position.z       = _state.z;
+    this->current_pose.orientation.z    = _state.yaw;
+    this->state_event = true;
+}
+
+void MissionScheduler::OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles)
+{
+    this->obstacles = _obstacles;
+    this->obstacle_event = true;
+}
+
+void MissionScheduler::OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status)
+{
+    this->guidance_status = _status;
+    this->status_event = true;
+}
+
+void MissionScheduler::Tick(double _time_s)
+{
+    this->time_s = _time_s;
+
+    /* Spawned coroutines and zero length sleeps */
+    this->scratch_ready.swap(this->ready);
+
+    for (size_t i = 0; i < this->scratch_ready.size(); i++)
+    {
+        if (this->coroutines[this->scratch_ready[i]] != NULL)
+        {
+            this->Run(this->scratch_ready[i]);
+        }
+    }
+
+    this->scratch_ready.clear();
+
+    /* Expired timers, which are the end of a sleep or the timeout of another wait */
+    while (!this->timers.empty() && this->timers.front().deadline_s <= this->time_s)
+    {
+        std::pop_heap(this->timers.begin(), this->timers.end(), LaterTimer);
+        CoroutineTimer_S timer = this->timers.back();
+        this->timers.pop_back();
+
+        MissionCoroutine* coroutine = this->coroutines[timer.slot];
+
+        if (coroutine != NULL && coroutine->generation == timer.generation)
+        {
+            this->Wake(timer.slot, (coroutine->wait.type == WAIT_TIME) ? WAIT_DONE : WAIT_TIMEOUT);
+        }
+    }
+
+    /* Only the waiters of the events that arrived are checked */
+    if (this->state_event)
+    {
+        this->state_event = false;
+        this->ProcessWaiters(this->depth_waiters);
+    }
+
+    if (this->status_event)
+    {
+        this->status_event = false;
+        this->ProcessWaiters(this->follow_waiters);
+    }
+
+    if (this->obstacle_event)
+    {
+        this->obstacle_event = false;
+        this->ProcessWaiters(this->detect_waiters);
+    }
+}
+
+void MissionScheduler::ProcessWaiters(std::vector<CoroutineWaiter_S>& _waiters)
+{
+    /* Coroutines woken here may wait again on the same list */
+    this->scratch_waiters.swap(_waiters);
+
+    for (size_t i = 0; i < this->scratch_waiters.size(); i++)
+    {
+        CoroutineWaiter_S waiter = this->scratch_waiters[i];
+        MissionCoroutine* coroutine = this->coroutines[waiter.slot];
+        MissionWaitResult_E result;
+
+        if (coroutine == NULL || coroutine->generation != waiter.generation)
+        {
+            continue;
+        }
+
+        if (this->CheckWait(coroutine, &result))
+        {
+            this->Wake(waiter.slot, result);
+        }
+        else
+        {
+            _waiters.push_back(waiter);
+        }
+    }
+
+    this->scratch_waiters.clear();
+}
+
+bool MissionScheduler::CheckWait(MissionCoroutine* _coroutine, MissionWaitResult_E* _result)
+{
+    MissionWait_S& wait = _coroutine->wait;
+    *_result = WAIT_DONE;
+
+    switch (wait.type)
+    {
+        case WAIT_DEPTH:
+            return std::fabs(this->current_pose.position.z - wait.depth) <= wait.tolerance;
+
+        case WAIT_FOLLOW:
+        {
+            if (this->guidance_status.waypoint_list_sequence == wait.sequence)
+            {
+                /* The guidance goes back to no law once it reaches the last waypoint */
+                wait.accepted = true;
+                return this->guidance_status.guidance_law == 0;
+            }
+
+            /* Replaced after being taken, or before by a newer list of ours */
+            *_result = WAIT_PREEMPTED;
+            return wait.accepted || this->sequence != wait.sequence;
+        }
+
+        case WAIT_DETECT:
+        {
+            float x_uuv = this->current_pose.position.x;
+            float y_uuv = this->current_pose.position.y;
+            float yaw   = this->current_pose.orientation.z;
+
+            for (size_t i = 0; i < this->obstacles.obstacles.size(); i++)
+            {
+                const vanttec_uuv::Obstacle& obstacle = this->obstacles.obstacles[i];
+
+                if (obstacle.obstacle_class != wait.obstacle_class)
+                {
+                    continue;
+                }
+
+                _coroutine->detected_x = obstacle.pose.position.x;
+                _coroutine->detected_y = obstacle.pose.position.y;
+
+                /* Detections from the perception come in the body frame */
+                if (this->obstacles.header.frame_id != "world")
+                {
+                    _coroutine->detected_x = x_uuv + obstacle.pose.position.x * std::cos(yaw) - obstacle.pose.position.y * std::sin(yaw);
+                    _coroutine->detected_y = y_uuv + obstacle.pose.position.x * std::sin(yaw) + obstacle.pose.position.y * std::cos(yaw);
+                }
+
+                return true;
+            }
+
+            return false;
+        }
+
+        case WAIT_TIME:
+        default:
+            return false;
+    }
+}
+
+void MissionScheduler::Wake(uint16_t _slot, MissionWaitResult_E _result)
+{
+    this->coroutines[_slot]->wait_result = _result;
+    this->Run(_slot);
+}
+
+void MissionScheduler::Run(uint16_t _slot)
+{
+    MissionCoroutine* coroutine = this->coroutines[_slot];
+
+    this->resumes++;
+    CoroutineStatus_E status = coroutine->Resume(*this);
+
+    if (status != COROUTINE_SUSPENDED)
+    {
+        ROS_INFO("Mission scheduler: %s %s", coroutine->name, (status == COROUTINE_DONE) ? "done" : "failed");
+        this->Release(_slot);
+        return;
+    }
+
+    /* A new generation invalidates the entries of the previous wait */
+    coroutine->generation++;
+
+    CoroutineWaiter_S waiter;
+    waiter.slot         = _slot;
+    waiter.generation   = coroutine->generation;
+
+    if (coroutine->wait.timeout_s > 0)
+    {
+        CoroutineTimer_S timer;
+        timer.deadline_s    = this->time_s + coroutine->wait.timeout_s;
+        timer.slot          = _slot;
+        timer.generation    = coroutine->generation;
+
+        this->timers.push_back(timer);
+        std::push_heap(this->timers.begin(), this->timers.end(), LaterTimer);
+    }
+
+    switch (coroutine->wait.type)
+    {
+        case WAIT_TIME:
+            if (coroutine->wait.timeout_s <= 0)
+            {
+                this->ready.push_back(_slot);
+            }
+            break;
+        case WAIT_DEPTH:
+            this->depth_waiters.push_back(waiter);
+            break;
+        case WAIT_FOLLOW:
+            this->follow_waiters.push_back(waiter);
+            break;
+        case WAIT_DETECT:
+            this->detect_waiters.push_back(waiter);
+            break;
+    }
+}
+
+MissionWait_S MissionScheduler::Sleep(double _seconds)
+{
+    MissionWait_S wait = {WAIT_TIME, _seconds, 0, 0, 0, false, NULL};
+    return wait;
+}
+
+MissionWait_S MissionScheduler::ReachDepth(float _depth, float _tolerance, double _timeout_s)
+{
+    /* Dive or rise in place */
+    float x = this->current_pose.position.x;
+    float y = this->current_pose.position.y;
+
+    this->SendWaypoints(&x, &y, &_depth, 1);
+
+    MissionWait_S wait = {WAIT_DEPTH, _timeout_s, _depth, _tolerance, 0, false, NULL};
+    return wait;
+}
+
+MissionWait_S MissionScheduler::Follow(const float* _x, const float* _y, const float* _z, uint8_t _count, double _timeout_s)
+{
+    this->SendWaypoints(_x, _y, _z, _count);
+
+    MissionWait_S wait = {WAIT_FOLLOW, _timeout_s, 0, 0, this->sequence, false, NULL};
+    return wait;
+}
+
+MissionWait_S MissionScheduler::Detect(const char* _obstacle_class, double _timeout_s)
+{
+    MissionWait_S wait = {WAIT_DETECT, _timeout_s, 0, 0, 0, false, _obstacle_class};
+    return wait;
+}
+
+void MissionScheduler::SendWaypoints(const float* _x, const float* _y, const float* _z, uint8_t _count)
+{
+    /* Lists start at the current position and use the 3D LOS */
+    this->waypoints.waypoint_list_x.assign(1, this->current_pose.position.x);
+    this->waypoints.waypoint_list_y.assign(1, this->current_pose.position.y);
+    this->waypoints.waypoint_list_z.assign(1, this->current_pose.position.z);
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        this->waypoints.waypoint_list_x.push_back(_x[i]);
+        this->waypoints.waypoint_list_y.push_back(_y[i]);
+        this->waypoints.waypoint_list_z.push_back(_z[i]);
+    }
+
+    this->waypoints.guidance_law            = 3;
+    this->waypoints.waypoint_list_length    = this->waypoints.waypoint_list_x.size();
+    this->waypoints.waypoint_list_speed.clear();
+    this->waypoints.waypoint_list_acceptance_radius.clear();
+    this->waypoints.sequence                = ++this->sequence;
+
+    this->path.header.stamp     = ros::Time::now();
+    this->path.header.frame_id  = "world";
+    this->waypoints.header = this->path.header;
+    this->path.poses.resize(this->waypoints.waypoint_list_length);
+
+    for (size_t i = 0; i < this->path.poses.size(); i++)
+    {
+        geometry_msgs::PoseStamped& pose = this->path.poses[i];
+
+        pose.header                 = this->path.header;
+        pose.pose.position.x        = this->waypoints.waypoint_list_x[i];
+        pose.pose.position.y        = -this->waypoints.waypoint_list_y[i];
+        pose.pose.position.z        = -this->waypoints.waypoint_list_z[i];
+        pose.pose.orientation.w     = 1;
+    }
+
+    this->new_waypoints = true;
+}
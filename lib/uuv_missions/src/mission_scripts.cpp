@@ -0,0 +1,134 @@
+/** ----------------------------------------------------------------------------
+ * @file: mission_scripts.cpp
+ * 
+ * @brief: Mission scripts written as coroutines, and the table used to start
+ *         them by number from a topic.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "mission_scripts.hpp"
+
+#include <cmath>
+
+SquareSurveyScript::SquareSurveyScript() : MissionCoroutine("square_survey")
+{
+    this->depth = 1.0;
+    this->side  = 4.0;
+}
+
+SquareSurveyScript::~SquareSurveyScript(){}
+
+CoroutineStatus_E SquareSurveyScript::Resume(MissionScheduler& _scheduler)
+{
+    MISSION_BEGIN();
+
+    MISSION_AWAIT(_scheduler.ReachDepth(this->depth, 0.15, 30));
+
+    if (this->wait_result != WAIT_DONE)
+    {
+        MISSION_FAIL();
+    }
+
+    /* Square ahead of the vehicle, to its starboard */
+    {
+        float x = _scheduler.current_pose.position.x;
+        float y = _scheduler.current_pose.position.y;
+        float yaw = _scheduler.current_pose.orientation.z;
+
+        float forward_x[4] = {1, 1, 0, 0};
+        float starboard[4] = {0, 1, 1, 0};
+
+        for (int i = 0; i < 4; i++)
+        {
+            this->corners_x[i] = x + this->side * (forward_x[i] * std::cos(yaw) - starboard[i] * std::sin(yaw));
+            this->corners_y[i] = y + this->side * (forward_x[i] * std::sin(yaw) + starboard[i] * std::cos(yaw));
+            this->corners_z[i] = this->depth;
+        }
+    }
+
+    MISSION_AWAIT(_scheduler.Follow(this->corners_x, this->corners_y, this->corners_z, 4, 120));
+
+    if (this->wait_result != WAIT_DONE)
+    {
+        MISSION_FAIL();
+    }
+
+    MISSION_AWAIT(_scheduler.ReachDepth(0, 0.15, 30));
+
+    MISSION_END();
+}
+
+ObjectWatchScript::ObjectWatchScript() : MissionCoroutine("object_watch")
+{
+    this->obstacle_class    = "buoy";
+    this->period_s          = 1.0;
+    this->timeout_s         = 300.0;
+    this->count             = 10;
+    this->detections        = 0;
+}
+
+ObjectWatchScript::~ObjectWatchScript(){}
+
+CoroutineStatus_E ObjectWatchScript::Resume(MissionScheduler& _scheduler)
+{
+    MISSION_BEGIN();
+
+    this->detections = 0;
+
+    while (this->detections < this->count)
+    {
+        MISSION_AWAIT(_scheduler.Detect(this->obstacle_class, this->timeout_s));
+
+        if (this->wait_result != WAIT_DONE)
+        {
+            MISSION_FAIL();
+        }
+
+        this->detections++;
+        ROS_INFO("Mission scheduler: %s seen at (%.2f, %.2f)", this->obstacle_class, this->detected_x, this->detected_y);
+
+        MISSION_AWAIT(_scheduler.Sleep(this->period_s));
+    }
+
+    MISSION_END();
+}
+
+MissionScripts::MissionScripts(MissionScheduler* _scheduler)
+{
+    this->scheduler         = _scheduler;
+    this->mission_manager   = NULL;
+}
+
+MissionScripts::~MissionScripts(){}
+
+void MissionScripts::OnScriptRequest(const std_msgs::UInt8& _script)
+{
+    if (_script.data != SCRIPT_CANCEL_ALL && this->mission_manager != NULL &&
+        this->mission_manager->mission_status == MISSION_RUNNING)
+    {
+        ROS_WARN("Mission scheduler: script %u refused, a mission is running", _script.data);
+        return;
+    }
+
+    switch (_script.data)
+    {
+        case SCRIPT_CANCEL_ALL:
+            this->CancelAll();
+            break;
+        case SCRIPT_SQUARE_SURVEY:
+            this->scheduler->Spawn(&this->square_survey);
+            break;
+        case SCRIPT_OBJECT_WATCH:
+            this->scheduler->Spawn(&this->object_watch);
+            break;
+        default:
+            ROS_WARN("Mission scheduler: unknown script %u", _script.data);
+            break;
+    }
+}
+
+void MissionScripts::CancelAll()
+{
+    this->scheduler->Cancel(&this->square_survey);
+    this->scheduler->Cancel(&this->object_watch);
+}
@@ -5,5 +5,522 @@
  * @email: pedro.sc.97@gmail.com
  * 
  * @brief: Mission manager class, used to trigger and track mission progress.
+ *         Each mission is a behavior tree built when the mission is requested
+ *         and ticked within a time budget from the guidance process, which
+ *         receives the waypoints of the mission actions directly.
  * -----------------------------------------------------------------------------
  * */
+
+#include "uuv_mission_manager.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+MissionManager::MissionManager() : tree(MISSION_TREE_CAPACITY)
+{
+    this->current_mission       = MISSION_NONE;
+    this->mission_status        = MISSION_IDLE;
+    this->mission_depth_m       = 1.0;
+    this->search_step_m         = 2.0;
+    this->search_distance_m     = 20.0;
+    this->action_timeout_s      = 60.0;
+    this->avoidance_radius_m    = 0.6;
+    this->touch_margin_m        = 0.5;
+    this->new_waypoints         = false;
+    this->waypoints_accepted    = false;
+    this->active_action         = ACTION_NONE;
+    this->searched_distance_m   = 0;
+    this->target_x              = 0;
+    this->target_y              = 0;
+
+    /* Chosen so it does not collide with the sequence of other waypoint sources */
+    this->sequence              = 0x30000;
+
+    this->current_pose.orientation.w = 1;
+    this->objects.reserve(MAX_MISSION_OBJECTS);
+    this->waypoints.waypoint_list_x.reserve(8);
+    this->waypoints.waypoint_list_y.reserve(8);
+    this->waypoints.waypoint_list_z.reserve(8);
+    this->path.poses.reserve(8);
+}
+
+MissionManager::~MissionManager(){}
+
+void MissionManager::OnMissionRequest(const std_msgs::UInt8& _mission)
+{
+    this->StartMission((MissionType_E) _mission.data);
+}
+
+void MissionManager::OnStateReception(const vanttec_uuv::VehicleState& _state)
+{
+    /* Same convention as the guidance: NED position and yaw in orientation.z */
+    this->current_pose.position.x       = _state.x;
+    this->current_pose.position.y       = _state.y;
+    this->current_pose.position.z       = _state.z;
+    this->current_pose.orientation.z    = _state.yaw;
+}
+
+void MissionManager::OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles)
+{
+    float x_uuv = this->current_pose.position.x;
+    float y_uuv = this->current_pose.position.y;
+    float yaw   = this->current_pose.orientation.z;
+
+    /* Detections from the perception come in the body frame */
+    bool in_body_frame = (_obstacles.header.frame_id != "world");
+
+    this->objects.clear();
+
+    for (size_t i = 0; i < _obstacles.obstacles.size() && i < MAX_MISSION_OBJECTS; i++)
+    {
+        const vanttec_uuv::Obstacle& obstacle = _obstacles.obstacles[i];
+        MissionObject_S object;
+
+        object.x        = obstacle.pose.position.x;
+        object.y        = obstacle.pose.position.y;
+        object.radius   = obstacle.radio;
+
+        if (in_body_frame)
+        {
+            object.x = x_uuv + obstacle.pose.position.x * std::cos(yaw) - obstacle.pose.position.y * std::sin(yaw);
+            object.y = y_uuv + obstacle.pose.position.x * std::sin(yaw) + obstacle.pose.position.y * std::cos(yaw);
+        }
+
+        if (obstacle.obstacle_class == "gate")
+        {
+            object.object_class = OBJECT_GATE;
+        }
+        else if (obstacle.obstacle_class == "buoy")
+        {
+            object.object_class = OBJECT_BUOY;
+        }
+        else
+        {
+            object.object_class = OBJECT_OTHER;
+        }
+
+        this->objects.push_back(object);
+    }
+}
+
+void MissionManager::OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status)
+{
+    this->guidance_status = _status;
+}
+
+void MissionManager::StartMission(MissionType_E _mission)
+{
+    this->current_mission       = _mission;
+    this->active_action         = ACTION_NONE;
+    this->searched_distance_m   = 0;
+
+    this->BuildMission(_mission);
+    this->mission_status = (_mission == MISSION_NONE) ? MISSION_IDLE : MISSION_RUNNING;
+}
+
+void MissionManager::BuildMission(MissionType_E _mission)
+{
+    /* The pool keeps its capacity, rebuilding does not allocate */
+    this->tree.Clear();
+
+    if (_mission == MISSION_NONE)
+    {
+        return;
+    }
+
+    if (_mission != MISSION_GATE && _mission != MISSION_BUOY)
+    {
+        this->tree.AddLeaf(BT_ACTION, "unsupported", &MissionManager::Unsupported, this, BT_NO_NODE);
+        return;
+    }
+
+    uint16_t root = this->tree.AddComposite(BT_SEQUENCE, "mission", BT_NO_NODE);
+    this->tree.AddLeaf(BT_ACTION, "dive", &MissionManager::Dive, this, root);
+
+    switch (_mission)
+    {
+        case MISSION_GATE:
+        {
+            uint16_t find = this->tree.AddComposite(BT_FALLBACK, "find_gate", root);
+            this->tree.AddLeaf(BT_CONDITION, "gate_visible", &MissionManager::GateVisible, this, find);
+            this->tree.AddLeaf(BT_ACTION, "search_for_gate", &MissionManager::SearchForGate, this, find);
+            this->tree.AddLeaf(BT_ACTION, "pass_gate", &MissionManager::PassGate, this, root);
+            break;
+        }
+        case MISSION_BUOY:
+        {
+            uint16_t find = this->tree.AddComposite(BT_FALLBACK, "find_buoy", root);
+            this->tree.AddLeaf(BT_CONDITION, "buoy_visible", &MissionManager::BuoyVisible, this, find);
+            this->tree.AddLeaf(BT_ACTION, "search_for_buoy", &MissionManager::SearchForBuoy, this, find);
+            this->tree.AddLeaf(BT_ACTION, "touch_buoy", &MissionManager::TouchBuoy, this, root);
+            this->tree.AddLeaf(BT_ACTION, "back_off", &MissionManager::BackOff, this, root);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void MissionManager::Iteration(std::chrono::microseconds _budget)
+{
+    if (this->mission_status != MISSION_RUNNING)
+    {
+        return;
+    }
+
+    BehaviorStatus_E status = this->tree.Tick(_budget);
+
+    if (status != BT_RUNNING)
+    {
+        this->mission_status = (status == BT_SUCCESS) ? MISSION_SUCCEEDED : MISSION_FAILED;
+        this->active_action = ACTION_NONE;
+        ROS_INFO("Mission manager: mission %d %s", this->current_mission,
+                 (status == BT_SUCCESS) ? "succeeded" : "failed");
+    }
+}
+
+void MissionManager::SendWaypoints(MissionAction_E _action, const float* _x, const float* _y, const float* _z, uint8_t _count,
+                                   float _last_acceptance_radius)
+{
+    this->waypoints.waypoint_list_x.assign(1, this->current_pose.position.x);
+    this->waypoints.waypoint_list_y.assign(1, this->current_pose.position.y);
+    this->waypoints.waypoint_list_z.assign(1, this->current_pose.position.z);
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        this->waypoints.waypoint_list_x.push_back(_x[i]);
+        this->waypoints.waypoint_list_y.push_back(_y[i]);
+        this->waypoints.waypoint_list_z.push_back(_z[i]);
+    }
+
+    /* 3D LOS, so the depth is reached along the way */
+    this->waypoints.guidance_law            = 3;
+    this->waypoints.waypoint_list_length    = this->waypoints.waypoint_list_x.size();
+    this->waypoints.waypoint_list_speed.clear();
+    this->waypoints.waypoint_list_acceptance_radius.clear();
+
+    if (_last_acceptance_radius > 0)
+    {
+        this->waypoints.waypoint_list_acceptance_radius.assign(this->waypoints.waypoint_list_length, 0);
+        this->waypoints.waypoint_list_acceptance_radius.back() = _last_acceptance_radius;
+    }
+
+    this->waypoints.sequence                = ++this->sequence;
+
+    this->path.header.stamp     = ros::Time::now();
+    this->path.header.frame_id  = "world";
+    this->waypoints.header = this->path.header;
+    this->path.poses.resize(this->waypoints.waypoint_list_length);
+
+    for (size_t i = 0; i < this->path.poses.size(); i++)
+    {
+        geometry_msgs::PoseStamped& pose = this->path.poses[i];
+
+        pose.header                 = this->path.header;
+        pose.pose.position.x        = this->waypoints.waypoint_list_x[i];
+        pose.pose.position.y        = -this->waypoints.waypoint_list_y[i];
+        pose.pose.position.z        = -this->waypoints.waypoint_list_z[i];
+        pose.pose.orientation.w     = 1;
+    }
+
+    this->active_action         = _action;
+    this->new_waypoints         = true;
+    this->waypoints_accepted    = false;
+}
+
+BehaviorStatus_E MissionManager::GuidanceProgress()
+{
+    if (!this->new_waypoints && this->guidance_status.waypoint_list_sequence == this->sequence)
+    {
+        /* The guidance goes back to no law once it reaches the last waypoint of our list */
+        this->waypoints_accepted = true;
+
+        if (this->guidance_status.guidance_law == 0)
+        {
+            return BT_SUCCESS;
+        }
+    }
+    /* Replaced after being taken, or never taken although the status came after
+       the list was handed over: a script or the waypoints topic got there first */
+    else if (this->waypoints_accepted ||
+             (!this->new_waypoints && this->guidance_status.header.stamp > this->waypoints.header.stamp))
+    {
+        ROS_WARN("Mission manager: waypoints of action %d replaced by list %u", this->active_action,
+                 this->guidance_status.waypoint_list_sequence);
+        this->active_action = ACTION_NONE;
+        return BT_FAILURE;
+    }
+
+    /* A list that cannot be finished, e.g. a point the avoidance keeps the vehicle from, fails the action */
+    if ((ros::Time::now() - this->waypoints.header.stamp).toSec() > this->action_timeout_s)
+    {
+        ROS_WARN("Mission manager: action %d timed out after %.1f s", this->active_action, this->action_timeout_s);
+        this->active_action = ACTION_NONE;
+        return BT_FAILURE;
+    }
+
+    return BT_RUNNING;
+}
+
+bool MissionManager::FindNearest(MissionObjectClass_E _class, MissionObject_S& _object) const
+{
+    float best_distance = INFINITY;
+
+    for (size_t i = 0; i < this->objects.size(); i++)
+    {
+        const MissionObject_S& object = this->objects[i];
+
+        if (object.object_class != _class)
+        {
+            continue;
+        }
+
+        float distance = std::hypot(object.x - this->current_pose.position.x, object.y - this->current_pose.position.y);
+
+        if (distance < best_distance)
+        {
+            best_distance = distance;
+            _object = object;
+        }
+    }
+
+    return best_distance < INFINITY;
+}
+
+bool MissionManager::FindGate(float* _center_x, float* _center_y, float* _normal_x, float* _normal_y) const
+{
+    /* The gate is given by its two posts closest to the vehicle */
+    const MissionObject_S* posts[2] = {NULL, NULL};
+    float distances[2] = {INFINITY, INFINITY};
+
+    for (size_t i = 0; i < this->objects.size(); i++)
+    {
+        const MissionObject_S& object = this->objects[i];
+
+        if (object.object_class != OBJECT_GATE)
+        {
+            continue;
+        }
+
+        float distance = std::hypot(object.x - this->current_pose.position.x, object.y - this->current_pose.position.y);
+
+        if (distance < distances[0])
+        {
+            posts[1] = posts[0];
+            distances[1] = distances[0];
+            posts[0] = &object;
+            distances[0] = distance;
+        }
+        else if (distance < distances[1])
+        {
+            posts[1] = &object;
+            distances[1] = distance;
+        }
+    }
+
+    if (posts[1] == NULL)
+    {
+        return false;
+    }
+
+    float dx = posts[1]->x - posts[0]->x;
+    float dy = posts[1]->y - posts[0]->y;
+    float width = std::hypot(dx, dy);
+
+    if (width < 1e-3)
+    {
+        return false;
+    }
+
+    *_center_x = (posts[0]->x + posts[1]->x) / 2;
+    *_center_y = (posts[0]->y + posts[1]->y) / 2;
+
+    /* Normal to the gate, pointing away from the vehicle */
+    *_normal_x = -dy / width;
+    *_normal_y = dx / width;
+
+    if ((*_center_x - this->current_pose.position.x) * *_normal_x + (*_center_y - this->current_pose.position.y) * *_normal_y < 0)
+    {
+        *_normal_x = -*_normal_x;
+        *_normal_y = -*_normal_y;
+    }
+
+    return true;
+}
+
+BehaviorStatus_E MissionManager::FollowWaypoints(MissionAction_E _action)
+{
+    if (this->active_action != _action)
+    {
+        return BT_FAILURE;
+    }
+
+    BehaviorStatus_E progress = this->GuidanceProgress();
+
+    if (progress == BT_SUCCESS)
+    {
+        this->active_action = ACTION_NONE;
+    }
+
+    return progress;
+}
+
+BehaviorStatus_E MissionManager::Search(MissionObjectClass_E _class)
+{
+    BehaviorStatus_E visible = (_class == OBJECT_GATE) ? GateVisible(this) : BuoyVisible(this);
+
+    if (visible == BT_SUCCESS)
+    {
+        this->active_action = ACTION_NONE;
+        return BT_SUCCESS;
+    }
+
+    BehaviorStatus_E progress = (this->active_action == ACTION_SEARCH) ? this->GuidanceProgress() : BT_SUCCESS;
+
+    if (progress == BT_FAILURE)
+    {
+        return BT_FAILURE;
+    }
+
+    /* Advance in steps along the current heading until something shows up */
+    if (progress == BT_SUCCESS)
+    {
+        if (this->searched_distance_m >= this->search_distance_m)
+        {
+            this->active_action = ACTION_NONE;
+            return BT_FAILURE;
+        }
+
+        float yaw = this->current_pose.orientation.z;
+        float x = this->current_pose.position.x + this->search_step_m * std::cos(yaw);
+        float y = this->current_pose.position.y + this->search_step_m * std::sin(yaw);
+        float z = this->mission_depth_m;
+
+        this->SendWaypoints(ACTION_SEARCH, &x, &y, &z, 1);
+        this->searched_distance_m += this->search_step_m;
+    }
+
+    return BT_RUNNING;
+}
+
+BehaviorStatus_E MissionManager::Dive(void* _context)
+{
+    MissionManager* manager = (MissionManager*) _context;
+
+    if (manager->active_action != ACTION_DIVE)
+    {
+        float x = manager->current_pose.position.x;
+        float y = manager->current_pose.position.y;
+        float z = manager->mission_depth_m;
+
+        manager->SendWaypoints(ACTION_DIVE, &x, &y, &z, 1);
+        return BT_RUNNING;
+    }
+
+    return manager->FollowWaypoints(ACTION_DIVE);
+}
+
+BehaviorStatus_E MissionManager::GateVisible(void* _context)
+{
+    MissionManager* manager = (MissionManager*) _context;
+    float center_x, center_y, normal_x, normal_y;
+
+    return manager->FindGate(&center_x, &center_y, &normal_x, &normal_y) ? BT_SUCCESS : BT_FAILURE;
+}
+
+BehaviorStatus_E MissionManager::BuoyVisible(void* _context)
+{
+    MissionManager* manager = (MissionManager*) _context;
+    MissionObject_S buoy;
+
+    return manager->FindNearest(OBJECT_BUOY, buoy) ? BT_SUCCESS : BT_FAILURE;
+}
+
+BehaviorStatus_E MissionManager::SearchForGate(void* _context)
+{
+    return ((MissionManager*) _context)->Search(OBJECT_GATE);
+}
+
+BehaviorStatus_E MissionManager::SearchForBuoy(void* _context)
+{
+    return ((MissionManager*) _context)->Search(OBJECT_BUOY);
+}
+
+BehaviorStatus_E MissionManager::PassGate(void* _context)
+{
+    MissionManager* manager = (MissionManager*) _context;
+
+    if (manager->active_action != ACTION_PASS_GATE)
+    {
+        float center_x, center_y, normal_x, normal_y;
+
+        if (!manager->FindGate(&center_x, &center_y, &normal_x, &normal_y))
+        {
+            return BT_FAILURE;
+        }
+
+        /* Line up 2 m before the gate and cross it, ending 3 m past it */
+        float x[2] = {center_x - 2 * normal_x, center_x + 3 * normal_x};
+        float y[2] = {center_y - 2 * normal_y, center_y + 3 * normal_y};
+        float z[2] = {manager->mission_depth_m, manager->mission_depth_m};
+
+        manager->SendWaypoints(ACTION_PASS_GATE, x, y, z, 2);
+        return BT_RUNNING;
+    }
+
+    return manager->FollowWaypoints(ACTION_PASS_GATE);
+}
+
+BehaviorStatus_E MissionManager::TouchBuoy(void* _context)
+{
+    MissionManager* manager = (MissionManager*) _context;
+
+    if (manager->active_action != ACTION_TOUCH_BUOY)
+    {
+        MissionObject_S buoy;
+
+        if (!manager->FindNearest(OBJECT_BUOY, buoy))
+        {
+            return BT_FAILURE;
+        }
+
+        /* Aim at the buoy center. The avoidance stops a head on approach a little outside its safety
+           radius, about 0.4 m with the default gains, so the touch is accepted past that */
+        float z = manager->mission_depth_m;
+        float dx = buoy.x - manager->current_pose.position.x;
+        float dy = buoy.y - manager->current_pose.position.y;
+        float distance = std::max(1e-3f, std::hypot(dx, dy));
+
+        /* Back off point, 2 m from the buoy on the approach side */
+        manager->target_x = buoy.x - 2 * dx / distance;
+        manager->target_y = buoy.y - 2 * dy / distance;
+        manager->SendWaypoints(ACTION_TOUCH_BUOY, &buoy.x, &buoy.y, &z, 1,
+                               buoy.radius + manager->avoidance_radius_m + manager->touch_margin_m);
+        return BT_RUNNING;
+    }
+
+    return manager->FollowWaypoints(ACTION_TOUCH_BUOY);
+}
+
+BehaviorStatus_E MissionManager::BackOff(void* _context)
+{
+    MissionManager* manager = (MissionManager*) _context;
+
+    if (manager->active_action != ACTION_BACK_OFF)
+    {
+        float z = manager->mission_depth_m;
+
+        manager->SendWaypoints(ACTION_BACK_OFF, &manager->target_x, &manager->target_y, &z, 1);
+        return BT_RUNNING;
+    }
+
+    return manager->FollowWaypoints(ACTION_BACK_OFF);
+}
+
+BehaviorStatus_E MissionManager::Unsupported(void* _context)
+{
+    MissionManager* manager = (MissionManager*) _context;
+
+    ROS_WARN("Mission manager: mission %d is not supported", manager->current_mission);
+    return BT_FAILURE;
+}
@@ -0,0 +1,67 @@
+/** ----------------------------------------------------------------------------
+ * @file: coverage_pattern.hpp
+ * 
+ * @brief: Boustrophedon (lawnmower) coverage pattern over a polygon. Legs run
+ *         along the sweep heading, spaced by the swath width, and consecutive
+ *         legs are joined by turn arcs. Waypoints are generated one leg at a
+ *         time, so the pattern is never stored as a whole.
+ *
+ *         Lines crossing a concave polygon more than once are flown interval
+ *         by interval, transiting over the gaps; split such areas into convex
+ *         cells to avoid it.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __COVERAGE_PATTERN_H__
+#define __COVERAGE_PATTERN_H__
+
+#include <deque>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+class CoveragePattern
+{
+    public:
+
+        float   swath_width_m;
+        float   depth_m;
+        float   heading_rad;
+        /* Intermediate points on each turn arc */
+        int     turn_points;
+
+        /* Polygon in NED, in order, not closed */
+        CoveragePattern(const std::vector<Eigen::Vector2f>& _polygon, float _swath_width_m, float _depth_m,
+                        float _heading_rad, int _turn_points);
+        ~CoveragePattern();
+
+        /* Sweep heading that gives the fewest legs (across the minimum width) */
+        static float BestHeading(const std::vector<Eigen::Vector2f>& _polygon);
+
+        uint32_t LineCount() const;
+        void Restart();
+
+        /* False when the pattern is over */
+        bool NextWaypoint(Eigen::Vector3f& _waypoint);
+
+    private:
+
+        /* Polygon in the sweep frame: u along the legs, v across */
+        std::vector<Eigen::Vector2f>    sweep_polygon;
+        float                           first_line_v;
+        uint32_t                        line_count;
+
+        uint32_t                        next_line;
+        bool                            forward;
+        bool                            has_previous_leg;
+        Eigen::Vector2f                 previous_leg_end;
+
+        std::deque<Eigen::Vector2f>     pending;
+        std::vector<float>              crossings;
+
+        bool GenerateLine();
+        void AddTurn(const Eigen::Vector2f& _from, const Eigen::Vector2f& _to);
+        Eigen::Vector3f ToNed(const Eigen::Vector2f& _sweep) const;
+};
+
+#endif
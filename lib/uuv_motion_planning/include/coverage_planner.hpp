@@ -0,0 +1,60 @@
+/** ----------------------------------------------------------------------------
+ * @file: coverage_planner.hpp
+ * 
+ * @brief: Coverage planner class. Streams a coverage pattern to the guidance
+ *         controller in chunks: the next chunk is sent once the vehicle is on
+ *         the last segment of the current one, starting with that segment so
+ *         the guidance law carries on without a jump.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __COVERAGE_PLANNER_H__
+#define __COVERAGE_PLANNER_H__
+
+#include "coverage_pattern.hpp"
+
+#include <ros/ros.h>
+#include <eigen3/Eigen/Dense>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Path.h>
+#include <vanttec_uuv/GuidanceStatus.h>
+#include <vanttec_uuv/GuidanceWaypoints.h>
+#include <vanttec_uuv/VehicleState.h>
+
+class CoveragePlanner
+{
+    public:
+
+        CoveragePattern                 pattern;
+
+        /* At most 255 waypoints fit in a list */
+        uint8_t                         chunk_size;
+
+        vanttec_uuv::GuidanceWaypoints  waypoints;
+        nav_msgs::Path                  path;
+
+        uint32_t                        sent_waypoints;
+        bool                            finished;
+
+        CoveragePlanner(const CoveragePattern& _pattern, uint8_t _chunk_size);
+        ~CoveragePlanner();
+
+        void OnStateReception(const vanttec_uuv::VehicleState& _state);
+        void OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status);
+
+        /* Returns true when there is a new chunk to publish */
+        bool Iteration();
+
+    private:
+
+        vanttec_uuv::GuidanceStatus     guidance_status;
+        Eigen::Vector3f                 current_position;
+        bool                            state_received;
+        bool                            status_received;
+        bool                            started;
+        uint32_t                        sequence;
+
+        bool BuildChunk();
+};
+
+#endif
@@ -0,0 +1,78 @@
+/** ----------------------------------------------------------------------------
+ * @file: mission_file.hpp
+ * 
+ * @brief: Binary mission file. A fixed header followed by one fixed size
+ *         record per waypoint, little endian. Files are memory mapped and
+ *         only the header is validated, so opening a mission is independent
+ *         of its length; records are paged in by the OS as they are read.
+ *
+ *         CSV sources have one waypoint per line, NED coordinates in meters.
+ *         Lines starting with '#' and a non numeric header line are skipped.
+ *
+ *             x, y, z, speed, acceptance_radius, guidance_law
+ *
+ *         Guidance laws are 1 (LOS), 2 (orbit) and 3 (3D LOS). A speed or
+ *         acceptance radius of 0 leaves the guidance defaults.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __MISSION_FILE_H__
+#define __MISSION_FILE_H__
+
+#include <stdint.h>
+#include <string>
+
+const char      MISSION_FILE_MAGIC[8]   = {'U', 'U', 'V', 'M', 'I', 'S', 'S', 'N'};
+const uint32_t  MISSION_FILE_VERSION    = 1;
+
+typedef struct MissionFileHeader_S
+{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    header_size;
+    uint32_t    record_size;
+    uint32_t    reserved;
+    uint64_t    waypoint_count;
+} MissionFileHeader_S;
+
+typedef struct MissionWaypoint_S
+{
+    float       x;
+    float       y;
+    float       z;
+    float       speed;
+    float       acceptance_radius;
+    uint8_t     guidance_law;
+    uint8_t     reserved[3];
+} MissionWaypoint_S;
+
+static_assert(sizeof(MissionFileHeader_S) == 32, "Mission file header layout changed");
+static_assert(sizeof(MissionWaypoint_S) == 24, "Mission file record layout changed");
+
+class MissionFile
+{
+    public:
+
+        /* Points into the mapping, valid while the file is open */
+        const MissionWaypoint_S*    waypoints;
+        uint64_t                    waypoint_count;
+        const char*                 error;
+
+        MissionFile();
+        ~MissionFile();
+
+        bool Open(const std::string& _path);
+        void Close();
+        bool IsOpen() const;
+
+        /* Converts a CSV mission, writing the records as they are parsed */
+        static bool FromCsv(const std::string& _csv_path, const std::string& _path,
+                            uint64_t* _waypoint_count, uint64_t* _malformed_lines);
+
+    private:
+
+        void*   mapping;
+        size_t  mapping_size;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/** ----------------------------------------------------------------------------
+ * @file: mission_player.hpp
+ * 
+ * @brief: Mission player class. Streams a memory mapped mission file to the
+ *         guidance controller in pages of consecutive waypoints that share a
+ *         guidance law. A page following one of the same law is sent when the
+ *         vehicle reaches its last segment and starts with that segment; a
+ *         page with a new law is sent once the previous one is finished.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __MISSION_PLAYER_H__
+#define __MISSION_PLAYER_H__
+
+#include "mission_file.hpp"
+
+#include <ros/ros.h>
+#include <eigen3/Eigen/Dense>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Path.h>
+#include <vanttec_uuv/GuidanceStatus.h>
+#include <vanttec_uuv/GuidanceWaypoints.h>
+#include <vanttec_uuv/VehicleState.h>
+
+class MissionPlayer
+{
+    public:
+
+        MissionFile                     mission;
+
+        /* At most 255 waypoints fit in a list */
+        uint8_t                         page_size;
+
+        vanttec_uuv::GuidanceWaypoints  waypoints;
+        nav_msgs::Path                  path;
+
+        uint64_t                        next_waypoint;
+        bool                            finished;
+
+        MissionPlayer(uint8_t _page_size);
+        ~MissionPlayer();
+
+        bool Load(const std::string& _path);
+
+        void OnStateReception(const vanttec_uuv::VehicleState& _state);
+        void OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status);
+
+        /* Returns true when there is a new page to publish */
+        bool Iteration();
+
+    private:
+
+        vanttec_uuv::GuidanceStatus     guidance_status;
+        Eigen::Vector3f                 current_position;
+        bool                            state_received;
+        bool                            status_received;
+        bool                            started;
+        uint32_t                        sequence;
+
+        void AddWaypoint(float _x, float _y, float _z, float _speed, float _acceptance_radius);
+        void BuildPage();
+};
+
+#endif
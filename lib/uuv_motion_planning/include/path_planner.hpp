@@ -0,0 +1,79 @@
+/** ----------------------------------------------------------------------------
+ * @file: path_planner.hpp
+ * 
+ * @brief: Path planner class. Keeps a voxel grid of the obstacle world and
+ *         plans from the current position to the requested goal, replanning
+ *         when the goal or the world change. The result is given as guidance
+ *         waypoints and as a path for RViz. Paths longer than a waypoint list
+ *         are streamed in chunks, like the coverage planner does: the next one
+ *         is sent once the vehicle is on the last segment of the current one.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __PATH_PLANNER_H__
+#define __PATH_PLANNER_H__
+
+#include "voxel_grid.hpp"
+#include "theta_star_planner.hpp"
+
+#include <vector>
+
+#include <ros/ros.h>
+#include <eigen3/Eigen/Dense>
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Path.h>
+#include <vanttec_uuv/GuidanceStatus.h>
+#include <vanttec_uuv/GuidanceWaypoints.h>
+#include <vanttec_uuv/ObstacleList.h>
+#include <vanttec_uuv/VehicleState.h>
+
+class PathPlanner
+{
+    public:
+
+        VoxelGrid                       grid;
+        ThetaStarPlanner                planner;
+        float                           inflation_m;
+
+        /* At most 255 waypoints fit in a list */
+        uint8_t                         chunk_size;
+
+        vanttec_uuv::GuidanceWaypoints  waypoints;
+        nav_msgs::Path                  path;
+
+        PathPlanner(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _size_m, float _resolution_m,
+                    float _inflation_m, uint32_t _max_nodes);
+        ~PathPlanner();
+
+        void OnWorldReception(const vanttec_uuv::ObstacleList& _obstacles);
+        void OnStateReception(const vanttec_uuv::VehicleState& _state);
+        void OnGoalReception(const geometry_msgs::Pose& _goal);
+        void OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status);
+
+        /* Plans if needed, returns true when there is a new plan or chunk to publish */
+        bool Iteration();
+
+    private:
+
+        Eigen::Vector3f                 current_position;
+        Eigen::Vector3f                 goal;
+        bool                            state_received;
+        bool                            goal_received;
+        bool                            replan_requested;
+
+        vanttec_uuv::GuidanceStatus     guidance_status;
+        bool                            status_received;
+        uint32_t                        sequence;
+
+        std::vector<Eigen::Vector3i>    voxel_path;
+
+        /* Waypoints of the whole plan, and the first one not sent yet */
+        std::vector<Eigen::Vector3f>    points;
+        size_t                          next_point;
+
+        void FillPath();
+        void BuildChunk();
+};
+
+#endif
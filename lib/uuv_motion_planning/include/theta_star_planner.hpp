@@ -0,0 +1,82 @@
+/** ----------------------------------------------------------------------------
+ * @file: theta_star_planner.hpp
+ * 
+ * @brief: Path planner over a voxel grid, 26-connected. Runs A* with the exact
+ *         26-connected distance as heuristic, or Lazy Theta* (any-angle, with
+ *         the euclidean distance) when any_angle is set. Both heuristics are
+ *         admissible. Search nodes live in a pool allocated once, are found
+ *         through an open addressing table keyed by voxel index, and the open
+ *         list is a binary heap with decrease-key.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __THETA_STAR_PLANNER_H__
+#define __THETA_STAR_PLANNER_H__
+
+#include "voxel_grid.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+/* heap_position is the node's slot in the open list, or one of these */
+const int32_t NODE_CLOSED       = -1;
+const int32_t NODE_UNVISITED    = -2;
+
+typedef struct PlannerNode_S
+{
+    uint32_t    voxel;
+    int32_t     parent;
+    float       g;
+    float       f;
+    int32_t     heap_position;
+} PlannerNode_S;
+
+class ThetaStarPlanner
+{
+    public:
+
+        uint32_t    max_nodes;
+
+        /* Lazy Theta* instead of A*. Shorter raw paths, but every expansion
+           pays a line of sight check, which gets slow on long open paths. */
+        bool        any_angle;
+
+        /* Statistics of the last search */
+        uint32_t    expanded_count;
+        uint32_t    line_of_sight_checks;
+
+        ThetaStarPlanner(uint32_t _max_nodes);
+        ~ThetaStarPlanner();
+
+        /* Voxel path from start to goal, both included. False if the goal is
+           blocked, unreachable or the node pool ran out. */
+        bool Plan(const VoxelGrid& _grid, const Eigen::Vector3i& _start, const Eigen::Vector3i& _goal,
+                  std::vector<Eigen::Vector3i>& _path);
+
+        /* Drops every point that the previous kept point can see past */
+        static void PrunePath(const VoxelGrid& _grid, std::vector<Eigen::Vector3i>& _path);
+
+    private:
+
+        std::vector<PlannerNode_S>  pool;
+        uint32_t                    pool_size;
+
+        std::vector<uint32_t>       table_keys;
+        std::vector<int32_t>        table_nodes;
+        int                         table_bits;
+
+        std::vector<int32_t>        heap;
+
+        int32_t FindNode(uint32_t _voxel) const;
+        int32_t CreateNode(uint32_t _voxel);
+
+        bool Before(int32_t _a, int32_t _b) const;
+        void HeapPush(int32_t _node);
+        int32_t HeapPop();
+        void SiftUp(int32_t _position);
+        void SiftDown(int32_t _position);
+};
+
+#endif
@@ -0,0 +1,53 @@
+/** ----------------------------------------------------------------------------
+ * @file: voxel_grid.hpp
+ * 
+ * @brief: 3D occupancy voxel grid in NED, built from the obstacle world with
+ *         the obstacles inflated by the vehicle radius.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __VOXEL_GRID_H__
+#define __VOXEL_GRID_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+#include <vanttec_uuv/ObstacleList.h>
+
+class VoxelGrid
+{
+    public:
+
+        Eigen::Vector3f         origin;
+        float                   resolution_m;
+        int                     size_x;
+        int                     size_y;
+        int                     size_z;
+
+        /* One byte per voxel, x fastest */
+        std::vector<uint8_t>    occupied;
+
+        VoxelGrid(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _size_m, float _resolution_m);
+        ~VoxelGrid();
+
+        void Build(const vanttec_uuv::ObstacleList& _obstacles, float _inflation_m);
+
+        inline uint32_t Index(int _x, int _y, int _z) const
+        {
+            return ((uint32_t) _z * this->size_y + _y) * this->size_x + _x;
+        }
+
+        inline bool Inside(int _x, int _y, int _z) const
+        {
+            return _x >= 0 && _y >= 0 && _z >= 0 && _x < this->size_x && _y < this->size_y && _z < this->size_z;
+        }
+
+        bool ToVoxel(const Eigen::Vector3f& _point, Eigen::Vector3i& _voxel) const;
+        Eigen::Vector3f ToPoint(const Eigen::Vector3i& _voxel) const;
+
+        /* Walks every voxel crossed by the segment between two voxel centers */
+        bool LineOfSight(const Eigen::Vector3i& _from, const Eigen::Vector3i& _to) const;
+};
+
+#endif
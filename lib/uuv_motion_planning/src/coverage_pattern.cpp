@@ -0,0 +1,212 @@
+/** ----------------------------------------------------------------------------
+ * @file: coverage_pattern.cpp
+ * 
+ * @brief: Boustrophedon (lawnmower) coverage pattern over a polygon. Legs run
+ *         along the sweep heading, spaced by the swath width, and consecutive
+ *         legs are joined by turn arcs.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "coverage_pattern.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+CoveragePattern::CoveragePattern(const std::vector<Eigen::Vector2f>& _polygon, float _swath_width_m, float _depth_m,
+                                 float _heading_rad, int _turn_points)
+{
+    this->swath_width_m = _swath_width_m;
+    this->depth_m       = _depth_m;
+    this->heading_rad   = _heading_rad;
+    this->turn_points   = std::max(0, _turn_points);
+
+    /* Rotate into the sweep frame */
+    float c = std::cos(_heading_rad);
+    float s = std::sin(_heading_rad);
+    float min_v = INFINITY;
+    float max_v = -INFINITY;
+
+    for (size_t i = 0; i < _polygon.size(); i++)
+    {
+        Eigen::Vector2f point(c * _polygon[i](0) + s * _polygon[i](1), -s * _polygon[i](0) + c * _polygon[i](1));
+
+        this->sweep_polygon.push_back(point);
+        min_v = std::min(min_v, point(1));
+        max_v = std::max(max_v, point(1));
+    }
+
+    /* Lines centered on the area, the outer ones half a swath inside */
+    this->line_count = 0;
+    this->first_line_v = 0;
+
+    if (_polygon.size() >= 3 && _swath_width_m > 0)
+    {
+        float width = max_v - min_v;
+        this->line_count = std::max(1, int(std::ceil(width / _swath_width_m)));
+        this->first_line_v = min_v + (width - (this->line_count - 1) * _swath_width_m) / 2;
+    }
+
+    this->crossings.reserve(_polygon.size());
+    this->Restart();
+}
+
+CoveragePattern::~CoveragePattern(){}
+
+float CoveragePattern::BestHeading(const std::vector<Eigen::Vector2f>& _polygon)
+{
+    /* The minimum width of a polygon is found across one of its edges,
+       so sweeping along that edge gives the fewest legs */
+    float best_heading  = 0;
+    float best_width    = INFINITY;
+
+    for (size_t i = 0; i < _polygon.size(); i++)
+    {
+        Eigen::Vector2f edge = _polygon[(i + 1) % _polygon.size()] - _polygon[i];
+
+        if (edge.norm() < 1e-6)
+        {
+            continue;
+        }
+
+        Eigen::Vector2f normal(-edge(1) / edge.norm(), edge(0) / edge.norm());
+        float min_v = INFINITY;
+        float max_v = -INFINITY;
+
+        for (size_t j = 0; j < _polygon.size(); j++)
+        {
+            float v = normal.dot(_polygon[j]);
+            min_v = std::min(min_v, v);
+            max_v = std::max(max_v, v);
+        }
+
+        if (max_v - min_v < best_width)
+        {
+            best_width      = max_v - min_v;
+            best_heading    = std::atan2(edge(1), edge(0));
+        }
+    }
+
+    return best_heading;
+}
+
+uint32_t CoveragePattern::LineCount() const
+{
+    return this->line_count;
+}
+
+void CoveragePattern::Restart()
+{
+    this->next_line         = 0;
+    this->forward           = true;
+    this->has_previous_leg  = false;
+    this->pending.clear();
+}
+
+Eigen::Vector3f CoveragePattern::ToNed(const Eigen::Vector2f& _sweep) const
+{
+    float c = std::cos(this->heading_rad);
+    float s = std::sin(this->heading_rad);
+
+    return Eigen::Vector3f(c * _sweep(0) - s * _sweep(1), s * _sweep(0) + c * _sweep(1), this->depth_m);
+}
+
+void CoveragePattern::AddTurn(const Eigen::Vector2f& _from, const Eigen::Vector2f& _to)
+{
+    /* forward is already the direction of the next leg: the turn bulges out
+       past the later of the two leg ends, in the direction of the previous one */
+    float outward   = this->forward ? -1 : 1;
+    float across    = (_to(1) > _from(1)) ? 1 : -1;
+    float along     = (outward > 0) ? std::max(_from(0), _to(0)) : std::min(_from(0), _to(0));
+    float radius    = std::fabs(_to(1) - _from(1)) / 2;
+
+    Eigen::Vector2f center(along, _from(1) + across * radius);
+
+    if (std::fabs(along - _from(0)) > 1e-3)
+    {
+        this->pending.push_back(Eigen::Vector2f(along, _from(1)));
+    }
+
+    for (int i = 1; i <= this->turn_points; i++)
+    {
+        float angle = M_PI * i / (this->turn_points + 1);
+
+        this->pending.push_back(Eigen::Vector2f(center(0) + outward * radius * std::sin(angle),
+                                                center(1) - across * radius * std::cos(angle)));
+    }
+
+    if (std::fabs(along - _to(0)) > 1e-3)
+    {
+        this->pending.push_back(Eigen::Vector2f(along, _to(1)));
+    }
+}
+
+bool CoveragePattern::GenerateLine()
+{
+    while (this->next_line < this->line_count)
+    {
+        float v = this->first_line_v + this->next_line * this->swath_width_m;
+        this->next_line++;
+
+        /* Crossings of the line with the polygon edges */
+        this->crossings.clear();
+
+        for (size_t i = 0; i < this->sweep_polygon.size(); i++)
+        {
+            const Eigen::Vector2f& a = this->sweep_polygon[i];
+            const Eigen::Vector2f& b = this->sweep_polygon[(i + 1) % this->sweep_polygon.size()];
+
+            /* Half open test so shared vertices count once */
+            if ((a(1) <= v) != (b(1) <= v))
+            {
+                this->crossings.push_back(a(0) + (v - a(1)) * (b(0) - a(0)) / (b(1) - a(1)));
+            }
+        }
+
+        if (this->crossings.size() < 2)
+        {
+            continue;
+        }
+
+        std::sort(this->crossings.begin(), this->crossings.end());
+
+        if (!this->forward)
+        {
+            std::reverse(this->crossings.begin(), this->crossings.end());
+        }
+
+        Eigen::Vector2f start(this->crossings.front(), v);
+
+        if (this->has_previous_leg)
+        {
+            this->AddTurn(this->previous_leg_end, start);
+        }
+
+        /* Inside intervals alternate with gaps */
+        for (size_t i = 0; i + 1 < this->crossings.size(); i += 2)
+        {
+            this->pending.push_back(Eigen::Vector2f(this->crossings[i], v));
+            this->pending.push_back(Eigen::Vector2f(this->crossings[i + 1], v));
+        }
+
+        this->previous_leg_end  = Eigen::Vector2f(this->crossings[this->crossings.size() - 1 - (this->crossings.size() % 2)], v);
+        this->has_previous_leg  = true;
+        this->forward           = !this->forward;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CoveragePattern::NextWaypoint(Eigen::Vector3f& _waypoint)
+{
+    if (this->pending.empty() && !this->GenerateLine())
+    {
+        return false;
+    }
+
+    _waypoint = this->ToNed(this->pending.front());
+    this->pending.pop_front();
+
+    return true;
+}
@@ -0,0 +1,149 @@
+/** ----------------------------------------------------------------------------
+ * @file: coverage_planner.cpp
+ * 
+ * @brief: Coverage planner class. Streams a coverage pattern to the guidance
+ *         controller in chunks: the next chunk is sent once the vehicle is on
+ *         the last segment of the current one, starting with that segment so
+ *         the guidance law carries on without a jump.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "coverage_planner.hpp"
+
+#include <algorithm>
+
+CoveragePlanner::CoveragePlanner(const CoveragePattern& _pattern, uint8_t _chunk_size)
+    : pattern(_pattern)
+{
+    this->chunk_size        = std::max((uint8_t) 3, _chunk_size);
+    this->sent_waypoints    = 0;
+    this->finished          = false;
+    this->state_received    = false;
+    this->status_received   = false;
+    this->started           = false;
+
+    /* Chosen so it does not collide with the sequence of other waypoint sources */
+    this->sequence          = 0x10000;
+
+    this->waypoints.guidance_law = 1;
+    this->waypoints.waypoint_list_x.reserve(this->chunk_size);
+    this->waypoints.waypoint_list_y.reserve(this->chunk_size);
+    this->waypoints.waypoint_list_z.reserve(this->chunk_size);
+    this->path.poses.reserve(this->chunk_size);
+}
+
+CoveragePlanner::~CoveragePlanner(){}
+
+void CoveragePlanner::OnStateReception(const vanttec_uuv::VehicleState& _state)
+{
+    this->current_position << _state.x, _state.y, _state.z;
+    this->state_received = true;
+}
+
+void CoveragePlanner::OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status)
+{
+    this->guidance_status = _status;
+    this->status_received = true;
+}
+
+bool CoveragePlanner::BuildChunk()
+{
+    /* Keep the last segment of the previous chunk as the first of this one */
+    size_t keep = 0;
+
+    if (this->waypoints.waypoint_list_length >= 2)
+    {
+        size_t last = this->waypoints.waypoint_list_length - 1;
+
+        this->waypoints.waypoint_list_x[0] = this->waypoints.waypoint_list_x[last - 1];
+        this->waypoints.waypoint_list_y[0] = this->waypoints.waypoint_list_y[last - 1];
+        this->waypoints.waypoint_list_z[0] = this->waypoints.waypoint_list_z[last - 1];
+        this->waypoints.waypoint_list_x[1] = this->waypoints.waypoint_list_x[last];
+        this->waypoints.waypoint_list_y[1] = this->waypoints.waypoint_list_y[last];
+        this->waypoints.waypoint_list_z[1] = this->waypoints.waypoint_list_z[last];
+        keep = 2;
+    }
+    else
+    {
+        /* First chunk: from wherever the vehicle is to the start of the pattern */
+        this->waypoints.waypoint_list_x.assign(1, this->current_position(0));
+        this->waypoints.waypoint_list_y.assign(1, this->current_position(1));
+        this->waypoints.waypoint_list_z.assign(1, this->current_position(2));
+        keep = 1;
+    }
+
+    this->waypoints.waypoint_list_x.resize(keep);
+    this->waypoints.waypoint_list_y.resize(keep);
+    this->waypoints.waypoint_list_z.resize(keep);
+
+    Eigen::Vector3f waypoint;
+    size_t added = 0;
+
+    while (this->waypoints.waypoint_list_x.size() < this->chunk_size && this->pattern.NextWaypoint(waypoint))
+    {
+        this->waypoints.waypoint_list_x.push_back(waypoint(0));
+        this->waypoints.waypoint_list_y.push_back(waypoint(1));
+        this->waypoints.waypoint_list_z.push_back(waypoint(2));
+        added++;
+    }
+
+    if (added == 0)
+    {
+        return false;
+    }
+
+    this->sent_waypoints                    += added;
+    this->waypoints.waypoint_list_length    = this->waypoints.waypoint_list_x.size();
+    this->waypoints.sequence                = ++this->sequence;
+
+    /* Path of the chunk for RViz */
+    this->path.header.stamp     = ros::Time::now();
+    this->path.header.frame_id  = "world";
+    this->waypoints.header = this->path.header;
+    this->path.poses.resize(this->waypoints.waypoint_list_length);
+
+    for (size_t i = 0; i < this->path.poses.size(); i++)
+    {
+        geometry_msgs::PoseStamped& pose = this->path.poses[i];
+
+        pose.header                 = this->path.header;
+        pose.pose.position.x        = this->waypoints.waypoint_list_x[i];
+        pose.pose.position.y        = -this->waypoints.waypoint_list_y[i];
+        pose.pose.position.z        = -this->waypoints.waypoint_list_z[i];
+        pose.pose.orientation.w     = 1;
+    }
+
+    return true;
+}
+
+bool CoveragePlanner::Iteration()
+{
+    if (this->finished || !this->state_received || !this->status_received)
+    {
+        return false;
+    }
+
+    if (!this->started)
+    {
+        this->started = true;
+        this->finished = !this->BuildChunk();
+
+        return !this->finished;
+    }
+
+    /* Wait until the guidance is on the last segment of our latest chunk */
+    if (this->guidance_status.waypoint_list_sequence != this->sequence ||
+        this->guidance_status.current_waypoint + 2 < (int32_t) this->waypoints.waypoint_list_length)
+    {
+        return false;
+    }
+
+    if (!this->BuildChunk())
+    {
+        this->finished = true;
+        ROS_INFO("Coverage planner: pattern finished, %u waypoints sent", this->sent_waypoints);
+        return false;
+    }
+
+    return true;
+}
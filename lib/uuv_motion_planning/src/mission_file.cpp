@@ -0,0 +1,192 @@
+/** ----------------------------------------------------------------------------
+ * @file: mission_file.cpp
+ * 
+ * @brief: Binary mission file. A fixed header followed by one fixed size
+ *         record per waypoint, little endian. Files are memory mapped and
+ *         only the header is validated, so opening a mission is independent
+ *         of its length; records are paged in by the OS as they are read.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "mission_file.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MissionFile::MissionFile()
+{
+    this->waypoints         = NULL;
+    this->waypoint_count    = 0;
+    this->error             = NULL;
+    this->mapping           = NULL;
+    this->mapping_size      = 0;
+}
+
+MissionFile::~MissionFile()
+{
+    this->Close();
+}
+
+bool MissionFile::Open(const std::string& _path)
+{
+    this->Close();
+
+    int fd = open(_path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        this->error = "could not open the file";
+        return false;
+    }
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) != 0 || (size_t) file_stat.st_size < sizeof(MissionFileHeader_S))
+    {
+        close(fd);
+        this->error = "file too short for a mission header";
+        return false;
+    }
+
+    void* mapping = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    /* The mapping keeps its own reference to the file */
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        this->error = "could not map the file";
+        return false;
+    }
+
+    const MissionFileHeader_S* header = (const MissionFileHeader_S*) mapping;
+    size_t size = file_stat.st_size;
+
+    if (std::memcmp(header->magic, MISSION_FILE_MAGIC, sizeof(MISSION_FILE_MAGIC)) != 0)
+    {
+        this->error = "not a mission file";
+    }
+    else if (header->version != MISSION_FILE_VERSION ||
+             header->header_size != sizeof(MissionFileHeader_S) ||
+             header->record_size != sizeof(MissionWaypoint_S))
+    {
+        this->error = "unsupported mission file version";
+    }
+    else if (header->waypoint_count > (size - sizeof(MissionFileHeader_S)) / sizeof(MissionWaypoint_S))
+    {
+        this->error = "mission file is truncated";
+    }
+
+    if (this->error != NULL)
+    {
+        munmap(mapping, size);
+        return false;
+    }
+
+    /* Waypoints are read front to back */
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    this->mapping           = mapping;
+    this->mapping_size      = size;
+    this->waypoints         = (const MissionWaypoint_S*) ((const char*) mapping + sizeof(MissionFileHeader_S));
+    this->waypoint_count    = header->waypoint_count;
+
+    return true;
+}
+
+void MissionFile::Close()
+{
+    if (this->mapping != NULL)
+    {
+        munmap(this->mapping, this->mapping_size);
+    }
+
+    this->mapping           = NULL;
+    this->mapping_size      = 0;
+    this->waypoints         = NULL;
+    this->waypoint_count    = 0;
+    this->error             = NULL;
+}
+
+bool MissionFile::IsOpen() const
+{
+    return this->mapping != NULL;
+}
+
+bool MissionFile::FromCsv(const std::string& _csv_path, const std::string& _path,
+                          uint64_t* _waypoint_count, uint64_t* _malformed_lines)
+{
+    std::ifstream csv(_csv_path.c_str());
+    FILE* output = std::fopen(_path.c_str(), "wb");
+
+    if (!csv.is_open() || output == NULL)
+    {
+        if (output != NULL)
+        {
+            std::fclose(output);
+        }
+        return false;
+    }
+
+    MissionFileHeader_S header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MISSION_FILE_MAGIC, sizeof(MISSION_FILE_MAGIC));
+    header.version      = MISSION_FILE_VERSION;
+    header.header_size  = sizeof(MissionFileHeader_S);
+    header.record_size  = sizeof(MissionWaypoint_S);
+
+    /* The count is patched once all the records are written */
+    bool ok = std::fwrite(&header, sizeof(header), 1, output) == 1;
+
+    std::string line;
+    uint64_t malformed = 0;
+    bool first_line = true;
+
+    while (ok && std::getline(csv, line))
+    {
+        size_t start = line.find_first_not_of(" \t\r");
+        bool header_line = first_line;
+        first_line = false;
+
+        if (start == std::string::npos || line[start] == '#')
+        {
+            continue;
+        }
+
+        MissionWaypoint_S waypoint;
+        std::memset(&waypoint, 0, sizeof(waypoint));
+        unsigned int law = 0;
+        char trailing;
+
+        if (std::sscanf(line.c_str(), " %f , %f , %f , %f , %f , %u %c",
+                        &waypoint.x, &waypoint.y, &waypoint.z, &waypoint.speed,
+                        &waypoint.acceptance_radius, &law, &trailing) != 6 ||
+            law < 1 || law > 3 || waypoint.speed < 0 || waypoint.acceptance_radius < 0)
+        {
+            /* A column header is not an error */
+            if (!(header_line && (line[start] < '0' || line[start] > '9') && line[start] != '-' && line[start] != '.'))
+            {
+                malformed++;
+            }
+            continue;
+        }
+
+        waypoint.guidance_law = law;
+        ok = std::fwrite(&waypoint, sizeof(waypoint), 1, output) == 1;
+        header.waypoint_count++;
+    }
+
+    ok = ok && std::fseek(output, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, output) == 1;
+    ok = (std::fclose(output) == 0) && ok;
+
+    *_waypoint_count    = header.waypoint_count;
+    *_malformed_lines   = malformed;
+
+    return ok;
+}
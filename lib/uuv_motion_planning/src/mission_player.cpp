@@ -0,0 +1,172 @@
+/** ----------------------------------------------------------------------------
+ * @file: mission_player.cpp
+ * 
+ * @brief: Mission player class. Streams a memory mapped mission file to the
+ *         guidance controller in pages of consecutive waypoints that share a
+ *         guidance law. A page following one of the same law is sent when the
+ *         vehicle reaches its last segment and starts with that segment; a
+ *         page with a new law is sent once the previous one is finished.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "mission_player.hpp"
+
+#include <algorithm>
+
+MissionPlayer::MissionPlayer(uint8_t _page_size)
+{
+    this->page_size         = std::max((uint8_t) 3, _page_size);
+    this->next_waypoint     = 0;
+    this->finished          = false;
+    this->state_received    = false;
+    this->status_received   = false;
+    this->started           = false;
+
+    /* Chosen so it does not collide with the sequence of other waypoint sources */
+    this->sequence          = 0x20000;
+
+    this->waypoints.waypoint_list_x.reserve(this->page_size);
+    this->waypoints.waypoint_list_y.reserve(this->page_size);
+    this->waypoints.waypoint_list_z.reserve(this->page_size);
+    this->waypoints.waypoint_list_speed.reserve(this->page_size);
+    this->waypoints.waypoint_list_acceptance_radius.reserve(this->page_size);
+    this->path.poses.reserve(this->page_size);
+}
+
+MissionPlayer::~MissionPlayer(){}
+
+bool MissionPlayer::Load(const std::string& _path)
+{
+    this->next_waypoint     = 0;
+    this->started           = false;
+
+    if (!this->mission.Open(_path))
+    {
+        this->finished = true;
+        return false;
+    }
+
+    this->finished = (this->mission.waypoint_count == 0);
+
+    return true;
+}
+
+void MissionPlayer::OnStateReception(const vanttec_uuv::VehicleState& _state)
+{
+    this->current_position << _state.x, _state.y, _state.z;
+    this->state_received = true;
+}
+
+void MissionPlayer::OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status)
+{
+    this->guidance_status = _status;
+    this->status_received = true;
+}
+
+void MissionPlayer::AddWaypoint(float _x, float _y, float _z, float _speed, float _acceptance_radius)
+{
+    this->waypoints.waypoint_list_x.push_back(_x);
+    this->waypoints.waypoint_list_y.push_back(_y);
+    this->waypoints.waypoint_list_z.push_back(_z);
+    this->waypoints.waypoint_list_speed.push_back(_speed);
+    this->waypoints.waypoint_list_acceptance_radius.push_back(_acceptance_radius);
+}
+
+void MissionPlayer::BuildPage()
+{
+    const MissionWaypoint_S* mission_waypoints = this->mission.waypoints;
+    uint8_t law = mission_waypoints[this->next_waypoint].guidance_law;
+
+    /* Continue the segment in progress if the law does not change */
+    bool continue_segment = this->started && (law == this->waypoints.guidance_law);
+
+    this->waypoints.waypoint_list_x.clear();
+    this->waypoints.waypoint_list_y.clear();
+    this->waypoints.waypoint_list_z.clear();
+    this->waypoints.waypoint_list_speed.clear();
+    this->waypoints.waypoint_list_acceptance_radius.clear();
+
+    if (!this->started)
+    {
+        /* First page: from wherever the vehicle is to the first waypoint */
+        this->AddWaypoint(this->current_position(0), this->current_position(1), this->current_position(2), 0, 0);
+        this->started = true;
+    }
+    else
+    {
+        for (uint64_t i = this->next_waypoint - (continue_segment ? 2 : 1); i < this->next_waypoint; i++)
+        {
+            const MissionWaypoint_S& waypoint = mission_waypoints[i];
+            this->AddWaypoint(waypoint.x, waypoint.y, waypoint.z, waypoint.speed, waypoint.acceptance_radius);
+        }
+    }
+
+    while (this->waypoints.waypoint_list_x.size() < this->page_size &&
+           this->next_waypoint < this->mission.waypoint_count &&
+           mission_waypoints[this->next_waypoint].guidance_law == law)
+    {
+        const MissionWaypoint_S& waypoint = mission_waypoints[this->next_waypoint];
+        this->AddWaypoint(waypoint.x, waypoint.y, waypoint.z, waypoint.speed, waypoint.acceptance_radius);
+        this->next_waypoint++;
+    }
+
+    this->waypoints.guidance_law            = law;
+    this->waypoints.waypoint_list_length    = this->waypoints.waypoint_list_x.size();
+    this->waypoints.sequence                = ++this->sequence;
+
+    /* Path of the page for RViz */
+    this->path.header.stamp     = ros::Time::now();
+    this->path.header.frame_id  = "world";
+    this->waypoints.header = this->path.header;
+    this->path.poses.resize(this->waypoints.waypoint_list_length);
+
+    for (size_t i = 0; i < this->path.poses.size(); i++)
+    {
+        geometry_msgs::PoseStamped& pose = this->path.poses[i];
+
+        pose.header                 = this->path.header;
+        pose.pose.position.x        = this->waypoints.waypoint_list_x[i];
+        pose.pose.position.y        = -this->waypoints.waypoint_list_y[i];
+        pose.pose.position.z        = -this->waypoints.waypoint_list_z[i];
+        pose.pose.orientation.w     = 1;
+    }
+}
+
+bool MissionPlayer::Iteration()
+{
+    if (this->finished || !this->state_received || !this->status_received)
+    {
+        return false;
+    }
+
+    if (!this->started)
+    {
+        this->BuildPage();
+        return true;
+    }
+
+    bool page_done = (this->guidance_status.waypoint_list_sequence == this->sequence &&
+                      this->guidance_status.guidance_law == 0);
+
+    if (this->next_waypoint >= this->mission.waypoint_count)
+    {
+        if (page_done)
+        {
+            this->finished = true;
+            ROS_INFO("Mission player: mission finished, %lu waypoints", (unsigned long) this->mission.waypoint_count);
+        }
+        return false;
+    }
+
+    bool same_law = (this->mission.waypoints[this->next_waypoint].guidance_law == this->waypoints.guidance_law);
+    bool last_segment = (this->guidance_status.waypoint_list_sequence == this->sequence &&
+                         this->guidance_status.current_waypoint + 2 >= (int32_t) this->waypoints.waypoint_list_length);
+
+    if ((same_law && (last_segment || page_done)) || (!same_law && page_done))
+    {
+        this->BuildPage();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,171 @@
+/** ----------------------------------------------------------------------------
+ * @file: path_planner.cpp
+ * 
+ * @brief: Path planner class. Keeps a voxel grid of the obstacle world and
+ *         plans from the current position to the requested goal, replanning
+ *         when the goal or the world change. The result is given as guidance
+ *         waypoints and as a path for RViz. Paths longer than a waypoint list
+ *         are streamed in chunks, like the coverage planner does: the next one
+ *         is sent once the vehicle is on the last segment of the current one.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "path_planner.hpp"
+
+#include <algorithm>
+#include <limits>
+
+PathPlanner::PathPlanner(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _size_m, float _resolution_m,
+                         float _inflation_m, uint32_t _max_nodes)
+    : grid(_origin, _size_m, _resolution_m), planner(_max_nodes)
+{
+    this->inflation_m       = _inflation_m;
+    this->chunk_size        = std::numeric_limits<uint8_t>::max();
+    this->state_received    = false;
+    this->goal_received     = false;
+    this->replan_requested  = false;
+    this->status_received   = false;
+    this->next_point        = 0;
+    this->current_position.setZero();
+    this->goal.setZero();
+
+    /* Chosen so it does not collide with the sequence of other waypoint sources */
+    this->sequence          = 0x60000;
+
+    /* Planned paths climb and dive between voxels, follow them with the 3D LOS */
+    this->waypoints.guidance_law = 3;
+}
+
+PathPlanner::~PathPlanner(){}
+
+void PathPlanner::OnWorldReception(const vanttec_uuv::ObstacleList& _obstacles)
+{
+    this->grid.Build(_obstacles, this->inflation_m);
+    this->replan_requested = this->goal_received;
+}
+
+void PathPlanner::OnStateReception(const vanttec_uuv::VehicleState& _state)
+{
+    this->current_position << _state.x, _state.y, _state.z;
+    this->state_received = true;
+}
+
+void PathPlanner::OnGoalReception(const geometry_msgs::Pose& _goal)
+{
+    this->goal << _goal.position.x, _goal.position.y, _goal.position.z;
+    this->goal_received     = true;
+    this->replan_requested  = true;
+}
+
+void PathPlanner::OnGuidanceStatus(const vanttec_uuv::GuidanceStatus& _status)
+{
+    this->guidance_status = _status;
+    this->status_received = true;
+}
+
+bool PathPlanner::Iteration()
+{
+    if (this->replan_requested && this->state_received)
+    {
+        this->replan_requested = false;
+
+        /* Whatever is left of the previous plan is not sent anymore */
+        this->points.clear();
+        this->next_point = 0;
+
+        Eigen::Vector3i start, goal;
+
+        if (!this->grid.ToVoxel(this->current_position, start) || !this->grid.ToVoxel(this->goal, goal))
+        {
+            ROS_WARN("Path planner: start or goal outside of the planning volume");
+            return false;
+        }
+
+        ros::WallTime begin = ros::WallTime::now();
+
+        if (!this->planner.Plan(this->grid, start, goal, this->voxel_path))
+        {
+            ROS_WARN("Path planner: no path found after %u expansions", this->planner.expanded_count);
+            return false;
+        }
+
+        ThetaStarPlanner::PrunePath(this->grid, this->voxel_path);
+
+        ROS_INFO("Path planner: %lu waypoints, %u expansions, %.1f ms",
+                 (unsigned long) this->voxel_path.size(), this->planner.expanded_count,
+                 (ros::WallTime::now() - begin).toSec() * 1000);
+
+        this->FillPath();
+        this->BuildChunk();
+
+        return true;
+    }
+
+    /* Wait until the guidance is on the last segment of our latest chunk */
+    if (this->next_point >= this->points.size() || !this->status_received ||
+        this->guidance_status.waypoint_list_sequence != this->sequence ||
+        this->guidance_status.current_waypoint + 2 < (int32_t) this->waypoints.waypoint_list_length)
+    {
+        return false;
+    }
+
+    this->BuildChunk();
+
+    return true;
+}
+
+void PathPlanner::FillPath()
+{
+    /* Exact positions at the ends, voxel centers in between. A goal in the
+       voxel of the vehicle still gives a segment to follow */
+    this->points.clear();
+    this->points.push_back(this->current_position);
+
+    for (size_t i = 1; i + 1 < this->voxel_path.size(); i++)
+    {
+        this->points.push_back(this->grid.ToPoint(this->voxel_path[i]));
+    }
+
+    this->points.push_back(this->goal);
+    this->next_point = 0;
+
+    this->path.header.stamp     = ros::Time::now();
+    this->path.header.frame_id  = "world";
+    this->path.poses.resize(this->points.size());
+
+    for (size_t i = 0; i < this->points.size(); i++)
+    {
+        geometry_msgs::PoseStamped& pose = this->path.poses[i];
+
+        pose.header                 = this->path.header;
+        pose.pose.position.x        = this->points[i](0);
+        pose.pose.position.y        = -this->points[i](1);
+        pose.pose.position.z        = -this->points[i](2);
+        pose.pose.orientation.w     = 1;
+    }
+}
+
+void PathPlanner::BuildChunk()
+{
+    /* Keep the last segment of the previous chunk as the first of this one */
+    size_t first = (this->next_point == 0) ? 0 : this->next_point - 2;
+    size_t last = std::min(first + this->chunk_size, this->points.size());
+    size_t count = last - first;
+
+    this->waypoints.waypoint_list_length    = count;
+    this->waypoints.waypoint_list_x.resize(count);
+    this->waypoints.waypoint_list_y.resize(count);
+    this->waypoints.waypoint_list_z.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        this->waypoints.waypoint_list_x[i] = this->points[first + i](0);
+        this->waypoints.waypoint_list_y[i] = this->points[first + i](1);
+        this->waypoints.waypoint_list_z[i] = this->points[first + i](2);
+    }
+
+    this->waypoints.header.stamp    = ros::Time::now();
+    this->waypoints.header.frame_id = "world";
+    this->waypoints.sequence        = ++this->sequence;
+    this->next_point                = last;
+}
@@ -0,0 +1,413 @@
+/** ----------------------------------------------------------------------------
+ * @file: theta_star_planner.cpp
+ * 
+ * @brief: Path planner over a voxel grid, 26-connected. Runs A* with the exact
+ *         26-connected distance as heuristic, or Lazy Theta* (any-angle, with
+ *         the euclidean distance) when any_angle is set.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "theta_star_planner.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const uint32_t EMPTY_KEY = 0xFFFFFFFF;
+
+static float Distance(const VoxelGrid& _grid, uint32_t _a, uint32_t _b)
+{
+    int ax = _a % _grid.size_x;
+    int ay = (_a / _grid.size_x) % _grid.size_y;
+    int az = _a / (_grid.size_x * _grid.size_y);
+    int bx = _b % _grid.size_x;
+    int by = (_b / _grid.size_x) % _grid.size_y;
+    int bz = _b / (_grid.size_x * _grid.size_y);
+
+    float dx = ax - bx;
+    float dy = ay - by;
+    float dz = az - bz;
+
+    return _grid.resolution_m * std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/* A* works in thousandths of a voxel with the step lengths rounded, so
+   costs are integers (exact in a float) and ties on f are real ties */
+static const float STEP_COSTS[4] = {0, 1000, 1414, 1732};
+
+/* Shortest 26-connected path length without obstacles, in the same units */
+static float GridDistance(const VoxelGrid& _grid, uint32_t _a, uint32_t _b)
+{
+    Eigen::Vector3i a(_a % _grid.size_x, (_a / _grid.size_x) % _grid.size_y, _a / (_grid.size_x * _grid.size_y));
+    Eigen::Vector3i b(_b % _grid.size_x, (_b / _grid.size_x) % _grid.size_y, _b / (_grid.size_x * _grid.size_y));
+    Eigen::Vector3i d = (a - b).cwiseAbs();
+
+    std::sort(d.data(), d.data() + 3);
+
+    return STEP_COSTS[3] * d(0) + STEP_COSTS[2] * (d(1) - d(0)) + STEP_COSTS[1] * (d(2) - d(1));
+}
+
+/* Diagonal moves may not cut through the corner of an occupied voxel */
+static bool CutsCorner(const VoxelGrid& _grid, const Eigen::Vector3i& _voxel, int _dx, int _dy, int _dz)
+{
+    for (int mask = 1; mask < 7; mask++)
+    {
+        int x = (mask & 1) ? _dx : 0;
+        int y = (mask & 2) ? _dy : 0;
+        int z = (mask & 4) ? _dz : 0;
+
+        if ((x == _dx && y == _dy && z == _dz) || (x == 0 && y == 0 && z == 0))
+        {
+            continue;
+        }
+
+        if (_grid.occupied[_grid.Index(_voxel(0) + x, _voxel(1) + y, _voxel(2) + z)])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static Eigen::Vector3i ToCoordinates(const VoxelGrid& _grid, uint32_t _voxel)
+{
+    return Eigen::Vector3i(_voxel % _grid.size_x,
+                           (_voxel / _grid.size_x) % _grid.size_y,
+                           _voxel / (_grid.size_x * _grid.size_y));
+}
+
+ThetaStarPlanner::ThetaStarPlanner(uint32_t _max_nodes)
+{
+    this->max_nodes             = _max_nodes;
+    this->any_angle             = false;
+    this->expanded_count        = 0;
+    this->line_of_sight_checks  = 0;
+    this->pool_size             = 0;
+
+    /* Table at most half full */
+    this->table_bits = 1;
+
+    while ((1u << this->table_bits) < 2 * _max_nodes)
+    {
+        this->table_bits++;
+    }
+
+    this->pool.resize(_max_nodes);
+    this->heap.reserve(_max_nodes);
+    this->table_keys.assign(1u << this->table_bits, EMPTY_KEY);
+    this->table_nodes.resize(1u << this->table_bits);
+}
+
+ThetaStarPlanner::~ThetaStarPlanner(){}
+
+int32_t ThetaStarPlanner::FindNode(uint32_t _voxel) const
+{
+    uint32_t mask = (1u << this->table_bits) - 1;
+    uint32_t slot = (_voxel * 2654435761u) >> (32 - this->table_bits);
+
+    while (this->table_keys[slot] != EMPTY_KEY)
+    {
+        if (this->table_keys[slot] == _voxel)
+        {
+            return this->table_nodes[slot];
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return -1;
+}
+
+int32_t ThetaStarPlanner::CreateNode(uint32_t _voxel)
+{
+    if (this->pool_size == this->max_nodes)
+    {
+        return -1;
+    }
+
+    uint32_t mask = (1u << this->table_bits) - 1;
+    uint32_t slot = (_voxel * 2654435761u) >> (32 - this->table_bits);
+
+    while (this->table_keys[slot] != EMPTY_KEY)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    int32_t node = this->pool_size++;
+
+    this->table_keys[slot]  = _voxel;
+    this->table_nodes[slot] = node;
+
+    PlannerNode_S& created  = this->pool[node];
+    created.voxel           = _voxel;
+    created.parent          = -1;
+    created.g               = INFINITY;
+    created.f               = INFINITY;
+    created.heap_position   = NODE_UNVISITED;
+
+    return node;
+}
+
+bool ThetaStarPlanner::Before(int32_t _a, int32_t _b) const
+{
+    /* Ties go to the deeper node, which is closer to the goal */
+    const PlannerNode_S& a = this->pool[_a];
+    const PlannerNode_S& b = this->pool[_b];
+
+    return a.f < b.f || (a.f == b.f && a.g > b.g);
+}
+
+void ThetaStarPlanner::SiftUp(int32_t _position)
+{
+    int32_t node = this->heap[_position];
+
+    while (_position > 0)
+    {
+        int32_t parent = (_position - 1) / 2;
+
+        if (!this->Before(node, this->heap[parent]))
+        {
+            break;
+        }
+
+        this->heap[_position] = this->heap[parent];
+        this->pool[this->heap[_position]].heap_position = _position;
+        _position = parent;
+    }
+
+    this->heap[_position] = node;
+    this->pool[node].heap_position = _position;
+}
+
+void ThetaStarPlanner::SiftDown(int32_t _position)
+{
+    int32_t node = this->heap[_position];
+    int32_t size = this->heap.size();
+
+    while (true)
+    {
+        int32_t child = 2 * _position + 1;
+
+        if (child >= size)
+        {
+            break;
+        }
+
+        if (child + 1 < size && this->Before(this->heap[child + 1], this->heap[child]))
+        {
+            child++;
+        }
+
+        if (!this->Before(this->heap[child], node))
+        {
+            break;
+        }
+
+        this->heap[_position] = this->heap[child];
+        this->pool[this->heap[_position]].heap_position = _position;
+        _position = child;
+    }
+
+    this->heap[_position] = node;
+    this->pool[node].heap_position = _position;
+}
+
+void ThetaStarPlanner::HeapPush(int32_t _node)
+{
+    this->heap.push_back(_node);
+    this->SiftUp(this->heap.size() - 1);
+}
+
+int32_t ThetaStarPlanner::HeapPop()
+{
+    int32_t top = this->heap[0];
+    int32_t last = this->heap.back();
+    this->heap.pop_back();
+
+    if (!this->heap.empty())
+    {
+        this->heap[0] = last;
+        this->SiftDown(0);
+    }
+
+    this->pool[top].heap_position = NODE_CLOSED;
+
+    return top;
+}
+
+bool ThetaStarPlanner::Plan(const VoxelGrid& _grid, const Eigen::Vector3i& _start, const Eigen::Vector3i& _goal,
+                            std::vector<Eigen::Vector3i>& _path)
+{
+    _path.clear();
+    this->expanded_count        = 0;
+    this->line_of_sight_checks  = 0;
+
+    if (!_grid.Inside(_start(0), _start(1), _start(2)) || !_grid.Inside(_goal(0), _goal(1), _goal(2)) ||
+        _grid.occupied[_grid.Index(_goal(0), _goal(1), _goal(2))])
+    {
+        return false;
+    }
+
+    /* Reset the search state; the pool itself is reused as is */
+    std::fill(this->table_keys.begin(), this->table_keys.end(), EMPTY_KEY);
+    this->heap.clear();
+    this->pool_size = 0;
+
+    uint32_t start_voxel    = _grid.Index(_start(0), _start(1), _start(2));
+    uint32_t goal_voxel     = _grid.Index(_goal(0), _goal(1), _goal(2));
+
+    int32_t start = this->CreateNode(start_voxel);
+    this->pool[start].parent    = start;
+    this->pool[start].g         = 0;
+    this->pool[start].f         = this->any_angle ? Distance(_grid, start_voxel, goal_voxel)
+                                                  : GridDistance(_grid, start_voxel, goal_voxel);
+    this->HeapPush(start);
+
+    while (!this->heap.empty())
+    {
+        int32_t current = this->HeapPop();
+        this->expanded_count++;
+
+        Eigen::Vector3i voxel = ToCoordinates(_grid, this->pool[current].voxel);
+
+        /* Lazy Theta*: the parent was assumed visible when the node was
+           opened, check it now and fall back to the best closed neighbor */
+        int32_t parent = this->pool[current].parent;
+
+        if (this->any_angle && parent != current)
+        {
+            this->line_of_sight_checks++;
+
+            if (!_grid.LineOfSight(ToCoordinates(_grid, this->pool[parent].voxel), voxel))
+            {
+                this->pool[current].g = INFINITY;
+
+                for (int dz = -1; dz <= 1; dz++)
+                for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    if (!_grid.Inside(voxel(0) + dx, voxel(1) + dy, voxel(2) + dz))
+                    {
+                        continue;
+                    }
+
+                    int32_t neighbor = this->FindNode(_grid.Index(voxel(0) + dx, voxel(1) + dy, voxel(2) + dz));
+
+                    if (neighbor < 0 || neighbor == current || this->pool[neighbor].heap_position != NODE_CLOSED)
+                    {
+                        continue;
+                    }
+
+                    float g = this->pool[neighbor].g + _grid.resolution_m * std::sqrt(float(dx * dx + dy * dy + dz * dz));
+
+                    if (g < this->pool[current].g)
+                    {
+                        this->pool[current].g       = g;
+                        this->pool[current].parent  = neighbor;
+                    }
+                }
+            }
+        }
+
+        if (this->pool[current].voxel == goal_voxel)
+        {
+            for (int32_t node = current; ; node = this->pool[node].parent)
+            {
+                _path.push_back(ToCoordinates(_grid, this->pool[node].voxel));
+
+                if (this->pool[node].parent == node)
+                {
+                    break;
+                }
+            }
+
+            std::reverse(_path.begin(), _path.end());
+            return true;
+        }
+
+        /* A* relaxes through the expanded node, Theta* through its parent */
+        int32_t anchor = this->any_angle ? this->pool[current].parent : current;
+
+        for (int dz = -1; dz <= 1; dz++)
+        for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int x = voxel(0) + dx;
+            int y = voxel(1) + dy;
+            int z = voxel(2) + dz;
+
+            if ((dx == 0 && dy == 0 && dz == 0) || !_grid.Inside(x, y, z))
+            {
+                continue;
+            }
+
+            uint32_t neighbor_voxel = _grid.Index(x, y, z);
+
+            if (_grid.occupied[neighbor_voxel] || CutsCorner(_grid, voxel, dx, dy, dz))
+            {
+                continue;
+            }
+
+            int32_t neighbor = this->FindNode(neighbor_voxel);
+
+            if (neighbor < 0)
+            {
+                neighbor = this->CreateNode(neighbor_voxel);
+
+                if (neighbor < 0)
+                {
+                    return false;
+                }
+            }
+            else if (this->pool[neighbor].heap_position == NODE_CLOSED)
+            {
+                continue;
+            }
+
+            /* Path 2 of Theta*, through the parent of the expanded node */
+            float g = this->pool[anchor].g + (this->any_angle ? Distance(_grid, this->pool[anchor].voxel, neighbor_voxel)
+                                                              : STEP_COSTS[std::abs(dx) + std::abs(dy) + std::abs(dz)]);
+
+            if (g < this->pool[neighbor].g)
+            {
+                this->pool[neighbor].g      = g;
+                this->pool[neighbor].f      = g + (this->any_angle ? Distance(_grid, neighbor_voxel, goal_voxel)
+                                                                   : GridDistance(_grid, neighbor_voxel, goal_voxel));
+                this->pool[neighbor].parent = anchor;
+
+                if (this->pool[neighbor].heap_position >= 0)
+                {
+                    this->SiftUp(this->pool[neighbor].heap_position);
+                }
+                else
+                {
+                    this->HeapPush(neighbor);
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void ThetaStarPlanner::PrunePath(const VoxelGrid& _grid, std::vector<Eigen::Vector3i>& _path)
+{
+    if (_path.size() < 3)
+    {
+        return;
+    }
+
+    std::vector<Eigen::Vector3i> pruned;
+    pruned.push_back(_path.front());
+
+    for (size_t i = 2; i < _path.size(); i++)
+    {
+        if (!_grid.LineOfSight(pruned.back(), _path[i]))
+        {
+            pruned.push_back(_path[i - 1]);
+        }
+    }
+
+    pruned.push_back(_path.back());
+    _path.swap(pruned);
+}
@@ -0,0 +1,160 @@
+/** ----------------------------------------------------------------------------
+ * @file: voxel_grid.cpp
+ * 
+ * @brief: 3D occupancy voxel grid in NED, built from the obstacle world with
+ *         the obstacles inflated by the vehicle radius.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "voxel_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+VoxelGrid::VoxelGrid(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _size_m, float _resolution_m)
+{
+    this->origin        = _origin;
+    this->resolution_m  = _resolution_m;
+    this->size_x        = std::max(1, int(std::ceil(_size_m(0) / _resolution_m)));
+    this->size_y        = std::max(1, int(std::ceil(_size_m(1) / _resolution_m)));
+    this->size_z        = std::max(1, int(std::ceil(_size_m(2) / _resolution_m)));
+
+    this->occupied.assign((size_t) this->size_x * this->size_y * this->size_z, 0);
+}
+
+VoxelGrid::~VoxelGrid(){}
+
+bool VoxelGrid::ToVoxel(const Eigen::Vector3f& _point, Eigen::Vector3i& _voxel) const
+{
+    Eigen::Vector3f scaled = (_point - this->origin) / this->resolution_m;
+
+    _voxel << int(std::floor(scaled(0))), int(std::floor(scaled(1))), int(std::floor(scaled(2)));
+
+    return this->Inside(_voxel(0), _voxel(1), _voxel(2));
+}
+
+Eigen::Vector3f VoxelGrid::ToPoint(const Eigen::Vector3i& _voxel) const
+{
+    return this->origin + (_voxel.cast<float>() + Eigen::Vector3f::Constant(0.5)) * this->resolution_m;
+}
+
+void VoxelGrid::Build(const vanttec_uuv::ObstacleList& _obstacles, float _inflation_m)
+{
+    std::fill(this->occupied.begin(), this->occupied.end(), 0);
+
+    for (size_t i = 0; i < _obstacles.obstacles.size(); i++)
+    {
+        const vanttec_uuv::Obstacle& obstacle = _obstacles.obstacles[i];
+
+        bool    is_wall         = (obstacle.obstacle_class == "wall");
+        float   yaw             = 2 * std::atan2(obstacle.pose.orientation.z, obstacle.pose.orientation.w);
+        float   c               = std::cos(yaw);
+        float   s               = std::sin(yaw);
+        float   half_length     = obstacle.length / 2 + _inflation_m;
+        float   half_width      = obstacle.radio + _inflation_m;
+        float   half_height     = obstacle.height / 2 + _inflation_m;
+        float   horizontal      = is_wall ? std::sqrt(half_length * half_length + half_width * half_width) : half_width;
+
+        Eigen::Vector3f center(obstacle.pose.position.x, obstacle.pose.position.y, obstacle.pose.position.z);
+        Eigen::Vector3f extent(horizontal, horizontal, half_height);
+
+        /* Bounding box in voxels, clamped to the grid */
+        Eigen::Vector3f low     = ((center - extent - this->origin) / this->resolution_m);
+        Eigen::Vector3f high    = ((center + extent - this->origin) / this->resolution_m);
+
+        int x0 = std::max(0, int(std::floor(low(0))));
+        int y0 = std::max(0, int(std::floor(low(1))));
+        int z0 = std::max(0, int(std::floor(low(2))));
+        int x1 = std::min(this->size_x - 1, int(std::floor(high(0))));
+        int y1 = std::min(this->size_y - 1, int(std::floor(high(1))));
+        int z1 = std::min(this->size_z - 1, int(std::floor(high(2))));
+
+        for (int z = z0; z <= z1; z++)
+        {
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    Eigen::Vector3f offset = this->ToPoint(Eigen::Vector3i(x, y, z)) - center;
+                    bool inside;
+
+                    if (is_wall)
+                    {
+                        float along     = c * offset(0) + s * offset(1);
+                        float across    = -s * offset(0) + c * offset(1);
+                        inside          = std::fabs(along) <= half_length && std::fabs(across) <= half_width;
+                    }
+                    else
+                    {
+                        inside          = offset(0) * offset(0) + offset(1) * offset(1) <= half_width * half_width;
+                    }
+
+                    if (inside)
+                    {
+                        this->occupied[this->Index(x, y, z)] = 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool VoxelGrid::LineOfSight(const Eigen::Vector3i& _from, const Eigen::Vector3i& _to) const
+{
+    /* Amanatides-Woo traversal between the two voxel centers */
+    Eigen::Vector3i voxel   = _from;
+    Eigen::Vector3i delta   = _to - _from;
+    Eigen::Vector3i step;
+    Eigen::Vector3f t_max;
+    Eigen::Vector3f t_delta;
+
+    for (int i = 0; i < 3; i++)
+    {
+        step(i) = (delta(i) > 0) - (delta(i) < 0);
+
+        if (delta(i) == 0)
+        {
+            t_max(i)    = std::numeric_limits<float>::infinity();
+            t_delta(i)  = std::numeric_limits<float>::infinity();
+        }
+        else
+        {
+            t_delta(i)  = 1.0f / std::abs(delta(i));
+            t_max(i)    = 0.5f * t_delta(i);
+        }
+    }
+
+    /* Each axis is stepped exactly |delta| times */
+    int steps = std::abs(delta(0)) + std::abs(delta(1)) + std::abs(delta(2));
+
+    for (int n = 0; n <= steps; n++)
+    {
+        if (this->occupied[this->Index(voxel(0), voxel(1), voxel(2))])
+        {
+            return false;
+        }
+
+        if (voxel == _to)
+        {
+            return true;
+        }
+
+        int axis = 0;
+
+        if (t_max(1) < t_max(axis))
+        {
+            axis = 1;
+        }
+
+        if (t_max(2) < t_max(axis))
+        {
+            axis = 2;
+        }
+
+        voxel(axis) += step(axis);
+        t_max(axis) += t_delta(axis);
+    }
+
+    return true;
+}
@@ -0,0 +1,41 @@
+/** ----------------------------------------------------------------------------
+ * @file: imu_preintegrator.hpp
+ *
+ * @brief: IMU preintegrator. Accumulates the delta-angle, delta-velocity and
+ *         delta-position of a batch of raw IMU samples, expressed in the body
+ *         frame at the start of the batch, together with their covariance.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __IMU_PREINTEGRATOR_H__
+#define __IMU_PREINTEGRATOR_H__
+
+#include <eigen3/Eigen/Dense>
+
+/* Order of the preintegrated error state: [delta angle, delta velocity, delta position] */
+typedef Eigen::Matrix<double, 9, 9> PreintegrationCovariance;
+
+class ImuPreintegrator
+{
+    public:
+
+        Eigen::Matrix3d             delta_rotation;
+        Eigen::Vector3d             delta_angle;
+        Eigen::Vector3d             delta_velocity;
+        Eigen::Vector3d             delta_position;
+        double                      delta_time_s;
+        PreintegrationCovariance    covariance;
+        uint32_t                    sample_count;
+
+        /* Continuous-time white noise densities, in rad/s/sqrt(Hz) and m/s^2/sqrt(Hz) */
+        float gyro_noise_density;
+        float accel_noise_density;
+
+        ImuPreintegrator(float _gyro_noise_density, float _accel_noise_density);
+        ~ImuPreintegrator();
+
+        void Reset();
+        void IntegrateSample(const Eigen::Vector3d& _accel, const Eigen::Vector3d& _rate, double _dt);
+};
+
+#endif
@@ -3,8 +3,8 @@
  * @date: July 30, 2020
  * @author: Pedro Sanchez
  * @email: pedro.sc.97@gmail.com
- * 
- * @brief: Odometry calculator class. Used to get velocities and positions 
+ *
+ * @brief: Odometry calculator class. Used to get velocities and positions
  *         from the IMU.
  * -----------------------------------------------------------------------------
  * */
@@ -12,16 +12,36 @@
 #ifndef __ODOMETRY_CALCULATOR_H__
 #define __ODOMETRY_CALCULATOR_H__
 
+#include "ring_buffer.hpp"
+#include "imu_preintegrator.hpp"
+#include "compensated_sum.hpp"
+#include "vanttec_uuv/VehicleState.h"
+
+#include <ros/ros.h>
 #include <geometry_msgs/Vector3.h>
 #include <geometry_msgs/Pose.h>
 #include <geometry_msgs/Twist.h>
 #include <geometry_msgs/Accel.h>
+#include <eigen3/Eigen/Dense>
+
+/* Order of the odometry error state: [attitude, NED velocity, NED position] */
+typedef Eigen::Matrix<double, 9, 9> OdometryCovariance;
+
+/* Timestamped IMU sample, as stored in the sample buffers */
+
+typedef struct TimedVector3_S
+{
+    double  stamp_s;
+    double  x;
+    double  y;
+    double  z;
+} TimedVector3_S;
 
 class OdometryCalculator
 {
     public:
-        
-        /* Inputs from IMU */
+
+        /* Inputs from IMU, interpolated to the last update time */
         geometry_msgs::Vector3  linear_acceleration;
         geometry_msgs::Vector3  angular_rate;
         geometry_msgs::Vector3  angular_position;
@@ -30,27 +50,70 @@ class OdometryCalculator
         geometry_msgs::Vector3  prev_linear_velocity;
         geometry_msgs::Vector3  prev_angular_rate;
 
-        /* Outputs to System */
+        /* Outputs to System. Position is NED, velocities are body-fixed. */
         geometry_msgs::Pose     pose;
         geometry_msgs::Twist    twist;
         geometry_msgs::Accel    accel;
+        OdometryCovariance      state_covariance;
+        vanttec_uuv::VehicleState   state;
+
+        ImuPreintegrator        preintegrator;
 
         /* Configuration */
         float sample_time_s;
+        float max_sample_gap_s;
+
+        /* Uncertainty of the attitude the IMU reports, in rad; replaces the
+           integrated one whenever the attitude is taken from the IMU */
+        float tilt_noise_rad;
+        float heading_noise_rad;
 
-        OdometryCalculator(float _sample_time);
+        /* Diagnostics */
+        uint32_t dropped_samples;
+        uint32_t late_samples;
+        uint32_t overflowed_samples;
+
+        OdometryCalculator(float _sample_time, size_t _buffer_capacity, float _gyro_noise_density, float _accel_noise_density,
+                           float _tilt_noise_rad, float _heading_noise_rad);
         ~OdometryCalculator();
-        
-        void AccelPubCallback(const geometry_msgs::Vector3& _accel);
-        void AngularRateCallback(const geometry_msgs::Vector3& _a_rate);
-        void AngularPositionCallback(const geometry_msgs::Vector3& _a_pos);
 
-        void UpdateParameters();
+        void AccelPubCallback(const ros::MessageEvent<geometry_msgs::Vector3 const>& _event);
+        void AngularRateCallback(const ros::MessageEvent<geometry_msgs::Vector3 const>& _event);
+        void AngularPositionCallback(const ros::MessageEvent<geometry_msgs::Vector3 const>& _event);
+
+        void AddAccelSample(const geometry_msgs::Vector3& _accel, double _stamp_s);
+        void AddAngularRateSample(const geometry_msgs::Vector3& _a_rate, double _stamp_s);
+        void AddAngularPositionSample(const geometry_msgs::Vector3& _a_pos, double _stamp_s);
+
+        void UpdateParameters(double _publish_time_s);
 
     private:
 
-        double Integral(double x1, double x2, double c, float timestep);
-        double Derivative(double x1, double x2, float timestep);
+        RingBuffer<TimedVector3_S>  accel_samples;
+        RingBuffer<TimedVector3_S>  rate_samples;
+        RingBuffer<TimedVector3_S>  ypr_samples;
+
+        /* State integrated up to the newest consumed acceleration sample */
+        CompensatedSum<Eigen::Vector3d> ned_velocity;
+        CompensatedSum<Eigen::Vector3d> ned_position;
+        Eigen::Matrix3d             integrated_attitude;
+
+        /* Time up to which the accelerations have been integrated */
+        double  integrated_time_s;
+        double  prev_rate_time_s;
+        bool    integration_started;
+
+        void InsertSample(RingBuffer<TimedVector3_S>& _buffer, const geometry_msgs::Vector3& _sample, double _stamp_s);
+        void PreintegrateSamples(double _until_s);
+        void ApplyPreintegration();
+        void PruneSamples(RingBuffer<TimedVector3_S>& _buffer, double _time_s);
+        TimedVector3_S InterpolateSample(const RingBuffer<TimedVector3_S>& _buffer, double _time_s, bool _wrap_angles) const;
+        bool AttitudeAt(double _time_s, Eigen::Matrix3d& _attitude) const;
+        void ResetAttitudeCovariance();
+        void UpdateVehicleState(double _publish_time_s, const Eigen::Matrix3d& _attitude);
+
+        double Integral(double x1, double x2, double c, double timestep);
+        double Derivative(double x1, double x2, double timestep);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+/** ----------------------------------------------------------------------------
+ * @file: imu_preintegrator.cpp
+ *
+ * @brief: IMU preintegrator. Accumulates the delta-angle, delta-velocity and
+ *         delta-position of a batch of raw IMU samples, expressed in the body
+ *         frame at the start of the batch, together with their covariance.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "imu_preintegrator.hpp"
+
+static Eigen::Matrix3d SkewMatrix(const Eigen::Vector3d& _v)
+{
+    Eigen::Matrix3d skew;
+
+    skew << 0, -_v(2), _v(1),
+            _v(2), 0, -_v(0),
+            -_v(1), _v(0), 0;
+
+    return skew;
+}
+
+ImuPreintegrator::ImuPreintegrator(float _gyro_noise_density, float _accel_noise_density)
+{
+    this->gyro_noise_density    = _gyro_noise_density;
+    this->accel_noise_density   = _accel_noise_density;
+
+    this->Reset();
+}
+
+ImuPreintegrator::~ImuPreintegrator(){}
+
+void ImuPreintegrator::Reset()
+{
+    this->delta_rotation.setIdentity();
+    this->delta_angle.setZero();
+    this->delta_velocity.setZero();
+    this->delta_position.setZero();
+    this->covariance.setZero();
+    this->delta_time_s  = 0;
+    this->sample_count  = 0;
+}
+
+void ImuPreintegrator::IntegrateSample(const Eigen::Vector3d& _accel, const Eigen::Vector3d& _rate, double _dt)
+{
+    if (_dt <= 0)
+    {
+        return;
+    }
+
+    Eigen::Vector3d rotated_accel   = this->delta_rotation * _accel;
+    Eigen::Vector3d angle_increment = _rate * _dt;
+    Eigen::Matrix3d rotation_increment;
+
+    if (angle_increment.norm() > 1e-12)
+    {
+        rotation_increment = Eigen::AngleAxisd(angle_increment.norm(), angle_increment.normalized()).toRotationMatrix();
+    }
+    else
+    {
+        rotation_increment.setIdentity();
+    }
+
+    /* Covariance propagation, first order in dt */
+
+    Eigen::Matrix3d accel_skew = this->delta_rotation * SkewMatrix(_accel);
+
+    PreintegrationCovariance A = PreintegrationCovariance::Identity();
+    A.block<3, 3>(0, 0) = rotation_increment.transpose();
+    A.block<3, 3>(3, 0) = -accel_skew * _dt;
+    A.block<3, 3>(6, 0) = -0.5 * accel_skew * _dt * _dt;
+    A.block<3, 3>(6, 3) = Eigen::Matrix3d::Identity() * _dt;
+
+    Eigen::Matrix<double, 9, 6> B = Eigen::Matrix<double, 9, 6>::Zero();
+    B.block<3, 3>(0, 0) = Eigen::Matrix3d::Identity() * _dt;
+    B.block<3, 3>(3, 3) = this->delta_rotation * _dt;
+    B.block<3, 3>(6, 3) = 0.5 * this->delta_rotation * _dt * _dt;
+
+    /* Discrete noise variance is the continuous density squared over dt */
+    Eigen::Matrix<double, 6, 1> noise_variance;
+    double gyro_variance    = this->gyro_noise_density * this->gyro_noise_density / _dt;
+    double accel_variance   = this->accel_noise_density * this->accel_noise_density / _dt;
+    noise_variance << gyro_variance, gyro_variance, gyro_variance,
+                      accel_variance, accel_variance, accel_variance;
+
+    this->covariance = A * this->covariance * A.transpose()
+                       + B * noise_variance.asDiagonal() * B.transpose();
+
+    /* Deltas, position first as it depends on the previous velocity */
+
+    this->delta_position    += this->delta_velocity * _dt + 0.5 * rotated_accel * _dt * _dt;
+    this->delta_velocity    += rotated_accel * _dt;
+    this->delta_rotation    = this->delta_rotation * rotation_increment;
+    this->delta_angle       += angle_increment;
+    this->delta_time_s      += _dt;
+    this->sample_count++;
+}
@@ -3,17 +3,37 @@
  * @date: July 30, 2020
  * @author: Pedro Sanchez
  * @email: pedro.sc.97@gmail.com
- * 
- * @brief: Odometry calculator class. Used to get velocities and positions 
+ *
+ * @brief: Odometry calculator class. Used to get velocities and positions
  *         from the IMU.
  * -----------------------------------------------------------------------------
  * */
 
 #include "odometry_calculator.hpp"
 
-OdometryCalculator::OdometryCalculator(float _sample_time)
+#include <cmath>
+
+OdometryCalculator::OdometryCalculator(float _sample_time, size_t _buffer_capacity, float _gyro_noise_density, float _accel_noise_density,
+                                       float _tilt_noise_rad, float _heading_noise_rad)
+                                      : preintegrator(_gyro_noise_density, _accel_noise_density)
+                                      , accel_samples(_buffer_capacity)
+                                      , rate_samples(_buffer_capacity)
+                                      , ypr_samples(_buffer_capacity)
+                                      , ned_velocity(Eigen::Vector3d::Zero())
+                                      , ned_position(Eigen::Vector3d::Zero())
 {
     this->sample_time_s = _sample_time;
+    this->max_sample_gap_s = 10 * _sample_time;
+    this->tilt_noise_rad = _tilt_noise_rad;
+    this->heading_noise_rad = _heading_noise_rad;
+
+    this->dropped_samples = 0;
+    this->late_samples = 0;
+    this->overflowed_samples = 0;
+
+    this->integrated_time_s = 0;
+    this->prev_rate_time_s = 0;
+    this->integration_started = false;
 
     this->linear_acceleration.x = 0;
     this->linear_acceleration.y = 0;
@@ -42,13 +62,13 @@ OdometryCalculator::OdometryCalculator(float _sample_time)
     this->accel.linear.y = 0;
     this->accel.linear.z = 0;
     this->accel.angular.x = 0;
-    this->accel.angular.x = 0;
-    this->accel.angular.x = 0;
+    this->accel.angular.y = 0;
+    this->accel.angular.z = 0;
 
     /* Velocities */
-    this->prev_linear_velocity.x = 0;;
-    this->prev_linear_velocity.y = 0;;
-    this->prev_linear_velocity.z = 0;;
+    this->prev_linear_velocity.x = 0;
+    this->prev_linear_velocity.y = 0;
+    this->prev_linear_velocity.z = 0;
 
     this->twist.linear.x = 0;
     this->twist.linear.y = 0;
@@ -58,6 +78,10 @@ OdometryCalculator::OdometryCalculator(float _sample_time)
     this->twist.angular.z = 0;
 
     /* Pose */
+    this->integrated_attitude.setIdentity();
+    this->state_covariance.setZero();
+    this->state.sequence = 0;
+
     this->pose.position.x = 0;
     this->pose.position.y = 0;
     this->pose.position.z = 0;
@@ -70,95 +94,423 @@ OdometryCalculator::OdometryCalculator(float _sample_time)
 
 OdometryCalculator::~OdometryCalculator(){}
 
-void OdometryCalculator::AccelPubCallback(const geometry_msgs::Vector3& _accel)
+void OdometryCalculator::AccelPubCallback(const ros::MessageEvent<geometry_msgs::Vector3 const>& _event)
 {
-    this->prev_linear_acceleration.x = this->linear_acceleration.x;
-    this->prev_linear_acceleration.y = this->linear_acceleration.y;
-    this->prev_linear_acceleration.z = this->linear_acceleration.z;
-    
-    this->linear_acceleration.x = _accel.x;
-    this->linear_acceleration.y = _accel.y;
-    this->linear_acceleration.z = _accel.z;
+    this->AddAccelSample(*_event.getConstMessage(), _event.getReceiptTime().toSec());
 }
 
-void OdometryCalculator::AngularRateCallback(const geometry_msgs::Vector3& _a_rate)
+void OdometryCalculator::AngularRateCallback(const ros::MessageEvent<geometry_msgs::Vector3 const>& _event)
 {
-    this->prev_angular_rate.x = this->angular_rate.x;
-    this->prev_angular_rate.y = this->angular_rate.y;
-    this->prev_angular_rate.z = this->angular_rate.z;
+    this->AddAngularRateSample(*_event.getConstMessage(), _event.getReceiptTime().toSec());
+}
 
-    this->angular_rate.x = _a_rate.x;
-    this->angular_rate.y = _a_rate.y;
-    this->angular_rate.z = _a_rate.z;
+void OdometryCalculator::AngularPositionCallback(const ros::MessageEvent<geometry_msgs::Vector3 const>& _event)
+{
+    this->AddAngularPositionSample(*_event.getConstMessage(), _event.getReceiptTime().toSec());
 }
 
-void OdometryCalculator::AngularPositionCallback(const geometry_msgs::Vector3& _a_pos)
+void OdometryCalculator::AddAccelSample(const geometry_msgs::Vector3& _accel, double _stamp_s)
 {
-    this->angular_position.x = _a_pos.x;
-    this->angular_position.y = _a_pos.y;
-    this->angular_position.z = _a_pos.z;
+    /* Samples older than what has already been integrated cannot be used anymore */
+    if (this->integration_started && _stamp_s <= this->integrated_time_s)
+    {
+        this->late_samples++;
+        return;
+    }
+
+    this->InsertSample(this->accel_samples, _accel, _stamp_s);
 }
 
-void OdometryCalculator::UpdateParameters()
+void OdometryCalculator::AddAngularRateSample(const geometry_msgs::Vector3& _a_rate, double _stamp_s)
 {
-    /* Accelerations */
-    this->accel.linear.x = this->linear_acceleration.x;
-    this->accel.linear.y = this->linear_acceleration.y;
-    this->accel.linear.z = this->linear_acceleration.z;
-    this->accel.angular.x = OdometryCalculator::Derivative(this->prev_angular_rate.x, this->angular_rate.x, this->sample_time_s);
-    this->accel.angular.x = OdometryCalculator::Derivative(this->prev_angular_rate.y, this->angular_rate.y, this->sample_time_s);
-    this->accel.angular.x = OdometryCalculator::Derivative(this->prev_angular_rate.z, this->angular_rate.z, this->sample_time_s);
+    this->InsertSample(this->rate_samples, _a_rate, _stamp_s);
+}
+
+void OdometryCalculator::AddAngularPositionSample(const geometry_msgs::Vector3& _a_pos, double _stamp_s)
+{
+    this->InsertSample(this->ypr_samples, _a_pos, _stamp_s);
+}
+
+void OdometryCalculator::UpdateParameters(double _publish_time_s)
+{
+    /* Accelerations: the first sample only sets the integration reference */
+    if (!this->integration_started && !this->accel_samples.Empty())
+    {
+        const TimedVector3_S& first = this->accel_samples.Front();
+
+        this->linear_acceleration.x = first.x;
+        this->linear_acceleration.y = first.y;
+        this->linear_acceleration.z = first.z;
+        this->integrated_time_s     = first.stamp_s;
+        this->integration_started   = true;
+
+        if (this->AttitudeAt(first.stamp_s, this->integrated_attitude))
+        {
+            this->ResetAttitudeCovariance();
+        }
+
+        this->accel_samples.PopFront();
+    }
+
+    /* Consume every raw sample up to the publish time as one batch */
+    this->PreintegrateSamples(_publish_time_s);
+    this->ApplyPreintegration();
+
+    /* Propagate the integrated state to the publish time without committing it. The acceleration
+       is interpolated if a newer sample is already buffered, and held otherwise. */
+    Eigen::Vector3d accel_last(this->linear_acceleration.x, this->linear_acceleration.y, this->linear_acceleration.z);
+    Eigen::Vector3d accel_at_publish = accel_last;
+
+    if (!this->accel_samples.Empty())
+    {
+        const TimedVector3_S& next = this->accel_samples.Front();
+        double span = next.stamp_s - this->integrated_time_s;
+        double ratio = (span > 0) ? (_publish_time_s - this->integrated_time_s) / span : 0;
+
+        accel_at_publish += (Eigen::Vector3d(next.x, next.y, next.z) - accel_last) * ratio;
+    }
+
+    double remaining_s = this->integration_started ? _publish_time_s - this->integrated_time_s : 0;
+
+    if (remaining_s < 0)
+    {
+        remaining_s = 0;
+    }
+
+    Eigen::Vector3d ned_accel_last      = this->integrated_attitude * accel_last;
+    Eigen::Vector3d ned_accel_publish   = this->integrated_attitude * accel_at_publish;
+    Eigen::Vector3d ned_velocity_publish;
+
+    for (int i = 0; i < 3; i++)
+    {
+        ned_velocity_publish(i) = OdometryCalculator::Integral(ned_accel_last(i), ned_accel_publish(i), this->ned_velocity.sum(i), remaining_s);
+    }
+
+    this->accel.linear.x = accel_at_publish(0);
+    this->accel.linear.y = accel_at_publish(1);
+    this->accel.linear.z = accel_at_publish(2);
+
+    /* Attitude at the publish time */
+    TimedVector3_S ypr = this->InterpolateSample(this->ypr_samples, _publish_time_s, true);
+    Eigen::Matrix3d attitude_at_publish = this->integrated_attitude;
+
+    this->AttitudeAt(_publish_time_s, attitude_at_publish);
+
+    this->angular_position.x = ypr.x;
+    this->angular_position.y = ypr.y;
+    this->angular_position.z = ypr.z;
+
+    /* Velocities, body-fixed */
+    Eigen::Vector3d body_velocity = attitude_at_publish.transpose() * ned_velocity_publish;
+
+    this->prev_linear_velocity = this->twist.linear;
+
+    this->twist.linear.x = body_velocity(0);
+    this->twist.linear.y = body_velocity(1);
+    this->twist.linear.z = body_velocity(2);
+
+    /* Angular rates and their derivative over the real elapsed time */
+    this->prev_angular_rate = this->angular_rate;
+
+    TimedVector3_S rate = this->InterpolateSample(this->rate_samples, _publish_time_s, false);
+
+    this->angular_rate.x = rate.x;
+    this->angular_rate.y = rate.y;
+    this->angular_rate.z = rate.z;
+
+    double rate_dt_s = _publish_time_s - this->prev_rate_time_s;
+
+    if (this->prev_rate_time_s > 0 && rate_dt_s > 0)
+    {
+        this->accel.angular.x = OdometryCalculator::Derivative(this->prev_angular_rate.x, this->angular_rate.x, rate_dt_s);
+        this->accel.angular.y = OdometryCalculator::Derivative(this->prev_angular_rate.y, this->angular_rate.y, rate_dt_s);
+        this->accel.angular.z = OdometryCalculator::Derivative(this->prev_angular_rate.z, this->angular_rate.z, rate_dt_s);
+    }
+
+    this->prev_rate_time_s = _publish_time_s;
 
-    /* Velocities */
-    this->prev_linear_velocity.x = this->twist.linear.x;
-    this->prev_linear_velocity.y = this->twist.linear.y;
-    this->prev_linear_velocity.z = this->twist.linear.z;
-
-    this->twist.linear.x = OdometryCalculator::Integral(this->prev_linear_acceleration.x, 
-                                                        this->accel.linear.x, 
-                                                        this->twist.linear.x, 
-                                                        this->sample_time_s);
-    this->twist.linear.y = OdometryCalculator::Integral(this->prev_linear_acceleration.y, 
-                                                        this->accel.linear.y, 
-                                                        this->twist.linear.y, 
-                                                        this->sample_time_s);
-    this->twist.linear.z = OdometryCalculator::Integral(this->prev_linear_acceleration.z, 
-                                                        this->accel.linear.z, 
-                                                        this->twist.linear.z, 
-                                                        this->sample_time_s);
     this->twist.angular.x = this->angular_rate.x;
     this->twist.angular.y = this->angular_rate.y;
     this->twist.angular.z = this->angular_rate.z;
 
-    /* Pose */
-    this->pose.position.x = OdometryCalculator::Integral(this->prev_linear_velocity.x, 
-                                                         this->twist.linear.x, 
-                                                         this->pose.position.x, 
-                                                         this->sample_time_s);
-    this->pose.position.y = OdometryCalculator::Integral(this->prev_linear_velocity.y, 
-                                                         this->twist.linear.y, 
-                                                         this->pose.position.y, 
-                                                         this->sample_time_s);
-    this->pose.position.z = OdometryCalculator::Integral(this->prev_linear_velocity.z, 
-                                                         this->twist.linear.z, 
-                                                         this->pose.position.z, 
-                                                         this->sample_time_s);
+    /* Pose, NED */
+    this->pose.position.x = OdometryCalculator::Integral(this->ned_velocity.sum(0),
+                                                         ned_velocity_publish(0),
+                                                         this->ned_position.sum(0),
+                                                         remaining_s);
+    this->pose.position.y = OdometryCalculator::Integral(this->ned_velocity.sum(1),
+                                                         ned_velocity_publish(1),
+                                                         this->ned_position.sum(1),
+                                                         remaining_s);
+    this->pose.position.z = OdometryCalculator::Integral(this->ned_velocity.sum(2),
+                                                         ned_velocity_publish(2),
+                                                         this->ned_position.sum(2),
+                                                         remaining_s);
 
     this->pose.orientation.x = this->angular_position.x;
     this->pose.orientation.y = this->angular_position.y;
     this->pose.orientation.z = this->angular_position.z;
     this->pose.orientation.w = 0;
+
+    this->UpdateVehicleState(_publish_time_s, attitude_at_publish);
+
+    /* Older samples are no longer needed for interpolation */
+    this->PruneSamples(this->rate_samples, _publish_time_s);
+    this->PruneSamples(this->ypr_samples, _publish_time_s);
+}
+
+void OdometryCalculator::UpdateVehicleState(double _publish_time_s, const Eigen::Matrix3d& _attitude)
+{
+    this->state.header.stamp = ros::Time(_publish_time_s);
+    this->state.sequence++;
+
+    /* The newest IMU sample integrated is the origin of this state */
+    this->state.trace.trace_id      = this->state.sequence;
+    this->state.trace.origin_stamp  = ros::Time(this->integrated_time_s);
+
+    this->state.x       = this->pose.position.x;
+    this->state.y       = this->pose.position.y;
+    this->state.z       = this->pose.position.z;
+    this->state.roll    = this->angular_position.x;
+    this->state.pitch   = this->angular_position.y;
+    this->state.yaw     = this->angular_position.z;
+
+    this->state.u       = this->twist.linear.x;
+    this->state.v       = this->twist.linear.y;
+    this->state.w       = this->twist.linear.z;
+    this->state.p       = this->twist.angular.x;
+    this->state.q       = this->twist.angular.y;
+    this->state.r       = this->twist.angular.z;
+
+    this->state.u_dot   = this->accel.linear.x;
+    this->state.v_dot   = this->accel.linear.y;
+    this->state.w_dot   = this->accel.linear.z;
+    this->state.p_dot   = this->accel.angular.x;
+    this->state.q_dot   = this->accel.angular.y;
+    this->state.r_dot   = this->accel.angular.z;
+
+    /* 4x4 blocks over [x y z yaw] and [u v w r]; velocity covariance is rotated to body axes */
+    Eigen::Matrix3d position_covariance = this->state_covariance.block<3, 3>(6, 6);
+    Eigen::Matrix3d velocity_covariance = _attitude.transpose() * this->state_covariance.block<3, 3>(3, 3) * _attitude;
+
+    for (int i = 0; i < 16; i++)
+    {
+        this->state.pose_covariance[i]  = 0;
+        this->state.twist_covariance[i] = 0;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            this->state.pose_covariance[i * 4 + j]  = position_covariance(i, j);
+            this->state.twist_covariance[i * 4 + j] = velocity_covariance(i, j);
+        }
+    }
+
+    this->state.pose_covariance[15] = this->state_covariance(2, 2);
+}
+
+void OdometryCalculator::InsertSample(RingBuffer<TimedVector3_S>& _buffer, const geometry_msgs::Vector3& _sample, double _stamp_s)
+{
+    TimedVector3_S sample;
+    sample.stamp_s  = _stamp_s;
+    sample.x        = _sample.x;
+    sample.y        = _sample.y;
+    sample.z        = _sample.z;
+
+    if (_buffer.PushBack(sample))
+    {
+        this->overflowed_samples++;
+    }
+
+    /* Out-of-order samples are moved back to their place; they are rare and usually only
+       one or two positions off, so this stays cheap. */
+    for (size_t i = _buffer.Size() - 1; i > 0 && _buffer[i - 1].stamp_s > _buffer[i].stamp_s; i--)
+    {
+        TimedVector3_S swap = _buffer[i - 1];
+        _buffer[i - 1]      = _buffer[i];
+        _buffer[i]          = swap;
+    }
+}
+
+void OdometryCalculator::PreintegrateSamples(double _until_s)
+{
+    this->preintegrator.Reset();
+
+    while (!this->accel_samples.Empty() && this->accel_samples.Front().stamp_s <= _until_s)
+    {
+        const TimedVector3_S& sample = this->accel_samples.Front();
+        double dt = sample.stamp_s - this->integrated_time_s;
+
+        if (dt > 0)
+        {
+            /* A long gap means samples were lost upstream; the midpoint rule below then
+               interpolates linearly across it. */
+            if (dt > this->max_sample_gap_s)
+            {
+                this->dropped_samples++;
+            }
+
+            TimedVector3_S rate = this->InterpolateSample(this->rate_samples, this->integrated_time_s + dt / 2, false);
+
+            Eigen::Vector3d accel_mid(this->linear_acceleration.x + sample.x,
+                                      this->linear_acceleration.y + sample.y,
+                                      this->linear_acceleration.z + sample.z);
+
+            this->preintegrator.IntegrateSample(accel_mid / 2, Eigen::Vector3d(rate.x, rate.y, rate.z), dt);
+
+            this->prev_linear_acceleration = this->linear_acceleration;
+
+            this->linear_acceleration.x = sample.x;
+            this->linear_acceleration.y = sample.y;
+            this->linear_acceleration.z = sample.z;
+            this->integrated_time_s     = sample.stamp_s;
+        }
+
+        this->accel_samples.PopFront();
+    }
+}
+
+void OdometryCalculator::ApplyPreintegration()
+{
+    if (this->preintegrator.sample_count == 0)
+    {
+        return;
+    }
+
+    const Eigen::Matrix3d& R = this->integrated_attitude;
+    double dt = this->preintegrator.delta_time_s;
+
+    /* State update with the batch deltas, expressed in the attitude at the batch start */
+    this->ned_position.Add(this->ned_velocity.sum * dt + R * this->preintegrator.delta_position);
+    this->ned_velocity.Add(R * this->preintegrator.delta_velocity);
+
+    /* Covariance update */
+    OdometryCovariance F = OdometryCovariance::Identity();
+    F.block<3, 3>(6, 3) = Eigen::Matrix3d::Identity() * dt;
+
+    OdometryCovariance G = OdometryCovariance::Zero();
+    G.block<3, 3>(0, 0) = R;
+    G.block<3, 3>(3, 3) = R;
+    G.block<3, 3>(6, 6) = R;
+
+    this->state_covariance = F * this->state_covariance * F.transpose()
+                             + G * this->preintegrator.covariance * G.transpose();
+
+    /* Prefer the attitude measured by the IMU, fall back to the integrated one */
+    Eigen::Matrix3d attitude_end = R * this->preintegrator.delta_rotation;
+
+    if (this->AttitudeAt(this->integrated_time_s, attitude_end))
+    {
+        this->ResetAttitudeCovariance();
+    }
+
+    this->integrated_attitude = attitude_end;
+}
+
+void OdometryCalculator::ResetAttitudeCovariance()
+{
+    /* The IMU attitude is absolute, so it carries nothing of the integrated
+       attitude error nor of its correlation with velocity and position */
+    this->state_covariance.block<3, 9>(0, 0).setZero();
+    this->state_covariance.block<9, 3>(0, 0).setZero();
+
+    this->state_covariance(0, 0) = this->tilt_noise_rad * this->tilt_noise_rad;
+    this->state_covariance(1, 1) = this->tilt_noise_rad * this->tilt_noise_rad;
+    this->state_covariance(2, 2) = this->heading_noise_rad * this->heading_noise_rad;
+}
+
+void OdometryCalculator::PruneSamples(RingBuffer<TimedVector3_S>& _buffer, double _time_s)
+{
+    /* Keep only the newest sample at or before the given time, plus anything newer */
+    while (_buffer.Size() >= 2 && _buffer[1].stamp_s <= _time_s)
+    {
+        _buffer.PopFront();
+    }
+}
+
+TimedVector3_S OdometryCalculator::InterpolateSample(const RingBuffer<TimedVector3_S>& _buffer, double _time_s, bool _wrap_angles) const
+{
+    TimedVector3_S result;
+    result.stamp_s = _time_s;
+    result.x = 0;
+    result.y = 0;
+    result.z = 0;
+
+    if (_buffer.Empty())
+    {
+        return result;
+    }
+
+    /* Buffers are pruned every update, so this search is only a few samples long */
+    size_t i = 0;
+
+    while (i + 1 < _buffer.Size() && _buffer[i + 1].stamp_s <= _time_s)
+    {
+        i++;
+    }
+
+    const TimedVector3_S& before = _buffer[i];
+
+    result.x = before.x;
+    result.y = before.y;
+    result.z = before.z;
+
+    if (i + 1 >= _buffer.Size() || before.stamp_s >= _time_s)
+    {
+        return result;
+    }
+
+    const TimedVector3_S& after = _buffer[i + 1];
+    double ratio = (_time_s - before.stamp_s) / (after.stamp_s - before.stamp_s);
+
+    double delta[3] = {after.x - before.x, after.y - before.y, after.z - before.z};
+
+    if (_wrap_angles)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            if (std::abs(delta[k]) > M_PI)
+            {
+                delta[k] = (delta[k] / std::abs(delta[k])) * (std::abs(delta[k]) - 2 * M_PI);
+            }
+        }
+    }
+
+    result.x += delta[0] * ratio;
+    result.y += delta[1] * ratio;
+    result.z += delta[2] * ratio;
+
+    return result;
+}
+
+bool OdometryCalculator::AttitudeAt(double _time_s, Eigen::Matrix3d& _attitude) const
+{
+    if (this->ypr_samples.Empty())
+    {
+        return false;
+    }
+
+    /* Angular position is stored as (roll, pitch, yaw) */
+    TimedVector3_S ypr = this->InterpolateSample(this->ypr_samples, _time_s, true);
+
+    _attitude = (Eigen::AngleAxisd(ypr.z, Eigen::Vector3d::UnitZ())
+                 * Eigen::AngleAxisd(ypr.y, Eigen::Vector3d::UnitY())
+                 * Eigen::AngleAxisd(ypr.x, Eigen::Vector3d::UnitX())).toRotationMatrix();
+
+    return true;
 }
 
-double OdometryCalculator::Integral(double x1, double x2, double c, float timestep)
+double OdometryCalculator::Integral(double x1, double x2, double c, double timestep)
 {
-    float integral_ = ((x1 + x2) / 2.0 * timestep) + c;
+    double integral_ = ((x1 + x2) / 2.0 * timestep) + c;
     return integral_;
 }
 
-double OdometryCalculator::Derivative(double x1, double x2, float timestep)
+double OdometryCalculator::Derivative(double x1, double x2, double timestep)
 {
-    float derivative_ = (x2 - x1) / timestep;
+    double derivative_ = (x2 - x1) / timestep;
     return derivative_;
 }
 
@@ -0,0 +1,74 @@
+/** ----------------------------------------------------------------------------
+ * @file: current_field.hpp
+ *
+ * @brief: Time varying ocean current on a regular 3D grid. Velocities (NED,
+ *         m/s) are trilinearly interpolated in space and linearly between
+ *         frames, which repeat every frames * frame_period_s, as a tidal
+ *         cycle does. Outside the grid the nearest edge value is used.
+ *
+ *         Current files are plain text: a header line
+ *
+ *             origin_x origin_y origin_z resolution cols rows layers frames frame_period_s
+ *
+ *         followed, frame after frame, by layers * rows * cols samples of
+ *         three velocities (north, east, down); x grows along a row, rows
+ *         grow in y and layers in depth. The origin is the NED position of
+ *         the first sample.
+ *
+ *         Samples are stored in bricks of 4 x 4 x 4 that overlap by one, so
+ *         the eight corners of any cell are in one brick and a lookup reads
+ *         a few nearby cache lines per frame instead of four rows spread
+ *         over the whole grid. A loaded field is only read, one can be
+ *         shared by any number of models and threads.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __CURRENT_FIELD_H__
+#define __CURRENT_FIELD_H__
+
+#include <eigen3/Eigen/Dense>
+#include <string>
+#include <vector>
+
+class CurrentField
+{
+    public:
+
+        float               origin_x;
+        float               origin_y;
+        float               origin_z;
+        float               resolution_m;
+        int                 cols;
+        int                 rows;
+        int                 layers;
+        int                 frames;
+        float               frame_period_s;
+
+        /* Why the last load failed */
+        std::string         error;
+
+        /* Still water until a field is loaded */
+        CurrentField();
+        ~CurrentField();
+
+        bool Load(const std::string& _path);
+
+        /* Takes the samples in file order for the grid described by the members above */
+        bool Build(const std::vector<float>& _velocities);
+
+        Eigen::Vector3f Velocity(double _x, double _y, double _z, double _time_s) const;
+
+    private:
+
+        /* Brick after brick, frame after frame within a brick, x fastest within a frame */
+        std::vector<float>  bricks;
+        int                 bricks_x;
+        int                 bricks_y;
+        int                 bricks_z;
+
+        /* Lookups multiply */
+        float               inverse_resolution;
+        double              inverse_cycle_period;
+};
+
+#endif
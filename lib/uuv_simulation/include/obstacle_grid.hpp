@@ -0,0 +1,56 @@
+/** ----------------------------------------------------------------------------
+ * @file: obstacle_grid.hpp
+ * 
+ * @brief: Uniform grid index over a set of obstacles in the horizontal plane.
+ *         Cells store obstacle indices in one flat array (cell_start gives the
+ *         range of each cell), so building and querying do not allocate once
+ *         the buffers have grown to the size of the world.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __OBSTACLE_GRID_H__
+#define __OBSTACLE_GRID_H__
+
+#include "obstacle_world.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+class ObstacleGrid
+{
+    public:
+
+        float   cell_size_m;
+        float   min_x;
+        float   min_y;
+        int     cells_x;
+        int     cells_y;
+
+        /* The grid is enlarged to keep the cell count under this limit */
+        int     max_cells;
+
+        ObstacleGrid(float _cell_size_m);
+        ~ObstacleGrid();
+
+        void Build(const std::vector<Obstacle_S>& _obstacles);
+
+        /* Appends to _result the obstacles whose bounding circle may overlap
+           the given axis aligned box, each one once. */
+        void Query(float _min_x, float _min_y, float _max_x, float _max_y, std::vector<uint32_t>& _result);
+
+    private:
+
+        std::vector<uint32_t>   cell_start;
+        std::vector<uint32_t>   cell_items;
+
+        /* Per obstacle stamp of the last query that returned it */
+        std::vector<uint32_t>   query_stamps;
+        uint32_t                query_counter;
+
+        float                   used_cell_size_m;
+
+        int CellX(float _x) const;
+        int CellY(float _y) const;
+};
+
+#endif
@@ -0,0 +1,44 @@
+/** ----------------------------------------------------------------------------
+ * @file: obstacle_simulator.hpp
+ * 
+ * @brief: Obstacle simulator. Keeps the simulated obstacle world and the
+ *         messages that describe it, rebuilding them only when it changes.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __OBSTACLE_SIMULATOR_H__
+#define __OBSTACLE_SIMULATOR_H__
+
+#include "obstacle_world.hpp"
+
+#include <ros/ros.h>
+#include <std_msgs/String.h>
+#include <visualization_msgs/MarkerArray.h>
+#include <vanttec_uuv/ObstacleList.h>
+#include <string>
+
+class ObstacleSimulator
+{
+    public:
+
+        ObstacleWorld                       world;
+        visualization_msgs::MarkerArray     marker_array;
+        vanttec_uuv::ObstacleList           obstacle_list;
+
+        std::string                         marker_frame;
+        std::string                         obstacle_frame;
+
+        /* Revision of the world the messages were last built from */
+        uint32_t                            published_revision;
+
+        ObstacleSimulator(const std::string& _marker_frame, const std::string& _obstacle_frame);
+        ~ObstacleSimulator();
+
+        bool LoadScenario(const std::string& _path);
+        void OnScenarioReception(const std_msgs::String& _path);
+
+        /* Rebuilds the messages if the world changed, returns true if it did */
+        bool UpdateMessages();
+};
+
+#endif
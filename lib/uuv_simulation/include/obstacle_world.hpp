@@ -0,0 +1,84 @@
+/** ----------------------------------------------------------------------------
+ * @file: obstacle_world.hpp
+ *
+ * @brief: Simulated obstacle world. Obstacles are loaded from a scenario file
+ *         into a contiguous store and converted to RViz markers and obstacle
+ *         lists for the rest of the system.
+ *
+ *         Scenario files have one obstacle per line, NED coordinates in
+ *         meters and angles in radians. Text after a '#' is a comment.
+ *
+ *             buoy  x y z radius height
+ *             gate  x y z post_radius height width yaw [posts]
+ *             wall  x y z thickness height length yaw
+ *
+ *         Gates are stored as their individual posts, evenly spread across
+ *         the gate width (2 posts by default).
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __OBSTACLE_WORLD_H__
+#define __OBSTACLE_WORLD_H__
+
+#include <string>
+#include <vector>
+
+#include <visualization_msgs/MarkerArray.h>
+#include <vanttec_uuv/ObstacleList.h>
+
+typedef enum ObstacleClass_E
+{
+    OBSTACLE_BUOY = 0,
+    OBSTACLE_GATE = 1,
+    OBSTACLE_WALL = 2,
+} ObstacleClass_E;
+
+/* Buoys and gate posts are vertical cylinders; walls are boxes of
+   length x (2 * radius) x height rotated by yaw. */
+
+typedef struct Obstacle_S
+{
+    ObstacleClass_E obstacle_class;
+    float           x;
+    float           y;
+    float           z;
+    float           radius;
+    float           height;
+    float           length;
+    float           yaw;
+} Obstacle_S;
+
+class ObstacleWorld
+{
+    public:
+
+        std::vector<Obstacle_S>     obstacles;
+
+        /* Incremented every time the world changes */
+        uint32_t                    revision;
+        uint32_t                    malformed_lines;
+
+        ObstacleWorld();
+        ~ObstacleWorld();
+
+        bool LoadScenario(const std::string& _path);
+        void AddObstacle(const Obstacle_S& _obstacle);
+        void Clear();
+
+        /* Bounding radius in the horizontal plane, used by the spatial queries */
+        static float BoundingRadius(const Obstacle_S& _obstacle);
+        static const char* ClassName(ObstacleClass_E _class);
+        static ObstacleClass_E ClassFromName(const std::string& _name);
+
+        /* Replaces the world with the obstacles of a list in the NED frame */
+        void LoadObstacleList(const vanttec_uuv::ObstacleList& _list);
+
+        void FillMarkers(visualization_msgs::MarkerArray& _markers, const std::string& _frame) const;
+        void FillObstacleList(vanttec_uuv::ObstacleList& _list, const std::string& _frame) const;
+
+    private:
+
+        bool ParseLine(const std::string& _line);
+};
+
+#endif
@@ -0,0 +1,83 @@
+/** ----------------------------------------------------------------------------
+ * @file: perception_simulator.hpp
+ * 
+ * @brief: Simulated perception. Queries the obstacle world around the vehicle
+ *         through a uniform grid, keeps the obstacles inside the sensor range
+ *         and field of view, and reports them in the body frame with noise and
+ *         random dropouts.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __PERCEPTION_SIMULATOR_H__
+#define __PERCEPTION_SIMULATOR_H__
+
+#include "obstacle_world.hpp"
+#include "obstacle_grid.hpp"
+
+#include <ros/ros.h>
+#include <eigen3/Eigen/Dense>
+#include <vanttec_uuv/ObstacleList.h>
+#include <vanttec_uuv/VehicleState.h>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef struct SensorModel_S
+{
+    float   min_range_m;
+    float   max_range_m;
+    float   horizontal_fov_rad;
+    float   vertical_fov_rad;
+
+    /* Position noise standard deviation: constant part plus a part proportional to range */
+    float   position_noise_m;
+    float   range_noise_ratio;
+
+    /* Probability of missing an obstacle that is in view, per cycle */
+    float   dropout_probability;
+} SensorModel_S;
+
+class PerceptionSimulator
+{
+    public:
+
+        SensorModel_S                   sensor;
+        std::string                     body_frame;
+
+        vanttec_uuv::ObstacleList       detections;
+
+        /* Vehicle pose in NED, roll and pitch are neglected */
+        float                           ned_x;
+        float                           ned_y;
+        float                           ned_z;
+        float                           yaw;
+        bool                            state_received;
+
+        /* Obstacles returned by the grid on the last cycle, before culling */
+        uint32_t                        candidate_count;
+
+        PerceptionSimulator(const SensorModel_S& _sensor, const std::string& _body_frame, float _cell_size_m, uint32_t _seed);
+        ~PerceptionSimulator();
+
+        void OnWorldReception(const vanttec_uuv::ObstacleList& _list);
+        void OnStateReception(const vanttec_uuv::VehicleState& _state);
+
+        void Iteration();
+
+        void ned_to_body(float ned_x2, float ned_y2, float* x2, float* y2);
+        Eigen::Matrix2d rotation_matrix(float angle);
+
+    private:
+
+        ObstacleWorld                   world;
+        ObstacleGrid                    grid;
+        std::vector<uint32_t>           candidates;
+
+        std::mt19937                            generator;
+        std::normal_distribution<float>         normal;
+        std::uniform_real_distribution<float>   uniform;
+
+        void SectorBounds(float* _min_x, float* _min_y, float* _max_x, float* _max_y);
+};
+
+#endif
@@ -0,0 +1,47 @@
+/** ----------------------------------------------------------------------------
+ * @file: seabed_map.hpp
+ * 
+ * @brief: Seabed height map. Depths (positive down, NED) on a regular grid,
+ *         bilinearly interpolated, with a constant depth outside the grid.
+ *
+ *         Map files are plain text: a header line
+ *
+ *             origin_x origin_y resolution cols rows
+ *
+ *         followed by rows * cols depths, row major with x growing along a
+ *         row. The origin is the NED position of the first sample.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __SEABED_MAP_H__
+#define __SEABED_MAP_H__
+
+#include <eigen3/Eigen/Dense>
+#include <string>
+#include <vector>
+
+class SeabedMap
+{
+    public:
+
+        float               default_depth_m;
+        float               origin_x;
+        float               origin_y;
+        float               resolution_m;
+        int                 cols;
+        int                 rows;
+        std::vector<float>  depths;
+
+        SeabedMap(float _default_depth_m);
+        ~SeabedMap();
+
+        bool Load(const std::string& _path);
+
+        float Depth(float _x, float _y) const;
+
+        /* Distance along a unit direction to the seabed, false if it is not
+           reached within _max_range. */
+        bool Intersect(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _direction, float _max_range, float* _range) const;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/** ----------------------------------------------------------------------------
+ * @file: sonar_simulator.hpp
+ * 
+ * @brief: Ray casting sonar simulator. Every scan casts one ray per beam
+ *         against the obstacle world and the seabed. Obstacles near the fan
+ *         are fetched once per scan from the uniform grid, and the beams are
+ *         split between a fixed set of worker threads.
+ * -----------------------------------------------------------------------------
+ **/
+
+#ifndef __SONAR_SIMULATOR_H__
+#define __SONAR_SIMULATOR_H__
+
+#include "obstacle_world.hpp"
+#include "obstacle_grid.hpp"
+#include "seabed_map.hpp"
+
+#include <ros/ros.h>
+#include <eigen3/Eigen/Dense>
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <vanttec_uuv/ObstacleList.h>
+#include <vanttec_uuv/VehicleState.h>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef enum SonarType_E
+{
+    /* Fan in the body xy plane, tilted down by tilt_rad */
+    SONAR_FORWARD_LOOKING = 0,
+    /* Fan across track around the body z axis, tilted forward by tilt_rad */
+    SONAR_MULTIBEAM = 1,
+} SonarType_E;
+
+typedef struct SonarModel_S
+{
+    SonarType_E sonar_type;
+    int         beam_count;
+    float       fan_angle_rad;
+    float       tilt_rad;
+    float       min_range_m;
+    float       max_range_m;
+    float       range_noise_m;
+} SonarModel_S;
+
+class SonarSimulator
+{
+    public:
+
+        SonarModel_S                sonar;
+        std::string                 body_frame;
+        SeabedMap                   seabed;
+
+        /* Ranges are given in the fan plane; the cloud has the exact hit points */
+        sensor_msgs::LaserScan      scan;
+        sensor_msgs::PointCloud2    cloud;
+
+        bool                        state_received;
+        uint32_t                    candidate_count;
+
+        SonarSimulator(const SonarModel_S& _sonar, const std::string& _body_frame, float _cell_size_m,
+                       float _seabed_depth_m, int _thread_count, uint32_t _seed);
+        ~SonarSimulator();
+
+        void OnWorldReception(const vanttec_uuv::ObstacleList& _list);
+        void OnStateReception(const vanttec_uuv::VehicleState& _state);
+
+        void Iteration();
+
+    private:
+
+        ObstacleWorld                   world;
+        ObstacleGrid                    grid;
+        std::vector<uint32_t>           candidates;
+
+        /* Beam directions in the body frame and the same rotated to NED */
+        std::vector<Eigen::Vector3f>    body_directions;
+        std::vector<Eigen::Vector3f>    ned_directions;
+        std::vector<float>              hit_ranges;
+
+        Eigen::Vector3f                 ned_position;
+        Eigen::Matrix3f                 body_to_ned;
+
+        /* Worker 0 is the calling thread */
+        int                             thread_count;
+        std::vector<std::thread>        workers;
+        std::vector<std::mt19937>       generators;
+        std::mutex                      work_mutex;
+        std::condition_variable         work_ready;
+        std::condition_variable         work_done;
+        uint32_t                        work_generation;
+        int                             pending_workers;
+        bool                            stopping;
+
+        void WorkerLoop(int _worker);
+        void CastBeams(int _worker);
+        float CastRay(const Eigen::Vector3f& _direction) const;
+        void FillMessages();
+};
+
+#endif
@@ -0,0 +1,78 @@
+/** ----------------------------------------------------------------------------
+ * @file: system_identification.hpp
+ *
+ * @brief: Estimates the hydrodynamic coefficients of the 4-DOF model from
+ *         logged thrust, velocities and accelerations. With the accelerations
+ *         measured, each axis of the model is linear in its added mass and
+ *         damping coefficients:
+ *
+ *             (m - X_u_dot) u_dot = tau_x + (m - Y_v_dot) v r + X_u u + X_uu |u| u - g_x
+ *
+ *         so the batch of every logged sample is one least squares problem,
+ *         solved from its normal equations. The mass, inertia and restoring
+ *         forces come from a base vehicle and are not estimated; neither are
+ *         coefficients the logs do not excite, which keep the base value.
+ *         Equations are weighted by the base effective mass of their axis,
+ *         so residuals are accelerations.
+ * -----------------------------------------------------------------------------
+ * */
+
+#ifndef __SYSTEM_IDENTIFICATION_H__
+#define __SYSTEM_IDENTIFICATION_H__
+
+#include "telemetry_recorder.hpp"
+#include "vehicle_parameters.hpp"
+
+#include <string>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+/* X_u_dot, Y_v_dot, Z_w_dot, N_r_dot, X_u, X_uu, Y_v, Y_vv, Z_w, Z_ww, N_r, N_rr */
+const size_t SYSID_COEFFICIENTS = 12;
+
+/* Thrust applied, velocities the accelerations were computed from and the accelerations */
+typedef struct SysIdSample_S
+{
+    float   tau[4];
+    float   upsilon[4];
+    float   upsilon_dot[4];
+} SysIdSample_S;
+
+class SystemIdentification
+{
+    public:
+
+        /* Base vehicle, holds the estimate after Fit */
+        VehicleParameters           vehicle;
+
+        std::vector<SysIdSample_S>  samples;
+
+        /* Results, per axis in surge, sway, heave and yaw order */
+        double                      rms_residual[4];
+        bool                        estimated[SYSID_COEFFICIENTS];
+        std::string                 error;
+
+        SystemIdentification(const VehicleParameters& _vehicle);
+        ~SystemIdentification();
+
+        /* Pairs every state with the one before it and the last thrust recorded
+           before it, as the simulation node logs them. Returns the samples added */
+        size_t AddLog(TelemetryReader& _reader);
+
+        /* Splits the samples over _threads workers */
+        bool Fit(unsigned _threads);
+
+        /* Estimated coefficients by index, as named in SYSID_COEFFICIENTS */
+        static const char* CoefficientName(size_t _index);
+        static float Coefficient(const VehicleParameters& _vehicle, size_t _index);
+
+    private:
+
+        /* Augmented normal equations of one axis, the last row and column are the observations */
+        typedef Eigen::Matrix<double, SYSID_COEFFICIENTS + 1, SYSID_COEFFICIENTS + 1> Normal;
+
+        void Accumulate(size_t _first, size_t _last, Normal* _normals) const;
+};
+
+#endif
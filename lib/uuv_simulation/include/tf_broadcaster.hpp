@@ -21,21 +21,38 @@
 #include <geometry_msgs/Pose.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <nav_msgs/Path.h>
+#include <vanttec_uuv/VehicleState.h>
+
+#include "ring_buffer.hpp"
 
 class TfBroadcaster
 {
     public:
         
         nav_msgs::Path                  path;
+        nav_msgs::Path                  path_increment;
         tf2_ros::TransformBroadcaster   br;
 
         std::string parent_frame;
         std::string child_frame;
-        
-        TfBroadcaster(const std::string& _parent, const std::string& _child);
+
+        /* Path decimation: a pose is only recorded after moving or turning enough */
+        float min_path_distance_m;
+        float min_path_angle_rad;
+
+        TfBroadcaster(const std::string& _parent, const std::string& _child, size_t _path_capacity);
         ~TfBroadcaster();
 
-        void BroadcastTransform(const geometry_msgs::Pose& msg);
+        void BroadcastTransform(const vanttec_uuv::VehicleState& _state);
+        void BuildFullPath();
+        void ClearPathIncrement();
+
+    private:
+
+        RingBuffer<geometry_msgs::PoseStamped>  path_history;
+
+        bool    path_started;
+        float   last_path_yaw;
 };
 
 #endif
\ No newline at end of file
@@ -5,6 +5,12 @@
  * @email: pedro.sc.97@gmail.com
  * 
  * @brief: Implementation of the kinematic 4dof model of the UUV for simulation.
+ *         Templated on the parameter set: UUVDynamic4DOFModel takes one loaded
+ *         at startup, VtecU3GammaDynamicModel has the shipped vehicle built
+ *         in. The terms that only depend on the parameters are computed once
+ *         when the model is constructed. With a current field the added mass
+ *         Coriolis and damping terms act on the velocity relative to the
+ *         water, taken as irrotational and slowly varying.
  * -----------------------------------------------------------------------------
  **/
 
@@ -12,28 +18,46 @@
 #define __UUV_DYNAMIC_4DOF_MODEL_H__
 
 #include "vanttec_uuv/ThrustControl.h"
-#include "vtec_u3_gamma_parameters.hpp"
+#include "vanttec_uuv/VehicleState.h"
+#include "vehicle_parameters.hpp"
+#include "compensated_sum.hpp"
+#include "current_field.hpp"
+#include "telemetry_recorder.hpp"
 
 #include <geometry_msgs/Vector3.h>
 #include <geometry_msgs/Twist.h>
 #include <geometry_msgs/Pose.h>
 #include <eigen3/Eigen/Dense>
 
-class UUVDynamic4DOFModel
+template <typename Parameters>
+class UUVDynamic4DOFModelT
 {
     public:
 
         float sample_time_s;
 
+        /* Bound when the model is constructed */
+        const Parameters            parameters;
+
         geometry_msgs::Vector3  linear_acceleration;
         geometry_msgs::Vector3  angular_rate;
         geometry_msgs::Vector3  angular_position;
 
-        geometry_msgs::Twist    velocities;
-        geometry_msgs::Pose     pose;
+        vanttec_uuv::VehicleState   state;
+
+        /* Trace of the last thrust received, new_thrust is set until it is applied */
+        vanttec_uuv::TraceInfo      thrust_trace;
+        bool                        new_thrust;
+
+        /* Thrust inputs are recorded as they are received when set, NULL by default */
+        TelemetryRecorder*          recorder;
 
-        UUVDynamic4DOFModel(float _sample_time_s);
-        ~UUVDynamic4DOFModel();
+        /* Shared with other models, NULL for still water. Sampled at the position
+           and simulated time of each step */
+        const CurrentField*         current_field;
+
+        UUVDynamic4DOFModelT(float _sample_time_s, const Parameters& _parameters = Parameters());
+        ~UUVDynamic4DOFModelT();
 
         void ThrustCallback(const vanttec_uuv::ThrustControl& _thrust);
         void CalculateStates();
@@ -43,7 +67,6 @@ class UUVDynamic4DOFModel
         /* Matrices */
         
         Eigen::Vector4f tau;
-        Eigen::Vector4f body_pos;
         Eigen::Vector4f upsilon;
         Eigen::Vector4f upsilon_prev;
         Eigen::Vector4f upsilon_dot;
@@ -55,9 +78,18 @@ class UUVDynamic4DOFModel
         Eigen::Matrix4f D_lin;
         Eigen::Matrix4f D_qua;
         Eigen::Vector4f G_eta;
+        Eigen::Matrix4f M_inv;
         Eigen::Matrix4f J;
         Eigen::Vector4f eta_dot;
-        Eigen::Vector4f eta;
+
+        /* Positions are accumulated in double with compensated summation so that
+           long missions keep their resolution; derivatives stay in float. */
+        CompensatedSum<Eigen::Vector4d> body_pos;
+        CompensatedSum<Eigen::Vector4d> eta;
 };
 
+/* Instantiated in uuv_dynamic_4dof_model.cpp */
+typedef UUVDynamic4DOFModelT<VehicleParameters>        UUVDynamic4DOFModel;
+typedef UUVDynamic4DOFModelT<VtecU3GammaParameters>    VtecU3GammaDynamicModel;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,232 @@
+/** ----------------------------------------------------------------------------
+ * @file: current_field.cpp
+ *
+ * @brief: Time varying ocean current on a regular 3D grid, stored in
+ *         overlapping bricks and interpolated at the vehicle position.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "current_field.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+/* Samples per brick side, the cells it covers per side, and its size in floats */
+static const int    CURRENT_BRICK_SIZE      = 4;
+static const int    CURRENT_BRICK_CELLS     = CURRENT_BRICK_SIZE - 1;
+static const int    CURRENT_BRICK_FLOATS    = CURRENT_BRICK_SIZE * CURRENT_BRICK_SIZE * CURRENT_BRICK_SIZE * 3;
+
+/* Offsets to the next sample in x, y and z within a brick */
+static const int    CURRENT_STEP_X          = 3;
+static const int    CURRENT_STEP_Y          = CURRENT_BRICK_SIZE * CURRENT_STEP_X;
+static const int    CURRENT_STEP_Z          = CURRENT_BRICK_SIZE * CURRENT_STEP_Y;
+
+CurrentField::CurrentField()
+{
+    this->origin_x          = 0;
+    this->origin_y          = 0;
+    this->origin_z          = 0;
+    this->resolution_m      = 1;
+    this->cols              = 0;
+    this->rows              = 0;
+    this->layers            = 0;
+    this->frames            = 0;
+    this->frame_period_s    = 0;
+    this->bricks_x          = 0;
+    this->bricks_y          = 0;
+    this->bricks_z          = 0;
+
+    this->inverse_resolution    = 1;
+    this->inverse_cycle_period  = 0;
+}
+
+CurrentField::~CurrentField(){}
+
+bool CurrentField::Load(const std::string& _path)
+{
+    std::ifstream file(_path.c_str());
+
+    this->error.clear();
+
+    if (!file.is_open())
+    {
+        this->error = "could not open " + _path;
+        return false;
+    }
+
+    if (!(file >> this->origin_x >> this->origin_y >> this->origin_z >> this->resolution_m
+               >> this->cols >> this->rows >> this->layers >> this->frames >> this->frame_period_s))
+    {
+        this->error = _path + ": expected origin_x origin_y origin_z resolution cols rows layers frames frame_period_s";
+        this->cols = 0;
+        return false;
+    }
+
+    if (this->cols < 2 || this->rows < 2 || this->layers < 2 || this->frames < 1)
+    {
+        this->error = _path + ": the grid needs 2 samples per axis and a frame";
+        this->cols = 0;
+        return false;
+    }
+
+    std::vector<float> velocities((size_t) this->cols * this->rows * this->layers * this->frames * 3);
+
+    for (size_t i = 0; i < velocities.size(); i++)
+    {
+        if (!(file >> velocities[i]))
+        {
+            this->error = _path + ": fewer samples than the header gives";
+            this->cols = 0;
+            return false;
+        }
+    }
+
+    if (!this->Build(velocities))
+    {
+        this->error = _path + ": " + this->error;
+        return false;
+    }
+
+    return true;
+}
+
+bool CurrentField::Build(const std::vector<float>& _velocities)
+{
+    size_t points = (size_t) this->cols * this->rows * this->layers;
+
+    if (this->cols < 2 || this->rows < 2 || this->layers < 2 || this->frames < 1 ||
+        _velocities.size() != points * this->frames * 3)
+    {
+        this->error = "samples do not match the grid";
+        this->cols = 0;
+        return false;
+    }
+
+    if (this->resolution_m <= 0 || (this->frames > 1 && this->frame_period_s <= 0))
+    {
+        this->error = "resolution and frame period must be positive";
+        this->cols = 0;
+        return false;
+    }
+
+    this->inverse_resolution    = 1 / this->resolution_m;
+    this->inverse_cycle_period  = this->frames > 1 ? 1 / ((double) this->frame_period_s * this->frames) : 0;
+
+    this->bricks_x = (this->cols - 2) / CURRENT_BRICK_CELLS + 1;
+    this->bricks_y = (this->rows - 2) / CURRENT_BRICK_CELLS + 1;
+    this->bricks_z = (this->layers - 2) / CURRENT_BRICK_CELLS + 1;
+
+    this->bricks.resize((size_t) this->bricks_x * this->bricks_y * this->bricks_z * this->frames * CURRENT_BRICK_FLOATS);
+
+    float* brick = &this->bricks[0];
+
+    /* Bricks past the far edges repeat the last sample */
+    for (int bz = 0; bz < this->bricks_z; bz++)
+    {
+        for (int by = 0; by < this->bricks_y; by++)
+        {
+            for (int bx = 0; bx < this->bricks_x; bx++)
+            {
+                for (int frame = 0; frame < this->frames; frame++)
+                {
+                    for (int k = 0; k < CURRENT_BRICK_SIZE; k++)
+                    {
+                        int z = std::min(bz * CURRENT_BRICK_CELLS + k, this->layers - 1);
+
+                        for (int j = 0; j < CURRENT_BRICK_SIZE; j++)
+                        {
+                            int y = std::min(by * CURRENT_BRICK_CELLS + j, this->rows - 1);
+
+                            for (int i = 0; i < CURRENT_BRICK_SIZE; i++)
+                            {
+                                int x = std::min(bx * CURRENT_BRICK_CELLS + i, this->cols - 1);
+
+                                const float* sample = &_velocities[((frame * points) + ((size_t) z * this->rows + y) * this->cols + x) * 3];
+
+                                brick[0] = sample[0];
+                                brick[1] = sample[1];
+                                brick[2] = sample[2];
+                                brick += 3;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/* Grid coordinate clamped to the samples, its brick, the cell within the brick
+   and the position within the cell */
+static inline void Locate(float _coordinate, int _samples, int* _brick, int* _corner, float* _fraction)
+{
+    float coordinate = std::min(std::max(_coordinate, 0.0f), float(_samples - 1));
+    int cell = std::min(int(coordinate), _samples - 2);
+
+    *_brick     = cell / CURRENT_BRICK_CELLS;
+    *_corner    = cell - *_brick * CURRENT_BRICK_CELLS;
+    *_fraction  = coordinate - cell;
+}
+
+/* Interpolates the cell whose first corner is _sample, the other corners follow at the brick steps */
+static inline Eigen::Vector3f Trilinear(const float* _sample, float _fx, float _fy, float _fz)
+{
+    Eigen::Vector3f velocity;
+
+    for (int c = 0; c < 3; c++)
+    {
+        const float* s = _sample + c;
+
+        float x00 = s[0] + _fx * (s[CURRENT_STEP_X] - s[0]);
+        float x10 = s[CURRENT_STEP_Y] + _fx * (s[CURRENT_STEP_Y + CURRENT_STEP_X] - s[CURRENT_STEP_Y]);
+        float x01 = s[CURRENT_STEP_Z] + _fx * (s[CURRENT_STEP_Z + CURRENT_STEP_X] - s[CURRENT_STEP_Z]);
+        float x11 = s[CURRENT_STEP_Z + CURRENT_STEP_Y] + _fx * (s[CURRENT_STEP_Z + CURRENT_STEP_Y + CURRENT_STEP_X] - s[CURRENT_STEP_Z + CURRENT_STEP_Y]);
+
+        float y0 = x00 + _fy * (x10 - x00);
+        float y1 = x01 + _fy * (x11 - x01);
+
+        velocity(c) = y0 + _fz * (y1 - y0);
+    }
+
+    return velocity;
+}
+
+Eigen::Vector3f CurrentField::Velocity(double _x, double _y, double _z, double _time_s) const
+{
+    if (this->cols == 0)
+    {
+        return Eigen::Vector3f::Zero();
+    }
+
+    int brick_x, brick_y, brick_z;
+    int corner_x, corner_y, corner_z;
+    float fx, fy, fz;
+
+    Locate(float(_x - this->origin_x) * this->inverse_resolution, this->cols, &brick_x, &corner_x, &fx);
+    Locate(float(_y - this->origin_y) * this->inverse_resolution, this->rows, &brick_y, &corner_y, &fy);
+    Locate(float(_z - this->origin_z) * this->inverse_resolution, this->layers, &brick_z, &corner_z, &fz);
+
+    const float* brick = &this->bricks[(((size_t) brick_z * this->bricks_y + brick_y) * this->bricks_x + brick_x) * this->frames * CURRENT_BRICK_FLOATS];
+    const float* sample = brick + corner_z * CURRENT_STEP_Z + corner_y * CURRENT_STEP_Y + corner_x * CURRENT_STEP_X;
+
+    if (this->frames == 1)
+    {
+        return Trilinear(sample, fx, fy, fz);
+    }
+
+    /* Frames repeat, the last one blends into the first */
+    double cycle = _time_s * this->inverse_cycle_period;
+    cycle = (cycle - std::floor(cycle)) * this->frames;
+
+    int frame = std::min(int(cycle), this->frames - 1);
+    int next_frame = frame + 1 < this->frames ? frame + 1 : 0;
+    float ft = cycle - frame;
+
+    Eigen::Vector3f current = Trilinear(sample + frame * CURRENT_BRICK_FLOATS, fx, fy, fz);
+    Eigen::Vector3f next = Trilinear(sample + next_frame * CURRENT_BRICK_FLOATS, fx, fy, fz);
+
+    return current + ft * (next - current);
+}
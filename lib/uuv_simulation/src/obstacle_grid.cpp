@@ -0,0 +1,182 @@
+/** ----------------------------------------------------------------------------
+ * @file: obstacle_grid.cpp
+ * 
+ * @brief: Uniform grid index over a set of obstacles in the horizontal plane.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "obstacle_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ObstacleGrid::ObstacleGrid(float _cell_size_m)
+{
+    this->cell_size_m       = _cell_size_m;
+    this->used_cell_size_m  = _cell_size_m;
+    this->min_x             = 0;
+    this->min_y             = 0;
+    this->cells_x           = 0;
+    this->cells_y           = 0;
+    this->max_cells         = 1 << 20;
+    this->query_counter     = 0;
+}
+
+ObstacleGrid::~ObstacleGrid(){}
+
+int ObstacleGrid::CellX(float _x) const
+{
+    int cell = int(std::floor((_x - this->min_x) / this->used_cell_size_m));
+    return std::min(std::max(cell, 0), this->cells_x - 1);
+}
+
+int ObstacleGrid::CellY(float _y) const
+{
+    int cell = int(std::floor((_y - this->min_y) / this->used_cell_size_m));
+    return std::min(std::max(cell, 0), this->cells_y - 1);
+}
+
+void ObstacleGrid::Build(const std::vector<Obstacle_S>& _obstacles)
+{
+    this->cells_x = 0;
+    this->cells_y = 0;
+    this->cell_start.clear();
+    this->cell_items.clear();
+    this->query_stamps.assign(_obstacles.size(), 0);
+    this->query_counter = 0;
+
+    if (_obstacles.empty())
+    {
+        return;
+    }
+
+    float max_x = -INFINITY;
+    float max_y = -INFINITY;
+    this->min_x = INFINITY;
+    this->min_y = INFINITY;
+
+    for (size_t i = 0; i < _obstacles.size(); i++)
+    {
+        float radius = ObstacleWorld::BoundingRadius(_obstacles[i]);
+
+        this->min_x = std::min(this->min_x, _obstacles[i].x - radius);
+        this->min_y = std::min(this->min_y, _obstacles[i].y - radius);
+        max_x       = std::max(max_x, _obstacles[i].x + radius);
+        max_y       = std::max(max_y, _obstacles[i].y + radius);
+    }
+
+    /* Grow the cells of very sparse worlds instead of allocating a huge grid */
+    this->used_cell_size_m = this->cell_size_m;
+
+    while (true)
+    {
+        this->cells_x = int((max_x - this->min_x) / this->used_cell_size_m) + 1;
+        this->cells_y = int((max_y - this->min_y) / this->used_cell_size_m) + 1;
+
+        if ((double) this->cells_x * this->cells_y <= this->max_cells)
+        {
+            break;
+        }
+
+        this->used_cell_size_m *= 2;
+    }
+
+    /* Counting pass, then prefix sum, then fill; cell_start ends up as the
+       start offset of each cell with one extra entry for the end. */
+    this->cell_start.assign(this->cells_x * this->cells_y + 1, 0);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (size_t i = 0; i < _obstacles.size(); i++)
+        {
+            float radius = ObstacleWorld::BoundingRadius(_obstacles[i]);
+            int x0 = this->CellX(_obstacles[i].x - radius);
+            int x1 = this->CellX(_obstacles[i].x + radius);
+            int y0 = this->CellY(_obstacles[i].y - radius);
+            int y1 = this->CellY(_obstacles[i].y + radius);
+
+            for (int cx = x0; cx <= x1; cx++)
+            {
+                for (int cy = y0; cy <= y1; cy++)
+                {
+                    int cell = cx * this->cells_y + cy;
+
+                    if (pass == 0)
+                    {
+                        this->cell_start[cell + 1]++;
+                    }
+                    else
+                    {
+                        this->cell_items[this->cell_start[cell]++] = i;
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (size_t c = 1; c < this->cell_start.size(); c++)
+            {
+                this->cell_start[c] += this->cell_start[c - 1];
+            }
+
+            this->cell_items.resize(this->cell_start.back());
+        }
+    }
+
+    /* The fill pass advanced every start to the next cell's start */
+    for (size_t c = this->cell_start.size() - 1; c > 0; c--)
+    {
+        this->cell_start[c] = this->cell_start[c - 1];
+    }
+
+    this->cell_start[0] = 0;
+}
+
+void ObstacleGrid::Query(float _min_x, float _min_y, float _max_x, float _max_y, std::vector<uint32_t>& _result)
+{
+    if (this->cells_x == 0)
+    {
+        return;
+    }
+
+    if (_max_x < this->min_x || _max_y < this->min_y ||
+        _min_x > this->min_x + this->cells_x * this->used_cell_size_m ||
+        _min_y > this->min_y + this->cells_y * this->used_cell_size_m)
+    {
+        return;
+    }
+
+    this->query_counter++;
+
+    /* Stamps wrapped around, old values could alias the new counter */
+    if (this->query_counter == 0)
+    {
+        std::fill(this->query_stamps.begin(), this->query_stamps.end(), 0);
+        this->query_counter = 1;
+    }
+
+    int x0 = this->CellX(_min_x);
+    int x1 = this->CellX(_max_x);
+    int y0 = this->CellY(_min_y);
+    int y1 = this->CellY(_max_y);
+
+    for (int cx = x0; cx <= x1; cx++)
+    {
+        for (int cy = y0; cy <= y1; cy++)
+        {
+            int cell = cx * this->cells_y + cy;
+
+            for (uint32_t k = this->cell_start[cell]; k < this->cell_start[cell + 1]; k++)
+            {
+                uint32_t index = this->cell_items[k];
+
+                if (this->query_stamps[index] != this->query_counter)
+                {
+                    this->query_stamps[index] = this->query_counter;
+                    _result.push_back(index);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,55 @@
+/** ----------------------------------------------------------------------------
+ * @file: obstacle_simulator.cpp
+ * 
+ * @brief: Obstacle simulator. Keeps the simulated obstacle world and the
+ *         messages that describe it, rebuilding them only when it changes.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "obstacle_simulator.hpp"
+
+ObstacleSimulator::ObstacleSimulator(const std::string& _marker_frame, const std::string& _obstacle_frame)
+{
+    this->marker_frame          = _marker_frame;
+    this->obstacle_frame        = _obstacle_frame;
+    this->published_revision    = this->world.revision;
+}
+
+ObstacleSimulator::~ObstacleSimulator(){}
+
+bool ObstacleSimulator::LoadScenario(const std::string& _path)
+{
+    if (!this->world.LoadScenario(_path))
+    {
+        ROS_WARN("Could not open scenario file %s", _path.c_str());
+        return false;
+    }
+
+    if (this->world.malformed_lines > 0)
+    {
+        ROS_WARN("Scenario %s: skipped %u malformed lines", _path.c_str(), this->world.malformed_lines);
+    }
+
+    ROS_INFO("Scenario %s: loaded %lu obstacles", _path.c_str(), (unsigned long) this->world.obstacles.size());
+
+    return true;
+}
+
+void ObstacleSimulator::OnScenarioReception(const std_msgs::String& _path)
+{
+    this->LoadScenario(_path.data);
+}
+
+bool ObstacleSimulator::UpdateMessages()
+{
+    if (this->world.revision == this->published_revision)
+    {
+        return false;
+    }
+
+    this->world.FillMarkers(this->marker_array, this->marker_frame);
+    this->world.FillObstacleList(this->obstacle_list, this->obstacle_frame);
+    this->published_revision = this->world.revision;
+
+    return true;
+}
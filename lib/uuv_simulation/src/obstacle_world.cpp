@@ -0,0 +1,305 @@
+/** ----------------------------------------------------------------------------
+ * @file: obstacle_world.cpp
+ *
+ * @brief: Simulated obstacle world. Obstacles are loaded from a scenario file
+ *         into a contiguous store and converted to RViz markers and obstacle
+ *         lists for the rest of the system.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "obstacle_world.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+ObstacleWorld::ObstacleWorld()
+{
+    this->revision          = 0;
+    this->malformed_lines   = 0;
+}
+
+ObstacleWorld::~ObstacleWorld(){}
+
+bool ObstacleWorld::LoadScenario(const std::string& _path)
+{
+    std::ifstream file(_path.c_str());
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    this->obstacles.clear();
+    this->malformed_lines = 0;
+
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        if (!this->ParseLine(line))
+        {
+            this->malformed_lines++;
+        }
+    }
+
+    this->revision++;
+
+    return true;
+}
+
+void ObstacleWorld::AddObstacle(const Obstacle_S& _obstacle)
+{
+    this->obstacles.push_back(_obstacle);
+    this->revision++;
+}
+
+void ObstacleWorld::Clear()
+{
+    this->obstacles.clear();
+    this->revision++;
+}
+
+float ObstacleWorld::BoundingRadius(const Obstacle_S& _obstacle)
+{
+    if (_obstacle.obstacle_class == OBSTACLE_WALL)
+    {
+        return std::sqrt(_obstacle.length * _obstacle.length / 4 + _obstacle.radius * _obstacle.radius);
+    }
+
+    return _obstacle.radius;
+}
+
+const char* ObstacleWorld::ClassName(ObstacleClass_E _class)
+{
+    switch (_class)
+    {
+        case OBSTACLE_BUOY:
+            return "buoy";
+        case OBSTACLE_GATE:
+            return "gate";
+        case OBSTACLE_WALL:
+            return "wall";
+        default:
+            return "unknown";
+    }
+}
+
+ObstacleClass_E ObstacleWorld::ClassFromName(const std::string& _name)
+{
+    if (_name == "gate")
+    {
+        return OBSTACLE_GATE;
+    }
+    else if (_name == "wall")
+    {
+        return OBSTACLE_WALL;
+    }
+
+    return OBSTACLE_BUOY;
+}
+
+void ObstacleWorld::LoadObstacleList(const vanttec_uuv::ObstacleList& _list)
+{
+    this->obstacles.resize(_list.obstacles.size());
+
+    for (size_t i = 0; i < _list.obstacles.size(); i++)
+    {
+        const vanttec_uuv::Obstacle& input = _list.obstacles[i];
+        Obstacle_S& obstacle = this->obstacles[i];
+
+        obstacle.obstacle_class = ObstacleWorld::ClassFromName(input.obstacle_class);
+        obstacle.x              = input.pose.position.x;
+        obstacle.y              = input.pose.position.y;
+        obstacle.z              = input.pose.position.z;
+        obstacle.radius         = input.radio;
+        obstacle.height         = input.height;
+        obstacle.length         = input.length;
+        obstacle.yaw            = 2 * std::atan2(input.pose.orientation.z, input.pose.orientation.w);
+    }
+
+    this->revision++;
+}
+
+void ObstacleWorld::FillMarkers(visualization_msgs::MarkerArray& _markers, const std::string& _frame) const
+{
+    _markers.markers.clear();
+    _markers.markers.reserve(this->obstacles.size() + 1);
+
+    /* Remove whatever the previous world left in RViz */
+    visualization_msgs::Marker clear_marker;
+    clear_marker.header.frame_id    = _frame;
+    clear_marker.action             = visualization_msgs::Marker::DELETEALL;
+    _markers.markers.push_back(clear_marker);
+
+    for (size_t i = 0; i < this->obstacles.size(); i++)
+    {
+        const Obstacle_S& obstacle = this->obstacles[i];
+        visualization_msgs::Marker marker;
+
+        /* RViz uses the world frame of the tf broadcaster: y and z are flipped from NED */
+        marker.header.frame_id      = _frame;
+        marker.header.stamp         = ros::Time();
+        marker.ns                   = ObstacleWorld::ClassName(obstacle.obstacle_class);
+        marker.id                   = i;
+        marker.action               = visualization_msgs::Marker::ADD;
+        marker.pose.position.x      = obstacle.x;
+        marker.pose.position.y      = -obstacle.y;
+        marker.pose.position.z      = -obstacle.z;
+        marker.pose.orientation.x   = 0.0;
+        marker.pose.orientation.y   = 0.0;
+        marker.pose.orientation.z   = std::sin(-obstacle.yaw / 2);
+        marker.pose.orientation.w   = std::cos(-obstacle.yaw / 2);
+        marker.color.a              = 1.0;
+
+        switch (obstacle.obstacle_class)
+        {
+            case OBSTACLE_WALL:
+                marker.type     = visualization_msgs::Marker::CUBE;
+                marker.scale.x  = obstacle.length;
+                marker.scale.y  = 2 * obstacle.radius;
+                marker.scale.z  = obstacle.height;
+                marker.color.r  = 0.5;
+                marker.color.g  = 0.5;
+                marker.color.b  = 0.5;
+                break;
+            case OBSTACLE_GATE:
+                marker.type     = visualization_msgs::Marker::CYLINDER;
+                marker.scale.x  = 2 * obstacle.radius;
+                marker.scale.y  = 2 * obstacle.radius;
+                marker.scale.z  = obstacle.height;
+                marker.color.r  = 0.0;
+                marker.color.g  = 1.0;
+                marker.color.b  = 0.0;
+                break;
+            case OBSTACLE_BUOY:
+            default:
+                marker.type     = visualization_msgs::Marker::CYLINDER;
+                marker.scale.x  = 2 * obstacle.radius;
+                marker.scale.y  = 2 * obstacle.radius;
+                marker.scale.z  = obstacle.height;
+                marker.color.r  = 1.0;
+                marker.color.g  = 0.5;
+                marker.color.b  = 0.0;
+                break;
+        }
+
+        _markers.markers.push_back(marker);
+    }
+}
+
+void ObstacleWorld::FillObstacleList(vanttec_uuv::ObstacleList& _list, const std::string& _frame) const
+{
+    _list.header.stamp      = ros::Time::now();
+    _list.header.frame_id   = _frame;
+    _list.obstacles.resize(this->obstacles.size());
+
+    for (size_t i = 0; i < this->obstacles.size(); i++)
+    {
+        const Obstacle_S& obstacle = this->obstacles[i];
+        vanttec_uuv::Obstacle& output = _list.obstacles[i];
+
+        output.header               = _list.header;
+        output.obstacle_class       = ObstacleWorld::ClassName(obstacle.obstacle_class);
+        output.pose.position.x      = obstacle.x;
+        output.pose.position.y      = obstacle.y;
+        output.pose.position.z      = obstacle.z;
+        output.pose.orientation.x   = 0;
+        output.pose.orientation.y   = 0;
+        output.pose.orientation.z   = std::sin(obstacle.yaw / 2);
+        output.pose.orientation.w   = std::cos(obstacle.yaw / 2);
+        output.radio                = obstacle.radius;
+        output.height               = obstacle.height;
+        output.length               = obstacle.length;
+    }
+}
+
+bool ObstacleWorld::ParseLine(const std::string& _line)
+{
+    /* Comments may also follow the values */
+    std::istringstream stream(_line.substr(0, _line.find('#')));
+    std::string type;
+
+    if (!(stream >> type))
+    {
+        return true;
+    }
+
+    Obstacle_S obstacle;
+    obstacle.length = 0;
+    obstacle.yaw    = 0;
+
+    float width = 0;
+    int posts = 2;
+
+    if (!(stream >> obstacle.x >> obstacle.y >> obstacle.z >> obstacle.radius >> obstacle.height))
+    {
+        return false;
+    }
+
+    if (type == "buoy")
+    {
+        obstacle.obstacle_class = OBSTACLE_BUOY;
+    }
+    else if (type == "wall")
+    {
+        if (!(stream >> obstacle.length >> obstacle.yaw))
+        {
+            return false;
+        }
+
+        /* Walls are given by their thickness */
+        obstacle.obstacle_class = OBSTACLE_WALL;
+        obstacle.radius         = obstacle.radius / 2;
+    }
+    else if (type == "gate")
+    {
+        if (!(stream >> width >> obstacle.yaw))
+        {
+            return false;
+        }
+
+        /* The post count is optional */
+        if (!(stream >> std::ws).eof() && !(stream >> posts))
+        {
+            return false;
+        }
+
+        if (posts < 2)
+        {
+            return false;
+        }
+
+        obstacle.obstacle_class = OBSTACLE_GATE;
+    }
+    else
+    {
+        return false;
+    }
+
+    /* Trailing values are a typo, not something to ignore */
+    if (!(stream >> std::ws).eof())
+    {
+        return false;
+    }
+
+    if (obstacle.obstacle_class != OBSTACLE_GATE)
+    {
+        this->obstacles.push_back(obstacle);
+        return true;
+    }
+
+    /* Posts are spread along the gate's y axis, centered on the given position */
+    Obstacle_S post = obstacle;
+
+    for (int i = 0; i < posts; i++)
+    {
+        float offset = -width / 2 + width * i / (posts - 1);
+
+        post.x = obstacle.x - offset * std::sin(obstacle.yaw);
+        post.y = obstacle.y + offset * std::cos(obstacle.yaw);
+        this->obstacles.push_back(post);
+    }
+
+    return true;
+}
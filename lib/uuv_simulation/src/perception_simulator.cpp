@@ -0,0 +1,183 @@
+/** ----------------------------------------------------------------------------
+ * @file: perception_simulator.cpp
+ * 
+ * @brief: Simulated perception. Queries the obstacle world around the vehicle
+ *         through a uniform grid, keeps the obstacles inside the sensor range
+ *         and field of view, and reports them in the body frame with noise and
+ *         random dropouts.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "perception_simulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+PerceptionSimulator::PerceptionSimulator(const SensorModel_S& _sensor, const std::string& _body_frame, float _cell_size_m, uint32_t _seed)
+    : grid(_cell_size_m), generator(_seed), normal(0.0, 1.0), uniform(0.0, 1.0)
+{
+    this->sensor            = _sensor;
+    this->body_frame        = _body_frame;
+    this->ned_x             = 0;
+    this->ned_y             = 0;
+    this->ned_z             = 0;
+    this->yaw               = 0;
+    this->state_received    = false;
+    this->candidate_count   = 0;
+}
+
+PerceptionSimulator::~PerceptionSimulator(){}
+
+void PerceptionSimulator::OnWorldReception(const vanttec_uuv::ObstacleList& _list)
+{
+    this->world.LoadObstacleList(_list);
+    this->grid.Build(this->world.obstacles);
+    this->candidates.reserve(this->world.obstacles.size());
+    this->detections.obstacles.reserve(this->world.obstacles.size());
+}
+
+void PerceptionSimulator::OnStateReception(const vanttec_uuv::VehicleState& _state)
+{
+    this->ned_x             = _state.x;
+    this->ned_y             = _state.y;
+    this->ned_z             = _state.z;
+    this->yaw               = _state.yaw;
+    this->state_received    = true;
+}
+
+void PerceptionSimulator::ned_to_body(float ned_x2, float ned_y2, float* x2, float* y2)
+{
+    Eigen::Vector2d ned(ned_x2 - this->ned_x, ned_y2 - this->ned_y);
+    Eigen::Vector2d body = this->rotation_matrix(this->yaw).transpose() * ned;
+
+    *x2 = body(0);
+    *y2 = body(1);
+}
+
+Eigen::Matrix2d PerceptionSimulator::rotation_matrix(float angle)
+{
+    Eigen::Matrix2d a;
+
+    a << std::cos(angle), -1*std::sin(angle),
+         std::sin(angle), std::cos(angle);
+
+    return a;
+}
+
+void PerceptionSimulator::SectorBounds(float* _min_x, float* _min_y, float* _max_x, float* _max_y)
+{
+    float half_fov = this->sensor.horizontal_fov_rad / 2;
+    float range    = this->sensor.max_range_m;
+
+    /* Box around the vehicle, the two edges of the sector and every axis
+       direction the sector sweeps over */
+    *_min_x = this->ned_x;
+    *_max_x = this->ned_x;
+    *_min_y = this->ned_y;
+    *_max_y = this->ned_y;
+
+    float angles[6] = {this->yaw - half_fov, this->yaw + half_fov, 0, M_PI / 2, M_PI, -M_PI / 2};
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (i >= 2)
+        {
+            float difference = std::remainder(angles[i] - this->yaw, 2 * M_PI);
+
+            if (std::fabs(difference) > half_fov)
+            {
+                continue;
+            }
+        }
+
+        float x = this->ned_x + range * std::cos(angles[i]);
+        float y = this->ned_y + range * std::sin(angles[i]);
+
+        *_min_x = std::min(*_min_x, x);
+        *_max_x = std::max(*_max_x, x);
+        *_min_y = std::min(*_min_y, y);
+        *_max_y = std::max(*_max_y, y);
+    }
+}
+
+void PerceptionSimulator::Iteration()
+{
+    this->detections.header.stamp       = ros::Time::now();
+    this->detections.header.frame_id    = this->body_frame;
+    this->detections.obstacles.clear();
+
+    if (!this->state_received)
+    {
+        this->candidate_count = 0;
+        return;
+    }
+
+    float min_x, min_y, max_x, max_y;
+    this->SectorBounds(&min_x, &min_y, &max_x, &max_y);
+
+    this->candidates.clear();
+    this->grid.Query(min_x, min_y, max_x, max_y, this->candidates);
+    this->candidate_count = this->candidates.size();
+
+    for (size_t i = 0; i < this->candidates.size(); i++)
+    {
+        const Obstacle_S& obstacle = this->world.obstacles[this->candidates[i]];
+
+        float body_x, body_y;
+        this->ned_to_body(obstacle.x, obstacle.y, &body_x, &body_y);
+        float body_z = obstacle.z - this->ned_z;
+
+        /* Range and field of view, widened by the apparent size of the obstacle */
+        float radius        = ObstacleWorld::BoundingRadius(obstacle);
+        float horizontal    = std::sqrt(body_x * body_x + body_y * body_y);
+        float range         = std::sqrt(horizontal * horizontal + body_z * body_z);
+
+        if (range - radius > this->sensor.max_range_m || range + radius < this->sensor.min_range_m)
+        {
+            continue;
+        }
+
+        if (horizontal > radius)
+        {
+            float bearing       = std::atan2(body_y, body_x);
+            float half_width    = std::asin(radius / horizontal);
+
+            if (std::fabs(bearing) > this->sensor.horizontal_fov_rad / 2 + half_width)
+            {
+                continue;
+            }
+
+            float elevation     = std::atan2(body_z, horizontal);
+            float half_height   = std::atan2(obstacle.height / 2, horizontal);
+
+            if (std::fabs(elevation) > this->sensor.vertical_fov_rad / 2 + half_height)
+            {
+                continue;
+            }
+        }
+
+        if (this->uniform(this->generator) < this->sensor.dropout_probability)
+        {
+            continue;
+        }
+
+        float noise_m = this->sensor.position_noise_m + this->sensor.range_noise_ratio * range;
+        float relative_yaw = obstacle.yaw - this->yaw;
+
+        vanttec_uuv::Obstacle detection;
+        detection.header                = this->detections.header;
+        detection.obstacle_class        = ObstacleWorld::ClassName(obstacle.obstacle_class);
+        detection.pose.position.x       = body_x + noise_m * this->normal(this->generator);
+        detection.pose.position.y       = body_y + noise_m * this->normal(this->generator);
+        detection.pose.position.z       = body_z + noise_m * this->normal(this->generator);
+        detection.pose.orientation.x    = 0;
+        detection.pose.orientation.y    = 0;
+        detection.pose.orientation.z    = std::sin(relative_yaw / 2);
+        detection.pose.orientation.w    = std::cos(relative_yaw / 2);
+        detection.radio                 = obstacle.radius;
+        detection.height                = obstacle.height;
+        detection.length                = obstacle.length;
+
+        this->detections.obstacles.push_back(detection);
+    }
+}
@@ -0,0 +1,148 @@
+/** ----------------------------------------------------------------------------
+ * @file: seabed_map.cpp
+ * 
+ * @brief: Seabed height map. Depths (positive down, NED) on a regular grid,
+ *         bilinearly interpolated, with a constant depth outside the grid.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "seabed_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+static const int REFINE_ITERATIONS = 10;
+
+SeabedMap::SeabedMap(float _default_depth_m)
+{
+    this->default_depth_m   = _default_depth_m;
+    this->origin_x          = 0;
+    this->origin_y          = 0;
+    this->resolution_m      = 1;
+    this->cols              = 0;
+    this->rows              = 0;
+}
+
+SeabedMap::~SeabedMap(){}
+
+bool SeabedMap::Load(const std::string& _path)
+{
+    std::ifstream file(_path.c_str());
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    int cols, rows;
+
+    if (!(file >> this->origin_x >> this->origin_y >> this->resolution_m >> cols >> rows) ||
+        cols < 2 || rows < 2 || this->resolution_m <= 0)
+    {
+        return false;
+    }
+
+    std::vector<float> depths(cols * rows);
+
+    for (size_t i = 0; i < depths.size(); i++)
+    {
+        if (!(file >> depths[i]))
+        {
+            return false;
+        }
+    }
+
+    this->cols = cols;
+    this->rows = rows;
+    this->depths.swap(depths);
+
+    return true;
+}
+
+float SeabedMap::Depth(float _x, float _y) const
+{
+    float u = (_x - this->origin_x) / this->resolution_m;
+    float v = (_y - this->origin_y) / this->resolution_m;
+
+    if (this->cols == 0 || u < 0 || v < 0 || u > this->cols - 1 || v > this->rows - 1)
+    {
+        return this->default_depth_m;
+    }
+
+    int col = std::min(int(u), this->cols - 2);
+    int row = std::min(int(v), this->rows - 2);
+    float du = u - col;
+    float dv = v - row;
+
+    const float* sample = &this->depths[row * this->cols + col];
+
+    return (1 - dv) * ((1 - du) * sample[0] + du * sample[1])
+           + dv * ((1 - du) * sample[this->cols] + du * sample[this->cols + 1]);
+}
+
+bool SeabedMap::Intersect(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _direction, float _max_range, float* _range) const
+{
+    /* Flat bottom, closed form */
+    if (this->cols == 0)
+    {
+        if (_direction(2) <= 0)
+        {
+            return false;
+        }
+
+        float range = (this->default_depth_m - _origin(2)) / _direction(2);
+
+        if (range < 0 || range > _max_range)
+        {
+            return false;
+        }
+
+        *_range = range;
+        return true;
+    }
+
+    /* March at half a cell and refine the first crossing by bisection */
+    float step      = this->resolution_m / 2;
+    float previous  = 0;
+
+    if (_origin(2) >= this->Depth(_origin(0), _origin(1)))
+    {
+        *_range = 0;
+        return true;
+    }
+
+    for (float range = step; previous < _max_range; range += step)
+    {
+        range = std::min(range, _max_range);
+        Eigen::Vector3f point = _origin + range * _direction;
+
+        if (point(2) >= this->Depth(point(0), point(1)))
+        {
+            float low   = previous;
+            float high  = range;
+
+            for (int i = 0; i < REFINE_ITERATIONS; i++)
+            {
+                float middle = (low + high) / 2;
+                Eigen::Vector3f probe = _origin + middle * _direction;
+
+                if (probe(2) >= this->Depth(probe(0), probe(1)))
+                {
+                    high = middle;
+                }
+                else
+                {
+                    low = middle;
+                }
+            }
+
+            *_range = high;
+            return true;
+        }
+
+        previous = range;
+    }
+
+    return false;
+}
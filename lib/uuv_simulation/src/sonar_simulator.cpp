@@ -0,0 +1,413 @@
+/** ----------------------------------------------------------------------------
+ * @file: sonar_simulator.cpp
+ * 
+ * @brief: Ray casting sonar simulator. Every scan casts one ray per beam
+ *         against the obstacle world and the seabed. Obstacles near the fan
+ *         are fetched once per scan from the uniform grid, and the beams are
+ *         split between a fixed set of worker threads.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "sonar_simulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+/* Distance along a unit direction to a vertical cylinder centered at _center */
+static bool IntersectCylinder(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _direction,
+                              const Eigen::Vector3f& _center, float _radius, float _height, float* _range)
+{
+    Eigen::Vector3f offset = _origin - _center;
+    float half_height = _height / 2;
+    float best = std::numeric_limits<float>::infinity();
+
+    /* Side */
+    float a = _direction(0) * _direction(0) + _direction(1) * _direction(1);
+    float b = offset(0) * _direction(0) + offset(1) * _direction(1);
+    float c = offset(0) * offset(0) + offset(1) * offset(1) - _radius * _radius;
+
+    if (a > 1e-9)
+    {
+        float discriminant = b * b - a * c;
+
+        if (discriminant >= 0)
+        {
+            float root = std::sqrt(discriminant);
+            float t0 = (-b - root) / a;
+            float t1 = (-b + root) / a;
+            float t = (t0 >= 0) ? t0 : t1;
+
+            if (t >= 0 && std::fabs(offset(2) + t * _direction(2)) <= half_height)
+            {
+                best = t;
+            }
+        }
+    }
+
+    /* Caps */
+    if (std::fabs(_direction(2)) > 1e-9)
+    {
+        for (int side = -1; side <= 1; side += 2)
+        {
+            float t = (side * half_height - offset(2)) / _direction(2);
+            float x = offset(0) + t * _direction(0);
+            float y = offset(1) + t * _direction(1);
+
+            if (t >= 0 && t < best && x * x + y * y <= _radius * _radius)
+            {
+                best = t;
+            }
+        }
+    }
+
+    if (best == std::numeric_limits<float>::infinity())
+    {
+        return false;
+    }
+
+    *_range = best;
+    return true;
+}
+
+/* Slab test against a box rotated by _yaw around the vertical axis */
+static bool IntersectBox(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _direction,
+                         const Eigen::Vector3f& _center, const Eigen::Vector3f& _half_size, float _yaw, float* _range)
+{
+    float c = std::cos(_yaw);
+    float s = std::sin(_yaw);
+
+    Eigen::Vector3f offset = _origin - _center;
+    Eigen::Vector3f origin(c * offset(0) + s * offset(1), -s * offset(0) + c * offset(1), offset(2));
+    Eigen::Vector3f direction(c * _direction(0) + s * _direction(1), -s * _direction(0) + c * _direction(1), _direction(2));
+
+    float t_near = -std::numeric_limits<float>::infinity();
+    float t_far = std::numeric_limits<float>::infinity();
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (std::fabs(direction(i)) < 1e-9)
+        {
+            if (std::fabs(origin(i)) > _half_size(i))
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        float t0 = (-_half_size(i) - origin(i)) / direction(i);
+        float t1 = (_half_size(i) - origin(i)) / direction(i);
+
+        t_near = std::max(t_near, std::min(t0, t1));
+        t_far = std::min(t_far, std::max(t0, t1));
+    }
+
+    if (t_near > t_far || t_far < 0)
+    {
+        return false;
+    }
+
+    *_range = std::max(t_near, 0.0f);
+    return true;
+}
+
+SonarSimulator::SonarSimulator(const SonarModel_S& _sonar, const std::string& _body_frame, float _cell_size_m,
+                               float _seabed_depth_m, int _thread_count, uint32_t _seed)
+    : seabed(_seabed_depth_m), grid(_cell_size_m)
+{
+    this->sonar             = _sonar;
+    this->body_frame        = _body_frame;
+    this->state_received    = false;
+    this->candidate_count   = 0;
+    this->thread_count      = std::max(1, _thread_count);
+    this->work_generation   = 0;
+    this->pending_workers   = 0;
+    this->stopping          = false;
+    this->ned_position.setZero();
+    this->body_to_ned.setIdentity();
+
+    /* Beam directions never change in the body frame */
+    int beams = std::max(1, this->sonar.beam_count);
+    float increment = (beams > 1) ? this->sonar.fan_angle_rad / (beams - 1) : 0;
+    float start = (beams > 1) ? -this->sonar.fan_angle_rad / 2 : 0;
+    float ct = std::cos(this->sonar.tilt_rad);
+    float st = std::sin(this->sonar.tilt_rad);
+
+    this->body_directions.resize(beams);
+    this->ned_directions.resize(beams);
+    this->hit_ranges.resize(beams);
+
+    for (int i = 0; i < beams; i++)
+    {
+        float angle = start + increment * i;
+
+        if (this->sonar.sonar_type == SONAR_MULTIBEAM)
+        {
+            this->body_directions[i] << std::cos(angle) * st, std::sin(angle), std::cos(angle) * ct;
+        }
+        else
+        {
+            this->body_directions[i] << ct * std::cos(angle), ct * std::sin(angle), st;
+        }
+    }
+
+    this->scan.header.frame_id  = this->body_frame;
+    this->scan.angle_min        = start;
+    this->scan.angle_max        = start + increment * (beams - 1);
+    this->scan.angle_increment  = increment;
+    this->scan.time_increment   = 0;
+    this->scan.range_min        = this->sonar.min_range_m;
+    this->scan.range_max        = this->sonar.max_range_m;
+    this->scan.ranges.resize(beams);
+
+    const char* field_names[3] = {"x", "y", "z"};
+
+    this->cloud.header.frame_id = this->body_frame;
+    this->cloud.height          = 1;
+    this->cloud.is_bigendian    = false;
+    this->cloud.is_dense        = true;
+    this->cloud.point_step      = 3 * sizeof(float);
+    this->cloud.fields.resize(3);
+
+    for (int i = 0; i < 3; i++)
+    {
+        this->cloud.fields[i].name      = field_names[i];
+        this->cloud.fields[i].offset    = i * sizeof(float);
+        this->cloud.fields[i].datatype  = sensor_msgs::PointField::FLOAT32;
+        this->cloud.fields[i].count     = 1;
+    }
+
+    this->cloud.data.reserve(beams * this->cloud.point_step);
+
+    for (int i = 0; i < this->thread_count; i++)
+    {
+        this->generators.push_back(std::mt19937(_seed + i));
+    }
+
+    for (int i = 1; i < this->thread_count; i++)
+    {
+        this->workers.push_back(std::thread(&SonarSimulator::WorkerLoop, this, i));
+    }
+}
+
+SonarSimulator::~SonarSimulator()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->work_mutex);
+        this->stopping = true;
+    }
+
+    this->work_ready.notify_all();
+
+    for (size_t i = 0; i < this->workers.size(); i++)
+    {
+        this->workers[i].join();
+    }
+}
+
+void SonarSimulator::OnWorldReception(const vanttec_uuv::ObstacleList& _list)
+{
+    this->world.LoadObstacleList(_list);
+    this->grid.Build(this->world.obstacles);
+    this->candidates.reserve(this->world.obstacles.size());
+}
+
+void SonarSimulator::OnStateReception(const vanttec_uuv::VehicleState& _state)
+{
+    this->ned_position << _state.x, _state.y, _state.z;
+    this->body_to_ned = (Eigen::AngleAxisf(_state.yaw, Eigen::Vector3f::UnitZ())
+                         * Eigen::AngleAxisf(_state.pitch, Eigen::Vector3f::UnitY())
+                         * Eigen::AngleAxisf(_state.roll, Eigen::Vector3f::UnitX())).toRotationMatrix();
+    this->state_received = true;
+}
+
+float SonarSimulator::CastRay(const Eigen::Vector3f& _direction) const
+{
+    float nearest = this->sonar.max_range_m;
+    float range;
+    bool hit = false;
+
+    if (this->seabed.Intersect(this->ned_position, _direction, nearest, &range))
+    {
+        nearest = range;
+        hit = true;
+    }
+
+    for (size_t i = 0; i < this->candidates.size(); i++)
+    {
+        const Obstacle_S& obstacle = this->world.obstacles[this->candidates[i]];
+        Eigen::Vector3f center(obstacle.x, obstacle.y, obstacle.z);
+        bool intersects;
+
+        if (obstacle.obstacle_class == OBSTACLE_WALL)
+        {
+            Eigen::Vector3f half_size(obstacle.length / 2, obstacle.radius, obstacle.height / 2);
+            intersects = IntersectBox(this->ned_position, _direction, center, half_size, obstacle.yaw, &range);
+        }
+        else
+        {
+            intersects = IntersectCylinder(this->ned_position, _direction, center, obstacle.radius, obstacle.height, &range);
+        }
+
+        if (intersects && range < nearest)
+        {
+            nearest = range;
+            hit = true;
+        }
+    }
+
+    if (!hit || nearest < this->sonar.min_range_m)
+    {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    return nearest;
+}
+
+void SonarSimulator::CastBeams(int _worker)
+{
+    /* Contiguous slice of beams for each worker */
+    int beams = this->ned_directions.size();
+    int begin = beams * _worker / this->thread_count;
+    int end = beams * (_worker + 1) / this->thread_count;
+
+    std::normal_distribution<float> noise(0.0, this->sonar.range_noise_m);
+    std::mt19937& generator = this->generators[_worker];
+
+    for (int i = begin; i < end; i++)
+    {
+        float range = this->CastRay(this->ned_directions[i]);
+
+        if (std::isfinite(range) && this->sonar.range_noise_m > 0)
+        {
+            range = std::min(std::max(range + noise(generator), this->sonar.min_range_m), this->sonar.max_range_m);
+        }
+
+        this->hit_ranges[i] = range;
+    }
+}
+
+void SonarSimulator::WorkerLoop(int _worker)
+{
+    uint32_t seen_generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->work_mutex);
+
+            while (!this->stopping && this->work_generation == seen_generation)
+            {
+                this->work_ready.wait(lock);
+            }
+
+            if (this->stopping)
+            {
+                return;
+            }
+
+            seen_generation = this->work_generation;
+        }
+
+        this->CastBeams(_worker);
+
+        {
+            std::lock_guard<std::mutex> lock(this->work_mutex);
+            this->pending_workers--;
+        }
+
+        this->work_done.notify_one();
+    }
+}
+
+void SonarSimulator::Iteration()
+{
+    ros::Time stamp = ros::Time::now();
+
+    this->scan.header.stamp     = stamp;
+    this->cloud.header.stamp    = stamp;
+
+    if (!this->state_received)
+    {
+        std::fill(this->hit_ranges.begin(), this->hit_ranges.end(), std::numeric_limits<float>::infinity());
+        this->FillMessages();
+        return;
+    }
+
+    /* Rotate the beams and bound the fan for the grid query */
+    float min_x = this->ned_position(0);
+    float max_x = min_x;
+    float min_y = this->ned_position(1);
+    float max_y = min_y;
+
+    for (size_t i = 0; i < this->body_directions.size(); i++)
+    {
+        this->ned_directions[i] = this->body_to_ned * this->body_directions[i];
+        Eigen::Vector3f end = this->ned_position + this->sonar.max_range_m * this->ned_directions[i];
+
+        min_x = std::min(min_x, end(0));
+        max_x = std::max(max_x, end(0));
+        min_y = std::min(min_y, end(1));
+        max_y = std::max(max_y, end(1));
+    }
+
+    /* The arc between two beam ends bulges out of the box by at most this */
+    float margin = this->sonar.max_range_m * (1 - std::cos(this->scan.angle_increment / 2));
+
+    this->candidates.clear();
+    this->grid.Query(min_x - margin, min_y - margin, max_x + margin, max_y + margin, this->candidates);
+    this->candidate_count = this->candidates.size();
+
+    /* Hand the slices out and do the first one here */
+    if (this->thread_count > 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->work_mutex);
+            this->pending_workers = this->thread_count - 1;
+            this->work_generation++;
+        }
+
+        this->work_ready.notify_all();
+    }
+
+    this->CastBeams(0);
+
+    if (this->thread_count > 1)
+    {
+        std::unique_lock<std::mutex> lock(this->work_mutex);
+
+        while (this->pending_workers > 0)
+        {
+            this->work_done.wait(lock);
+        }
+    }
+
+    this->FillMessages();
+}
+
+void SonarSimulator::FillMessages()
+{
+    this->cloud.data.clear();
+
+    for (size_t i = 0; i < this->hit_ranges.size(); i++)
+    {
+        float range = this->hit_ranges[i];
+        this->scan.ranges[i] = range;
+
+        if (!std::isfinite(range))
+        {
+            continue;
+        }
+
+        Eigen::Vector3f point = range * this->body_directions[i];
+        size_t offset = this->cloud.data.size();
+
+        this->cloud.data.resize(offset + this->cloud.point_step);
+        std::memcpy(&this->cloud.data[offset], point.data(), this->cloud.point_step);
+    }
+
+    this->cloud.width       = this->cloud.data.size() / this->cloud.point_step;
+    this->cloud.row_step    = this->cloud.data.size();
+}
@@ -0,0 +1,326 @@
+/** ----------------------------------------------------------------------------
+ * @file: system_identification.cpp
+ *
+ * @brief: Estimates the hydrodynamic coefficients of the 4-DOF model from
+ *         logged thrust, velocities and accelerations.
+ * -----------------------------------------------------------------------------
+ * */
+
+#include "system_identification.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+/* Columns of the coefficients, in the order of SYSID_COEFFICIENTS */
+enum
+{
+    SYSID_X_U_DOT = 0,
+    SYSID_Y_V_DOT,
+    SYSID_Z_W_DOT,
+    SYSID_N_R_DOT,
+    SYSID_X_U,
+    SYSID_X_UU,
+    SYSID_Y_V,
+    SYSID_Y_VV,
+    SYSID_Z_W,
+    SYSID_Z_WW,
+    SYSID_N_R,
+    SYSID_N_RR,
+    SYSID_OBSERVATION,
+};
+
+typedef struct SysIdCoefficient_S
+{
+    const char*                 name;
+    float VehicleParameters::*  value;
+} SysIdCoefficient_S;
+
+static const SysIdCoefficient_S SYSID_COEFFICIENT_FIELDS[SYSID_COEFFICIENTS] =
+{
+    {"X_u_dot",     &VehicleParameters::X_u_dot},
+    {"Y_v_dot",     &VehicleParameters::Y_v_dot},
+    {"Z_w_dot",     &VehicleParameters::Z_w_dot},
+    {"N_r_dot",     &VehicleParameters::N_r_dot},
+    {"X_u",         &VehicleParameters::X_u},
+    {"X_uu",        &VehicleParameters::X_uu},
+    {"Y_v",         &VehicleParameters::Y_v},
+    {"Y_vv",        &VehicleParameters::Y_vv},
+    {"Z_w",         &VehicleParameters::Z_w},
+    {"Z_ww",        &VehicleParameters::Z_ww},
+    {"N_r",         &VehicleParameters::N_r},
+    {"N_rr",        &VehicleParameters::N_rr},
+};
+
+/* A coefficient is not excited when its column is this small per sample, in (m/s^2)^2 */
+static const double SYSID_MIN_EXCITATION = 1e-12;
+
+SystemIdentification::SystemIdentification(const VehicleParameters& _vehicle) : vehicle(_vehicle)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        this->rms_residual[i] = 0;
+    }
+
+    for (size_t i = 0; i < SYSID_COEFFICIENTS; i++)
+    {
+        this->estimated[i] = false;
+    }
+}
+
+SystemIdentification::~SystemIdentification(){}
+
+const char* SystemIdentification::CoefficientName(size_t _index)
+{
+    return _index < SYSID_COEFFICIENTS ? SYSID_COEFFICIENT_FIELDS[_index].name : "";
+}
+
+float SystemIdentification::Coefficient(const VehicleParameters& _vehicle, size_t _index)
+{
+    return _index < SYSID_COEFFICIENTS ? _vehicle.*SYSID_COEFFICIENT_FIELDS[_index].value : 0;
+}
+
+size_t SystemIdentification::AddLog(TelemetryReader& _reader)
+{
+    const TelemetryRecord_S* record;
+    TelemetryState_S previous = TelemetryState_S();
+    bool have_previous = false;
+    bool have_thrust = false;
+    SysIdSample_S sample;
+    size_t added = 0;
+
+    while ((record = _reader.Next()) != NULL)
+    {
+        if (record->type == TELEMETRY_THRUST)
+        {
+            sample.tau[0] = record->thrust.tau_x;
+            sample.tau[1] = record->thrust.tau_y;
+            sample.tau[2] = record->thrust.tau_z;
+            sample.tau[3] = record->thrust.tau_yaw;
+            have_thrust = true;
+        }
+        else if (record->type == TELEMETRY_STATE)
+        {
+            const TelemetryState_S& state = record->state;
+
+            /* The accelerations of a state come from the velocities of the one before */
+            if (have_previous && have_thrust && state.sequence == previous.sequence + 1)
+            {
+                sample.upsilon[0]       = previous.u;
+                sample.upsilon[1]       = previous.v;
+                sample.upsilon[2]       = previous.w;
+                sample.upsilon[3]       = previous.r;
+                sample.upsilon_dot[0]   = state.u_dot;
+                sample.upsilon_dot[1]   = state.v_dot;
+                sample.upsilon_dot[2]   = state.w_dot;
+                sample.upsilon_dot[3]   = state.r_dot;
+
+                this->samples.push_back(sample);
+                added++;
+            }
+
+            previous = state;
+            have_previous = true;
+        }
+    }
+
+    return added;
+}
+
+void SystemIdentification::Accumulate(size_t _first, size_t _last, Normal* _normals) const
+{
+    const VehicleParameters& base = this->vehicle;
+
+    float net_weight = base.weight - base.buoyancy;
+    double restoring[4] = {net_weight * std::sin(base.theta_b),
+                           -net_weight * std::cos(base.theta_b) * std::sin(base.phi_b),
+                           -net_weight * std::cos(base.theta_b) * std::cos(base.phi_b),
+                           0};
+
+    /* Base effective mass of each axis, so every equation is in accelerations */
+    double weight[4] = {1.0 / (base.mass - base.X_u_dot),
+                        1.0 / (base.mass - base.Y_v_dot),
+                        1.0 / (base.mass - base.Z_w_dot),
+                        1.0 / (base.Izz - base.N_r_dot)};
+
+    double m = base.mass;
+    double I = base.Izz;
+
+    for (size_t axis = 0; axis < 4; axis++)
+    {
+        _normals[axis].setZero();
+    }
+
+    Eigen::Matrix<double, SYSID_COEFFICIENTS + 1, 1> row;
+
+    for (size_t i = _first; i < _last; i++)
+    {
+        const SysIdSample_S& sample = this->samples[i];
+
+        double u = sample.upsilon[0];
+        double v = sample.upsilon[1];
+        double w = sample.upsilon[2];
+        double r = sample.upsilon[3];
+
+        double u_dot = sample.upsilon_dot[0];
+        double v_dot = sample.upsilon_dot[1];
+        double w_dot = sample.upsilon_dot[2];
+        double r_dot = sample.upsilon_dot[3];
+
+        /* Surge: m u_dot - m v r - tau_x + g_x = X_u_dot u_dot - Y_v_dot v r + X_u u + X_uu |u| u */
+        row.setZero();
+        row(SYSID_X_U_DOT)      = u_dot;
+        row(SYSID_Y_V_DOT)      = -v * r;
+        row(SYSID_X_U)          = u;
+        row(SYSID_X_UU)         = std::abs(u) * u;
+        row(SYSID_OBSERVATION)  = m * u_dot - m * v * r - sample.tau[0] + restoring[0];
+        row *= weight[0];
+        _normals[0].noalias() += row * row.transpose();
+
+        /* Sway: m v_dot + m u r - tau_y + g_y = Y_v_dot v_dot + X_u_dot u r + Y_v v + Y_vv |v| v */
+        row.setZero();
+        row(SYSID_Y_V_DOT)      = v_dot;
+        row(SYSID_X_U_DOT)      = u * r;
+        row(SYSID_Y_V)          = v;
+        row(SYSID_Y_VV)         = std::abs(v) * v;
+        row(SYSID_OBSERVATION)  = m * v_dot + m * u * r - sample.tau[1] + restoring[1];
+        row *= weight[1];
+        _normals[1].noalias() += row * row.transpose();
+
+        /* Heave: m w_dot - tau_z + g_z = Z_w_dot w_dot + Z_w w + Z_ww |w| w */
+        row.setZero();
+        row(SYSID_Z_W_DOT)      = w_dot;
+        row(SYSID_Z_W)          = w;
+        row(SYSID_Z_WW)         = std::abs(w) * w;
+        row(SYSID_OBSERVATION)  = m * w_dot - sample.tau[2] + restoring[2];
+        row *= weight[2];
+        _normals[2].noalias() += row * row.transpose();
+
+        /* Yaw: Izz r_dot - tau_yaw = N_r_dot r_dot - (X_u_dot - Y_v_dot) u v + N_r r + N_rr |r| r */
+        row.setZero();
+        row(SYSID_N_R_DOT)      = r_dot;
+        row(SYSID_X_U_DOT)      = -u * v;
+        row(SYSID_Y_V_DOT)      = u * v;
+        row(SYSID_N_R)          = r;
+        row(SYSID_N_RR)         = std::abs(r) * r;
+        row(SYSID_OBSERVATION)  = I * r_dot - sample.tau[3] + restoring[3];
+        row *= weight[3];
+        _normals[3].noalias() += row * row.transpose();
+    }
+}
+
+bool SystemIdentification::Fit(unsigned _threads)
+{
+    size_t count = this->samples.size();
+
+    if (count < SYSID_COEFFICIENTS)
+    {
+        this->error = "not enough samples, the logs need states and thrust";
+        return false;
+    }
+
+    _threads = std::max(1u, std::min(_threads, (unsigned) (count / SYSID_COEFFICIENTS)));
+
+    /* Each worker sums its own share, the shares are added in order so a
+       given thread count always gives the same result */
+    std::vector<Normal> normals(4 * _threads);
+    std::vector<std::thread> workers;
+
+    for (unsigned i = 0; i < _threads; i++)
+    {
+        workers.push_back(std::thread(&SystemIdentification::Accumulate, this,
+                                      count * i / _threads, count * (i + 1) / _threads, &normals[4 * i]));
+    }
+
+    for (unsigned i = 0; i < _threads; i++)
+    {
+        workers[i].join();
+    }
+
+    Normal axes[4];
+    Normal total = Normal::Zero();
+
+    for (size_t axis = 0; axis < 4; axis++)
+    {
+        axes[axis] = normals[axis];
+
+        for (unsigned i = 1; i < _threads; i++)
+        {
+            axes[axis] += normals[4 * i + axis];
+        }
+
+        total += axes[axis];
+    }
+
+    /* Coefficients without excitation keep their base value and move to the observations */
+    Eigen::Matrix<double, SYSID_COEFFICIENTS + 1, 1> solution;
+    std::vector<size_t> free_coefficients;
+
+    for (size_t i = 0; i < SYSID_COEFFICIENTS; i++)
+    {
+        solution(i) = Coefficient(this->vehicle, i);
+        this->estimated[i] = total(i, i) > SYSID_MIN_EXCITATION * count;
+
+        if (this->estimated[i])
+        {
+            free_coefficients.push_back(i);
+        }
+    }
+
+    solution(SYSID_OBSERVATION) = -1;
+
+    size_t free_count = free_coefficients.size();
+
+    if (free_count == 0)
+    {
+        this->error = "the logs do not excite any coefficient";
+        return false;
+    }
+
+    Eigen::MatrixXd normal(free_count, free_count);
+    Eigen::VectorXd right(free_count);
+
+    for (size_t i = 0; i < free_count; i++)
+    {
+        right(i) = total(free_coefficients[i], SYSID_OBSERVATION);
+
+        for (size_t j = 0; j < SYSID_COEFFICIENTS; j++)
+        {
+            if (!this->estimated[j])
+            {
+                right(i) -= total(free_coefficients[i], j) * solution(j);
+            }
+        }
+
+        for (size_t j = 0; j < free_count; j++)
+        {
+            normal(i, j) = total(free_coefficients[i], free_coefficients[j]);
+        }
+    }
+
+    /* Columns are scaled to unit norm, the coefficients differ by orders of magnitude */
+    Eigen::VectorXd scale = normal.diagonal().cwiseSqrt().cwiseInverse();
+    Eigen::MatrixXd scaled = scale.asDiagonal() * normal * scale.asDiagonal();
+    Eigen::ColPivHouseholderQR<Eigen::MatrixXd> decomposition(scaled);
+
+    if ((size_t) decomposition.rank() < free_count)
+    {
+        this->error = "the logs do not tell the coefficients apart, they need speed changes on every axis";
+        return false;
+    }
+
+    Eigen::VectorXd estimate = scale.asDiagonal() * decomposition.solve(scale.asDiagonal() * right);
+
+    for (size_t i = 0; i < free_count; i++)
+    {
+        solution(free_coefficients[i]) = estimate(i);
+        this->vehicle.*SYSID_COEFFICIENT_FIELDS[free_coefficients[i]].value = estimate(i);
+    }
+
+    for (size_t axis = 0; axis < 4; axis++)
+    {
+        this->rms_residual[axis] = std::sqrt(std::max(0.0, solution.dot(axes[axis] * solution)) / count);
+    }
+
+    return true;
+}
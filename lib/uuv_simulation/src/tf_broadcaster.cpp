@@ -11,27 +11,38 @@
 
 #include "tf_broadcaster.hpp"
 
-TfBroadcaster::TfBroadcaster(const std::string& _parent, const std::string& _child)
+TfBroadcaster::TfBroadcaster(const std::string& _parent, const std::string& _child, size_t _path_capacity)
+                             : path_history(_path_capacity)
 {
     this->parent_frame = _parent;
     this->child_frame = _child;
+
+    this->min_path_distance_m = 0.1;
+    this->min_path_angle_rad = 0.1;
+
+    this->path_started = false;
+    this->last_path_yaw = 0;
+
+    /* Reserve once so that rebuilding the path never reallocates */
+    this->path.poses.reserve(_path_capacity);
+    this->path_increment.poses.reserve(_path_capacity);
 }
 
 TfBroadcaster::~TfBroadcaster(){}
 
-void TfBroadcaster::BroadcastTransform(const geometry_msgs::Pose& _pose)
+void TfBroadcaster::BroadcastTransform(const vanttec_uuv::VehicleState& _state)
 {    
     geometry_msgs::TransformStamped transformStamped;
     
-    transformStamped.header.stamp               = ros::Time::now();
+    transformStamped.header.stamp               = _state.header.stamp;
     transformStamped.header.frame_id            = this->parent_frame;
     transformStamped.child_frame_id             = this->child_frame;
-    transformStamped.transform.translation.x    = _pose.position.x;
-    transformStamped.transform.translation.y    = -_pose.position.y;
-    transformStamped.transform.translation.z    = -_pose.position.z;
+    transformStamped.transform.translation.x    = _state.x;
+    transformStamped.transform.translation.y    = -_state.y;
+    transformStamped.transform.translation.z    = -_state.z;
 
     tf2::Quaternion q;
-    q.setRPY(0, 0, -_pose.orientation.z);
+    q.setRPY(_state.roll, -_state.pitch, -_state.yaw);
     transformStamped.transform.rotation.x = q.x();
     transformStamped.transform.rotation.y = q.y();
     transformStamped.transform.rotation.z = q.z();
@@ -41,13 +52,64 @@ void TfBroadcaster::BroadcastTransform(const geometry_msgs::Pose& _pose)
 
     geometry_msgs::PoseStamped      pose;
 
-    pose.header.stamp       = ros::Time::now();
+    pose.header.stamp       = _state.header.stamp;
     pose.header.frame_id    = this->parent_frame;
-    pose.pose.position.x    = _pose.position.x;
-    pose.pose.position.y    = -_pose.position.y;
-    pose.pose.position.z    = -_pose.position.z;
+    pose.pose.position.x    = _state.x;
+    pose.pose.position.y    = -_state.y;
+    pose.pose.position.z    = -_state.z;
+
+    /* Decimate by distance and heading change from the last recorded pose */
+    if (this->path_started)
+    {
+        const geometry_msgs::Point& last = this->path_history.Back().pose.position;
+
+        float dx = pose.pose.position.x - last.x;
+        float dy = pose.pose.position.y - last.y;
+        float dz = pose.pose.position.z - last.z;
+        float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        float yaw_change = std::abs(_state.yaw - this->last_path_yaw);
+
+        if (yaw_change > M_PI)
+        {
+            yaw_change = 2 * M_PI - yaw_change;
+        }
+
+        if (distance < this->min_path_distance_m && yaw_change < this->min_path_angle_rad)
+        {
+            return;
+        }
+    }
+
+    this->path_started  = true;
+    this->last_path_yaw = _state.yaw;
+
+    this->path_history.PushBack(pose);
 
+    /* Increments are bounded too, in case nobody clears them */
+    if (this->path_increment.poses.size() >= this->path_history.Capacity())
+    {
+        this->path_increment.poses.erase(this->path_increment.poses.begin());
+    }
+
+    this->path_increment.header.stamp       = _state.header.stamp;
+    this->path_increment.header.frame_id    = this->parent_frame;
+    this->path_increment.poses.push_back(pose);
+}
+
+void TfBroadcaster::BuildFullPath()
+{
     this->path.header.stamp     = ros::Time::now();
     this->path.header.frame_id  = this->parent_frame;
-    this->path.poses.push_back(pose);
-}
\ No newline at end of file
+    this->path.poses.resize(this->path_history.Size());
+
+    for (size_t i = 0; i < this->path_history.Size(); i++)
+    {
+        this->path.poses[i] = this->path_history[i];
+    }
+}
+
+void TfBroadcaster::ClearPathIncrement()
+{
+    this->path_increment.poses.clear();
+}
@@ -10,17 +10,59 @@
 
 #include "uuv_dynamic_4dof_model.hpp"
 
+#include <ros/ros.h>
 #include <math.h>
 #include <stdio.h>
 
-UUVDynamic4DOFModel::UUVDynamic4DOFModel(float _sample_time_s)
+static const float pi = 3.14159;
+
+template <typename Parameters>
+UUVDynamic4DOFModelT<Parameters>::UUVDynamic4DOFModelT(float _sample_time_s, const Parameters& _parameters)
+                                                      : parameters(_parameters)
+                                                      , body_pos(Eigen::Vector4d::Zero())
+                                                      , eta(Eigen::Vector4d::Zero())
 {
     this->sample_time_s = _sample_time_s;
 
+    /* Rigid Body Mass Matrix */
+
+    this->M_rb << this->parameters.mass, 0, 0, 0,
+                  0, this->parameters.mass, 0, 0,
+                  0, 0, this->parameters.mass, 0,
+                  0, 0, 0, this->parameters.Izz;
+
+    /* Hydrodynamic Added Mass Matrix */
+
+    this->M_a << this->parameters.X_u_dot, 0, 0, 0,
+                 0, this->parameters.Y_v_dot, 0, 0,
+                 0, 0, this->parameters.Z_w_dot, 0,
+                 0, 0, 0, this->parameters.N_r_dot;
+
+    Eigen::Matrix4f M = this->M_rb - this->M_a;
+    this->M_inv = M.inverse();
+
+    /* Linear Hydrodynamic Damping */
+
+    this->D_lin << -(this->parameters.X_u), 0, 0, 0,
+                   0, -(this->parameters.Y_v), 0, 0,
+                   0, 0, -(this->parameters.Z_w), 0,
+                   0, 0, 0, -(this->parameters.N_r);
+
+    /* Restoring Forces */
+
+    float net_weight = this->parameters.weight - this->parameters.buoyancy;
+
+    this->G_eta << net_weight * sin(this->parameters.theta_b),
+                   -net_weight * cos(this->parameters.theta_b) * sin(this->parameters.phi_b),
+                   -net_weight * cos(this->parameters.theta_b) * cos(this->parameters.phi_b),
+                   0;
+
     this->upsilon << 0,
                      0,
                      0,
                      0;
+
+    this->J = Eigen::Matrix4f::Identity();
     
     this->upsilon_prev << 0,
                           0,
@@ -37,11 +79,6 @@ UUVDynamic4DOFModel::UUVDynamic4DOFModel(float _sample_time_s)
                               0,
                               0;
 
-    this->body_pos << 0,
-                      0,
-                      0,
-                      0;
-
     this->tau << 0,
                  0,
                  0,
@@ -59,49 +96,57 @@ UUVDynamic4DOFModel::UUVDynamic4DOFModel(float _sample_time_s)
     this->angular_position.y = 0;
     this->angular_position.z = 0;
 
-    this->velocities.linear.x = 0;
-    this->velocities.linear.y = 0;
-    this->velocities.linear.z = 0;
-    
-    this->velocities.angular.x = 0;
-    this->velocities.angular.y = 0;
-    this->velocities.angular.z = 0;
+    this->state.sequence = 0;
+    this->new_thrust = false;
+    this->recorder = NULL;
+    this->current_field = NULL;
 
 }
 
-UUVDynamic4DOFModel::~UUVDynamic4DOFModel(){}
+template <typename Parameters>
+UUVDynamic4DOFModelT<Parameters>::~UUVDynamic4DOFModelT(){}
 
-void UUVDynamic4DOFModel::ThrustCallback(const vanttec_uuv::ThrustControl& _thrust)
+template <typename Parameters>
+void UUVDynamic4DOFModelT<Parameters>::ThrustCallback(const vanttec_uuv::ThrustControl& _thrust)
 {
     this->tau << _thrust.tau_x,
                  _thrust.tau_y,
                  _thrust.tau_z,
                  _thrust.tau_yaw;
+
+    this->thrust_trace  = _thrust.trace;
+    this->new_thrust    = true;
+
+    if (this->recorder != NULL)
+    {
+        this->recorder->RecordThrust(ros::Time::now().toSec(), _thrust);
+    }
 }
 
-void UUVDynamic4DOFModel::CalculateStates()
+template <typename Parameters>
+void UUVDynamic4DOFModelT<Parameters>::CalculateStates()
 {
     this->upsilon_dot_prev = this->upsilon_dot;
     this->upsilon_prev = this->upsilon;
 
-    /* Rigid Body Mass Matrix */
+    /* Velocity relative to the water, the current is rotated into body axes
+       with the transformation of the last step */
+    Eigen::Vector4f upsilon_r = this->upsilon;
 
-    this->M_rb << mass, 0, 0, 0,
-                  0, mass, 0, 0,
-                  0, 0, mass, 0,
-                  0, 0, 0, Izz;
-
-    /* Hydrodynamic Added Mass Matrix */
+    if (this->current_field != NULL)
+    {
+        Eigen::Vector3f current = this->current_field->Velocity(this->eta.sum(0), this->eta.sum(1), this->eta.sum(2),
+                                                                this->state.sequence * (double) this->sample_time_s);
 
-    this->M_a << X_u_dot, 0, 0, 0,
-                 0, Y_v_dot, 0, 0,
-                 0, 0, Z_w_dot, 0,
-                 0, 0, 0, N_r_dot;
+        upsilon_r(0) -= this->J(0, 0) * current(0) + this->J(1, 0) * current(1);
+        upsilon_r(1) -= this->J(0, 1) * current(0) + this->J(1, 1) * current(1);
+        upsilon_r(2) -= current(2);
+    }
 
     /* Rigid Body Coriolis Matrix */
 
-    float rb_a_1 = mass * this->upsilon(0);
-    float rb_a_2 = mass * this->upsilon(1);
+    float rb_a_1 = this->parameters.mass * this->upsilon(0);
+    float rb_a_2 = this->parameters.mass * this->upsilon(1);
     
     this->C_rb << 0, 0, 0, -rb_a_2,
                   0, 0, 0, rb_a_1,
@@ -110,41 +155,27 @@ void UUVDynamic4DOFModel::CalculateStates()
 
     /* Hydrodynamic Added Mass Coriolis Matrix */
 
-    float a_a_1 = X_u_dot * this->upsilon(0);
-    float a_a_2 = Y_v_dot * this->upsilon(1);
+    float a_a_1 = this->parameters.X_u_dot * upsilon_r(0);
+    float a_a_2 = this->parameters.Y_v_dot * upsilon_r(1);
     
     this->C_a << 0, 0, 0, a_a_2,
                  0, 0, 0, -a_a_1,
                  0, 0, 0, 0,
                  -a_a_2, a_a_1, 0, 0;
     
-    /* Hydrodynamic Damping */
+    /* Quadratic Hydrodynamic Damping */
 
-    this->D_lin << -(X_u), 0, 0, 0,
-                   0, -(Y_v), 0, 0,
-                   0, 0, -(Z_w), 0,
-                   0, 0, 0, -(N_r);
-
-    this->D_qua << -(X_uu * fabs(this->upsilon(0))), 0, 0, 0,
-                   0, -(Y_vv * fabs(this->upsilon(1))), 0, 0,
-                   0, 0, -(Z_ww * fabs(this->upsilon(2))), 0,
-                   0, 0, 0, -(N_rr * fabs(this->upsilon(3)));
-
-    /* Restoring Forces */
-    
-    this->G_eta << (weight - buoyancy) * sin(theta_b),
-                   -(weight - buoyancy) * cos(theta_b) * sin(phi_b),
-                   -(weight - buoyancy) * cos(theta_b) * cos(phi_b),
-                   0;
+    this->D_qua << -(this->parameters.X_uu * fabs(upsilon_r(0))), 0, 0, 0,
+                   0, -(this->parameters.Y_vv * fabs(upsilon_r(1))), 0, 0,
+                   0, 0, -(this->parameters.Z_ww * fabs(upsilon_r(2))), 0,
+                   0, 0, 0, -(this->parameters.N_rr * fabs(upsilon_r(3)));
 
     /* 4 DoF State Calculation */
 
-    Eigen::Matrix4f M = this->M_rb - this->M_a;
-    Eigen::Matrix4f C = this->C_rb + this->C_a;
     Eigen::Matrix4f D = this->D_lin + this->D_qua;
 
-    this->upsilon_dot = M.inverse() * (this->tau - (C * this->upsilon) 
-                                       - (D * this->upsilon) - this->G_eta);
+    this->upsilon_dot = this->M_inv * (this->tau - (this->C_rb * this->upsilon) - (this->C_a * upsilon_r)
+                                       - (D * upsilon_r) - this->G_eta);
 
     /* Integrating Acceleration to get Velocities */
 
@@ -154,28 +185,30 @@ void UUVDynamic4DOFModel::CalculateStates()
     /* Integrating Velocities to get Position */
 
     Eigen::Vector4f upsilon_sum = this->upsilon + this->upsilon_prev;
-    this->body_pos = (upsilon_sum / 2 * this->sample_time_s) + this->body_pos;
+    this->body_pos.Add((upsilon_sum / 2 * this->sample_time_s).cast<double>());
 
-    if (fabs(this->body_pos(3)) > pi)
+    if (fabs(this->body_pos.sum(3)) > pi)
     {
-        this->body_pos(3) = (this->body_pos(3) / fabs(this->body_pos(3))) * (this->body_pos(3) - 2 * pi);
+        this->body_pos.sum(3) = (this->body_pos.sum(3) / fabs(this->body_pos.sum(3))) * (fabs(this->body_pos.sum(3)) - 2 * pi);
     }
 
     /* Calculate Transformation Matrix */
 
-    this->J << cos(this->body_pos(3)), -sin(this->body_pos(3)), 0, 0,
-               sin(this->body_pos(3)), cos(this->body_pos(3)), 0, 0,
+    float psi = this->body_pos.sum(3);
+
+    this->J << cos(psi), -sin(psi), 0, 0,
+               sin(psi), cos(psi), 0, 0,
                0, 0, 1, 0,
                0, 0, 0, 1;
 
     /* Integrating Velocities to get Position on NED */
 
     Eigen::Vector4f eta_dot_sum = (this->J * this->upsilon) + (this->J * this->upsilon_prev);
-    this->eta = (eta_dot_sum / 2 * this->sample_time_s) + this->eta;
+    this->eta.Add((eta_dot_sum / 2 * this->sample_time_s).cast<double>());
 
-    if (fabs(this->eta(3)) > pi)
+    if (fabs(this->eta.sum(3)) > pi)
     {
-        this->eta(3) = (this->eta(3) / fabs(this->eta(3))) * (this->eta(3) - 2 * pi);
+        this->eta.sum(3) = (this->eta.sum(3) / fabs(this->eta.sum(3))) * (fabs(this->eta.sum(3)) - 2 * pi);
     }
 
     /* Update ROS Messages */
@@ -190,15 +223,26 @@ void UUVDynamic4DOFModel::CalculateStates()
 
     this->angular_position.x = 0;
     this->angular_position.y = 0;
-    this->angular_position.z = this->body_pos(3); 
+    this->angular_position.z = this->body_pos.sum(3);
    
-    this->velocities.linear.x = this->upsilon(0);
-    this->velocities.linear.y = this->upsilon(1);
-    this->velocities.linear.z = this->upsilon(2);
-    this->velocities.angular.z = this->upsilon(3);
-    
-    this->pose.position.x = this->eta(0);
-    this->pose.position.y = this->eta(1);
-    this->pose.position.z = this->eta(2);
-    this->pose.orientation.z = this->eta(3);
+    this->state.sequence++;
+    this->state.trace.trace_id = this->state.sequence;
+
+    this->state.x = this->eta.sum(0);
+    this->state.y = this->eta.sum(1);
+    this->state.z = this->eta.sum(2);
+    this->state.yaw = this->eta.sum(3);
+
+    this->state.u = this->upsilon(0);
+    this->state.v = this->upsilon(1);
+    this->state.w = this->upsilon(2);
+    this->state.r = this->upsilon(3);
+
+    this->state.u_dot = this->upsilon_dot(0);
+    this->state.v_dot = this->upsilon_dot(1);
+    this->state.w_dot = this->upsilon_dot(2);
+    this->state.r_dot = this->upsilon_dot(3);
 }
+
+template class UUVDynamic4DOFModelT<VehicleParameters>;
+template class UUVDynamic4DOFModelT<VtecU3GammaParameters>;
@@ -0,0 +1,103 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_choose_side_node.cpp
+ * 
+ * @brief: ROS choose side mission node for the UUV. Uses uuv_missions library,
+ *         replaces the auto_nav_position script.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "choose_side_mission.hpp"
+
+#include <ros/ros.h>
+#include <std_msgs/Int32.h>
+#include <algorithm>
+
+/* Decisions are taken at most one cycle after the detections arrive */
+const float     SAMPLE_TIME_S           = 0.01;
+const uint32_t  LATENCY_REPORT_PERIOD   = 10;
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "uuv_choose_side_node");
+    ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    std::string     side;
+    int             gate_count;
+    float           distance_away_m;
+    float           pass_distance_m;
+
+    private_nh.param("side", side, std::string("left"));
+    private_nh.param("gate_count", gate_count, 2);
+    private_nh.param("distance_away_m", distance_away_m, 5.0f);
+    private_nh.param("pass_distance_m", pass_distance_m, 3.0f);
+
+    ros::Rate               cycle_rate(int(1 / SAMPLE_TIME_S));
+    ChooseSideMission       choose_side_mission;
+
+    choose_side_mission.selected_side   = (side == "right") ? SIDE_RIGHT : SIDE_LEFT;
+    choose_side_mission.gate_count      = std::min(std::max(gate_count, 1), 255);
+    choose_side_mission.distance_away   = distance_away_m;
+    choose_side_mission.pass_distance   = pass_distance_m;
+
+    ros::Publisher  uuv_waypoints   = nh.advertise<vanttec_uuv::GuidanceWaypoints>("/uuv_guidance/guidance_controller/waypoints", 10);
+    ros::Publisher  uuv_path        = nh.advertise<nav_msgs::Path>("/uuv_planning/motion_planning/desired_path", 10);
+    ros::Publisher  mission_status  = nh.advertise<std_msgs::Int32>("/mission/status", 10);
+    ros::Publisher  mission_state   = nh.advertise<std_msgs::Int32>("/mission/state", 10);
+
+    ros::Subscriber uuv_state       = nh.subscribe("/uuv_simulation/dynamic_model/state",
+                                                   1,
+                                                   &ChooseSideMission::OnPoseReception,
+                                                   &choose_side_mission);
+
+    ros::Subscriber uuv_obstacles   = nh.subscribe("/uuv_perception/simulated_perception/obstacles",
+                                                   1,
+                                                   &ChooseSideMission::OnObstacleReception,
+                                                   &choose_side_mission);
+
+    /* Time from the detections stamp to the waypoints publication, search legs are
+       triggered by a timeout or by distance and are left out of the statistics */
+    uint32_t    decisions = 0;
+    double      latency_sum_ms = 0;
+    double      latency_max_ms = 0;
+
+    while(ros::ok() && choose_side_mission.state_machine != CHOOSE_SIDE_DONE)
+    {
+        /* Run Queued Callbacks */ 
+        ros::spinOnce();
+
+        if (choose_side_mission.Iteration(ros::Time::now().toSec()))
+        {
+            uuv_waypoints.publish(choose_side_mission.desired_waypoints);
+            uuv_path.publish(choose_side_mission.path);
+        }
+
+        if (choose_side_mission.detection_decision)
+        {
+            double latency_ms = (ros::Time::now() - choose_side_mission.decision_stamp).toSec() * 1000;
+
+            decisions++;
+            latency_sum_ms += latency_ms;
+            latency_max_ms = std::max(latency_max_ms, latency_ms);
+
+            if (decisions % LATENCY_REPORT_PERIOD == 0)
+            {
+                ROS_INFO("Choose side mission: decision latency mean %.2f ms, max %.2f ms over %u decisions",
+                         latency_sum_ms / decisions, latency_max_ms, decisions);
+            }
+        }
+
+        std_msgs::Int32 state;
+        state.data = choose_side_mission.state_machine;
+        mission_state.publish(state);
+
+        /* Sleep for 10ms */
+        cycle_rate.sleep();
+    }
+
+    std_msgs::Int32 status;
+    status.data = 1;
+    mission_status.publish(status);
+
+    return 0;
+}
@@ -9,44 +9,102 @@
  **/
 
 #include "uuv_4dof_controller.hpp"
+#include "latency_tracer.hpp"
+#include "telemetry_recorder.hpp"
 
 #include <ros/ros.h>
 #include <stdio.h>
 
 const float SAMPLE_TIME_S = 0.01;
+const size_t TRACE_EVENT_CAPACITY = 1 << 16;
 
 int main(int argc, char **argv)
 {
     ros::init(argc, argv, "uuv_control_node");
     ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    std::string vehicle_file;
+    std::string trace_file;
+    std::string telemetry_dir;
+    int         telemetry_segment_records;
+    int         telemetry_segments;
+    private_nh.param("vehicle_file", vehicle_file, std::string(""));
+    private_nh.param("trace_file", trace_file, std::string(""));
+    private_nh.param("telemetry_dir", telemetry_dir, std::string(""));
+    private_nh.param("telemetry_segment_records", telemetry_segment_records, 65536);
+    private_nh.param("telemetry_segments", telemetry_segments, 16);
+
+    /* A file given to the node wins over the vehicle namespace */
+    VehicleParameters   vehicle;
+    bool vehicle_loaded = vehicle_file.empty() ? vehicle.LoadParameterServer(ros::NodeHandle(nh, VEHICLE_PARAMETERS_NAMESPACE))
+                                               : vehicle.LoadFile(vehicle_file);
+
+    if (!vehicle_loaded)
+    {
+        ROS_ERROR("Vehicle: %s", vehicle.error.c_str());
+        return 1;
+    }
     
     ros::Rate           cycle_rate(int(1 / SAMPLE_TIME_S));
-    UUV4DOFController   system_controller(SAMPLE_TIME_S, Kpid_u, Kpid_v, Kpid_z, Kpid_psi);
+    UUV4DOFController   system_controller(SAMPLE_TIME_S, vehicle);
+    LatencyTracer       tracer("uuv_control_node", TRACE_EVENT_CAPACITY);
+    TelemetryRecorder   recorder;
+
+    if (!telemetry_dir.empty())
+    {
+        if (recorder.Open(telemetry_dir, "uuv_control_node", telemetry_segment_records, telemetry_segments))
+        {
+            /* Settings a replay of this log needs */
+            double time_s = ros::Time::now().toSec();
+            recorder.RecordParameter(time_s, "sample_time_s", SAMPLE_TIME_S);
+
+            for (size_t i = 0; i < VehicleParameters::Count(); i++)
+            {
+                recorder.RecordParameter(time_s, (VEHICLE_PARAMETERS_NAMESPACE + "/" + VehicleParameters::Name(i)).c_str(), vehicle.Value(i));
+            }
+            system_controller.recorder = &recorder;
+        }
+        else
+        {
+            ROS_ERROR("Telemetry: could not open %s: %s", telemetry_dir.c_str(), recorder.error);
+        }
+    }
+
+    /* Age of the state and of the setpoint behind each thrust command */
+    uint8_t state_to_thrust     = tracer.AddStage("state_to_thrust");
+    uint8_t setpoint_to_thrust  = tracer.AddStage("setpoint_to_thrust");
     
     ros::Publisher  uuv_thrust      = nh.advertise<vanttec_uuv::ThrustControl>("/uuv_control/uuv_control_node/thrust", 1000);
 
-    ros::Subscriber uuv_pose        = nh.subscribe("/uuv_simulation/dynamic_model/pose",
-                                                    1000,
-                                                    &UUV4DOFController::UpdatePose,
-                                                    &system_controller);
-
-    ros::Subscriber uuv_twist       = nh.subscribe("/uuv_simulation/dynamic_model/vel", 
+    ros::Subscriber uuv_state       = nh.subscribe("/uuv_simulation/dynamic_model/state",
                                                     10,
-                                                    &UUV4DOFController::UpdateTwist,
+                                                    &UUV4DOFController::UpdateState,
                                                     &system_controller);
 
     ros::Subscriber uuv_setpoint    = nh.subscribe("/uuv_control/uuv_control_node/setpoint", 
                                                     10,
-                                                    &UUV4DOFController::UpdateSetPoints,
+                                                    &UUV4DOFController::OnSetPointReception,
                                                     &system_controller); 
 
+    /* Live tuning, applied at the next cycle */
+    ros::ServiceServer uuv_set_gains = nh.advertiseService("/uuv_control/uuv_control_node/set_gains",
+                                                           &UUV4DOFController::OnSetGains,
+                                                           &system_controller);
+
     int counter = 0;
+    uint64_t cycle = 0;
     
     while(ros::ok())
     {
         /* Run Queued Callbacks */ 
         ros::spinOnce();
 
+        if (recorder.IsOpen())
+        {
+            recorder.RecordTick(ros::Time::now().toSec(), cycle);
+        }
+
         /* Update Parameters with new info */ 
         system_controller.UpdateControlLaw();
         system_controller.UpdateThrustOutput();
@@ -63,10 +121,36 @@ int main(int argc, char **argv)
        
         /* Publish Odometry */ 
         uuv_thrust.publish(system_controller.thrust);
+        tracer.Record(state_to_thrust, system_controller.state_trace, system_controller.thrust.header.stamp);
+        tracer.Record(setpoint_to_thrust, system_controller.setpoint_trace, system_controller.thrust.header.stamp);
+
+        if (recorder.IsOpen())
+        {
+            double time_s = system_controller.thrust.header.stamp.toSec();
+            recorder.RecordThrust(time_s, system_controller.thrust);
+            recorder.RecordPid(time_s, TELEMETRY_PID_SURGE, system_controller.surge_speed_controller);
+            recorder.RecordPid(time_s, TELEMETRY_PID_SWAY, system_controller.sway_speed_controller);
+            recorder.RecordPid(time_s, TELEMETRY_PID_DEPTH, system_controller.depth_controller);
+            recorder.RecordPid(time_s, TELEMETRY_PID_HEADING, system_controller.heading_controller);
+        }
+
+        cycle++;
 
         /* Slee for 10ms */
         cycle_rate.sleep();
     }
+
+    tracer.LogSummary();
+
+    if (recorder.IsOpen())
+    {
+        ROS_INFO("Telemetry: %lu records, %lu segment rotations", (unsigned long) recorder.records, (unsigned long) recorder.rotations);
+    }
+
+    if (!trace_file.empty())
+    {
+        tracer.DumpChromeTrace(trace_file);
+    }
     
     return 0;
 }
\ No newline at end of file
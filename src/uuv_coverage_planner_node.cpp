@@ -0,0 +1,95 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_coverage_planner_node.cpp
+ * 
+ * @brief: ROS coverage planner node for the UUV. Uses uuv_motion_planning
+ *         library.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "coverage_planner.hpp"
+
+#include <ros/ros.h>
+#include <algorithm>
+#include <vector>
+
+const float SAMPLE_TIME_S = 0.1;
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "uuv_coverage_planner_node");
+    ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    std::vector<float>  polygon_x;
+    std::vector<float>  polygon_y;
+    float               swath_width_m;
+    float               depth_m;
+    float               heading_rad;
+    bool                auto_heading;
+    int                 turn_points;
+    int                 chunk_size;
+
+    private_nh.param("polygon_x", polygon_x, std::vector<float>());
+    private_nh.param("polygon_y", polygon_y, std::vector<float>());
+    private_nh.param("swath_width_m", swath_width_m, 2.0f);
+    private_nh.param("depth_m", depth_m, 1.0f);
+    private_nh.param("heading_rad", heading_rad, 0.0f);
+    private_nh.param("auto_heading", auto_heading, true);
+    private_nh.param("turn_points", turn_points, 4);
+    private_nh.param("chunk_size", chunk_size, 64);
+
+    std::vector<Eigen::Vector2f> polygon;
+
+    for (size_t i = 0; i < polygon_x.size() && i < polygon_y.size(); i++)
+    {
+        polygon.push_back(Eigen::Vector2f(polygon_x[i], polygon_y[i]));
+    }
+
+    if (polygon.size() < 3)
+    {
+        ROS_ERROR("Coverage planner: the survey polygon needs at least 3 vertices");
+        return 1;
+    }
+
+    if (auto_heading)
+    {
+        heading_rad = CoveragePattern::BestHeading(polygon);
+    }
+
+    ros::Rate           cycle_rate(int(1 / SAMPLE_TIME_S));
+    CoveragePlanner     coverage_planner(CoveragePattern(polygon, swath_width_m, depth_m, heading_rad, turn_points),
+                                         std::min(std::max(chunk_size, 3), 255));
+
+    ROS_INFO("Coverage planner: %u legs, sweep heading %.2f rad", coverage_planner.pattern.LineCount(), heading_rad);
+
+    ros::Publisher  uuv_waypoints   = nh.advertise<vanttec_uuv::GuidanceWaypoints>("/uuv_guidance/guidance_controller/waypoints", 10);
+    ros::Publisher  uuv_path        = nh.advertise<nav_msgs::Path>("/uuv_planning/motion_planning/desired_path", 10);
+
+    ros::Subscriber uuv_state       = nh.subscribe("/uuv_simulation/dynamic_model/state",
+                                                   1,
+                                                   &CoveragePlanner::OnStateReception,
+                                                   &coverage_planner);
+
+    ros::Subscriber guidance_status = nh.subscribe("/uuv_guidance/guidance_controller/status",
+                                                   1,
+                                                   &CoveragePlanner::OnGuidanceStatus,
+                                                   &coverage_planner);
+
+    while(ros::ok() && !coverage_planner.finished)
+    {
+        /* Run Queued Callbacks */ 
+        ros::spinOnce();
+
+        /* Send the next chunk when the guidance is about to run out */
+        if (coverage_planner.Iteration())
+        {
+            uuv_path.publish(coverage_planner.path);
+            uuv_waypoints.publish(coverage_planner.waypoints);
+        }
+
+        /* Sleep for 100ms */
+        cycle_rate.sleep();
+    }
+
+    return 0;
+}
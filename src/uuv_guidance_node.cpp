@@ -5,30 +5,151 @@
  * @email: pedro.sc.97@gmail.com
  * 
  * @brief: ROS guidance node for the UUV. Uses uuv_guidance library.
+ *         The mission manager owns the guidance while its mission runs: script
+ *         requests are refused and running scripts are cancelled until it ends.
+ *         Lists published on the waypoints topic are taken at any time.
  * -----------------------------------------------------------------------------
  **/
 
 #include <uuv_guidance_controller.hpp>
+#include <uuv_mission_manager.hpp>
+#include <mission_scripts.hpp>
+#include <latency_tracer.hpp>
+#include <telemetry_recorder.hpp>
+#include <vanttec_uuv/ControlSetpoint.h>
 
 #include <ros/ros.h>
 #include <stdio.h>
 
-const float SAMPLE_TIME_S = 0.01;
+const float     SAMPLE_TIME_S           = 0.01;
+const uint16_t  MISSION_SCRIPT_CAPACITY = 16;
+const size_t    TRACE_EVENT_CAPACITY    = 1 << 16;
+
+/* The state and the obstacles are subscribed to once and handed to everything
+   in this process that needs them, so all of them see the same messages */
+class GuidanceInputs
+{
+    public:
+
+        GuidanceController* guidance_controller;
+        MissionManager*     mission_manager;
+        MissionScheduler*   mission_scheduler;
+
+        void OnStateReception(const vanttec_uuv::VehicleState& _state)
+        {
+            this->guidance_controller->OnCurrentPositionReception(_state);
+            this->mission_manager->OnStateReception(_state);
+            this->mission_scheduler->OnStateReception(_state);
+        }
+
+        void OnObstacleReception(const vanttec_uuv::ObstacleList& _obstacles)
+        {
+            this->guidance_controller->OnObstacleReception(_obstacles);
+            this->mission_manager->OnObstacleReception(_obstacles);
+            this->mission_scheduler->OnObstacleReception(_obstacles);
+        }
+};
 
 int main(int argc, char **argv)
 {
     ros::init(argc, argv, "uuv_guidance_node");
     ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    std::string     switching_mode;
+    float           acceptance_radius_m;
+    float           switching_distance_m;
+    int             mission_tick_budget_us;
+    float           mission_depth_m;
+    double          mission_action_timeout_s;
+    std::string     vehicle_file;
+    std::string     trace_file;
+    std::string     telemetry_dir;
+    int             telemetry_segment_records;
+    int             telemetry_segments;
+
+    private_nh.param("switching_mode", switching_mode, std::string("lookahead"));
+    private_nh.param("acceptance_radius_m", acceptance_radius_m, 0.4f);
+    private_nh.param("switching_distance_m", switching_distance_m, 0.9f);
+    private_nh.param("mission_tick_budget_us", mission_tick_budget_us, 500);
+    private_nh.param("mission_depth_m", mission_depth_m, 1.0f);
+    private_nh.param("mission_action_timeout_s", mission_action_timeout_s, 60.0);
+    private_nh.param("vehicle_file", vehicle_file, std::string(""));
+    private_nh.param("trace_file", trace_file, std::string(""));
+    private_nh.param("telemetry_dir", telemetry_dir, std::string(""));
+    private_nh.param("telemetry_segment_records", telemetry_segment_records, 65536);
+    private_nh.param("telemetry_segments", telemetry_segments, 16);
+
+    /* A file given to the node wins over the vehicle namespace */
+    VehicleParameters       vehicle;
+    bool vehicle_loaded = vehicle_file.empty() ? vehicle.LoadParameterServer(ros::NodeHandle(nh, VEHICLE_PARAMETERS_NAMESPACE))
+                                               : vehicle.LoadFile(vehicle_file);
+
+    if (!vehicle_loaded)
+    {
+        ROS_ERROR("Vehicle: %s", vehicle.error.c_str());
+        return 1;
+    }
     
     ros::Rate               cycle_rate(int(1 / SAMPLE_TIME_S));
     GuidanceController      guidance_controller;
+    MissionManager          mission_manager;
+    MissionScheduler        mission_scheduler(MISSION_SCRIPT_CAPACITY);
+    MissionScripts          mission_scripts(&mission_scheduler);
+    LatencyTracer           tracer("uuv_guidance_node", TRACE_EVENT_CAPACITY);
+    TelemetryRecorder       recorder;
+    vanttec_uuv::ControlSetpoint    setpoint;
+    GuidanceInputs                  inputs;
+
+    uint8_t state_to_setpoint = tracer.AddStage("state_to_setpoint");
+
+    mission_manager.mission_depth_m     = mission_depth_m;
+    mission_manager.action_timeout_s    = mission_action_timeout_s;
+    inputs.guidance_controller          = &guidance_controller;
+    inputs.mission_manager              = &mission_manager;
+    inputs.mission_scheduler            = &mission_scheduler;
+    mission_scripts.mission_manager     = &mission_manager;
+
+    /* The buoy is touched from outside the radius the avoidance keeps */
+    mission_manager.avoidance_radius_m  = guidance_controller.obstacle_avoidance.safety_radius_m;
+    guidance_controller.speed_profile.vehicle = vehicle;
+
+    if (!telemetry_dir.empty())
+    {
+        if (recorder.Open(telemetry_dir, "uuv_guidance_node", telemetry_segment_records, telemetry_segments))
+        {
+            /* Settings a replay of this log needs */
+            double time_s = ros::Time::now().toSec();
+            recorder.RecordParameter(time_s, "switching_mode", switching_mode);
+            recorder.RecordParameter(time_s, "acceptance_radius_m", acceptance_radius_m);
+            recorder.RecordParameter(time_s, "switching_distance_m", switching_distance_m);
+
+            for (size_t i = 0; i < VehicleParameters::Count(); i++)
+            {
+                recorder.RecordParameter(time_s, (VEHICLE_PARAMETERS_NAMESPACE + "/" + VehicleParameters::Name(i)).c_str(), vehicle.Value(i));
+            }
+
+            guidance_controller.recorder = &recorder;
+        }
+        else
+        {
+            ROS_ERROR("Telemetry: could not open %s: %s", telemetry_dir.c_str(), recorder.error);
+        }
+    }
+
+    guidance_controller.SetLOSSwitching(GuidanceController::LOSSwitchingModeFromName(switching_mode),
+                                        acceptance_radius_m,
+                                        switching_distance_m);
     
-    ros::Publisher  uuv_desired_setpoints       = nh.advertise<geometry_msgs::Twist>("/uuv_control/uuv_control_node/setpoint", 1000);
+    ros::Publisher  uuv_desired_setpoints       = nh.advertise<vanttec_uuv::ControlSetpoint>("/uuv_control/uuv_control_node/setpoint", 1000);
+    ros::Publisher  uuv_guidance_status         = nh.advertise<vanttec_uuv::GuidanceStatus>("/uuv_guidance/guidance_controller/status", 10);
+    ros::Publisher  uuv_mission_status          = nh.advertise<std_msgs::UInt8>("/uuv_missions/mission_manager/status", 10);
+    ros::Publisher  uuv_mission_path            = nh.advertise<nav_msgs::Path>("/uuv_missions/mission_manager/path", 10);
 
-    ros::Subscriber uuv_pose                    = nh.subscribe("/uuv_simulation/dynamic_model/pose",
-                                                                1000,
-                                                                &GuidanceController::OnCurrentPositionReception,
-                                                                &guidance_controller);
+    ros::Subscriber uuv_state                   = nh.subscribe("/uuv_simulation/dynamic_model/state",
+                                                                10,
+                                                                &GuidanceInputs::OnStateReception,
+                                                                &inputs);
 
     ros::Subscriber uuv_e_stop                  = nh.subscribe("/uuv_master/uuv_master_node/e_stop",
                                                                 1000,
@@ -45,6 +166,28 @@ int main(int argc, char **argv)
                                                                 &GuidanceController::OnMasterStatus,
                                                                 &guidance_controller);
 
+    ros::Subscriber uuv_obstacles               = nh.subscribe("/uuv_perception/simulated_perception/obstacles",
+                                                                1,
+                                                                &GuidanceInputs::OnObstacleReception,
+                                                                &inputs);
+
+    /* Live tuning, applied at the next cycle */
+    ros::ServiceServer uuv_set_parameters       = nh.advertiseService("/uuv_guidance/guidance_controller/set_parameters",
+                                                                      &GuidanceController::OnSetParameters,
+                                                                      &guidance_controller);
+
+    /* The mission manager runs in this process and hands its waypoints to the guidance directly */
+    ros::Subscriber uuv_mission                 = nh.subscribe("/uuv_missions/mission_manager/mission",
+                                                                10,
+                                                                &MissionManager::OnMissionRequest,
+                                                                &mission_manager);
+
+    /* Mission scripts are resumed every cycle, from the same process */
+    ros::Subscriber uuv_mission_script          = nh.subscribe("/uuv_missions/mission_scheduler/script",
+                                                                10,
+                                                                &MissionScripts::OnScriptRequest,
+                                                                &mission_scripts);
+
     uint32_t counter = 0;
  
     while(ros::ok())
@@ -52,18 +195,88 @@ int main(int argc, char **argv)
         /* Run Queued Callbacks */ 
         ros::spinOnce();
 
+        if (recorder.IsOpen())
+        {
+            recorder.RecordTick(ros::Time::now().toSec(), counter);
+        }
+
         /* Update Parameters with new info */ 
         guidance_controller.UpdateStateMachines();
 
+        /* Recorded every cycle, also while the setpoints are not published */
+        if (recorder.IsOpen())
+        {
+            recorder.RecordSetpoint(ros::Time::now().toSec(), guidance_controller.desired_setpoints, guidance_controller.state_trace);
+        }
+
         /* Publish Odometry */ 
         if (guidance_controller.uuv_status.status == 1)
         {
-            uuv_desired_setpoints.publish(guidance_controller.desired_setpoints);
+            setpoint.header.stamp   = ros::Time::now();
+            setpoint.trace          = guidance_controller.state_trace;
+            setpoint.setpoint       = guidance_controller.desired_setpoints;
+            uuv_desired_setpoints.publish(setpoint);
+            tracer.Record(state_to_setpoint, setpoint.trace, setpoint.header.stamp);
+        }
+
+        /* Publish Guidance Status at 10 Hz */
+        if (counter % 10 == 0)
+        {
+            guidance_controller.UpdateGuidanceStatus();
+            uuv_guidance_status.publish(guidance_controller.guidance_status);
+
+            /* Tick the mission within its budget so the guidance cycle is not delayed */
+            mission_manager.OnGuidanceStatus(guidance_controller.guidance_status);
+            mission_scheduler.OnGuidanceStatus(guidance_controller.guidance_status);
+            mission_manager.Iteration(std::chrono::microseconds(mission_tick_budget_us));
+
+            if (mission_manager.new_waypoints)
+            {
+                guidance_controller.OnWaypointReception(mission_manager.waypoints);
+                uuv_mission_path.publish(mission_manager.path);
+                mission_manager.new_waypoints = false;
+            }
+
+            std_msgs::UInt8 mission_status;
+            mission_status.data = mission_manager.mission_status;
+            uuv_mission_status.publish(mission_status);
+        }
+
+        /* A mission started while scripts were running takes the guidance from them */
+        if (mission_manager.mission_status == MISSION_RUNNING && mission_scheduler.running > 0)
+        {
+            ROS_WARN("Mission scheduler: %u scripts cancelled, a mission is running", mission_scheduler.running);
+            mission_scripts.CancelAll();
+            mission_scheduler.new_waypoints = false;
+        }
+
+        /* Suspended scripts are only resumed when their event arrives or their timer expires */
+        mission_scheduler.Tick(ros::Time::now().toSec());
+
+        if (mission_scheduler.new_waypoints)
+        {
+            guidance_controller.OnWaypointReception(mission_scheduler.waypoints);
+            uuv_mission_path.publish(mission_scheduler.path);
+            mission_scheduler.new_waypoints = false;
         }
 
+        counter++;
+
         /* Slee for 10ms */
         cycle_rate.sleep();
     }
+
+    tracer.LogSummary();
+
+    if (recorder.IsOpen())
+    {
+        ROS_INFO("Telemetry: %lu records, %lu segment rotations", (unsigned long) recorder.records, (unsigned long) recorder.rotations);
+    }
+
+    if (!trace_file.empty())
+    {
+        tracer.DumpChromeTrace(trace_file);
+    }
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_integration_drift.cpp
+ *
+ * @brief: Checks that the positions integrated by the dynamic model do not
+ *         drift over a long mission. The model is stepped through a
+ *         simulated survey, 6 hours at the 10 ms sample time by default, and
+ *         its NED position and heading are compared against the same
+ *         velocities integrated in long double. A straight run checks the
+ *         position, a turning run checks both the body and the NED heading,
+ *         whose float increments are reproduced exactly so only their sum is
+ *         measured.
+ *         CompensatedSum is also checked on its own. Exits with 1 when any
+ *         error is above its bound. Uses uuv_common and uuv_simulation
+ *         libraries.
+ *
+ *             uuv_integration_drift [hours]
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "uuv_dynamic_4dof_model.hpp"
+#include "compensated_sum.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static const float      SAMPLE_TIME_S           = 0.01;
+static const double     SURVEY_HOURS            = 6;
+
+/* About 14 km at the speed the surge thrust settles to, float accumulation
+   was off by hundreds of meters over the same survey */
+static const float      SURVEY_SURGE_THRUST     = 20;
+static const double     MAX_POSITION_ERROR_M    = 0.01;
+
+/* About 37000 rad of turning, float accumulation was off by 0.05 rad */
+static const float      SURVEY_YAW_THRUST       = 2;
+static const double     MAX_HEADING_ERROR_RAD   = 1e-6;
+
+/* The model wraps its headings by this approximation of 2 pi */
+static const double     MODEL_HEADING_PERIOD    = 2 * 3.14159f;
+
+/* Accumulator alone: a float sum of small steps, the plain sum loses them */
+static const uint64_t   SUM_STEPS               = 2160000;
+static const float      SUM_STEP                = 0.001;
+static const double     MAX_SUM_ERROR           = 1e-3;
+
+typedef struct DriftResult_S
+{
+    double  x_error_m;
+    double  y_error_m;
+    double  z_error_m;
+    double  body_heading_error_rad;
+    double  ned_heading_error_rad;
+} DriftResult_S;
+
+static double HeadingError(double _heading, long double _reference)
+{
+    return std::fabs(std::remainder((double) (_heading - _reference), MODEL_HEADING_PERIOD));
+}
+
+static void Survey(uint64_t _cycles, float _surge_thrust, float _yaw_thrust, DriftResult_S* _result)
+{
+    UUVDynamic4DOFModel model(SAMPLE_TIME_S);
+    vanttec_uuv::ThrustControl thrust;
+
+    thrust.tau_x    = _surge_thrust;
+    thrust.tau_y    = 0;
+    thrust.tau_z    = 0;
+    thrust.tau_yaw  = _yaw_thrust;
+    model.ThrustCallback(thrust);
+
+    /* Trapezoidal rule as in the model, with the heading of the model at each step. The
+       position increments are exact, the ones of the heading are the float ones of the model */
+    long double x       = 0;
+    long double y       = 0;
+    long double z       = 0;
+    long double heading = 0;
+    long double u_prev  = 0;
+    long double v_prev  = 0;
+    long double w_prev  = 0;
+    float       r_prev  = 0;
+
+    for (uint64_t cycle = 0; cycle < _cycles; cycle++)
+    {
+        model.CalculateStates();
+
+        long double u = model.state.u;
+        long double v = model.state.v;
+        long double w = model.state.w;
+        float       r = model.state.r;
+        long double c = std::cos((long double) model.angular_position.z);
+        long double s = std::sin((long double) model.angular_position.z);
+
+        x       += (c * (u + u_prev) - s * (v + v_prev)) / 2 * SAMPLE_TIME_S;
+        y       += (s * (u + u_prev) + c * (v + v_prev)) / 2 * SAMPLE_TIME_S;
+        z       += (w + w_prev) / 2 * SAMPLE_TIME_S;
+        heading += (float) ((r + r_prev) / 2 * SAMPLE_TIME_S);
+
+        u_prev  = u;
+        v_prev  = v;
+        w_prev  = w;
+        r_prev  = r;
+    }
+
+    _result->x_error_m              = std::fabs((double) (model.state.x - x));
+    _result->y_error_m              = std::fabs((double) (model.state.y - y));
+    _result->z_error_m              = std::fabs((double) (model.state.z - z));
+    _result->body_heading_error_rad = HeadingError(model.angular_position.z, heading);
+    _result->ned_heading_error_rad  = HeadingError(model.state.yaw, heading);
+}
+
+static bool CheckSurvey(const char* _name, const DriftResult_S& _result)
+{
+    double position_error = std::max(_result.x_error_m, std::max(_result.y_error_m, _result.z_error_m));
+    double heading_error = std::max(_result.body_heading_error_rad, _result.ned_heading_error_rad);
+    bool passed = position_error <= MAX_POSITION_ERROR_M && heading_error <= MAX_HEADING_ERROR_RAD;
+
+    std::printf("%-10s position error x %.3g y %.3g z %.3g m, heading error body %.3g ned %.3g rad, %s\n",
+                _name, _result.x_error_m, _result.y_error_m, _result.z_error_m,
+                _result.body_heading_error_rad, _result.ned_heading_error_rad,
+                passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+static bool CheckCompensatedSum()
+{
+    CompensatedSum<float> sum(0.0f);
+    float plain = 0;
+
+    for (uint64_t step = 0; step < SUM_STEPS; step++)
+    {
+        sum.Add(SUM_STEP);
+        plain += SUM_STEP;
+    }
+
+    long double reference = (long double) SUM_STEP * SUM_STEPS;
+    double error = std::fabs((double) (sum.sum - reference));
+    bool passed = error <= MAX_SUM_ERROR;
+
+    std::printf("%-10s error %.3g, plain float sum error %.3g, %s\n", "sum", error,
+                std::fabs((double) (plain - reference)), passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+int main(int argc, char **argv)
+{
+    double hours = argc > 1 ? std::strtod(argv[1], NULL) : SURVEY_HOURS;
+
+    if (!(hours > 0))
+    {
+        std::fprintf(stderr, "usage: %s [hours]\n", argv[0]);
+        return 2;
+    }
+
+    uint64_t cycles = hours * 3600 / SAMPLE_TIME_S;
+    DriftResult_S straight;
+    DriftResult_S turning;
+    int result = 0;
+
+    std::printf("%.2f hours, %llu steps\n", hours, (unsigned long long) cycles);
+
+    Survey(cycles, SURVEY_SURGE_THRUST, 0, &straight);
+    Survey(cycles, 0, SURVEY_YAW_THRUST, &turning);
+
+    if (!CheckSurvey("straight", straight))
+    {
+        result = 1;
+    }
+    if (!CheckSurvey("turning", turning))
+    {
+        result = 1;
+    }
+    if (!CheckCompensatedSum())
+    {
+        result = 1;
+    }
+
+    return result;
+}
@@ -9,6 +9,7 @@
  **/
 
 #include "master_node.hpp"
+#include "vanttec_uuv/ControlSetpoint.h"
 
 #include <ros/ros.h>
 #include <stdio.h>
@@ -24,7 +25,7 @@ int main(int argc, char **argv)
     ros::Rate           cycle_rate(int(1 / SAMPLE_TIME_S));
     UUVMasterNode       uuv_master(DEFAULT_SPEED_MPS);
         
-    ros::Publisher  uuv_vel      = nh.advertise<geometry_msgs::Twist>("/uuv_control/uuv_control_node/setpoint", 1000);
+    ros::Publisher  uuv_vel      = nh.advertise<vanttec_uuv::ControlSetpoint>("/uuv_control/uuv_control_node/setpoint", 1000);
     ros::Publisher  uuv_status   = nh.advertise<vanttec_uuv::MasterStatus>("/uuv_master/uuv_master_node/status", 1000);
     ros::Publisher  uuv_estop    = nh.advertise<std_msgs::Empty>("/uuv_master/uuv_master_node/e_stop", 1000);
 
@@ -38,17 +39,25 @@ int main(int argc, char **argv)
                                                 &UUVMasterNode::keyboardDownCallback,
                                                 &uuv_master);
 
+    vanttec_uuv::ControlSetpoint setpoint;
+
     while(ros::ok())
     {
         /* Run Queued Callbacks */ 
         ros::spinOnce();
 
         /* Publish Data */ 
+        uuv_master.status.header.stamp = ros::Time::now();
         uuv_status.publish(uuv_master.status);
 
+        /* Manual setpoints start their own trace */
         if (uuv_master.status.status == 0)
         {
-            uuv_vel.publish(uuv_master.velocities);
+            setpoint.header.stamp           = uuv_master.status.header.stamp;
+            setpoint.trace.trace_id++;
+            setpoint.trace.origin_stamp     = setpoint.header.stamp;
+            setpoint.setpoint               = uuv_master.velocities;
+            uuv_vel.publish(setpoint);
         }
                 
         if (uuv_master.e_stop_flag == 1)
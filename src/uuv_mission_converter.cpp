@@ -0,0 +1,41 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_mission_converter.cpp
+ * 
+ * @brief: Converts CSV missions into binary mission files. Uses
+ *         uuv_motion_planning library.
+ *
+ *             uuv_mission_converter mission.csv mission.bin
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "mission_file.hpp"
+
+#include <cstdio>
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::fprintf(stderr, "usage: %s <mission.csv> <mission.bin>\n", argv[0]);
+        return 2;
+    }
+
+    uint64_t waypoint_count = 0;
+    uint64_t malformed_lines = 0;
+
+    if (!MissionFile::FromCsv(argv[1], argv[2], &waypoint_count, &malformed_lines))
+    {
+        std::fprintf(stderr, "could not convert %s into %s\n", argv[1], argv[2]);
+        return 1;
+    }
+
+    std::printf("%lu waypoints written to %s\n", (unsigned long) waypoint_count, argv[2]);
+
+    if (malformed_lines > 0)
+    {
+        std::fprintf(stderr, "%lu malformed lines skipped\n", (unsigned long) malformed_lines);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_mission_player_node.cpp
+ * 
+ * @brief: ROS mission player node for the UUV. Uses uuv_motion_planning
+ *         library.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "mission_player.hpp"
+
+#include <ros/ros.h>
+#include <algorithm>
+
+const float SAMPLE_TIME_S = 0.1;
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "uuv_mission_player_node");
+    ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    std::string mission_file;
+    int         page_size;
+
+    private_nh.param("mission_file", mission_file, std::string(""));
+    private_nh.param("page_size", page_size, 64);
+
+    ros::Rate       cycle_rate(int(1 / SAMPLE_TIME_S));
+    MissionPlayer   mission_player(std::min(std::max(page_size, 3), 255));
+
+    if (!mission_player.Load(mission_file))
+    {
+        ROS_ERROR("Mission player: could not load %s: %s", mission_file.c_str(), mission_player.mission.error);
+        return 1;
+    }
+
+    ROS_INFO("Mission player: %lu waypoints in %s", (unsigned long) mission_player.mission.waypoint_count, mission_file.c_str());
+
+    ros::Publisher  uuv_waypoints   = nh.advertise<vanttec_uuv::GuidanceWaypoints>("/uuv_guidance/guidance_controller/waypoints", 10);
+    ros::Publisher  uuv_path        = nh.advertise<nav_msgs::Path>("/uuv_planning/motion_planning/desired_path", 10);
+
+    ros::Subscriber uuv_state       = nh.subscribe("/uuv_simulation/dynamic_model/state",
+                                                   1,
+                                                   &MissionPlayer::OnStateReception,
+                                                   &mission_player);
+
+    ros::Subscriber guidance_status = nh.subscribe("/uuv_guidance/guidance_controller/status",
+                                                   1,
+                                                   &MissionPlayer::OnGuidanceStatus,
+                                                   &mission_player);
+
+    while(ros::ok() && !mission_player.finished)
+    {
+        /* Run Queued Callbacks */ 
+        ros::spinOnce();
+
+        /* Send the next page when the guidance is about to run out */
+        if (mission_player.Iteration())
+        {
+            uuv_path.publish(mission_player.path);
+            uuv_waypoints.publish(mission_player.waypoints);
+        }
+
+        /* Sleep for 100ms */
+        cycle_rate.sleep();
+    }
+
+    return 0;
+}
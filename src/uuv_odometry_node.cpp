@@ -9,52 +9,82 @@
  **/
 
 #include "odometry_calculator.hpp"
+#include "latency_tracer.hpp"
 
 #include <ros/ros.h>
 
 const float SAMPLE_TIME_S = 0.01;
 
+/* Enough room for several control periods of an 800 Hz IMU stream */
+const size_t IMU_BUFFER_CAPACITY = 256;
+const uint32_t IMU_QUEUE_SIZE = 100;
+const size_t TRACE_EVENT_CAPACITY = 1 << 16;
+
+/* VN-100 noise densities, in rad/s/sqrt(Hz) and m/s^2/sqrt(Hz) */
+const float GYRO_NOISE_DENSITY = 6.1e-5;
+const float ACCEL_NOISE_DENSITY = 1.4e-3;
+
+/* VN-100 attitude accuracy, 0.5 deg in pitch and roll and 2 deg in heading */
+const float TILT_NOISE_RAD = 0.5 * M_PI / 180;
+const float HEADING_NOISE_RAD = 2.0 * M_PI / 180;
+
 int main(int argc, char **argv)
 {
     ros::init(argc, argv, "uuv_odometry_node");
     ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    std::string trace_file;
+    private_nh.param("trace_file", trace_file, std::string(""));
     
     ros::Rate           cycle_rate(int(1 / SAMPLE_TIME_S));
-    OdometryCalculator  odom_calc(SAMPLE_TIME_S);
+    OdometryCalculator  odom_calc(SAMPLE_TIME_S, IMU_BUFFER_CAPACITY, GYRO_NOISE_DENSITY, ACCEL_NOISE_DENSITY,
+                                  TILT_NOISE_RAD, HEADING_NOISE_RAD);
+    LatencyTracer       tracer("uuv_odometry_node", TRACE_EVENT_CAPACITY);
+
+    uint8_t imu_to_state = tracer.AddStage("imu_to_state");
     
-    ros::Publisher  uuv_pose    = nh.advertise<geometry_msgs::Pose>("/uuv_control/odometry_calculator/pose", 1000);
-    ros::Publisher  uuv_twist   = nh.advertise<geometry_msgs::Twist>("/uuv_control/odometry_calculator/twist", 1000);
-    ros::Publisher  uuv_accel   = nh.advertise<geometry_msgs::Accel>("/uuv_control/odometry_calculator/accel", 1000);
+    ros::Publisher  uuv_state   = nh.advertise<vanttec_uuv::VehicleState>("/uuv_control/odometry_calculator/state", 10);
 
     ros::Subscriber uuv_linear_accel = nh.subscribe("/vectornav/ins_3d/ins_acc", 
-                                                    10, 
+                                                    IMU_QUEUE_SIZE, 
                                                     &OdometryCalculator::AccelPubCallback, 
-                                                    &odom_calc);
+                                                    &odom_calc,
+                                                    ros::TransportHints().tcpNoDelay());
     ros::Subscriber uuv_angular_rate = nh.subscribe("/vectornav/ins_3d/ins_ar", 
-                                                    10, 
+                                                    IMU_QUEUE_SIZE, 
                                                     &OdometryCalculator::AngularRateCallback, 
-                                                    &odom_calc);
+                                                    &odom_calc,
+                                                    ros::TransportHints().tcpNoDelay());
     ros::Subscriber uuv_angular_pose = nh.subscribe("/vectornav/ins_3d/ins_ypr", 
-                                                    10, 
+                                                    IMU_QUEUE_SIZE, 
                                                     &OdometryCalculator::AngularPositionCallback, 
-                                                    &odom_calc);
+                                                    &odom_calc,
+                                                    ros::TransportHints().tcpNoDelay());
     
     while(ros::ok())
     {
         /* Run Queued Callbacks */
         ros::spinOnce();
 
-        /* Update Parameters with new info */
-        odom_calc.UpdateParameters();
+        /* Preintegrate all buffered samples and publish at the control rate */
+        odom_calc.UpdateParameters(ros::Time::now().toSec());
 
         /* Publish Odometry */
-        uuv_pose.publish(odom_calc.pose);
-        uuv_twist.publish(odom_calc.twist);
-        uuv_accel.publish(odom_calc.accel);
+        odom_calc.state.header.frame_id = "world";
+        uuv_state.publish(odom_calc.state);
+        tracer.Record(imu_to_state, odom_calc.state.trace, ros::Time::now());
 
         /* Slee for 10ms */
         cycle_rate.sleep();
     }
 
+    tracer.LogSummary();
+
+    if (!trace_file.empty())
+    {
+        tracer.DumpChromeTrace(trace_file);
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_path_planner_node.cpp
+ * 
+ * @brief: ROS path planner node for the UUV. Uses uuv_motion_planning
+ *         library.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "path_planner.hpp"
+
+#include <ros/ros.h>
+
+const float SAMPLE_TIME_S = 0.1;
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "uuv_path_planner_node");
+    ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    float   min_x, min_y, min_z;
+    float   size_x, size_y, size_z;
+    float   resolution_m;
+    float   inflation_m;
+    int     max_nodes;
+    bool    any_angle;
+
+    private_nh.param("min_x", min_x, -50.0f);
+    private_nh.param("min_y", min_y, -50.0f);
+    private_nh.param("min_z", min_z, 0.0f);
+    private_nh.param("size_x", size_x, 100.0f);
+    private_nh.param("size_y", size_y, 100.0f);
+    private_nh.param("size_z", size_z, 20.0f);
+    private_nh.param("resolution_m", resolution_m, 0.25f);
+    private_nh.param("inflation_m", inflation_m, 0.5f);
+    private_nh.param("max_nodes", max_nodes, 1 << 22);
+    private_nh.param("any_angle", any_angle, false);
+
+    ros::Rate       cycle_rate(int(1 / SAMPLE_TIME_S));
+    PathPlanner     path_planner(Eigen::Vector3f(min_x, min_y, min_z),
+                                 Eigen::Vector3f(size_x, size_y, size_z),
+                                 resolution_m, inflation_m, max_nodes);
+
+    path_planner.planner.any_angle = any_angle;
+
+    ros::Publisher  uuv_waypoints   = nh.advertise<vanttec_uuv::GuidanceWaypoints>("/uuv_guidance/guidance_controller/waypoints", 10);
+    ros::Publisher  uuv_path        = nh.advertise<nav_msgs::Path>("/uuv_planning/motion_planning/desired_path", 10);
+
+    ros::Subscriber world           = nh.subscribe("/uuv_simulation/obstacle_simulation/obstacles",
+                                                   1,
+                                                   &PathPlanner::OnWorldReception,
+                                                   &path_planner);
+
+    ros::Subscriber uuv_state       = nh.subscribe("/uuv_simulation/dynamic_model/state",
+                                                   1,
+                                                   &PathPlanner::OnStateReception,
+                                                   &path_planner);
+
+    ros::Subscriber goal            = nh.subscribe("/uuv_planning/motion_planning/goal",
+                                                   1,
+                                                   &PathPlanner::OnGoalReception,
+                                                   &path_planner);
+
+    ros::Subscriber guidance_status = nh.subscribe("/uuv_guidance/guidance_controller/status",
+                                                   1,
+                                                   &PathPlanner::OnGuidanceStatus,
+                                                   &path_planner);
+
+    while(ros::ok())
+    {
+        /* Run Queued Callbacks */ 
+        ros::spinOnce();
+
+        /* Replan when the goal or the world changed, stream the rest of long paths */
+        if (path_planner.Iteration())
+        {
+            uuv_path.publish(path_planner.path);
+            uuv_waypoints.publish(path_planner.waypoints);
+        }
+
+        /* Sleep for 100ms */
+        cycle_rate.sleep();
+    }
+
+    return 0;
+}
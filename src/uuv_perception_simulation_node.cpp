@@ -0,0 +1,66 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_perception_simulation_node.cpp
+ * 
+ * @brief: ROS simulated perception node for the UUV. Uses uuv_simulation library.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "perception_simulator.hpp"
+
+#include <ros/ros.h>
+#include <string>
+
+static const double SAMPLE_TIME_S = 1.0 / 30;
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "uuv_perception_simulation_node");
+    ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    SensorModel_S   sensor;
+    float           cell_size_m;
+    int             seed;
+
+    private_nh.param("min_range_m", sensor.min_range_m, 0.3f);
+    private_nh.param("max_range_m", sensor.max_range_m, 15.0f);
+    private_nh.param("horizontal_fov_rad", sensor.horizontal_fov_rad, 1.57f);
+    private_nh.param("vertical_fov_rad", sensor.vertical_fov_rad, 1.05f);
+    private_nh.param("position_noise_m", sensor.position_noise_m, 0.05f);
+    private_nh.param("range_noise_ratio", sensor.range_noise_ratio, 0.01f);
+    private_nh.param("dropout_probability", sensor.dropout_probability, 0.05f);
+    private_nh.param("cell_size_m", cell_size_m, 5.0f);
+    private_nh.param("seed", seed, 0);
+
+    ros::Rate               cycle_rate(1 / SAMPLE_TIME_S);
+    PerceptionSimulator     perception_simulator(sensor, "uuv", cell_size_m, seed);
+
+    ros::Publisher  detections  = nh.advertise<vanttec_uuv::ObstacleList>("/uuv_perception/simulated_perception/obstacles", 10);
+
+    ros::Subscriber world       = nh.subscribe("/uuv_simulation/obstacle_simulation/obstacles", 
+                                               1, 
+                                               &PerceptionSimulator::OnWorldReception, 
+                                               &perception_simulator);
+
+    ros::Subscriber uuv_state   = nh.subscribe("/uuv_simulation/dynamic_model/state", 
+                                               1, 
+                                               &PerceptionSimulator::OnStateReception, 
+                                               &perception_simulator);
+
+    while(ros::ok())
+    {
+        /* Run Queued Callbacks */
+        ros::spinOnce();
+
+        /* Detect the obstacles in view */
+        perception_simulator.Iteration();
+
+        /* Publish Detections */
+        detections.publish(perception_simulator.detections);
+
+        /* Sleep at the camera rate */
+        cycle_rate.sleep();
+    }
+
+    return 0;
+}
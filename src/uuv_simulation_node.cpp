@@ -9,36 +9,108 @@
  **/
 
 #include "uuv_dynamic_4dof_model.hpp"
+#include "current_field.hpp"
+#include "latency_tracer.hpp"
+#include "telemetry_recorder.hpp"
 
 #include <ros/ros.h>
 #include <stdio.h>
 
 static const float SAMPLE_TIME_S = 0.01;
+static const size_t TRACE_EVENT_CAPACITY = 1 << 16;
 
 int main(int argc, char **argv)
 {
     ros::init(argc, argv, "uuv_simulation_node");
     ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    std::string vehicle_file;
+    std::string current_file;
+    std::string trace_file;
+    std::string telemetry_dir;
+    int         telemetry_segment_records;
+    int         telemetry_segments;
+    private_nh.param("vehicle_file", vehicle_file, std::string(""));
+    private_nh.param("current_file", current_file, std::string(""));
+    private_nh.param("trace_file", trace_file, std::string(""));
+    private_nh.param("telemetry_dir", telemetry_dir, std::string(""));
+    private_nh.param("telemetry_segment_records", telemetry_segment_records, 65536);
+    private_nh.param("telemetry_segments", telemetry_segments, 16);
+
+    /* A file given to the node wins over the vehicle namespace */
+    VehicleParameters       vehicle;
+    bool vehicle_loaded = vehicle_file.empty() ? vehicle.LoadParameterServer(ros::NodeHandle(nh, VEHICLE_PARAMETERS_NAMESPACE))
+                                               : vehicle.LoadFile(vehicle_file);
+
+    if (!vehicle_loaded)
+    {
+        ROS_ERROR("Vehicle: %s", vehicle.error.c_str());
+        return 1;
+    }
         
+    /* Still water without a current file */
+    CurrentField            current_field;
+
+    if (!current_file.empty() && !current_field.Load(current_file))
+    {
+        ROS_ERROR("Current: %s", current_field.error.c_str());
+        return 1;
+    }
+
     ros::Rate               cycle_rate(int(1 / SAMPLE_TIME_S));
-    UUVDynamic4DOFModel     uuv_model(SAMPLE_TIME_S);
+    UUVDynamic4DOFModel     uuv_model(SAMPLE_TIME_S, vehicle);
+    LatencyTracer           tracer("uuv_simulation_node", TRACE_EVENT_CAPACITY);
+    TelemetryRecorder       recorder;
+
+    if (!current_file.empty())
+    {
+        uuv_model.current_field = &current_field;
+    }
+
+    if (!telemetry_dir.empty())
+    {
+        if (recorder.Open(telemetry_dir, "uuv_simulation_node", telemetry_segment_records, telemetry_segments))
+        {
+            uuv_model.recorder = &recorder;
+        }
+        else
+        {
+            ROS_ERROR("Telemetry: could not open %s: %s", telemetry_dir.c_str(), recorder.error);
+        }
+    }
+
+    /* From a state sample to the thrust computed from it being applied */
+    uint8_t state_to_thrust_applied = tracer.AddStage("state_to_thrust_applied");
     
     ros::Publisher  uuv_accel  = nh.advertise<geometry_msgs::Vector3>("/vectornav/ins_3d/ins_acc", 1000);
     ros::Publisher  uuv_arate  = nh.advertise<geometry_msgs::Vector3>("/vectornav/ins_3d/ins_ar", 1000);
     ros::Publisher  uuv_apos   = nh.advertise<geometry_msgs::Vector3>("/vectornav/ins_3d/ins_ypr", 1000);
-    ros::Publisher  uuv_vel    = nh.advertise<geometry_msgs::Twist>("/uuv_simulation/dynamic_model/vel", 1000);
-    ros::Publisher  uuv_pos    = nh.advertise<geometry_msgs::Pose>("/uuv_simulation/dynamic_model/pose", 1000);
+    ros::Publisher  uuv_state  = nh.advertise<vanttec_uuv::VehicleState>("/uuv_simulation/dynamic_model/state", 10);
 
     ros::Subscriber uuv_thrust_input = nh.subscribe("/uuv_control/uuv_control_node/thrust", 
                                                     10, 
                                                     &UUVDynamic4DOFModel::ThrustCallback, 
                                                     &uuv_model);
     
+    uint64_t cycle = 0;
+
     while(ros::ok())
     {
         /* Run Queued Callbacks */
         ros::spinOnce();
 
+        if (recorder.IsOpen())
+        {
+            recorder.RecordTick(ros::Time::now().toSec(), cycle);
+        }
+
+        if (uuv_model.new_thrust)
+        {
+            tracer.Record(state_to_thrust_applied, uuv_model.thrust_trace, ros::Time::now());
+            uuv_model.new_thrust = false;
+        }
+
         /* Calculate Model States */
         uuv_model.CalculateStates();
 
@@ -46,12 +118,34 @@ int main(int argc, char **argv)
         uuv_accel.publish(uuv_model.linear_acceleration);
         uuv_arate.publish(uuv_model.angular_rate);
         uuv_apos.publish(uuv_model.angular_position);
-        uuv_vel.publish(uuv_model.velocities);
-        uuv_pos.publish(uuv_model.pose);
+
+        uuv_model.state.header.stamp = ros::Time::now();
+        uuv_model.state.header.frame_id = "world";
+        uuv_model.state.trace.origin_stamp = uuv_model.state.header.stamp;
+        uuv_state.publish(uuv_model.state);
+
+        if (recorder.IsOpen())
+        {
+            recorder.RecordState(uuv_model.state.header.stamp.toSec(), uuv_model.state);
+        }
+
+        cycle++;
         
         /* Sleep for 10ms */
         cycle_rate.sleep();
     }
 
+    tracer.LogSummary();
+
+    if (recorder.IsOpen())
+    {
+        ROS_INFO("Telemetry: %lu records, %lu segment rotations", (unsigned long) recorder.records, (unsigned long) recorder.rotations);
+    }
+
+    if (!trace_file.empty())
+    {
+        tracer.DumpChromeTrace(trace_file);
+    }
+
     return 0;
 }
\ No newline at end of file
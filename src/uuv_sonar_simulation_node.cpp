@@ -0,0 +1,86 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_sonar_simulation_node.cpp
+ * 
+ * @brief: ROS sonar simulation node for the UUV. Uses uuv_simulation library.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "sonar_simulator.hpp"
+
+#include <ros/ros.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "uuv_sonar_simulation_node");
+    ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
+
+    SonarModel_S    sonar;
+    std::string     sonar_type;
+    std::string     seabed_file;
+    float           seabed_depth_m;
+    float           cell_size_m;
+    float           rate_hz;
+    int             thread_count;
+    int             seed;
+
+    private_nh.param("sonar_type", sonar_type, std::string("forward_looking"));
+    private_nh.param("beam_count", sonar.beam_count, 256);
+    private_nh.param("fan_angle_rad", sonar.fan_angle_rad, 2.09f);
+    private_nh.param("tilt_rad", sonar.tilt_rad, 0.17f);
+    private_nh.param("min_range_m", sonar.min_range_m, 0.2f);
+    private_nh.param("max_range_m", sonar.max_range_m, 30.0f);
+    private_nh.param("range_noise_m", sonar.range_noise_m, 0.02f);
+    private_nh.param("seabed_file", seabed_file, std::string(""));
+    private_nh.param("seabed_depth_m", seabed_depth_m, 10.0f);
+    private_nh.param("cell_size_m", cell_size_m, 5.0f);
+    private_nh.param("rate_hz", rate_hz, 15.0f);
+    private_nh.param("threads", thread_count, int(std::min(4u, std::max(1u, std::thread::hardware_concurrency()))));
+    private_nh.param("seed", seed, 0);
+
+    sonar.sonar_type = (sonar_type == "multibeam") ? SONAR_MULTIBEAM : SONAR_FORWARD_LOOKING;
+
+    ros::Rate           cycle_rate(rate_hz);
+    SonarSimulator      sonar_simulator(sonar, "uuv", cell_size_m, seabed_depth_m, thread_count, seed);
+
+    if (!seabed_file.empty() && !sonar_simulator.seabed.Load(seabed_file))
+    {
+        ROS_WARN("Could not load seabed map %s, using a flat bottom at %.1f m", seabed_file.c_str(), seabed_depth_m);
+    }
+
+    sonar_simulator.scan.scan_time = 1 / rate_hz;
+
+    ros::Publisher  scan        = nh.advertise<sensor_msgs::LaserScan>("/uuv_simulation/sonar_simulation/scan", 10);
+    ros::Publisher  cloud       = nh.advertise<sensor_msgs::PointCloud2>("/uuv_simulation/sonar_simulation/points", 10);
+
+    ros::Subscriber world       = nh.subscribe("/uuv_simulation/obstacle_simulation/obstacles", 
+                                               1, 
+                                               &SonarSimulator::OnWorldReception, 
+                                               &sonar_simulator);
+
+    ros::Subscriber uuv_state   = nh.subscribe("/uuv_simulation/dynamic_model/state", 
+                                               1, 
+                                               &SonarSimulator::OnStateReception, 
+                                               &sonar_simulator);
+
+    while(ros::ok())
+    {
+        /* Run Queued Callbacks */
+        ros::spinOnce();
+
+        /* Cast the beams from the latest pose */
+        sonar_simulator.Iteration();
+
+        /* Publish Scan */
+        scan.publish(sonar_simulator.scan);
+        cloud.publish(sonar_simulator.cloud);
+
+        /* Sleep at the ping rate */
+        cycle_rate.sleep();
+    }
+
+    return 0;
+}
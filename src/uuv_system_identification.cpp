@@ -0,0 +1,123 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_system_identification.cpp
+ *
+ * @brief: Fits the added mass and damping coefficients of the 4-DOF model
+ *         to logged thrust, velocities and accelerations, and writes the
+ *         resulting vehicle file, which the simulation and control nodes
+ *         load with ~vehicle_file. Everything that is not fitted is taken
+ *         from the base vehicle file. Takes run directories, as written
+ *         with ~telemetry_dir, or segment files; logs without states and
+ *         thrust add nothing. Uses uuv_common and uuv_simulation libraries.
+ *
+ *             uuv_system_identification config/vehicles/vtec_u3_gamma.yaml fitted.yaml logs/2020_08_02_lake
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "system_identification.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::fprintf(stderr, "usage: %s <base vehicle.yaml> <output vehicle.yaml> <run directory | segment.tlm>...\n", argv[0]);
+        return 2;
+    }
+
+    VehicleParameters base;
+
+    if (!base.LoadFile(argv[1]))
+    {
+        std::fprintf(stderr, "%s\n", base.error.c_str());
+        return 2;
+    }
+
+    std::map<std::string, std::vector<std::string> > logs;
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (!TelemetryReader::FindLogs(argv[i], &logs))
+        {
+            std::fprintf(stderr, "%s: not a run directory or a segment file\n", argv[i]);
+            return 2;
+        }
+    }
+
+    SystemIdentification identification(base);
+
+    for (std::map<std::string, std::vector<std::string> >::iterator log = logs.begin(); log != logs.end(); log++)
+    {
+        TelemetryReader reader;
+
+        if (!reader.Open(log->second))
+        {
+            std::fprintf(stderr, "%s: %s\n", log->first.c_str(), reader.error);
+            return 2;
+        }
+
+        std::printf("%s: %lu samples\n", log->first.c_str(), (unsigned long) identification.AddLog(reader));
+    }
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool fitted = identification.Fit(threads);
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!fitted)
+    {
+        std::fprintf(stderr, "%s\n", identification.error.c_str());
+        return 1;
+    }
+
+    std::printf("%lu samples fitted in %.3f s on %u threads\n",
+                (unsigned long) identification.samples.size(), elapsed_s, threads);
+
+    for (size_t i = 0; i < SYSID_COEFFICIENTS; i++)
+    {
+        std::printf("    %-8s %12.6g -> %12.6g%s\n",
+                    SystemIdentification::CoefficientName(i),
+                    SystemIdentification::Coefficient(base, i),
+                    SystemIdentification::Coefficient(identification.vehicle, i),
+                    identification.estimated[i] ? "" : " (not excited, kept)");
+    }
+
+    std::ostringstream header;
+    header << "Fitted by uuv_system_identification from " << argv[1] << " and\n";
+
+    for (std::map<std::string, std::vector<std::string> >::iterator log = logs.begin(); log != logs.end(); log++)
+    {
+        header << "    " << log->first << "\n";
+    }
+
+    header << identification.samples.size() << " samples, rms residual in m/s^2 and rad/s^2: surge "
+           << identification.rms_residual[0] << ", sway " << identification.rms_residual[1] << ", heave "
+           << identification.rms_residual[2] << ", yaw " << identification.rms_residual[3] << "\n";
+
+    for (size_t i = 0; i < SYSID_COEFFICIENTS; i++)
+    {
+        if (!identification.estimated[i])
+        {
+            header << SystemIdentification::CoefficientName(i) << " was not excited and keeps the base value\n";
+        }
+    }
+
+    std::printf("rms residual: surge %.3g, sway %.3g, heave %.3g, yaw %.3g\n",
+                identification.rms_residual[0], identification.rms_residual[1],
+                identification.rms_residual[2], identification.rms_residual[3]);
+
+    if (!identification.vehicle.SaveFile(argv[2], header.str()))
+    {
+        std::fprintf(stderr, "%s\n", identification.vehicle.error.c_str());
+        return 2;
+    }
+
+    std::printf("written to %s\n", argv[2]);
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_telemetry_converter.cpp
+ *
+ * @brief: Converts the telemetry segments of one node into CSV, one file per
+ *         record type, named <prefix>_<type>.csv. Values are printed with
+ *         enough digits to read back the recorded ones exactly. Uses
+ *         uuv_common library.
+ *
+ *             uuv_telemetry_converter run/control run/uuv_control_node_*.tlm
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "telemetry_recorder.hpp"
+
+#include <cstdio>
+
+typedef struct TelemetryCsv_S
+{
+    const char*     name;
+    const char*     columns;
+} TelemetryCsv_S;
+
+/* Indexed by TelemetryRecordType_E, every file starts with sequence and time_s */
+static const TelemetryCsv_S TELEMETRY_CSV[TELEMETRY_RECORD_TYPES] =
+{
+    {"tick",            "cycle"},
+    {"state",           "x,y,z,roll,pitch,yaw,u,v,w,p,q,r,u_dot,v_dot,w_dot,p_dot,q_dot,r_dot,state_sequence,trace_id,origin_s"},
+    {"setpoint",        "linear_x,linear_y,linear_z,angular_x,angular_y,angular_z,trace_id,origin_s"},
+    {"thrust",          "tau_x,tau_y,tau_z,tau_yaw,trace_id,origin_s"},
+    {"pid",             "axis,set_point,error,prev_error,manipulation,f_x,g_x,k_p,k_i,k_d,transfer"},
+    {"waypoint_list",   "guidance_law,waypoint_list_length,list_sequence,x_count,y_count,z_count,speed_count,acceptance_radius_count"},
+    {"waypoint",        "index,x,y,z,speed,acceptance_radius"},
+    {"master_status",   "status,desired_routine"},
+    {"emergency_stop",  ""},
+    {"obstacle_list",   "count,frame_id"},
+    {"obstacle",        "x,y,z,orientation_z,orientation_w,radio,height,length,obstacle_class"},
+    {"parameter",       "name,value,text"},
+};
+
+static void WriteRecord(FILE* _file, const TelemetryRecord_S& _record)
+{
+    std::fprintf(_file, "%u,%.17g", _record.sequence, _record.time_s);
+
+    switch ((TelemetryRecordType_E) _record.type)
+    {
+        case TELEMETRY_TICK:
+            std::fprintf(_file, ",%lu", (unsigned long) _record.tick.cycle);
+            break;
+        case TELEMETRY_STATE:
+        {
+            const TelemetryState_S& state = _record.state;
+            std::fprintf(_file, ",%.17g,%.17g,%.17g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%u,%lu,%.17g",
+                         state.x, state.y, state.z, state.roll, state.pitch, state.yaw,
+                         state.u, state.v, state.w, state.p, state.q, state.r,
+                         state.u_dot, state.v_dot, state.w_dot, state.p_dot, state.q_dot, state.r_dot,
+                         state.sequence, (unsigned long) state.trace_id, state.origin_s);
+            break;
+        }
+        case TELEMETRY_SETPOINT:
+        {
+            const TelemetrySetpoint_S& setpoint = _record.setpoint;
+            std::fprintf(_file, ",%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%lu,%.17g",
+                         setpoint.linear_x, setpoint.linear_y, setpoint.linear_z,
+                         setpoint.angular_x, setpoint.angular_y, setpoint.angular_z,
+                         (unsigned long) setpoint.trace_id, setpoint.origin_s);
+            break;
+        }
+        case TELEMETRY_THRUST:
+        {
+            const TelemetryThrust_S& thrust = _record.thrust;
+            std::fprintf(_file, ",%.9g,%.9g,%.9g,%.9g,%lu,%.17g",
+                         thrust.tau_x, thrust.tau_y, thrust.tau_z, thrust.tau_yaw,
+                         (unsigned long) thrust.trace_id, thrust.origin_s);
+            break;
+        }
+        case TELEMETRY_PID:
+        {
+            const TelemetryPid_S& pid = _record.pid;
+            std::fprintf(_file, ",%u,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g",
+                         pid.axis, pid.set_point, pid.error, pid.prev_error, pid.manipulation,
+                         pid.f_x, pid.g_x, pid.k_p, pid.k_i, pid.k_d, pid.transfer);
+            break;
+        }
+        case TELEMETRY_WAYPOINT_LIST:
+        {
+            const TelemetryWaypointList_S& list = _record.waypoint_list;
+            std::fprintf(_file, ",%u,%u,%u,%u,%u,%u,%u,%u",
+                         list.guidance_law, list.waypoint_list_length, list.sequence,
+                         list.x_count, list.y_count, list.z_count, list.speed_count, list.acceptance_radius_count);
+            break;
+        }
+        case TELEMETRY_WAYPOINT:
+        {
+            const TelemetryWaypoint_S& waypoint = _record.waypoint;
+            std::fprintf(_file, ",%u,%.9g,%.9g,%.9g,%.9g,%.9g",
+                         waypoint.index, waypoint.x, waypoint.y, waypoint.z, waypoint.speed, waypoint.acceptance_radius);
+            break;
+        }
+        case TELEMETRY_MASTER_STATUS:
+            std::fprintf(_file, ",%u,%u", _record.master_status.status, _record.master_status.desired_routine);
+            break;
+        case TELEMETRY_OBSTACLE_LIST:
+            std::fprintf(_file, ",%u,%.*s", _record.obstacle_list.count,
+                         (int) sizeof(_record.obstacle_list.frame_id), _record.obstacle_list.frame_id);
+            break;
+        case TELEMETRY_OBSTACLE:
+        {
+            const TelemetryObstacle_S& obstacle = _record.obstacle;
+            std::fprintf(_file, ",%.17g,%.17g,%.17g,%.17g,%.17g,%.9g,%.9g,%.9g,%.*s",
+                         obstacle.x, obstacle.y, obstacle.z, obstacle.orientation_z, obstacle.orientation_w,
+                         obstacle.radio, obstacle.height, obstacle.length,
+                         (int) sizeof(obstacle.obstacle_class), obstacle.obstacle_class);
+            break;
+        }
+        case TELEMETRY_PARAMETER:
+            std::fprintf(_file, ",%.*s,%.17g,%.*s",
+                         (int) sizeof(_record.parameter.name), _record.parameter.name, _record.parameter.value,
+                         (int) sizeof(_record.parameter.text), _record.parameter.text);
+            break;
+        case TELEMETRY_EMERGENCY_STOP:
+        default:
+            break;
+    }
+
+    std::fputc('\n', _file);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "usage: %s <output prefix> <segment.tlm>...\n", argv[0]);
+        return 2;
+    }
+
+    std::string prefix = argv[1];
+    std::vector<std::string> paths(argv + 2, argv + argc);
+
+    TelemetryReader reader;
+
+    if (!reader.Open(paths))
+    {
+        std::fprintf(stderr, "could not read the segments: %s\n", reader.error);
+        return 1;
+    }
+
+    /* Files are only created for the types found in the segments */
+    FILE*       files[TELEMETRY_RECORD_TYPES]   = {NULL};
+    uint64_t    counts[TELEMETRY_RECORD_TYPES]  = {0};
+    uint64_t    unknown_records                 = 0;
+    int         result                          = 0;
+
+    for (const TelemetryRecord_S* record = reader.Next(); record != NULL; record = reader.Next())
+    {
+        if (record->type >= TELEMETRY_RECORD_TYPES)
+        {
+            unknown_records++;
+            continue;
+        }
+
+        FILE*& file = files[record->type];
+
+        if (file == NULL)
+        {
+            std::string path = prefix + "_" + TELEMETRY_CSV[record->type].name + ".csv";
+            file = std::fopen(path.c_str(), "w");
+
+            if (file == NULL)
+            {
+                std::fprintf(stderr, "could not create %s\n", path.c_str());
+                result = 1;
+                break;
+            }
+
+            std::fprintf(file, "sequence,time_s%s%s\n",
+                         TELEMETRY_CSV[record->type].columns[0] != '\0' ? "," : "",
+                         TELEMETRY_CSV[record->type].columns);
+        }
+
+        WriteRecord(file, *record);
+        counts[record->type]++;
+    }
+
+    for (int i = 0; i < TELEMETRY_RECORD_TYPES; i++)
+    {
+        if (files[i] != NULL)
+        {
+            std::fclose(files[i]);
+            std::printf("%lu %s records written to %s_%s.csv\n", (unsigned long) counts[i], TELEMETRY_CSV[i].name, prefix.c_str(), TELEMETRY_CSV[i].name);
+        }
+    }
+
+    if (unknown_records > 0)
+    {
+        std::fprintf(stderr, "%lu records of unknown type skipped\n", (unsigned long) unknown_records);
+        result = 1;
+    }
+
+    return result;
+}
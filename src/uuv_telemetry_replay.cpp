@@ -0,0 +1,101 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_telemetry_replay.cpp
+ *
+ * @brief: Replays the control and guidance nodes from their telemetry and
+ *         compares their outputs bit for bit with the recorded ones. Takes
+ *         run directories, as written with ~telemetry_dir, or segment files;
+ *         segments of other nodes are skipped. Exits with 0 when every log
+ *         matched, 1 on the first difference and 2 when a log can not be
+ *         read, so a library of field logs can drive a bisection:
+ *
+ *             uuv_telemetry_replay logs/2020_07_30_pool logs/2020_08_02_lake
+ *             git bisect run sh -c "catkin build && uuv_telemetry_replay logs/2020_07_30_pool"
+ *
+ *         Uses uuv_common, uuv_control and uuv_guidance libraries.
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "control_replay.hpp"
+#include "guidance_replay.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <run directory | segment.tlm>...\n", argv[0]);
+        return 2;
+    }
+
+    std::map<std::string, std::vector<std::string> > logs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!TelemetryReader::FindLogs(argv[i], &logs))
+        {
+            std::fprintf(stderr, "%s: not a run directory or a segment file\n", argv[i]);
+            return 2;
+        }
+    }
+
+    /* The controllers stamp their outputs, the replay sets the clock to the recorded time */
+    ros::Time::init();
+
+    int result = 0;
+
+    for (std::map<std::string, std::vector<std::string> >::iterator log = logs.begin(); log != logs.end(); log++)
+    {
+        TelemetryReader reader;
+
+        if (!reader.Open(log->second))
+        {
+            std::fprintf(stderr, "%s: %s\n", log->first.c_str(), reader.error);
+            return 2;
+        }
+
+        TelemetryReplay* replay;
+
+        if (reader.source == "uuv_control_node")
+        {
+            replay = new ControlReplay();
+        }
+        else if (reader.source == "uuv_guidance_node")
+        {
+            replay = new GuidanceReplay();
+        }
+        else
+        {
+            std::printf("%s: no replay for %s, skipped\n", log->first.c_str(), reader.source.c_str());
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool matched = replay->Run(reader);
+        double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%s: %lu cycles from cycle %lu, %lu values compared, %lu mismatches, %.0fx real time\n",
+                    log->first.c_str(),
+                    (unsigned long) replay->cycles,
+                    (unsigned long) replay->first_cycle,
+                    (unsigned long) replay->compared,
+                    (unsigned long) replay->mismatches,
+                    elapsed_s > 0 ? replay->recorded_duration_s / elapsed_s : 0);
+
+        if (!matched)
+        {
+            std::printf("    first mismatch at cycle %lu (%.3f s): %s recorded %.9g, replayed %.9g\n",
+                        (unsigned long) replay->first_mismatch.cycle,
+                        replay->first_mismatch.time_s,
+                        replay->first_mismatch.field,
+                        replay->first_mismatch.recorded,
+                        replay->first_mismatch.replayed);
+            result = 1;
+        }
+
+        delete replay;
+    }
+
+    return result;
+}
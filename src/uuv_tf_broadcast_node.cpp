@@ -12,6 +12,7 @@
 
 #include <ros/ros.h>
 #include <string.h>
+#include <algorithm>
 
 static const float SAMPLE_TIME_S = 0.01;
 
@@ -19,28 +20,65 @@ int main(int argc, char **argv)
 {
     ros::init(argc, argv, "uuv_tf_broadcast_node");
     ros::NodeHandle nh;
-        
+    ros::NodeHandle private_nh("~");
+
+    int     path_capacity;
+    float   full_path_rate_hz;
+    float   min_path_distance_m;
+    float   min_path_angle_rad;
+
+    private_nh.param("path_capacity", path_capacity, 5000);
+    private_nh.param("full_path_rate_hz", full_path_rate_hz, 1.0f);
+    private_nh.param("min_path_distance_m", min_path_distance_m, 0.1f);
+    private_nh.param("min_path_angle_rad", min_path_angle_rad, 0.1f);
+
     ros::Rate               cycle_rate(int(1 / SAMPLE_TIME_S));
-    TfBroadcaster           tf_broadcaster("world", "uuv");
-    
-    ros::Publisher  uuv_path    = nh.advertise<nav_msgs::Path>("/uuv_simulation/uuv_tf_broadcast/uuv_path", 1000);
+    TfBroadcaster           tf_broadcaster("world", "uuv", path_capacity);
+
+    tf_broadcaster.min_path_distance_m  = min_path_distance_m;
+    tf_broadcaster.min_path_angle_rad   = min_path_angle_rad;
+
+    ros::Publisher  uuv_path            = nh.advertise<nav_msgs::Path>("/uuv_simulation/uuv_tf_broadcast/uuv_path", 1);
+    ros::Publisher  uuv_path_increment  = nh.advertise<nav_msgs::Path>("/uuv_simulation/uuv_tf_broadcast/uuv_path_increment", 10);
     
-    ros::Subscriber uuv_pose    = nh.subscribe("/uuv_simulation/dynamic_model/pose", 
+    ros::Subscriber uuv_state   = nh.subscribe("/uuv_simulation/dynamic_model/state", 
                                                10, 
                                                &TfBroadcaster::BroadcastTransform, 
                                                &tf_broadcaster);
-    
+
+    /* Period in cycles; a rate of 0 disables the full path */
+    int full_path_period = 0;
+
+    if (full_path_rate_hz > 0)
+    {
+        full_path_period = std::max(1, int(1 / (SAMPLE_TIME_S * full_path_rate_hz)));
+    }
+
+    int counter = 0;
+
     while(ros::ok())
     {
         /* Run Queued Callbacks */
         ros::spinOnce();
 
-        /* Publish Path */
-        uuv_path.publish(tf_broadcaster.path);
+        /* Publish the whole path at a low rate, and only the new poses in between */
+        if (full_path_period > 0 && counter % full_path_period == 0)
+        {
+            tf_broadcaster.BuildFullPath();
+            uuv_path.publish(tf_broadcaster.path);
+        }
+
+        if (!tf_broadcaster.path_increment.poses.empty())
+        {
+            uuv_path_increment.publish(tf_broadcaster.path_increment);
+            tf_broadcaster.ClearPathIncrement();
+        }
+
+        counter++;
         
         /* Sleep for 10ms */
         cycle_rate.sleep();
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,252 @@
+/** ----------------------------------------------------------------------------
+ * @file: uuv_vehicle_benchmark.cpp
+ *
+ * @brief: Compares the cost of stepping the dynamic model and the closed
+ *         control loop with a parameter set loaded at runtime against the
+ *         shipped vehicle built in as constants. Both runs start from the
+ *         same state and must end in the same one bit for bit; the runs are
+ *         interleaved and the fastest of each is reported. Exits with 1 when
+ *         the results differ. The cost of a current field is measured the
+ *         same way against still water. Uses uuv_common, uuv_control and
+ *         uuv_simulation libraries.
+ *
+ *             uuv_vehicle_benchmark [cycles]
+ * -----------------------------------------------------------------------------
+ **/
+
+#include "uuv_4dof_controller.hpp"
+#include "uuv_dynamic_4dof_model.hpp"
+#include "current_field.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const float      SAMPLE_TIME_S           = 0.01;
+static const uint64_t   BENCHMARK_CYCLES        = 1000000;
+static const int        BENCHMARK_REPETITIONS   = 5;
+
+/* Tidal current field over the area the open loop run covers */
+static const int        CURRENT_SAMPLES         = 128;
+static const int        CURRENT_LAYERS          = 16;
+static const int        CURRENT_FRAMES          = 4;
+static const float      CURRENT_RESOLUTION_M    = 10;
+static const float      CURRENT_PERIOD_S        = 3600;
+
+/* Thrust pattern of the open loop run, switched every second of simulated time */
+static const float      OPEN_LOOP_THRUST[4][4]  =
+{
+    {40, 0, 10, 2},
+    {-20, 15, 0, -3},
+    {60, -10, -15, 0},
+    {0, 0, 20, 4},
+};
+
+typedef struct BenchmarkResult_S
+{
+    double                      seconds;
+    vanttec_uuv::VehicleState   state;
+    vanttec_uuv::ThrustControl  thrust;
+} BenchmarkResult_S;
+
+static void BuildCurrentField(CurrentField* _field)
+{
+    _field->origin_x        = -CURRENT_SAMPLES * CURRENT_RESOLUTION_M / 2;
+    _field->origin_y        = -CURRENT_SAMPLES * CURRENT_RESOLUTION_M / 2;
+    _field->origin_z        = 0;
+    _field->resolution_m    = CURRENT_RESOLUTION_M;
+    _field->cols            = CURRENT_SAMPLES;
+    _field->rows            = CURRENT_SAMPLES;
+    _field->layers          = CURRENT_LAYERS;
+    _field->frames          = CURRENT_FRAMES;
+    _field->frame_period_s  = CURRENT_PERIOD_S;
+
+    std::vector<float> velocities;
+
+    for (int frame = 0; frame < CURRENT_FRAMES; frame++)
+    {
+        float tide = std::cos(2 * 3.14159 * frame / CURRENT_FRAMES);
+
+        for (int z = 0; z < CURRENT_LAYERS; z++)
+        {
+            for (int y = 0; y < CURRENT_SAMPLES; y++)
+            {
+                for (int x = 0; x < CURRENT_SAMPLES; x++)
+                {
+                    velocities.push_back(0.3 * tide * std::cos(0.1 * y) * (1 - 0.05 * z));
+                    velocities.push_back(0.2 * tide * std::sin(0.1 * x));
+                    velocities.push_back(0.01 * std::sin(0.2 * (x + y)));
+                }
+            }
+        }
+    }
+
+    _field->Build(velocities);
+}
+
+template <typename Parameters>
+static void OpenLoop(uint64_t _cycles, const Parameters& _parameters, const CurrentField* _current_field, BenchmarkResult_S* _result)
+{
+    UUVDynamic4DOFModelT<Parameters> model(SAMPLE_TIME_S, _parameters);
+    vanttec_uuv::ThrustControl thrust;
+
+    model.current_field = _current_field;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint64_t cycle = 0; cycle < _cycles; cycle++)
+    {
+        if (cycle % 100 == 0)
+        {
+            const float* pattern = OPEN_LOOP_THRUST[(cycle / 100) % 4];
+
+            thrust.tau_x    = pattern[0];
+            thrust.tau_y    = pattern[1];
+            thrust.tau_z    = pattern[2];
+            thrust.tau_yaw  = pattern[3];
+            model.ThrustCallback(thrust);
+        }
+
+        model.CalculateStates();
+    }
+
+    _result->seconds    = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    _result->state      = model.state;
+    _result->thrust     = thrust;
+}
+
+template <typename Parameters>
+static void ClosedLoop(uint64_t _cycles, const Parameters& _parameters, BenchmarkResult_S* _result)
+{
+    UUVDynamic4DOFModelT<Parameters> model(SAMPLE_TIME_S, _parameters);
+    UUV4DOFControllerT<Parameters> controller(SAMPLE_TIME_S, _parameters);
+    geometry_msgs::Twist setpoint;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint64_t cycle = 0; cycle < _cycles; cycle++)
+    {
+        /* A new setpoint every ten seconds of simulated time */
+        if (cycle % 1000 == 0)
+        {
+            setpoint.linear.x   = (cycle / 1000) % 2 == 0 ? 0.8 : 0.2;
+            setpoint.linear.y   = 0;
+            setpoint.linear.z   = (cycle / 1000) % 3;
+            setpoint.angular.z  = (cycle / 1000) % 2 == 0 ? 1.5 : -1.5;
+            controller.UpdateSetPoints(setpoint);
+        }
+
+        model.CalculateStates();
+
+        controller.UpdateState(model.state);
+        controller.UpdateControlLaw();
+        controller.UpdateThrustOutput();
+
+        model.ThrustCallback(controller.thrust);
+    }
+
+    _result->seconds    = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    _result->state      = model.state;
+    _result->thrust     = controller.thrust;
+}
+
+static bool SameResult(const BenchmarkResult_S& _a, const BenchmarkResult_S& _b)
+{
+    const vanttec_uuv::VehicleState& a = _a.state;
+    const vanttec_uuv::VehicleState& b = _b.state;
+
+    double values_a[] = {a.x, a.y, a.z, a.yaw, a.u, a.v, a.w, a.r, a.u_dot, a.v_dot, a.w_dot, a.r_dot,
+                         _a.thrust.tau_x, _a.thrust.tau_y, _a.thrust.tau_z, _a.thrust.tau_yaw};
+    double values_b[] = {b.x, b.y, b.z, b.yaw, b.u, b.v, b.w, b.r, b.u_dot, b.v_dot, b.w_dot, b.r_dot,
+                         _b.thrust.tau_x, _b.thrust.tau_y, _b.thrust.tau_z, _b.thrust.tau_yaw};
+
+    return std::memcmp(values_a, values_b, sizeof(values_a)) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t cycles = argc > 1 ? std::strtoull(argv[1], NULL, 10) : BENCHMARK_CYCLES;
+
+    if (cycles == 0)
+    {
+        std::fprintf(stderr, "usage: %s [cycles]\n", argv[0]);
+        return 2;
+    }
+
+    /* The controller stamps its thrust */
+    ros::Time::init();
+
+    VtecU3GammaParameters   constant;
+    VehicleParameters       runtime;
+    CurrentField            current_field;
+    int                     result = 0;
+
+    BuildCurrentField(&current_field);
+
+    for (int benchmark = 0; benchmark < 3; benchmark++)
+    {
+        BenchmarkResult_S constant_best;
+        BenchmarkResult_S runtime_best;
+
+        /* Interleaved so both see the same machine state, the fastest run is kept */
+        for (int repetition = 0; repetition < BENCHMARK_REPETITIONS; repetition++)
+        {
+            BenchmarkResult_S constant_run;
+            BenchmarkResult_S runtime_run;
+
+            if (benchmark == 0)
+            {
+                OpenLoop(cycles, constant, NULL, &constant_run);
+                OpenLoop(cycles, runtime, NULL, &runtime_run);
+            }
+            else if (benchmark == 1)
+            {
+                ClosedLoop(cycles, constant, &constant_run);
+                ClosedLoop(cycles, runtime, &runtime_run);
+            }
+            else
+            {
+                /* Still water against the current, both with the runtime set */
+                OpenLoop(cycles, runtime, NULL, &constant_run);
+                OpenLoop(cycles, runtime, &current_field, &runtime_run);
+            }
+
+            if (repetition == 0 || constant_run.seconds < constant_best.seconds)
+            {
+                constant_best = constant_run;
+            }
+            if (repetition == 0 || runtime_run.seconds < runtime_best.seconds)
+            {
+                runtime_best = runtime_run;
+            }
+        }
+
+        if (benchmark == 2)
+        {
+            std::printf("%-12s still    %7.1f ns/cycle, current %7.1f ns/cycle, current/still %.3f\n",
+                        "current",
+                        constant_best.seconds / cycles * 1e9,
+                        runtime_best.seconds / cycles * 1e9,
+                        runtime_best.seconds / constant_best.seconds);
+            continue;
+        }
+
+        bool same = SameResult(constant_best, runtime_best);
+
+        std::printf("%-12s constant %7.1f ns/cycle, runtime %7.1f ns/cycle, runtime/constant %.3f, results %s\n",
+                    benchmark == 0 ? "model" : "closed loop",
+                    constant_best.seconds / cycles * 1e9,
+                    runtime_best.seconds / cycles * 1e9,
+                    runtime_best.seconds / constant_best.seconds,
+                    same ? "identical" : "differ");
+
+        if (!same)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
@@ -46,6 +46,8 @@ int main(int argc, char **argv)
         if (waypoint_publisher.path_publish_flag == 0)
         {
             uuv_path.publish(waypoint_publisher.path);
+            waypoint_publisher.waypoints.header.stamp = ros::Time::now();
+            waypoint_publisher.waypoints.header.frame_id = "world";
             uuv_waypoints.publish(waypoint_publisher.waypoints);
             waypoint_publisher.path_publish_flag = 1;
         }